@@ -16,8 +16,13 @@
  **
  ** \author Come Raczy
  **/
+#include <fstream>
+#include <sstream>
+
 #include "common/Debug.hh"
+#include "common/Exceptions.hh"
 #include "common/SystemCompatibility.hh"
+#include "common/Trace.hh"
 #include "options/AlignOptions.hh"
 #include "package/InstallationPaths.hh"
 #include "reference/ReferenceMetadata.hh"
@@ -67,10 +72,18 @@ void align(const isaac::options::AlignOptions &options)
         // We're the child process in a fork, just keep running.
     }
 
+    if (!options.traceFile.empty())
+    {
+        isaac::common::trace::start();
+    }
+
     isaac::workflow::AlignWorkflow workflow(
         options.argv,
         options.description,
         options.hashTableBucketCount,
+        options.canonicalKmerHash,
+        options.kmerFingerprints,
+        options.seedMinimizerWindow,
         options.flowcellLayoutList,
         options.seedLength,
         options.barcodeMetadataList,
@@ -105,12 +118,15 @@ void align(const isaac::options::AlignOptions &options)
         options.preAllocateBins,
         options.putUnalignedInTheBack,
         options.realignGapsVigorously,
+        options.realignEngine,
+        options.realignmentCache,
         options.realignDodgyFragments,
         options.realignedGapsPerFragment,
         options.clipSemialigned,
         options.clipOverlapping,
         options.scatterRepeats,
         options.rescueShadows,
+        options.bitParallelShadowRescue,
         options.trimPEAdapters,
         options.gappedMismatchesMax,
         options.smitWatermanGapsMax,
@@ -135,6 +151,7 @@ void align(const isaac::options::AlignOptions &options)
         options.bamGzipLevel,
         options.bamPuFormat,
         options.bamProduceMd5,
+        options.bamMergeRuns,
         options.bamHeaderTags,
         options.expectedBgzfCompressionRatio,
         options.singleLibrarySamples,
@@ -196,5 +213,18 @@ void align(const isaac::options::AlignOptions &options)
     {
         workflow.cleanupIntermediary();
     }
+
+    if (!options.traceFile.empty())
+    {
+        std::ofstream os(options.traceFile.string().c_str());
+        isaac::common::trace::dumpChromeTrace(os);
+        if (!os)
+        {
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to write trace file: " + options.traceFile.string()));
+        }
+        std::ostringstream summary;
+        isaac::common::trace::dumpSummary(summary);
+        ISAAC_THREAD_CERR << "Pipeline stage timings:\n" << summary.str() << std::endl;
+    }
 }
 
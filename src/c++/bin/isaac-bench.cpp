@@ -0,0 +1,43 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file isaac-bench.cpp
+ **
+ ** \brief Times the alignment hot kernels on synthetic data and reports the throughput as JSON
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include "common/Debug.hh"
+#include "options/BenchmarkOptions.hh"
+#include "workflow/BenchmarkWorkflow.hh"
+
+void benchmark(const isaac::options::BenchmarkOptions &options)
+{
+    isaac::workflow::BenchmarkWorkflow workflow(
+        options.kernels_,
+        options.referenceLength_,
+        options.readLength_,
+        options.reads_,
+        options.repeats_,
+        options.jobs_,
+        options.seed_,
+        options.tempDirectory_,
+        options.outputString_);
+
+    workflow.run();
+}
+
+int main(int argc, char *argv[])
+{
+    isaac::common::run(benchmark, argc, argv);
+}
@@ -27,7 +27,9 @@ void reoderReference(const isaac::options::ReorderReferenceOptions &options)
         options.sortedReferenceMetadata_,
         options.newXmlPath_,
         options.newDataDirectory_,
-        options.newOrder_);
+        options.newOrder_,
+        options.packedCache_,
+        options.jobs_);
 
     workflow.run();
 }
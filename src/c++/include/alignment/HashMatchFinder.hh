@@ -72,6 +72,22 @@ static const unsigned SV_READ_SEEDS_MIN = 1;
 static const unsigned SHORT_READ_SEEDS_MIN = 2;
 static const unsigned LONG_READ_SEEDS_MIN = 3;
 
+// reads at least this long are seeded with minimizers if the minimizer window is set
+static const unsigned MINIMIZER_READ_LENGTH_MIN = 250;
+
+/**
+ * \brief Widest minimizer window that still leaves LONG_READ_SEEDS_MIN non-overlapping minimizers in a read.
+ *        Each stretch of window + seedLength kmer positions has a window of its own, and the minimizers of
+ *        neighbouring stretches are at least seedLength apart.
+ *
+ * \return 0 if the read cannot have that many minimizers
+ */
+inline unsigned getMinimizerWindowMax(const unsigned seedLength, const unsigned readLength)
+{
+    const unsigned kmers = readLength < seedLength ? 0 : readLength - seedLength + 1;
+    return kmers / LONG_READ_SEEDS_MIN > seedLength ? kmers / LONG_READ_SEEDS_MIN - seedLength : 0;
+}
+
 
 template <typename ReferenceHash, unsigned seedsPerMatchMax = 4>
 class ClusterHashMatchFinder : SeedHashMatchFinder<ReferenceHash>
@@ -83,11 +99,17 @@ public:
     static const unsigned SEED_LENGTH = ReferenceHash::SEED_LENGTH;
     BOOST_STATIC_ASSERT(seedsPerMatchMax >= SHORT_READ_SEEDS_MIN);
 
+    /**
+     * \param minimizerWindow if greater than 1, reads of MINIMIZER_READ_LENGTH_MIN or longer are seeded
+     *                        only at the (minimizerWindow, SEED_LENGTH) minimizers of the read. Reads too short for
+     *                        the window to leave enough seeds are probed at every non-overlapping seed.
+     */
     ClusterHashMatchFinder(
         const ReferenceHash& referenceHash,
         const std::size_t candidateMatchesMax,
         const unsigned seedBaseQualityMin,
-        const unsigned seedRepeatsMax);
+        const unsigned seedRepeatsMax,
+        const unsigned minimizerWindow = 0);
 
     struct SeedHits
     {
@@ -116,6 +138,10 @@ public:
         }
     };
 
+    /**
+     * \param repeatProbesAvoided incremented for each seed rejected by the reference hash repeat filter
+     *                            without probing the hash table
+     */
     std::size_t findReadMatches(
         const reference::ContigList &contigList,
         const Cluster& cluster,
@@ -123,7 +149,8 @@ public:
         const std::size_t seedRepeatThreshold,
         MatchLists& matchLists,
         ReferenceOffsetLists& fwMergeBuffers,
-        ReferenceOffsetLists& rvMergeBuffers) const;
+        ReferenceOffsetLists& rvMergeBuffers,
+        std::size_t &repeatProbesAvoided) const;
 
     std::size_t findHeadAnchoredReadMatches(
         const reference::ContigList &contigList,
@@ -134,10 +161,13 @@ public:
         const unsigned headSeedOffsetMax,
         MatchLists& matchLists,
         ReferenceOffsetLists& fwMergeBuffers,
-        ReferenceOffsetLists& rvMergeBuffers) const;
+        ReferenceOffsetLists& rvMergeBuffers,
+        std::size_t &repeatProbesAvoided) const;
 
 private:
     const std::size_t candidateMatchesMax_;
+    // 0 or 1 to probe every non-overlapping seed
+    const unsigned minimizerWindow_;
 
     typedef common::StaticVector<SeedHits, (ISAAC_READ_LENGTH_MAX / SEED_LENGTH)> SeedsHits;
 
@@ -152,12 +182,36 @@ private:
         ReferenceOffsetLists& fwMergeBuffers,
         ReferenceOffsetLists& rvMergeBuffers) const;
 
+    enum SeedProbeResult
+    {
+        SEED_NO_HITS,
+        SEED_HIT,
+        SEED_REPEAT
+    };
+
+    SeedProbeResult probeSeed(
+        const Cluster& cluster,
+        const KmerT &seedKmer,
+        const unsigned seedOffset,
+        const std::size_t seedRepeatThreshold,
+        SeedsHits& seedsHits,
+        std::size_t &repeatProbesAvoided) const;
+
+    std::size_t collectMinimizerSeedHits(
+        const Cluster& cluster,
+        const unsigned readIndex,
+        const std::size_t seedRepeatThreshold,
+        const unsigned endSeedOffset,
+        SeedsHits& seedsHits,
+        std::size_t &repeatProbesAvoided) const;
+
     std::size_t collectSeedHits(
         const Cluster& cluster,
         const unsigned readIndex,
         const std::size_t seedRepeatThreshold,
         const unsigned endSeedOffset,
-        SeedsHits& seedsHits) const;
+        SeedsHits& seedsHits,
+        std::size_t &repeatProbesAvoided) const;
 };
 
 } // namespace alignment
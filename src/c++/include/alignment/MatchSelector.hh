@@ -81,6 +81,7 @@ public:
         const bool clipOverlapping,
         const bool scatterRepeats,
         const bool rescueShadows,
+        const bool bitParallelShadowRescue,
         const bool trimPEAdapters,
         const bool anchorMate,
         const unsigned gappedMismatchesMax,
@@ -108,6 +109,14 @@ public:
     void reserveMemory(
         const flowcell::TileMetadataList &tileMetadataList);
 
+    /**
+     * \brief stores the base calls loading latency in the tile stats
+     */
+    void recordTileLoad(const flowcell::TileMetadata &tileMetadata, const uint64_t loadMilliseconds)
+    {
+        allStats_.at(tileMetadata.getIndex()).recordTileLoad(loadMilliseconds);
+    }
+
     template <typename MatchFinderT>
     void parallelSelect(
         alignment::matchFinder::TileClusterInfo &tileClusterInfo,
@@ -158,6 +167,26 @@ private:
 
     mutable boost::mutex mutex_;
 
+    std::size_t getRepeatProbesAvoided() const
+    {
+        std::size_t ret = 0;
+        for (const TemplateBuilder &templateBuilder : threadTemplateBuilders_)
+        {
+            ret += templateBuilder.getRepeatProbesAvoided();
+        }
+        return ret;
+    }
+
+    std::size_t getFastPathTemplates() const
+    {
+        std::size_t ret = 0;
+        for (const TemplateBuilder &templateBuilder : threadTemplateBuilders_)
+        {
+            ret += templateBuilder.getFastPathTemplates();
+        }
+        return ret;
+    }
+
     template <typename MatchFinderT>
     void alignThread(
         const unsigned threadNumber,
@@ -202,6 +231,8 @@ private:
         matchSelector::FragmentStorage &fragmentStorage);
 
     static const unsigned CLUSTERS_AT_A_TIME = 10000;
+    // smallest block handed to a thread near the end of the tile. Keeps the mutex contention reasonable.
+    static const unsigned CLUSTERS_AT_A_TIME_MIN = 256;
 };
 
 } // namespace alignment
@@ -177,6 +177,7 @@ private:
 };
 
 void trimLowQualityEnds(Cluster &cluster, const unsigned baseQualityCutoff);
+void maskPadding(Cluster &cluster);
 
 
 template <typename FpT> bool ISAAC_LP_EQUALS(FpT left, FpT right)
@@ -39,7 +39,8 @@ class Read
 public:
     /// Default constructor to enable use in containers
     //explicit Read(unsigned index = 0) : index_(index) {}
-    Read(const unsigned maxReadLength, const unsigned index) : index_(index), /*beginCyclesMasked_(0), */endCyclesMasked_(0)
+    Read(const unsigned maxReadLength, const unsigned index) :
+        index_(index), /*beginCyclesMasked_(0), */endCyclesMasked_(0), unpaddedLength_(0)
     {
         forwardSequence_.reserve(maxReadLength);
         reverseSequence_.reserve(maxReadLength);
@@ -56,6 +57,7 @@ public:
         , reverseQuality_(read.reverseQuality_)
         /*, beginCyclesMasked_(read.beginCyclesMasked_)*/
         , endCyclesMasked_(read.endCyclesMasked_)
+        , unpaddedLength_(read.unpaddedLength_)
     {
         // keep the size of pre-allocated buffers
         forwardSequence_.reserve(read.forwardSequence_.capacity());
@@ -72,6 +74,8 @@ public:
     const std::vector<char> &getForwardQuality() const {return forwardQuality_;}
     const std::vector<char> &getReverseQuality() const {return reverseQuality_;}
     unsigned getLength() const {return forwardSequence_.size();}
+    /// length without the trailing no-calls such as the padding of variable-length reads up to the read length
+    unsigned getUnpaddedLength() const {return unpaddedLength_;}
     unsigned getBeginCyclesMasked() const { return 0; /*return beginCyclesMasked_;*/}
     unsigned getEndCyclesMasked() const {return endCyclesMasked_;}
     unsigned getIndex() const {return index_;}
@@ -98,6 +102,8 @@ private:
     //unsigned beginCyclesMasked_;
     /// number of cycles masked at the end of the read.
     unsigned endCyclesMasked_;
+    /// number of cycles up to and including the last called base
+    unsigned unpaddedLength_;
 };
 
 std::ostream &operator<<(std::ostream &os, const Read &read);
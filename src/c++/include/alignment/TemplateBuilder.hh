@@ -84,7 +84,9 @@ public:
         const AlignmentCfg &alignmentCfg,
         const DodgyAlignmentScore dodgyAlignmentScore,
         const unsigned anomalousPairHandicap,
-        const bool reserveBuffers);
+        const bool reserveBuffers,
+        const bool bitParallelShadowRescue = false,
+        const bool fastPath = true);
 
     const FragmentMetadataLists &getFragments() const {return candidates_;}
 
@@ -125,11 +127,23 @@ public:
         const TemplateLengthStatistics &tls,
         BamTemplate &bamTemplate) const;
 
+    std::size_t getRepeatProbesAvoided() const {return fragmentBuilder_.getRepeatProbesAvoided();}
+    std::size_t getFastPathTemplates() const {return fastPathTemplates_;}
+
+    /**
+     * \brief public for Unit tests. True for a proper pair of unique, ungapped, unclipped mates with at most
+     *        FAST_PATH_EDITS_MAX edits each. None of the mate rescue and double-checking steps of buildTemplate
+     *        can change such template, so it is emitted as soon as the seed-based candidates are paired.
+     */
+    bool isFastPathTemplate(const BamTemplate &bamTemplate) const;
+
 private:
     // BEST_SHADOWS_TO_KEEP includes semialigned shadows and SV candidates.
     // higher numbers lead to too many candidates stored causing cigar buffer running out of capacity
     static const std::size_t BEST_SHADOWS_TO_KEEP = 1000;
     static const unsigned SEMIALIGNED_MATCHES_MIN = 16;
+    // Fragments with up to this many edits always have both semialigned anchors. See possiblySemialigned
+    static const unsigned FAST_PATH_EDITS_MAX = 1;
 
     const unsigned repeatThreshold_;
     const unsigned seedLength_;
@@ -139,6 +153,8 @@ private:
 
     const bool scatterRepeats_;
     const bool rescueShadows_;
+    // emit the isFastPathTemplate templates without the mate rescue and double-checking steps
+    const bool fastPath_;
     const DodgyAlignmentScore dodgyAlignmentScore_;
     const double anomalousPairHandicap_;
 
@@ -169,6 +185,8 @@ private:
     mutable templateBuilder::BestPairInfo bestCombinationPairInfo_;
     /// Holds the information about the pairs rescued via rescueShadow or buildDisjoinedTemplate
     mutable templateBuilder::BestPairInfo bestRescuedPair_;
+    /// Number of templates that did not need any processing past pairing of the candidates
+    std::size_t fastPathTemplates_;
 
     template <typename MatchFinderT>
     templateBuilder::AlignmentType buildTemplateFromSeeds(
@@ -517,7 +535,7 @@ inline void upateBestRescuedPair(
     templateBuilder::BestPairInfo& ret)
 {
     const isaac::alignment::TemplateLengthStatistics::CheckModelResult model = tls.checkModel(orphan, rescuedShadow);
-    const bool properPair = TemplateLengthStatistics::Nominal == model || TemplateLengthStatistics::Undersized == model;
+    const bool properPair = TemplateLengthStatistics::Nominal == model || TemplateLengthStatistics::Undersized == model;
     const PairInfo pairInfo(orphan, rescuedShadow, properPair);
 
     // Notice that all pairs we deal with here are properly oriented as this is how the rescue works. Some of them are
@@ -1130,6 +1148,12 @@ templateBuilder::AlignmentType TemplateBuilder::buildTemplate(
         withGaps, matchFinder,
         bamTemplate);
 
+    if (fastPath_ && res == templateBuilder::Normal && 2 == readMetadataList.size() && isFastPathTemplate(bamTemplate))
+    {
+        ++fastPathTemplates_;
+        return res;
+    }
+
     if (res == templateBuilder::Normal)
     {
         if (2 == readMetadataList.size() && rescueShadows_)
@@ -319,6 +319,13 @@ public:
     bool appendTemplate(const FragmentMetadataList &r0Fragments, const FragmentMetadataList &r1Fragments);
     bool appendUniqueTemplate(const FragmentMetadata &perfect0, const FragmentMetadata &perfect1);
     void appendModel(const TemplateLengthStatistics::AlignmentModel am, const uint64_t length);
+    /**
+     ** \brief add a template to the histograms without recomputing the statistics.
+     **
+     ** The result does not depend on the order in which the templates are accumulated. Use finalize()
+     ** to update the statistics once all templates are in.
+     **/
+    void accumulateModel(const TemplateLengthStatistics::AlignmentModel am, const uint64_t length);
 
     /// finalize the model after adding all available templates
     bool finalize();
@@ -47,7 +47,9 @@ public:
         const bool collectCycleStats,
         const flowcell::BarcodeMetadataList &barcodeMetadataList) :
             collectCycleStats_(collectCycleStats),
-            barcodeMetadataList_(barcodeMetadataList)
+            barcodeMetadataList_(barcodeMetadataList),
+            loadMilliseconds_(0),
+            repeatProbesAvoided_(0)
     {
         const unsigned tileStatsCount = maxReads_ * filterStates_;
         ISAAC_THREAD_CERR << "Allocating " << tileStatsCount << " tile stats." << std::endl;
@@ -68,9 +70,30 @@ public:
                       boost::bind(&TileStats::reset, _1));
         std::for_each(tileBarcodeStats_.begin(), tileBarcodeStats_.end(),
                       boost::bind(&TileBarcodeStats::reset, _1));
+        loadMilliseconds_ = 0;
+        repeatProbesAvoided_ = 0;
+    }
 
+    /**
+     * \brief time it took to get the tile base calls into memory
+     */
+    void recordTileLoad(const uint64_t loadMilliseconds)
+    {
+        loadMilliseconds_ += loadMilliseconds;
     }
 
+    uint64_t getLoadMilliseconds() const {return loadMilliseconds_;}
+
+    /**
+     * \brief reference hash probes the repeat filter made unnecessary
+     */
+    void recordRepeatProbesAvoided(const uint64_t repeatProbesAvoided)
+    {
+        repeatProbesAvoided_ += repeatProbesAvoided;
+    }
+
+    uint64_t getRepeatProbesAvoided() const {return repeatProbesAvoided_;}
+
     void recordTemplate(
         const flowcell::ReadMetadataList &readMetadatalist,
         const TemplateLengthStatistics &templateLengthStatistics,
@@ -121,6 +144,8 @@ public:
             tileBarcodeStats += right.tileBarcodeStats_.at(i);
             ++i;
         }
+        loadMilliseconds_ += right.loadMilliseconds_;
+        repeatProbesAvoided_ += right.repeatProbesAvoided_;
         return *this;
     }
 
@@ -137,6 +162,8 @@ public:
         ISAAC_ASSERT_MSG(that.tileBarcodeStats_.size() == tileBarcodeStats_.size(), "size must match");
         tileStats_ = that.tileStats_;
         tileBarcodeStats_ = that.tileBarcodeStats_;
+        loadMilliseconds_ = that.loadMilliseconds_;
+        repeatProbesAvoided_ = that.repeatProbesAvoided_;
         return *this;
     }
 
@@ -175,6 +202,8 @@ private:
      * \brief higher-level stats that we can afford to keep per tile-barcode
      */
     std::vector<TileBarcodeStats>  tileBarcodeStats_;
+    uint64_t loadMilliseconds_;
+    uint64_t repeatProbesAvoided_;
 
     unsigned tileBarcodeIndex(
         const flowcell::ReadMetadata& read,
@@ -68,6 +68,29 @@ public:
         std::vector<alignment::TemplateLengthStatistics> &templateLengthStatistics,
         matchSelector::MatchSelectorStats &stats);
 
+    /**
+     * \brief True when the templates aligned by the main pass complete the template-length model of the barcodes
+     *        which did not get stable statistics from the detection pass. Once stable, the detection pass is not
+     *        repeated for the barcode in the following tiles.
+     */
+    bool learnsFromAlignedClusters() const {return !perTileTls_ && !userTemplateLengthStatistics_.isStable();}
+
+    /**
+     * \brief Record the template of the cluster just aligned by the thread. Thread-safe.
+     */
+    void collectAlignedTemplate(
+        const unsigned threadNumber,
+        const unsigned barcodeIndex,
+        const TemplateBuilder::FragmentMetadataLists &fragments);
+
+    /**
+     * \brief Merge the templates collected during the main pass of the tile and publish the statistics for the
+     *        barcodes that got stable. Must be called when no alignment threads are running.
+     */
+    void publishAlignedTemplates(
+        const flowcell::TileMetadata &tileMetadata,
+        std::vector<alignment::TemplateLengthStatistics> &templateLengthStatistics);
+
 private:
     // The threading code in selectTileMatches can't deal with exception cleanup. Let it just crash for now.
     common::UnsafeThreadVector &computeThreads_;
@@ -78,6 +101,7 @@ private:
 
     const TemplateLengthStatistics userTemplateLengthStatistics_;
     const bool perTileTls_;
+    const unsigned detectTemplateBlockSize_;
 
     std::vector<Cluster> threadCluster_;
     boost::ptr_vector<TemplateBuilder> &threadTemplateBuilders_;
@@ -101,6 +125,13 @@ private:
     static const unsigned CLUSTERS_AT_A_TIME = 10000;
     typedef std::pair<unsigned, TemplateLengthDistribution::AlignmentModel> BarcodeAlignmentModel;
 
+    // templates collected by each thread during the main pass. Merged into templateLengthDistributions_ when full
+    std::vector<std::vector<BarcodeAlignmentModel> > threadAlignedTemplates_;
+    // number of templates merged from the main pass since the barcode statistics were last finalized
+    std::vector<std::size_t> barcodeAlignedTemplates_;
+
+    void mergeAlignedTemplates(std::vector<BarcodeAlignmentModel> &alignedTemplates);
+
     template <typename MatchFinderT>
     void collectModels(
         const unsigned clusterRangeBegin,
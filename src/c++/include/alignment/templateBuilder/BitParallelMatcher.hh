@@ -0,0 +1,98 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BitParallelMatcher.hh
+ **
+ ** \brief Myers bit-vector approximate matching of a read against a reference window
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_ALIGNMENT_TEMPLATE_BUILDER_BIT_PARALLEL_MATCHER_HH
+#define iSAAC_ALIGNMENT_TEMPLATE_BUILDER_BIT_PARALLEL_MATCHER_HH
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "reference/Contig.hh"
+
+namespace isaac
+{
+namespace alignment
+{
+namespace templateBuilder
+{
+
+/**
+ ** \brief Finds all placements of a pattern in a text within an edit distance budget.
+ **
+ ** Myers' bit-vector algorithm with Hyyro's multi-word blocks. Each 64-bit word covers 64 pattern bases, so
+ ** the cost per text base is proportional to ceil(patternLength / 64). Pattern bases are free to align anywhere
+ ** in the text (semi-global: all pattern bases must be consumed, text ends are free).
+ **
+ ** Note: non-copyable because of the dynamically-allocated internal buffers.
+ **/
+class BitParallelMatcher: boost::noncopyable
+{
+public:
+    typedef uint64_t Word;
+    static const unsigned WORD_BITS = sizeof(Word) * 8;
+
+    struct Placement
+    {
+        Placement(const unsigned end, const unsigned edits) : end_(end), edits_(edits){}
+        // offset of the last text base covered by the pattern
+        unsigned end_;
+        unsigned edits_;
+    };
+    typedef std::vector<Placement> Placements;
+
+    explicit BitParallelMatcher(const unsigned patternLengthMax);
+
+    /**
+     * \brief Prepare the match masks for the pattern. Bases other than ACGT mismatch everything.
+     */
+    void setPattern(const std::vector<char> &pattern);
+
+    /**
+     * \brief Scans the text once and stores the best placement of each run of consecutive text positions
+     *        where the pattern ends within editsMax edits.
+     *
+     * \param placements  receives at most placements.capacity() placements. The scan stops when it is full.
+     *
+     * \return number of placements found
+     */
+    std::size_t scan(
+        const reference::Contig::const_iterator textBegin,
+        const reference::Contig::const_iterator textEnd,
+        const unsigned editsMax,
+        Placements &placements);
+
+    unsigned getPatternLength() const {return patternLength_;}
+
+private:
+    // A, C, G, T. Anything else gets an empty mask
+    static const unsigned ALPHABET_SIZE = 4;
+    unsigned patternLength_;
+    unsigned blocks_;
+    std::vector<Word> peq_;
+    std::vector<Word> pv_;
+    std::vector<Word> mv_;
+
+    static int advanceBlock(const int hin, Word &pv, Word &mv, Word eq, const Word scoreBit);
+};
+
+} // namespace templateBuilder
+} // namespace alignment
+} // namespace isaac
+
+#endif // #ifndef iSAAC_ALIGNMENT_TEMPLATE_BUILDER_BIT_PARALLEL_MATCHER_HH
@@ -136,6 +136,8 @@ public:
         FragmentCallbackT callback) const;
 
 
+    std::size_t getRepeatProbesAvoided() const {return repeatProbesAvoided_;}
+
     bool realignBadUngappedAlignments(
         const reference::ContigList &contigList,
         const flowcell::ReadMetadata &readMetadata,
@@ -175,6 +177,8 @@ private:
     mutable ReferenceOffsetLists fwMergeBuffers_;
     mutable ReferenceOffsetLists rvMergeBuffers_;
     mutable MatchLists matchLists_;
+    // seeds for which the repeat filter saved the hash table probes. Grows over the lifetime of the object
+    mutable std::size_t repeatProbesAvoided_;
     struct BestMatch
     {
         BestMatch (const Match &match, const unsigned mismatches):
@@ -299,7 +303,8 @@ AlignmentType FragmentBuilder::buildBest(
     fragments.clear();
     ISAAC_ASSERT_MSG(!matchLists_.empty(), "empty matches lists");
     const std::size_t uncheckedSeeds = matchFinder.findReadMatches(
-        contigList, cluster, readMetadata, seedRepeatThreshold, matchLists_, fwMergeBuffers_, rvMergeBuffers_);
+        contigList, cluster, readMetadata, seedRepeatThreshold, matchLists_, fwMergeBuffers_, rvMergeBuffers_,
+        repeatProbesAvoided_);
 
     const AlignmentType ret = findBestAlignments(
         contigList, readMetadata, adapterClipper, cluster, withGaps, matchLists_, uncheckedSeeds, fragments);
@@ -333,7 +338,8 @@ AlignmentType FragmentBuilder::buildAllHeadAnchored(
 
     const std::size_t uncheckedSeeds = matchFinder.findHeadAnchoredReadMatches(
         contigList,
-        cluster, readMetadata, filterContigId, seedRepeatThreshold, headLengthMax, matchLists_, fwMergeBuffers_, rvMergeBuffers_);
+        cluster, readMetadata, filterContigId, seedRepeatThreshold, headLengthMax, matchLists_, fwMergeBuffers_, rvMergeBuffers_,
+        repeatProbesAvoided_);
 
     std::size_t count = 0;
     for (unsigned supportingSeeds = matchLists_.size() - 1; 0 != supportingSeeds; --supportingSeeds)
@@ -29,6 +29,7 @@
 #include "alignment/Cluster.hh"
 #include "alignment/SequencingAdapter.hh"
 #include "alignment/TemplateLengthStatistics.hh"
+#include "alignment/templateBuilder/BitParallelMatcher.hh"
 #include "alignment/templateBuilder/GappedAligner.hh"
 #include "alignment/templateBuilder/UngappedAligner.hh"
 
@@ -53,6 +54,10 @@ public:
     /**
      ** \brief Construct a ShadowAligner for a reference genome and a given
      ** set of reads.
+     **
+     ** \param bitParallelShadowRescue when set, candidate positions are found by scanning the mate window with
+     **                                the bit-parallel matcher within gappedMismatchesMax edits instead of by
+     **                                exact SHADOW_KMER_LENGTH-mer matches
      **/
     ShadowAligner(
         const bool collectMismatchCycles,
@@ -63,7 +68,8 @@ public:
         const bool noSmithWaterman,
         const bool splitAlignments,
         const AlignmentCfg &alignmentCfg,
-        Cigar &cigarBuffer);
+        Cigar &cigarBuffer,
+        const bool bitParallelShadowRescue = false);
     /**
      ** \brief Helper method to align the shadow of an orphan.
      **
@@ -102,6 +108,7 @@ private:
     const unsigned smitWatermanGapsMax_;
     const bool noSmithWaterman_;
     const bool splitAlignments_;
+    const bool bitParallelShadowRescue_;
     const flowcell::FlowcellLayoutList &flowcellLayoutList_;
     const templateBuilder::UngappedAligner ungappedAligner_;
     Cigar &cigarBuffer_;
@@ -130,6 +137,8 @@ private:
      ** to the beginning of the reference).
      **/
     std::vector<int64_t> shadowCandidatePositions_;
+    BitParallelMatcher bitParallelMatcher_;
+    BitParallelMatcher::Placements bitParallelPlacements_;
     /// Find all candidate positions for a shadow sequence on a given reference interval
     bool findShadowCandidatePositions(
         const std::pair<int64_t, int64_t> &alignmentStartPositionRange,
@@ -138,6 +147,14 @@ private:
         const reference::Contig::const_iterator referenceEnd,
         const std::vector<char> &shadowSequence,
         std::vector<int64_t> &shadowCandidatePositions);
+    /// Same as above, but allows up to gappedMismatchesMax_ edits between the shadow and the reference
+    bool findBitParallelShadowCandidatePositions(
+        const std::pair<int64_t, int64_t> &alignmentStartPositionRange,
+        const int64_t referenceOffset,
+        const reference::Contig::const_iterator referenceBegin,
+        const reference::Contig::const_iterator referenceEnd,
+        const std::vector<char> &shadowSequence,
+        std::vector<int64_t> &shadowCandidatePositions);
     bool findShadowCandidatePositions(
         const FragmentMetadata& orphan,
         const TemplateLengthStatistics& templateLengthStatistics,
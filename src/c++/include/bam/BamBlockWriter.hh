@@ -0,0 +1,251 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BamBlockWriter.hh
+ **
+ ** \brief Encodes bam records directly into memory blocks sized for bgzf compression.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BAM_BAM_BLOCK_WRITER_HH
+#define iSAAC_BAM_BAM_BLOCK_WRITER_HH
+
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include "bam/Bam.hh"
+#include "bgzf/BgzfCompressor.hh"
+
+namespace isaac
+{
+namespace bam
+{
+
+/**
+ * \brief Block sink writing into std::ostream
+ */
+class StreamBlockSink
+{
+    std::ostream *os_;
+public:
+    explicit StreamBlockSink(std::ostream &os) : os_(&os){}
+    void operator()(const char *block, const std::size_t size) const
+    {
+        serialize(*os_, block, size);
+    }
+};
+
+/**
+ * \brief Encodes complete bam records into a contiguous block of memory. The block is handed to the
+ *        sink in a single call once the next record does not fit, so the per-field stream overhead
+ *        of serializeAlignment is paid once per block instead.
+ *
+ *        Produces exactly the same bytes as serializeAlignment.
+ *
+ * \param SinkT callable as sink(const char *block, std::size_t size)
+ */
+template <typename SinkT>
+class BamBlockWriter
+{
+public:
+    // a full block compresses into one bgzf block
+    static const unsigned BLOCK_CAPACITY = bgzf::BgzfCompressor::max_uncompressed_per_block_;
+
+    explicit BamBlockWriter(const SinkT &sink) : sink_(sink), size_(0)
+    {
+    }
+
+    /**
+     * \brief allocates the block upfront. Otherwise it gets allocated on first write
+     */
+    void reserve()
+    {
+        block_.resize(BLOCK_CAPACITY);
+    }
+
+    /**
+     * \return number of bytes the record occupies in bam. Same as serializeAlignment
+     */
+    template <typename T>
+    unsigned write(T &alignment);
+
+    /**
+     * \brief hands the buffered records to the sink
+     */
+    void flush()
+    {
+        if (size_)
+        {
+            sink_(&block_.front(), size_);
+            size_ = 0;
+        }
+    }
+
+private:
+    SinkT sink_;
+    std::vector<char> block_;
+    std::size_t size_;
+
+    char *allocateRecord(const std::size_t bytes)
+    {
+        if (block_.size() < size_ + bytes)
+        {
+            flush();
+            block_.resize(std::max<std::size_t>(BLOCK_CAPACITY, bytes));
+        }
+        char *ret = block_.data() + size_;
+        size_ += bytes;
+        return ret;
+    }
+
+    static char *put(char *p, const void *bytes, const std::size_t size)
+    {
+        memcpy(p, bytes, size);
+        return p + size;
+    }
+
+    template <typename IntT>
+    static char *put(char *p, const IntT value)
+    {
+        return put(p, &value, sizeof(value));
+    }
+
+    static char *put(char *p, const iTag &tag)
+    {
+        // tag layout: 2 bytes of tag, type byte, 4-byte value
+        p[0] = tag.tag_[0];
+        p[1] = tag.tag_[1];
+        p[2] = iTag::val_type_;
+        return put(p + 3, tag.value_);
+    }
+
+    static char *put(char *p, const zTag &tag)
+    {
+        p[0] = tag.tag_[0];
+        p[1] = tag.tag_[1];
+        p[2] = zTag::val_type_;
+        return put(p + 3, tag.value_, std::distance(tag.value_, tag.valueEnd_));
+    }
+
+    template <typename IteratorT>
+    static char *put(char *p, const std::pair<IteratorT, IteratorT> &pairBeginEnd)
+    {
+        return put(p, &*pairBeginEnd.first, std::distance(pairBeginEnd.first, pairBeginEnd.second) * sizeof(*pairBeginEnd.first));
+    }
+};
+
+template <typename SinkT>
+template <typename T>
+unsigned BamBlockWriter<SinkT>::write(T &alignment)
+{
+    const int refID(alignment.refId());
+    const int pos(alignment.pos());
+
+    const char *readName = alignment.readName();
+    const std::size_t readNameLength = strlen(readName);
+    ISAAC_ASSERT_MSG(0xFF > readNameLength, "Read name length must fit in 8 bit value");
+
+    const unsigned observedLength = alignment.observedLength();
+    const unsigned bin_mq_nl(unsigned(bam_reg2bin(pos, pos + (observedLength ? observedLength : 1))) << 16 |
+                             unsigned(alignment.mapq()) << 8 |
+                             unsigned(readNameLength + 1));
+
+    typedef typename T::CigarBeginEnd CigarBeginEnd;
+    const CigarBeginEnd cigarBeginEnd = alignment.cigar();
+    const std::size_t cigarLength = std::distance(cigarBeginEnd.first, cigarBeginEnd.second);
+    ISAAC_ASSERT_MSG(0xFFFF >= cigarLength, "Cigar length must fit in 16 bit value");
+
+    const unsigned flag_nc(unsigned (alignment.flag()) << 16 | (unsigned (cigarLength) & 0xFFFF));
+    const int l_seq(alignment.seqLen());
+    const int next_RefID(alignment.nextRefId());
+    const int next_pos(alignment.nextPos());
+    const int tlen(alignment.tlen());
+
+    const typename T::SeqBeginEnd seqBeginEnd = alignment.seq();
+    const std::size_t seqLength = std::distance(seqBeginEnd.first, seqBeginEnd.second);
+
+    const typename T::QualBeginEnd qualBeginEnd = alignment.qual();
+    const std::size_t qualLength = std::distance(qualBeginEnd.first, qualBeginEnd.second);
+
+    // same tag order as serializeAlignment
+    const iTag fragmentSM = alignment.getFragmentSM();
+    const iTag fragmentAS = alignment.getFragmentAS();
+    const zTag fragmentRG = alignment.getFragmentRG();
+    const iTag fragmentNM = alignment.getFragmentNM();
+    const zTag fragmentBC = alignment.getFragmentBC();
+    const zTag fragmentOC = alignment.getFragmentOC();
+    const iTag fragmentOP = alignment.getFragmentOP();
+    const iTag fragmentZX = alignment.getFragmentZX();
+    const iTag fragmentZY = alignment.getFragmentZY();
+    const zTag fragmentSA = alignment.getFragmentSA();
+
+    const int block_size(  sizeof(refID)
+                           + sizeof(pos)
+                           + sizeof(bin_mq_nl)
+                           + sizeof(flag_nc)
+                           + sizeof(l_seq)
+                           + sizeof(next_RefID)
+                           + sizeof(next_pos)
+                           + sizeof(tlen)
+                           + readNameLength + 1
+                           + cigarLength * sizeof(unsigned)
+                           + seqLength
+                           + qualLength
+                           + fragmentSM.size()
+                           + fragmentAS.size()
+                           + fragmentNM.size()
+                           + fragmentBC.size()
+                           + fragmentRG.size()
+                           + fragmentOC.size()
+                           + fragmentOP.size()
+                           + fragmentZX.size()
+                           + fragmentZY.size()
+                           + fragmentSA.size());
+
+    char *p = allocateRecord(block_size + sizeof(block_size));
+    p = put(p, block_size);
+    p = put(p, refID);
+    p = put(p, pos);
+    p = put(p, bin_mq_nl);
+    p = put(p, flag_nc);
+    p = put(p, l_seq);
+    p = put(p, next_RefID);
+    p = put(p, next_pos);
+    p = put(p, tlen);
+
+    p = put(p, readName, readNameLength + 1);
+    p = put(p, cigarBeginEnd);
+    p = put(p, seqBeginEnd);
+    p = put(p, qualBeginEnd);
+
+    if (!fragmentSM.empty()) {p = put(p, fragmentSM);}
+    if (!fragmentAS.empty()) {p = put(p, fragmentAS);}
+    if (!fragmentRG.empty()) {p = put(p, fragmentRG);}
+    if (!fragmentNM.empty()) {p = put(p, fragmentNM);}
+    if (!fragmentBC.empty()) {p = put(p, fragmentBC);}
+    if (!fragmentOC.empty()) {p = put(p, fragmentOC);}
+    if (!fragmentOP.empty()) {p = put(p, fragmentOP);}
+    if (!fragmentZX.empty()) {p = put(p, fragmentZX);}
+    if (!fragmentZY.empty()) {p = put(p, fragmentZY);}
+    if (!fragmentSA.empty()) {p = put(p, fragmentSA);}
+
+    ISAAC_ASSERT_MSG(block_.data() + size_ == p, "Encoded record size does not match the computed block_size");
+    return block_size + sizeof(block_size);
+}
+
+} //namespace bam
+} // namespace isaac
+
+
+#endif // iSAAC_BAM_BAM_BLOCK_WRITER_HH
@@ -652,6 +652,8 @@ class BamIndexPart
 public:
     BamIndexPart();
     void processFragment( const build::FragmentAccessorBamAdapter& alignment, uint32_t serializedLength );
+    void processFragment( const int pos, const int refId, const uint32_t seqLen, const uint32_t observedLength,
+                          const bool unmapped, const uint32_t serializedLength );
 
 //private:
     void initStructures();
@@ -0,0 +1,99 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BgzfBlockCompressor.hh
+ **
+ ** \brief Compresses memory blocks into complete bgzf blocks going directly to zlib deflate.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BGZF_BGZF_BLOCK_COMPRESSOR_HH
+#define iSAAC_BGZF_BGZF_BLOCK_COMPRESSOR_HH
+
+#include <zlib.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "bgzf/Bgzf.hh"
+#include "bgzf/BgzfCompressor.hh"
+#include "common/Exceptions.hh"
+
+namespace isaac
+{
+namespace bgzf
+{
+
+/**
+ ** \brief Exception thrown when a zlib deflate method invocation fails.
+ **
+ **/
+class BgzfDeflateException: public common::IsaacException
+{
+public:
+    BgzfDeflateException(int error, z_stream &strm) : IsaacException(EINVAL, strm.msg ? strm.msg : "unknown error " + boost::lexical_cast<std::string>(error))
+    {
+
+    }
+};
+
+/**
+ * \brief Unlike BgzfCompressor, does not need a stream chain. Each call produces self-contained bgzf blocks,
+ *        so blocks compressed by different threads can be concatenated in any order the caller needs.
+ */
+class BgzfBlockCompressor: boost::noncopyable
+{
+public:
+    // bgzf blocks cannot be longer than 64 kilobytes
+    static const unsigned BGZF_BLOCK_SIZE_MAX = 0x10000;
+    static const unsigned UNCOMPRESSED_PER_BLOCK_MAX = BgzfCompressor::max_uncompressed_per_block_;
+
+    explicit BgzfBlockCompressor(const int level);
+    ~BgzfBlockCompressor();
+
+    /**
+     * \brief Appends to out as many bgzf blocks as needed to hold size bytes of data
+     */
+    template <typename ContainerT>
+    void compress(const char *data, std::size_t size, ContainerT &out)
+    {
+        while (size)
+        {
+            std::size_t blockData = std::min<std::size_t>(size, UNCOMPRESSED_PER_BLOCK_MAX);
+            std::size_t blockSize = compressBlock(data, blockData);
+            // incompressible data does not fit. Retry with less
+            while (!blockSize)
+            {
+                blockData /= 2;
+                blockSize = compressBlock(data, blockData);
+            }
+            out.insert(out.end(), block_, block_ + blockSize);
+            data += blockData;
+            size -= blockData;
+        }
+    }
+
+private:
+    z_stream strm_;
+    char block_[BGZF_BLOCK_SIZE_MAX];
+
+    /**
+     * \return size of the bgzf block in block_ or 0 if the compressed data does not fit
+     */
+    std::size_t compressBlock(const char *data, const std::size_t size);
+};
+
+} // namespace bgzf
+} // namespace isaac
+
+#endif // iSAAC_BGZF_BGZF_BLOCK_COMPRESSOR_HH
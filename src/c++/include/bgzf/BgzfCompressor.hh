@@ -21,6 +21,8 @@
 #ifndef iSAAC_BGZF_BGZF_COMPRESSOR_HH
 #define iSAAC_BGZF_BGZF_COMPRESSOR_HH
 
+#include <vector>
+
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
@@ -81,7 +83,7 @@ private:
     size_t uncompressed_in_;
 };
 
-void BgzfCompressor::rewriteHeader()
+inline void BgzfCompressor::rewriteHeader()
 {
     memmove(&bgzf_buffer[0], &bgzf_buffer[sizeof(BAM_XFIELD)], sizeof(Header) - sizeof(BAM_XFIELD));
     Header *h(reinterpret_cast<Header*>(&bgzf_buffer[0]));
@@ -89,7 +91,7 @@ void BgzfCompressor::rewriteHeader()
     h->FLG |= 0x04; // tell gzip that XLEN is in effect now.
 }
 
-void BgzfCompressor::initBuffer()
+inline void BgzfCompressor::initBuffer()
 {
     bgzf_buffer.clear();
     uncompressed_in_ = 0;
@@ -99,7 +101,7 @@ void BgzfCompressor::initBuffer()
 
 }
 
-BgzfCompressor::BgzfCompressor(const bios::gzip_params& gzip_params):
+inline BgzfCompressor::BgzfCompressor(const bios::gzip_params& gzip_params):
     gzip_params_(gzip_params),
     compressor_(gzip_params_,65535),
     uncompressed_in_(0)
@@ -108,7 +110,7 @@ BgzfCompressor::BgzfCompressor(const bios::gzip_params& gzip_params):
     initBuffer();
 }
 
-BgzfCompressor::BgzfCompressor(const BgzfCompressor& that):
+inline BgzfCompressor::BgzfCompressor(const BgzfCompressor& that):
     gzip_params_(that.gzip_params_),
     compressor_(gzip_params_,65535),
     uncompressed_in_(0)
@@ -153,7 +155,7 @@ std::streamsize BgzfCompressor::write(Sink &snk, const char* s, std::streamsize
     return src_size;
 }
 
-void BgzfCompressor::close()
+inline void BgzfCompressor::close()
 {
 }
 
@@ -47,32 +47,6 @@ public:
             barcodeOutputFileIndexMap_(barcodeOutputFileIndexMap)
     {}
 
-    void storeAligned(
-        const io::FragmentAccessor &fragment,
-        boost::ptr_vector<boost::iostreams::filtering_ostream> &streams,
-        boost::ptr_vector<bam::BamIndexPart> &bamIndexParts,
-        FragmentAccessorBamAdapter& adapter)
-    {
-        unsigned serializedLength = bam::serializeAlignment(
-            streams.at(barcodeOutputFileIndexMap_.at(fragment.barcode_)), adapter);
-        bam::BamIndexPart& bamIndexPart = bamIndexParts.at(barcodeOutputFileIndexMap_.at(fragment.barcode_));
-        bamIndexPart.processFragment( adapter, serializedLength );
-//        ISAAC_THREAD_CERR << "Serialized to bam pos_: " << idx.pos_ << " dataOffset_: " << idx.dataOffset_ << std::endl;
-    }
-
-    void storeUnaligned(
-        const io::FragmentAccessor &fragment,
-        boost::ptr_vector<boost::iostreams::filtering_ostream> &streams,
-        boost::ptr_vector<bam::BamIndexPart> &bamIndexParts,
-        FragmentAccessorBamAdapter& adapter)
-    {
-//        ISAAC_THREAD_CERR << "Serialized unaligned pos_: " << fragment << std::endl;
-        unsigned serializedLength = bam::serializeAlignment(
-            streams.at(barcodeOutputFileIndexMap_.at(fragment.barcode_)), adapter);
-        bam::BamIndexPart& bamIndexPart = bamIndexParts.at(barcodeOutputFileIndexMap_.at(fragment.barcode_));
-        bamIndexPart.processFragment( adapter, serializedLength );
-    }
-
     void prepareForBam(
         const reference::ContigList &contigList,
         PackedFragmentBuffer &data,
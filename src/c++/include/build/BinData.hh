@@ -30,6 +30,7 @@
 #include "alignment/BinMetadata.hh"
 #include "build/FragmentAccessorBamAdapter.hh"
 #include "build/FragmentIndex.hh"
+#include "build/KnownIndels.hh"
 #include "build/PackedFragmentBuffer.hh"
 #include "build/gapRealigner/RealignerGaps.hh"
 #include "io/FileBufCache.hh"
@@ -66,7 +67,7 @@ public:
         const flowcell::BarcodeMetadataList &barcodeMetadataList,
         const build::GapRealignerMode realignGaps,
         const unsigned realignMapqMin,
-        const gapRealigner::Gaps &knownIndels,
+        const KnownIndels &knownIndels,
         const alignment::BinMetadata &bin,
         const unsigned binStatsIndex,
         const flowcell::TileMetadataList &tileMetadataList,
@@ -184,7 +185,7 @@ public:
     PackedFragmentBuffer data_;
     const GapRealignerMode realignGaps_;
     const unsigned realignMapqMin_;
-    const gapRealigner::Gaps &knownIndels_;
+    const KnownIndels &knownIndels_;
     alignment::Cigar additionalCigars_;
 
     SplitInfoList splitInfoList_;
@@ -195,7 +196,7 @@ public:
 private:
     void reserveGaps(
         const alignment::BinMetadata& bin,
-        const gapRealigner::Gaps &knownIndels,
+        const KnownIndels &knownIndels,
         const flowcell::BarcodeMetadataList &barcodeMetadataList);
 
     unsigned getGapGroupIndex(const unsigned barcode) const;
@@ -68,10 +68,10 @@ public:
         BinData &binData,
         BuildStats &buildStats);
 
-    std::size_t serialize(
-        BinData &binData,
-        boost::ptr_vector<boost::iostreams::filtering_ostream> &bgzfStreams,
-        boost::ptr_vector<bam::BamIndexPart> &bamIndexParts);
+    /**
+     * \brief Splits and orders the bin index the way records need to appear in bam
+     */
+    void prepareForSerialization(BinData &binData);
 
 private:
     const bool singleLibrarySamples_;
@@ -31,6 +31,8 @@
 #include "build/BinSorter.hh"
 #include "build/BuildStats.hh"
 #include "build/BuildContigMap.hh"
+#include "build/ParallelBinSerializer.hh"
+#include "build/SortedRunMerger.hh"
 #include "common/Threads.hpp"
 #include "flowcell/BarcodeMetadata.hh"
 #include "flowcell/Layout.hh"
@@ -60,6 +62,8 @@ class Build
     unsigned maxLoaders_;
     unsigned maxComputers_;
     unsigned allocatedBins_;
+    // number of bins stored as sorted runs
+    std::size_t storedRunBins_;
     std::vector<unsigned> computeSlotWaitingBins_;
     const unsigned maxSavers_;
     const int bamGzipLevel_;
@@ -103,13 +107,13 @@ class Build
     typedef std::vector<bam::BgzfBuffer> BgzfBuffers;
     typedef std::vector<BgzfBuffers> ThreadBgzfBuffers;
     ThreadBgzfBuffers threadBgzfBuffers_;
-    // Geometry: [thread][bam file]. Streams for compressing bam data into threadBgzfBuffers_
-    boost::ptr_vector<boost::ptr_vector<boost::iostreams::filtering_ostream> > threadBgzfStreams_;
     boost::ptr_vector<boost::ptr_vector<bam::BamIndexPart> > threadBamIndexParts_;
 
-    const build::gapRealigner::Gaps knownIndels_;
+    const KnownIndels knownIndels_;
     ParallelGapRealigner gapRealigner_;
     BinSorter binSorter_;
+    ParallelBinSerializer binSerializer_;
+    SortedRunMerger runMerger_;
 
     struct Task
     {
@@ -140,6 +144,7 @@ public:
           const reference::SortedReferenceMetadataList &sortedReferenceMetadataList,
           const reference::ContigLists &contigLists,
           const boost::filesystem::path outputDirectory,
+          const boost::filesystem::path &tempDirectory,
           const unsigned maxLoaders,
           const unsigned maxComputers,
           const unsigned maxSavers,
@@ -149,6 +154,7 @@ public:
           const int bamGzipLevel,
           const std::string &bamPuFormat,
           const bool bamProduceMd5,
+          const bool bamMergeRuns,
           const std::vector<std::string> &bamHeaderTags,
           const unsigned expectedCoverage,
           const uint64_t targetBinSize,
@@ -158,6 +164,8 @@ public:
           const bool markDuplicates,
           const bool anchorMate,
           const bool realignGapsVigorously,
+          const GapRealignerEngine realignEngine,
+          const bool realignmentCache,
           const bool realignDodgyFragments,
           const unsigned realignedGapsPerFragment,
           const bool clipSemialigned,
@@ -199,7 +207,6 @@ private:
         const alignment::BinMetadata &bin,
         const unsigned binStatsIndex,
         const reference::ContigLists &contigLists,
-        boost::ptr_vector<boost::iostreams::filtering_ostream> &bgzfStreams,
         boost::ptr_vector<bam::BamIndexPart> &bamIndexParts,
         BgzfBuffers &bgzfBuffers,
         boost::shared_ptr<BinData> &binDataPtr);
@@ -269,6 +276,14 @@ private:
         const boost::filesystem::path &filePath,
         const std::size_t threadNumber);
 
+    void storeRunsAndReleaseBuffers(
+        boost::unique_lock<boost::mutex> &lock,
+        const std::size_t run,
+        common::ScopedMallocBlock &mallocBlock,
+        const std::size_t threadNumber);
+
+    void returnRunSlot(const std::size_t bins, const bool exceptionUnwinding);
+
     void saveBuffer(
         const bam::BgzfBuffer &bgzfBuffer,
         std::ostream &bamStream,
@@ -287,7 +302,6 @@ private:
 
     void cleanupBinAllocationFailure(
         const alignment::BinMetadata& bin,
-        boost::ptr_vector<boost::iostreams::filtering_ostream>& bgzfStreams,
         boost::ptr_vector<bam::BamIndexPart>& bamIndexParts,
         boost::shared_ptr<BinData>& binDataPtr, BgzfBuffers& bgzfBuffers);
 };
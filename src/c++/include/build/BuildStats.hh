@@ -65,10 +65,21 @@ public:
         const alignment::BinMetadataCRefList &binMetadataList,
         const flowcell::BarcodeMetadataList &barcodeMetadataList) :
             barcodeMetadataList_(barcodeMetadataList),
-            binBarcodeStats_(barcodeMetadataList_.size() * binMetadataList.size())
+            binBarcodeStats_(barcodeMetadataList_.size() * binMetadataList.size()),
+            realignmentCacheHits_(0),
+            realignmentCacheMisses_(0)
     {
     }
 
+    void addRealignmentCacheStats(const uint64_t hits, const uint64_t misses)
+    {
+        realignmentCacheHits_ += hits;
+        realignmentCacheMisses_ += misses;
+    }
+
+    uint64_t getRealignmentCacheHits() const {return realignmentCacheHits_;}
+    uint64_t getRealignmentCacheMisses() const {return realignmentCacheMisses_;}
+
     void incrementTotalFragments(
         const unsigned binIndex,
         const unsigned barcodeIndex)
@@ -101,17 +112,23 @@ public:
     {
         std::transform(binBarcodeStats_.begin(), binBarcodeStats_.end(),
                        right.binBarcodeStats_.begin(), binBarcodeStats_.begin(), std::plus<BinBarcodeStats>());
+        addRealignmentCacheStats(right.realignmentCacheHits_, right.realignmentCacheMisses_);
         return *this;
     }
 
     BuildStats & operator =(const BuildStats &that) {
         binBarcodeStats_ = that.binBarcodeStats_;
+        realignmentCacheHits_ = that.realignmentCacheHits_;
+        realignmentCacheMisses_ = that.realignmentCacheMisses_;
         return *this;
     }
 
 private:
     const flowcell::BarcodeMetadataList &barcodeMetadataList_;
     std::vector<BinBarcodeStats>  binBarcodeStats_;
+    // fragments that reused or had to compute the realignment of an identical fragment in the same bin
+    uint64_t realignmentCacheHits_;
+    uint64_t realignmentCacheMisses_;
 
     unsigned binBarcodeIndex(const unsigned binIndex, const unsigned barcodeIndex) const
     {
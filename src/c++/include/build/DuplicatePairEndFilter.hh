@@ -24,6 +24,7 @@
 #include "build/FragmentIndex.hh"
 #include "build/PackedFragmentBuffer.hh"
 #include "common/Debug.hh"
+#include "common/Trace.hh"
 
 namespace isaac
 {
@@ -53,6 +54,7 @@ public:
     {
         if (duplicatesBegin != duplicatesEnd)
         {
+            ISAAC_TRACE_SPAN("dedup");
             // reorder them according to duplicate removal rules
             ISAAC_THREAD_CERR << "Sorting duplicates" << std::endl;
             const clock_t startSort = clock();
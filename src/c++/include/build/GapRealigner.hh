@@ -25,6 +25,7 @@
 #include "alignment/Cigar.hh"
 #include "alignment/TemplateLengthStatistics.hh"
 #include "build/gapRealigner/RealignerGaps.hh"
+#include "build/gapRealigner/RealignmentCache.hh"
 #include "build/PackedFragmentBuffer.hh"
 #include "flowcell/BarcodeMetadata.hh"
 #include "reference/Contig.hh"
@@ -35,6 +36,14 @@ namespace isaac
 namespace build
 {
 
+enum GapRealignerEngine
+{
+    /// evaluate every combination of up to gapsPerFragmentMax candidate gaps
+    REALIGN_ENGINE_COMBINATORIAL,
+    /// align the fragment once to the graph of the reference and the candidate gaps
+    REALIGN_ENGINE_GRAPH
+};
+
 /**
  * \brief Attempts to insert gaps found on other fragments while preserving the ones that
  *        are already there.
@@ -47,7 +56,14 @@ private:
     // number of bits that can represent the on/off state for each gap.
     // Currently unsigned is used to hold the choice
     static const unsigned MAX_GAPS_AT_A_TIME = 64;
-
+    // highest priority candidate gaps considered by the combinatorial engine
+    static const unsigned COMBINATORIAL_GAPS_MAX = 8;
+    // graph engine limits. The search is not allowed to allocate. Paths exceeding the limits are not considered
+    static const unsigned GRAPH_START_DIAGONALS_MAX = MAX_GAPS_AT_A_TIME * 64;
+    static const unsigned GRAPH_NODES_PER_GAP_MAX = 64;
+    static const unsigned GRAPH_NODES_MAX = GRAPH_START_DIAGONALS_MAX + MAX_GAPS_AT_A_TIME * GRAPH_NODES_PER_GAP_MAX;
+
+    const GapRealignerEngine engine_;
     const bool realignGapsVigorously_;
     const bool realignDodgyFragments_;
     const unsigned gapsPerFragmentMax_;
@@ -66,9 +82,47 @@ private:
 
     gapRealigner::RealignerGaps fragmentGaps_;
 
+    gapRealigner::RealignmentCache cache_;
+
+    /**
+     * \brief Point of the gap graph right after a gap has been introduced, or the start of the read
+     */
+    struct GraphNode
+    {
+        // alignment position the read would have if it had no gaps and the current read base stayed where it is
+        int64_t diagonal_;
+        int64_t referencePos_;
+        unsigned readOffset_;
+        // index of the gap introduced last. gaps.size() for the start node
+        unsigned gapIndex_;
+        unsigned gaps_;
+        // true if one of the path segments lies on an original alignment diagonal
+        bool anchored_;
+        unsigned cost_;
+        unsigned editDistance_;
+        unsigned totalPriority_;
+        // index in graphNodes_ of the node this one was reached from. -1U for the start nodes
+        unsigned previous_;
+
+        bool isBetterThan(const GraphNode &that) const
+        {
+            return cost_ < that.cost_ || (cost_ == that.cost_ &&
+                (editDistance_ < that.editDistance_ || (editDistance_ == that.editDistance_ &&
+                    totalPriority_ > that.totalPriority_)));
+        }
+    };
+    std::vector<GraphNode> graphNodes_;
+    // graphNodes_ indexes by the gap introduced last. Last element holds the start nodes
+    std::vector<std::vector<unsigned> > gapGraphNodes_;
+    std::vector<int64_t> anchorDiagonals_;
+    std::vector<int> gapLengths_;
+    std::vector<int64_t> startDiagonals_;
+
 public:
     typedef gapRealigner::Gap GapType;
     GapRealigner(
+        const GapRealignerEngine engine,
+        const bool realignmentCache,
         const bool realignGapsVigorously,
         const bool realignDodgyFragments,
         const unsigned gapsPerFragmentMax,
@@ -76,6 +130,7 @@ public:
         const unsigned gapOpenCost,
         const unsigned gapExtendCost,
         const flowcell::BarcodeMetadataList &barcodeMetadataList):
+            engine_(engine),
             realignGapsVigorously_(realignGapsVigorously),
             realignDodgyFragments_(realignDodgyFragments),
             gapsPerFragmentMax_(gapsPerFragmentMax),
@@ -83,7 +138,8 @@ public:
             mismatchCost_(mismatchCost),
             gapOpenCost_(gapOpenCost),
             gapExtendCost_(gapExtendCost),
-            barcodeMetadataList_(barcodeMetadataList)
+            barcodeMetadataList_(barcodeMetadataList),
+            cache_(realignmentCache)
     {
         reserve();
     }
@@ -93,8 +149,26 @@ public:
         currentAttemptGaps_.reserve(MAX_GAPS_AT_A_TIME * 10);
         // number of existing gaps to be expected in one fragment. No need to be particularly precise.
         fragmentGaps_.reserve(currentAttemptGaps_.capacity());
+        if (REALIGN_ENGINE_GRAPH == engine_)
+        {
+            graphNodes_.reserve(GRAPH_NODES_MAX);
+            gapGraphNodes_.resize(MAX_GAPS_AT_A_TIME + 1);
+            for (unsigned gapIndex = 0; MAX_GAPS_AT_A_TIME != gapIndex; ++gapIndex)
+            {
+                gapGraphNodes_[gapIndex].reserve(GRAPH_NODES_PER_GAP_MAX);
+            }
+            // start nodes
+            gapGraphNodes_[MAX_GAPS_AT_A_TIME].reserve(GRAPH_START_DIAGONALS_MAX);
+            anchorDiagonals_.reserve(MAX_GAPS_AT_A_TIME);
+            gapLengths_.reserve(MAX_GAPS_AT_A_TIME);
+            startDiagonals_.reserve(GRAPH_START_DIAGONALS_MAX);
+        }
+        cache_.reserve();
     }
 
+    uint64_t getCacheHits() const {return cache_.getHits();}
+    uint64_t getCacheMisses() const {return cache_.getMisses();}
+
     bool realign(
         const gapRealigner::RealignerGaps &realignerGaps,
         const reference::ReferencePosition binStartPos,
@@ -253,6 +327,42 @@ private:
         unsigned &leftToEvaluate,
         GapChoice &bestChoice);
 
+    bool findBestGapsPath(
+        const gapRealigner::GapsRange& gaps,
+        const reference::ReferencePosition& binStartPos,
+        const reference::ReferencePosition& binEndPos,
+        const reference::ContigList& reference,
+        const io::FragmentAccessor& fragment,
+        const PackedFragmentBuffer::Index& index,
+        GapChoice &bestChoice);
+
+    void collectStartDiagonals(
+        const gapRealigner::GapsRange& gaps,
+        const reference::ReferencePosition& binStartPos,
+        const reference::ReferencePosition& binEndPos);
+
+    void extendGraphNode(
+        const unsigned nodeIndex,
+        const unsigned nextGapIndex,
+        const gapRealigner::GapsRange& gaps,
+        const reference::Contig& contig,
+        const reference::ContigList& reference,
+        const io::FragmentAccessor& fragment);
+
+    bool finishGraphPath(
+        const GraphNode &node,
+        const reference::Contig& contig,
+        const reference::ContigList& reference,
+        const io::FragmentAccessor& fragment,
+        GraphNode &finished) const;
+
+    uint64_t makeCacheKey(
+        const reference::ReferencePosition binStartPos,
+        const reference::ReferencePosition binEndPos,
+        const io::FragmentAccessor &fragment,
+        const PackedFragmentBuffer::Index &index,
+        const gapRealigner::GapsRange &gaps) const;
+
     int64_t undoExistingGaps(const PackedFragmentBuffer::Index& index,
                           const reference::ReferencePosition& pivotPos);
 
@@ -30,6 +30,13 @@ namespace isaac
 namespace build
 {
 
+/**
+ * \brief Reads indels from a plain, gzip or bgzip compressed vcf file
+ */
+build::gapRealigner::Gaps loadIndels(
+    const boost::filesystem::path &vcfFilePath,
+    const reference::SortedReferenceMetadata &sortedReferenceMetadata);
+
 build::gapRealigner::Gaps loadIndels(
     const boost::filesystem::path &vcfFilePath,
     const reference::SortedReferenceMetadataList &sortedReferenceMetadataList);
@@ -0,0 +1,158 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file KnownIndels.hh
+ **
+ ** Memory-mapped store of known indels sorted by position.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BUILD_KNOWN_INDELS_HH
+#define iSAAC_BUILD_KNOWN_INDELS_HH
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "build/gapRealigner/Gap.hh"
+#include "reference/SortedReferenceMetadata.hh"
+
+namespace isaac
+{
+namespace build
+{
+
+namespace knownIndels
+{
+
+/**
+ * \brief Layout of the store file: Header, ContigEntry[contigCount_], uint64_t blockStarts[],
+ *        Record[records_]. Records are sorted by ReferencePosition which partitions them by contig.
+ *        blockStarts hold the index of the first record at or after each BLOCK_BASES boundary
+ *        of each contig so that finding the records of a bin does not require a search over the
+ *        whole file.
+ */
+struct Header
+{
+    char magic_[8];
+    uint32_t version_;
+    uint32_t contigCount_;
+    // hash of the names and lengths of the reference contigs the record positions refer to
+    uint64_t referenceFingerprint_;
+    // size and modification time of the vcf the store was produced from
+    uint64_t sourceSize_;
+    int64_t sourceMtime_;
+    uint64_t records_;
+    uint64_t blocks_;
+    // longest deletion in the store. Bounds the look-back for deletions ending in a bin
+    uint64_t maxDeletionLength_;
+};
+
+struct ContigEntry
+{
+    uint64_t firstBlock_;
+    uint64_t blocks_;
+    // index of the first record past this contig
+    uint64_t recordsEnd_;
+};
+
+struct Record
+{
+    reference::ReferencePosition::value_type pos_;
+    int64_t length_;
+};
+
+} // namespace knownIndels
+
+class KnownIndels: boost::noncopyable
+{
+public:
+    static const char MAGIC[8];
+    static const uint32_t VERSION = 1;
+    static const unsigned BLOCK_BASES_BITS = 20;
+
+    /// no known indels
+    KnownIndels();
+
+    /**
+     * \brief Maps the store. If path is a vcf (optionally gzip or bgzip compressed), converts it first into
+     *        <path>.isaac-indels or, if that cannot be written, into fallbackDirectory. Conversion happens only
+     *        once, subsequent runs with the same vcf and reference map the existing store.
+     */
+    KnownIndels(
+        const boost::filesystem::path &path,
+        const reference::SortedReferenceMetadataList &sortedReferenceMetadataList,
+        const boost::filesystem::path &fallbackDirectory);
+
+    bool empty() const {return !size();}
+    std::size_t size() const {return recordsEnd_ - recordsBegin_;}
+
+    /**
+     * \brief calls callback(gap) for each known indel that begins or ends within [binStart, binEnd)
+     */
+    template <typename CallbackT>
+    void forEachOverlapping(
+        const reference::ReferencePosition binStart,
+        const reference::ReferencePosition binEnd,
+        CallbackT callback) const
+    {
+        for (const knownIndels::Record *record = findFirst(binStart);
+            recordsEnd_ != record && reference::ReferencePosition(record->pos_) < binEnd; ++record)
+        {
+            const gapRealigner::Gap gap(reference::ReferencePosition(record->pos_), record->length_);
+            if ((gap.getBeginPos() >= binStart && gap.getBeginPos() < binEnd) ||
+                (gap.getEndPos(false) >= binStart && gap.getEndPos(false) < binEnd))
+            {
+                callback(gap);
+            }
+        }
+    }
+
+    static uint64_t getReferenceFingerprint(const reference::SortedReferenceMetadata &sortedReferenceMetadata);
+
+    /**
+     * \brief Loads the vcf and stores the indels in the binary format
+     */
+    static void convert(
+        const boost::filesystem::path &vcfPath,
+        const reference::SortedReferenceMetadata &sortedReferenceMetadata,
+        const boost::filesystem::path &storePath);
+
+    /// true if the file starts with the store magic
+    static bool isStore(const boost::filesystem::path &path);
+
+    /**
+     * \brief true if storePath is a store of the current version converted from the vcf as it is now for the
+     *        reference with the referenceFingerprint
+     */
+    static bool isUpToDate(
+        const boost::filesystem::path &storePath,
+        const boost::filesystem::path &vcfPath,
+        const uint64_t referenceFingerprint);
+
+private:
+    boost::iostreams::mapped_file_source file_;
+    const knownIndels::Header *header_;
+    const knownIndels::ContigEntry *contigs_;
+    const uint64_t *blockStarts_;
+    const knownIndels::Record *recordsBegin_;
+    const knownIndels::Record *recordsEnd_;
+
+    void map(const boost::filesystem::path &storePath);
+    const knownIndels::Record *findFirst(const reference::ReferencePosition binStart) const;
+};
+
+} // namespace build
+} // namespace isaac
+
+#endif // #ifndef iSAAC_BUILD_KNOWN_INDELS_HH
@@ -0,0 +1,203 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file ParallelBinSerializer.hh
+ **
+ ** Serializes a single bin into bgzf-compressed bam data on multiple threads.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BUILD_PARALLEL_BIN_SERIALIZER_HH
+#define iSAAC_BUILD_PARALLEL_BIN_SERIALIZER_HH
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread.hpp>
+
+#include "bam/BamBlockWriter.hh"
+#include "bam/BamIndexer.hh"
+#include "bgzf/BgzfBlockCompressor.hh"
+#include "build/BinData.hh"
+#include "demultiplexing/BarcodePathMap.hh"
+
+namespace isaac
+{
+namespace build
+{
+
+/**
+ * \brief Splits the sorted bin index into contiguous chunks. Each chunk is encoded and bgzf-compressed by
+ *        whichever thread claims it. Chunks are appended to the bin bgzf buffers and bam index parts strictly
+ *        in order, so the result is a valid bam stream with the same records and index as the sequential
+ *        serialization. The only difference is a partially filled bgzf block at the end of each chunk.
+ *        A chunk that outgrows the thread buffers waits for its turn and gets stored in parts.
+ */
+class ParallelBinSerializer
+{
+public:
+    typedef std::vector<bam::BgzfBuffer> BgzfBuffers;
+
+    /**
+     * \brief Progress of a bin serialization shared by all threads that join it
+     */
+    struct BinState
+    {
+        BinState(
+            BinData &binData,
+            BgzfBuffers &bgzfBuffers,
+            boost::ptr_vector<bam::BamIndexPart> &bamIndexParts) :
+                binData_(binData), bgzfBuffers_(bgzfBuffers), bamIndexParts_(bamIndexParts),
+                nextUnprocessed_(binData.indexBegin()), nextUnprocessedOffset_(0),
+                nextChunk_(0), nextChunkToStore_(0), failed_(false)
+        {
+        }
+
+        BinData &binData_;
+        BgzfBuffers &bgzfBuffers_;
+        boost::ptr_vector<bam::BamIndexPart> &bamIndexParts_;
+        // aligned bins are claimed by index position
+        BinData::iterator nextUnprocessed_;
+        // unaligned bins don't have index and are claimed by data offset
+        uint64_t nextUnprocessedOffset_;
+        unsigned nextChunk_;
+        unsigned nextChunkToStore_;
+        // set when one of the threads fails so that the rest don't wait for the chunk that will never be stored
+        bool failed_;
+    };
+
+    ParallelBinSerializer(
+        const unsigned threads,
+        const unsigned outputFiles,
+        const int bamGzipLevel,
+        const demultiplexing::BarcodePathMap::BarcodeSampleIndexMap &barcodeOutputFileIndexMap);
+
+    /**
+     * \brief Processes chunks of the bin until there are none left. Expects lock to be held on entry and
+     *        returns with lock held.
+     */
+    void threadSerialize(boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned threadNumber);
+
+    /**
+     * \brief Extra compressed bytes an output file can get due to the bin being split into chunks
+     */
+    static uint64_t estimateChunkingOverhead(const uint64_t binRecords)
+    {
+        return (binRecords / CHUNK_RECORDS + 1) * PARTIAL_BLOCK_OVERHEAD;
+    }
+
+private:
+    static const std::size_t CHUNK_RECORDS = 16384;
+    // bgzf header and footer of the partial block at the end of a chunk plus the loss of compression context
+    static const std::size_t PARTIAL_BLOCK_OVERHEAD = 1024;
+    // size of per-thread compressed data buffers. Enough for a chunk of typical short reads. Chunks that don't fit
+    // get stored in parts
+    static const std::size_t THREAD_COMPRESSED_RESERVE = 4 * 1024 * 1024;
+    // incompressible data of one bam block gets split into two bgzf blocks
+    static const std::size_t COMPRESSED_PER_BLOCK_MAX = 2 * bgzf::BgzfBlockCompressor::BGZF_BLOCK_SIZE_MAX;
+
+    /**
+     * \brief What it takes to replay the record in BamIndexPart once the chunk gets stored
+     */
+    struct IndexRecord
+    {
+        unsigned outputFile_;
+        int pos_;
+        int refId_;
+        unsigned seqLen_;
+        unsigned observedLength_;
+        bool unmapped_;
+        unsigned serializedLength_;
+    };
+
+    /**
+     * \brief Compressed bytes that belong to one output file. Records of different output files are
+     *        interleaved within a chunk
+     */
+    struct CompressedRange
+    {
+        unsigned outputFile_;
+        std::size_t size_;
+    };
+
+    class ThreadState;
+
+    /**
+     * \brief Compresses full blocks of one output file into the thread chunk data
+     */
+    class CompressingSink
+    {
+        ThreadState *threadState_;
+        unsigned outputFile_;
+    public:
+        CompressingSink(ThreadState &threadState, const unsigned outputFile) :
+            threadState_(&threadState), outputFile_(outputFile){}
+        void operator()(const char *block, const std::size_t size) const;
+    };
+
+    class ThreadState : boost::noncopyable
+    {
+    public:
+        ThreadState(const unsigned outputFiles, const int bamGzipLevel);
+
+        template <typename AdapterT>
+        void write(const unsigned outputFile, AdapterT &adapter);
+        void compress(const unsigned outputFile, const char *block, const std::size_t size);
+        void flush(const unsigned outputFile);
+        void store(BgzfBuffers &bgzfBuffers, boost::ptr_vector<bam::BamIndexPart> &bamIndexParts);
+        unsigned getOutputFiles() const {return blockWriters_.size();}
+
+        /**
+         * \return true if compressing one more block could overflow the preallocated buffers
+         */
+        bool full() const
+        {
+            return compressed_.capacity() - compressed_.size() < COMPRESSED_PER_BLOCK_MAX ||
+                compressedRanges_.capacity() == compressedRanges_.size();
+        }
+
+    private:
+        bgzf::BgzfBlockCompressor compressor_;
+        // one per output file
+        std::vector<bam::BamBlockWriter<CompressingSink> > blockWriters_;
+        std::vector<char> compressed_;
+        std::vector<CompressedRange> compressedRanges_;
+        std::vector<IndexRecord> indexRecords_;
+    };
+
+    const demultiplexing::BarcodePathMap::BarcodeSampleIndexMap &barcodeOutputFileIndexMap_;
+    boost::ptr_vector<ThreadState> threadStates_;
+    // signalled each time a chunk gets stored
+    boost::condition_variable chunkStoredCondition_;
+
+    template <typename AdapterT>
+    void write(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk,
+        const unsigned outputFile, AdapterT &adapter, ThreadState &threadState);
+    void flush(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk, ThreadState &threadState);
+    void serializeChunk(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk,
+        const BinData::iterator begin, const BinData::iterator end, ThreadState &threadState);
+    void serializeUnalignedChunk(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk,
+        const uint64_t beginOffset, const uint64_t endOffset, ThreadState &threadState);
+    void waitForChunkTurn(boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk);
+    void storeChunkPart(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk, ThreadState &threadState);
+    void storeChunk(
+        boost::unique_lock<boost::mutex> &lock, BinState &state, const unsigned chunk, ThreadState &threadState);
+};
+
+} // namespace build
+} // namespace isaac
+
+#endif // #ifndef iSAAC_BUILD_PARALLEL_BIN_SERIALIZER_HH
@@ -24,6 +24,7 @@
 
 #include "alignment/TemplateLengthStatistics.hh"
 #include "build/BinData.hh"
+#include "build/BuildStats.hh"
 #include "build/GapRealigner.hh"
 #include "common/Threads.hpp"
 
@@ -46,6 +47,8 @@ public:
     ParallelGapRealigner(
         const unsigned threads,
         const bool realignGapsVigorously,
+        const GapRealignerEngine realignEngine,
+        const bool realignmentCache,
         const bool realignDodgyFragments,
         const unsigned realignedGapsPerFragment,
         const bool clipSemialigned,
@@ -59,7 +62,7 @@ public:
             threadCigars_(threads),
             threadGapRealigners_(
                 threads,
-                GapRealigner(realignGapsVigorously, realignDodgyFragments, realignedGapsPerFragment, 3, 4, 0,
+                GapRealigner(realignEngine, realignmentCache, realignGapsVigorously, realignDodgyFragments, realignedGapsPerFragment, 3, 4, 0,
                              barcodeMetadataList))
     {
         std::for_each(threadCigars_.begin(), threadCigars_.end(), boost::bind(&alignment::Cigar::reserve, _1, THREAD_CIGAR_MAX));
@@ -71,7 +74,9 @@ public:
         }
     }
 
-    void threadRealignGaps(boost::unique_lock<boost::mutex> &lock, BinData &binData, BinData::iterator &nextUnprocessed, uint64_t threadNumber);
+    void threadRealignGaps(
+        boost::unique_lock<boost::mutex> &lock, BinData &binData, BinData::iterator &nextUnprocessed,
+        uint64_t threadNumber, BuildStats &buildStats);
 private:
     static const std::size_t THREAD_CIGAR_MAX =1024;
     const bool clipSemialigned_;
@@ -0,0 +1,152 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SortedRunMerger.hh
+ **
+ ** Stores bgzf-compressed sorted runs on disk and merges them into coordinate-sorted bam.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BUILD_SORTED_RUN_MERGER_HH
+#define iSAAC_BUILD_SORTED_RUN_MERGER_HH
+
+#include <zlib.h>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "bam/BamIndexer.hh"
+#include "bam/BamParser.hh"
+#include "bgzf/BgzfBlockCompressor.hh"
+#include "common/Threads.hpp"
+
+namespace isaac
+{
+namespace build
+{
+
+/**
+ * \brief Alternative to saving bins in bin order. Each bin gets stored as a sorted run as soon as it is
+ *        serialized so that its memory does not wait for the preceding bins to be saved. Once all runs
+ *        are stored, a k-way merge streams the records of each output file into the final bam, compressing
+ *        the merged data on all threads.
+ *
+ *        Runs are opened only when the merge reaches the key of their first record, so that the number of
+ *        open files stays low when the runs don't overlap, which is the case for bins.
+ */
+class SortedRunMerger: boost::noncopyable
+{
+public:
+    /**
+     * \param directory  where the run files go. Empty path disables the merger
+     * \param unalignedFirst  sort records without reference position before or after the aligned ones
+     */
+    SortedRunMerger(
+        const boost::filesystem::path &directory,
+        const unsigned outputFiles,
+        const std::size_t maxRuns,
+        const bool unalignedFirst,
+        const int bamGzipLevel);
+    ~SortedRunMerger();
+
+    bool isEnabled() const {return !directory_.empty();}
+
+    /**
+     * \brief Stores bgzf-compressed bam records of one output file. Records in the buffer must be sorted.
+     *        Safe to call concurrently for different runs.
+     *
+     * \param run  runs having records with the same key are merged in the order of run index
+     */
+    void storeRun(const unsigned outputFile, const std::size_t run, const bam::BgzfBuffer &bgzfBuffer);
+
+    /**
+     * \brief Merges the stored runs of the output file into bamStream and removes them
+     */
+    void merge(
+        const unsigned outputFile,
+        common::ThreadVector &threads,
+        std::ostream &bamStream,
+        bam::BamIndex &bamIndex);
+
+private:
+    // amount of uncompressed merged data each thread compresses at a time
+    static const std::size_t BLOCKS_PER_THREAD = 16;
+
+    struct Run
+    {
+        Run() : firstKey_(0){}
+        boost::filesystem::path path_;
+        uint64_t firstKey_;
+    };
+    typedef std::vector<Run> Runs;
+
+    /**
+     * \brief Streams records of a run file one at a time
+     */
+    class RunReader : boost::noncopyable
+    {
+    public:
+        RunReader(const boost::filesystem::path &path, const std::size_t run);
+
+        /**
+         * \return false when there are no more records in the run
+         */
+        bool next(z_stream &strm);
+        const bam::BamBlockHeader &record() const
+        {
+            return *reinterpret_cast<const bam::BamBlockHeader*>(&data_.front() + offset_);
+        }
+        std::size_t recordLength() const {return sizeof(int32_t) + record().blockLength();}
+        std::size_t run() const {return run_;}
+
+    private:
+        const boost::filesystem::path path_;
+        const std::size_t run_;
+        std::ifstream is_;
+        std::vector<char> compressed_;
+        std::vector<char> data_;
+        std::size_t offset_;
+        // length of the current record
+        std::size_t length_;
+
+        bool readBlock(z_stream &strm);
+    };
+
+    const boost::filesystem::path directory_;
+    const bool unalignedFirst_;
+    const int bamGzipLevel_;
+    // [outputFile][run]
+    std::vector<Runs> runs_;
+
+    z_stream strm_;
+    // merge buffers are allocated when the merge starts, once the bins have released their memory
+    boost::ptr_vector<bgzf::BgzfBlockCompressor> compressors_;
+    std::vector<std::vector<char> > threadCompressed_;
+    std::vector<char> merged_;
+
+    uint64_t getKey(const bam::BamBlockHeader &record) const;
+    static std::size_t inflateBlock(z_stream &strm, const char *block, std::vector<char> &data);
+
+    void flushMerged(
+        common::ThreadVector &threads, bam::BamIndexPart &bamIndexPart,
+        std::ostream &bamStream, bam::BamIndex &bamIndex, bam::BgzfBuffer &bgzfBuffer);
+    void compressMergedThread(const unsigned threadNumber, const std::size_t sliceSize);
+};
+
+} // namespace build
+} // namespace isaac
+
+#endif // #ifndef iSAAC_BUILD_SORTED_RUN_MERGER_HH
@@ -0,0 +1,147 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file RealignmentCache.hh
+ **
+ ** Remembers realignment outcomes so that identical fragments don't get realigned over and over again.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_BUILD_GAP_REALIGNER_REALIGNMENT_CACHE_HH
+#define iSAAC_BUILD_GAP_REALIGNER_REALIGNMENT_CACHE_HH
+
+#include <vector>
+
+#include "reference/ReferencePosition.hh"
+
+namespace isaac
+{
+namespace build
+{
+namespace gapRealigner
+{
+
+/**
+ * \brief Direct-mapped cache of realignment outcomes. Key is a 64-bit hash of everything the realignment
+ *        result depends on: bin, barcode, original position and CIGAR, clipping, bases and candidate gaps.
+ *        Colliding entries are simply overwritten so the memory stays bounded by SLOTS.
+ */
+class RealignmentCache
+{
+public:
+    static const unsigned SLOTS = 4096;
+    // realigned CIGARs with more operations than this are not cached
+    static const unsigned CIGAR_LENGTH_MAX = 16;
+
+    struct Entry
+    {
+        Entry() : key_(0), valid_(false), realigned_(false), newEditDistance_(0), cigarLength_(0){}
+        uint64_t key_;
+        reference::ReferencePosition pos_;
+        bool valid_;
+        bool realigned_;
+        reference::ReferencePosition newPos_;
+        reference::ReferencePosition newRStrandPosition_;
+        unsigned short newEditDistance_;
+        unsigned cigarLength_;
+        uint32_t cigar_[CIGAR_LENGTH_MAX];
+    };
+
+    /**
+     * \brief Accumulates the key. FNV-1a over 64-bit words
+     */
+    class KeyBuilder
+    {
+        uint64_t key_;
+    public:
+        KeyBuilder() : key_(0xcbf29ce484222325UL){}
+        KeyBuilder &operator <<(const uint64_t value)
+        {
+            key_ = (key_ ^ value) * 0x100000001b3UL;
+            return *this;
+        }
+        uint64_t get() const {return key_ ^ (key_ >> 29);}
+    };
+
+    explicit RealignmentCache(const bool enabled) : enabled_(enabled), hits_(0), misses_(0)
+    {
+    }
+
+    bool isEnabled() const {return enabled_;}
+    uint64_t getHits() const {return hits_;}
+    uint64_t getMisses() const {return misses_;}
+
+    void reserve()
+    {
+        if (enabled_)
+        {
+            entries_.resize(SLOTS);
+        }
+    }
+
+    /**
+     * \return entry stored for the key or 0 if there is none
+     */
+    const Entry *find(const uint64_t key, const reference::ReferencePosition pos)
+    {
+        const Entry &entry = entries_.at(key % SLOTS);
+        if (entry.valid_ && key == entry.key_ && pos == entry.pos_)
+        {
+            ++hits_;
+            return &entry;
+        }
+        ++misses_;
+        return 0;
+    }
+
+    template <typename CigarIteratorT>
+    void store(
+        const uint64_t key,
+        const reference::ReferencePosition pos,
+        const bool realigned,
+        const reference::ReferencePosition newPos,
+        const CigarIteratorT cigarBegin,
+        const CigarIteratorT cigarEnd,
+        const reference::ReferencePosition newRStrandPosition,
+        const unsigned short newEditDistance)
+    {
+        Entry &entry = entries_.at(key % SLOTS);
+        const std::size_t cigarLength = realigned ? std::distance(cigarBegin, cigarEnd) : 0;
+        if (CIGAR_LENGTH_MAX < cigarLength)
+        {
+            // keep whatever was there. Long CIGARs are rare
+            return;
+        }
+        entry.key_ = key;
+        entry.pos_ = pos;
+        entry.valid_ = true;
+        entry.realigned_ = realigned;
+        entry.newPos_ = newPos;
+        entry.newRStrandPosition_ = newRStrandPosition;
+        entry.newEditDistance_ = newEditDistance;
+        entry.cigarLength_ = cigarLength;
+        std::copy(cigarBegin, cigarBegin + cigarLength, entry.cigar_);
+    }
+
+private:
+    bool enabled_;
+    uint64_t hits_;
+    uint64_t misses_;
+    std::vector<Entry> entries_;
+};
+
+} // namespace gapRealigner
+} // namespace build
+} // namespace isaac
+
+#endif // #ifndef iSAAC_BUILD_GAP_REALIGNER_REALIGNMENT_CACHE_HH
@@ -0,0 +1,143 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file AsyncMD5Sum.hh
+ **
+ ** \brief MD5 digest computed on a shared hashing thread.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_COMMON_ASYNC_MD5SUM_HH
+#define iSAAC_COMMON_ASYNC_MD5SUM_HH
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include "common/MD5Sum.hh"
+
+namespace isaac
+{
+namespace common
+{
+
+/**
+ * \brief One hashing thread and a fixed set of buffers shared by all AsyncMD5Sum instances, so the cost does not
+ *        grow with the number of output files. Buffers are hashed in the order they are submitted.
+ *
+ *        No allocations happen after construction.
+ */
+class MD5HashingQueue : boost::noncopyable
+{
+public:
+    static const std::size_t DEFAULT_BUFFERS = 4;
+    static const std::size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+    MD5HashingQueue(const std::size_t buffers, const std::size_t bufferSize);
+    ~MD5HashingQueue();
+
+    /**
+     * \brief The queue used by the AsyncMD5Sum instances that don't specify one. Created on first use.
+     */
+    static MD5HashingQueue &instance();
+
+    std::size_t getBufferSize() const {return bufferSize_;}
+
+    /**
+     * \return a free buffer or 0 if all of them are in use
+     */
+    char *tryAcquire();
+
+    /**
+     * \brief hands size bytes of the acquired buffer over to the hashing thread. The buffer gets freed once hashed
+     */
+    void submit(MD5Sum &md5Sum, char *buffer, const std::size_t size);
+
+    /**
+     * \brief Waits for the hashing thread to digest everything submitted for md5Sum so far
+     */
+    void wait(const MD5Sum &md5Sum);
+
+    /**
+     * \return number of bytes digested on the hashing thread so far
+     */
+    std::size_t getHashedBytes();
+
+private:
+    struct Job
+    {
+        MD5Sum *md5Sum_;
+        char *buffer_;
+        std::size_t size_;
+    };
+
+    const std::size_t bufferSize_;
+    std::vector<char> memory_;
+    std::vector<char *> free_;
+    // never more than there are buffers. Oldest first
+    std::vector<Job> jobs_;
+    // the one being hashed right now or 0
+    const MD5Sum *hashing_;
+    std::size_t hashedBytes_;
+    bool terminate_;
+
+    boost::mutex mutex_;
+    boost::condition_variable stateChangedCondition_;
+    boost::thread thread_;
+
+    bool isPending(const MD5Sum &md5Sum) const;
+    void hashThread();
+};
+
+/**
+ * \brief Takes MD5 off the write path. update accumulates the data in a buffer of its own. Once the buffer is
+ *        full, it gets copied into a buffer borrowed from the MD5HashingQueue and submitted to the hashing thread
+ *        while the caller moves on. When all the queue buffers are busy, the data gets hashed on the caller
+ *        thread instead. Queue buffers are never held between the calls, so quiet outputs don't keep the busy
+ *        ones from using the hashing thread.
+ *        The digest is identical to that of MD5Sum fed with the same data.
+ */
+class AsyncMD5Sum : boost::noncopyable
+{
+public:
+    explicit AsyncMD5Sum(MD5HashingQueue &queue = MD5HashingQueue::instance());
+    ~AsyncMD5Sum();
+
+    void update(const char* buffer, std::size_t bufferLength);
+
+    /**
+     * \brief Waits for the hashing thread to digest everything supplied so far
+     */
+    MD5Sum::Digest getDigest();
+    std::string getHexStringDigest()
+    {
+        const MD5Sum::Digest dig = getDigest();
+        return MD5Sum::toHexString(dig.data, sizeof(dig.data));
+    }
+
+    void clear();
+
+private:
+    MD5HashingQueue &queue_;
+    std::vector<char> fill_;
+    std::size_t fillSize_;
+    MD5Sum md5Sum_;
+
+    void flush();
+};
+
+} // namespace common
+} // namespace isaac
+
+#endif // #ifndef iSAAC_COMMON_ASYNC_MD5SUM_HH
@@ -73,6 +73,19 @@ inline int lsbSet(const unsigned v)
     return r;
 }
 
+/**
+ * \brief murmur3 64-bit finalizer. Spreads every input bit over all the output bits.
+ */
+inline uint64_t murmur3Mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdUL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53UL;
+    h ^= h >> 33;
+    return h;
+}
+
 /**
  * \brief this function returns next higher number with same number of set bits as x.
  * http://www.geeksforgeeks.org/next-higher-number-with-same-number-of-set-bits/
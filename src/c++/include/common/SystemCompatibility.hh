@@ -144,6 +144,23 @@ void configureMemoryManagement(
 
 boost::filesystem::path getModuleFileName();
 
+/**
+ * \brief Resource consumption of the process since its start
+ */
+struct ResourceUsage
+{
+    // high-water mark of the resident set size in bytes
+    uint64_t peakRss_;
+    // bytes passed through read and write system calls, including the ones served from page cache
+    uint64_t bytesRead_;
+    uint64_t bytesWritten_;
+};
+
+/**
+ * \brief Snapshot of the process resource usage. Counters that the platform does not expose are 0
+ */
+ResourceUsage getResourceUsage();
+
 /**
  * \brief calls linux-specific fallocate with FALLOC_FL_KEEP_SIZE to pre-allocate file on disk in a way that does
  *        not mess up reopening for append. Notice that posix_fallocate does not do the job.
@@ -155,6 +172,14 @@ int linuxFallocate(int fd, std::size_t offset, std::size_t len);
  */
 int linuxFtruncate(int fd, std::size_t len);
 
+/**
+ * \brief asks the kernel to start reading the file region in the background. Does not wait for io and does not
+ *        allocate memory. len 0 means to the end of file
+ *
+ * \return 0 on success
+ */
+int readAhead(const PathCharType *filePath, std::size_t offset, std::size_t len);
+
 } // namespace common
 } // namespace isaac
 
@@ -0,0 +1,101 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file Trace.hh
+ **
+ ** \brief Low-overhead timing of the pipeline stages
+ **
+ ** Each thread records the spans it executes into its own fixed-size ring buffer. The rings are allocated by start()
+ ** only when a trace is requested. Recording does not lock, allocate or format anything, so it is safe inside
+ ** ScopedMallocBlock regions. When the ring is full, the oldest
+ ** events of that thread are overwritten. Recording is compiled in only when the build is configured with
+ ** -DISAAC_PERFORMANCE_TRACE=1. Otherwise ISAAC_TRACE_SPAN and ISAAC_TRACE_COUNTER expand to nothing.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_COMMON_TRACE_HH
+#define iSAAC_COMMON_TRACE_HH
+
+#include "config.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include <boost/noncopyable.hpp>
+
+namespace isaac
+{
+namespace common
+{
+namespace trace
+{
+
+inline uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * \param name must be a string literal. Only the pointer is stored.
+ */
+void recordSpan(const char *name, const uint64_t beginNs, const uint64_t endNs);
+void recordCounter(const char *name, const int64_t value);
+
+class ScopedSpan: boost::noncopyable
+{
+    const char * const name_;
+    const uint64_t beginNs_;
+public:
+    explicit ScopedSpan(const char *name) : name_(name), beginNs_(nowNs()) {}
+    ~ScopedSpan() {recordSpan(name_, beginNs_, nowNs());}
+};
+
+/// true if the binary records the spans
+bool enabled();
+
+/**
+ * \brief Allocates the per-thread rings. Until this is called, recording does nothing. Must be called before the
+ *        threads start recording and outside of ScopedMallocBlock regions.
+ */
+void start();
+
+/**
+ * \brief Writes the recorded events in Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+ *        Must not be called while other threads are recording.
+ */
+void dumpChromeTrace(std::ostream &os);
+
+/**
+ * \brief Writes count, total and longest duration of each named span, one line per name, followed by the number
+ *        of events missing from the trace. The totals include the events overwritten in the rings.
+ *        Must not be called while other threads are recording.
+ */
+void dumpSummary(std::ostream &os);
+
+} // namespace trace
+} // namespace common
+} // namespace isaac
+
+#if ISAAC_PERFORMANCE_TRACE
+#define ISAAC_TRACE_CONCAT_IMPL(a, b) a ## b
+#define ISAAC_TRACE_CONCAT(a, b) ISAAC_TRACE_CONCAT_IMPL(a, b)
+#define ISAAC_TRACE_SPAN(name) const ::isaac::common::trace::ScopedSpan ISAAC_TRACE_CONCAT(isaacTraceSpan, __LINE__)(name)
+#define ISAAC_TRACE_COUNTER(name, value) ::isaac::common::trace::recordCounter(name, value)
+#else
+#define ISAAC_TRACE_SPAN(name)
+#define ISAAC_TRACE_COUNTER(name, value)
+#endif
+
+#endif // #ifndef iSAAC_COMMON_TRACE_HH
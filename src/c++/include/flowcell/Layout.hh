@@ -142,6 +142,9 @@ public:
     unsigned getIndex() const {return index_;}
     void setIndex(unsigned index) {index_ = index;}
 
+    /// true if reads shorter than the read length are allowed and padded with no-calls
+    bool isVariableReadLength() const;
+
     template <Format format, typename AttributeTag> const typename AttributeTag::value_type& getAttribute(
         typename AttributeTag::value_type &result) const
     {
@@ -22,8 +22,9 @@
 
 #include <boost/filesystem/path.hpp>
 #include <boost/iostreams/device/file.hpp>
+#include <boost/shared_ptr.hpp>
 
-#include "common/MD5Sum.hh"
+#include "common/AsyncMD5Sum.hh"
 
 namespace isaac
 {
@@ -46,7 +47,7 @@ struct BasicFileSinkWithMd5 : private boost::iostreams::basic_file<Ch> {
     BasicFileSinkWithMd5( const common::PathStringType& path,
                      BOOST_IOS::openmode mode = BOOST_IOS::out )
         : boost::iostreams::basic_file<Ch>(common::pathStringToStdString(path), mode & ~BOOST_IOS::in, BOOST_IOS::out),
-          filePath_(path)
+          filePath_(path), md5Sum_(new common::AsyncMD5Sum)
         { }
     ~BasicFileSinkWithMd5()
     {
@@ -55,21 +56,21 @@ struct BasicFileSinkWithMd5 : private boost::iostreams::basic_file<Ch> {
                BOOST_IOS::openmode mode = BOOST_IOS::out )
     {
         filePath_ = path;
-        md5Sum_.clear();
+        md5Sum_->clear();
         boost::iostreams::basic_file<Ch>::open(path, mode & ~BOOST_IOS::in, BOOST_IOS::out);
     }
 
     std::streamsize write(const char_type* s, std::streamsize n)
     {
         const std::streamsize ret = boost::iostreams::basic_file<Ch>::write(s, n);
-        md5Sum_.update(s, n);
+        md5Sum_->update(s, n);
         return ret;
     }
 
     void close()
     {
         boost::iostreams::basic_file<Ch>::close();
-        const std::string md5String = md5Sum_.getHexStringDigest();
+        const std::string md5String = md5Sum_->getHexStringDigest();
         std::ofstream md5File((filePath_.string() + ".md5").c_str(), BOOST_IOS::out);
         md5File << md5String << " *" << filePath_.filename().string() << std::endl;
         if (!md5File)
@@ -82,7 +83,8 @@ struct BasicFileSinkWithMd5 : private boost::iostreams::basic_file<Ch> {
 
 private:
     boost::filesystem::path filePath_;
-    common::MD5Sum md5Sum_;
+    // iostreams copy devices around. The copies share the digest
+    boost::shared_ptr<common::AsyncMD5Sum> md5Sum_;
 };
 
 typedef BasicFileSinkWithMd5<char> FileSinkWithMd5;
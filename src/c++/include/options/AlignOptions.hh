@@ -50,6 +50,7 @@ private:
     void verifyMandatoryPaths(boost::program_options::variables_map &vm);
     void parseParallelization();
     build::GapRealignerMode parseGapRealignment();
+    build::GapRealignerEngine parseGapRealignerEngine();
     void parseExecutionTargets();
     void parseMemoryControl();
     void parseGapScoring();
@@ -65,6 +66,7 @@ private:
     void parseBamExcludeTags();
     void processLegacyOptions(boost::program_options::variables_map &vm);
     void parseHashTableBuckets();
+    void parseSeedMinimizerWindow();
 
 
 public:
@@ -79,6 +81,9 @@ public:
     std::vector<std::string> tilesFilterList;
     std::vector<std::string> useBasesMaskList;
     std::size_t hashTableBucketCount;
+    bool canonicalKmerHash;
+    bool kmerFingerprints;
+    unsigned seedMinimizerWindow;
     std::vector<flowcell::Layout> flowcellLayoutList;
     flowcell::BarcodeMetadataList barcodeMetadataList;
     // another workaround for boost and spaces in paths
@@ -133,12 +138,16 @@ public:
     bool preAllocateBins;
     bool putUnalignedInTheBack;
     bool realignGapsVigorously;
+    std::string realignEngineString;
+    build::GapRealignerEngine realignEngine;
+    bool realignmentCache;
     bool realignDodgyFragments;
     unsigned realignedGapsPerFragment;
     bool clipSemialigned;
     bool clipOverlapping;
     bool scatterRepeats;
     bool rescueShadows;
+    bool bitParallelShadowRescue;
     bool trimPEAdapters;
     unsigned gappedMismatchesMax;
     unsigned smitWatermanGapsMax;
@@ -160,6 +169,8 @@ public:
     common::ScopedMallocBlock::Mode memoryControl;
     uint64_t memoryLimit;
     static const uint64_t memoryLimitUnlimited = 0;
+    std::string traceFileString;
+    boost::filesystem::path traceFile;
     unsigned inputLoadersMax;
     unsigned tempSaversMax;
     unsigned tempLoadersMax;
@@ -173,6 +184,7 @@ public:
     std::vector<std::string> bamHeaderTags;
     std::string bamPuFormat;
     bool bamProduceMd5;
+    bool bamMergeRuns;
     double expectedBgzfCompressionRatio;
     bool singleLibrarySamples;
     bool keepDuplicates;
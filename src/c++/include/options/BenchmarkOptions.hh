@@ -0,0 +1,60 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BenchmarkOptions.hh
+ **
+ ** Command line options for 'isaac-bench'
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_OPTIONS_BENCHMARK_OPTIONS_HH
+#define iSAAC_OPTIONS_BENCHMARK_OPTIONS_HH
+
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "common/Program.hh"
+
+namespace isaac
+{
+namespace options
+{
+
+class BenchmarkOptions : public common::Options
+{
+public:
+    std::string kernelsString_;
+    std::vector<std::string> kernels_;
+    uint64_t referenceLength_;
+    unsigned readLength_;
+    unsigned reads_;
+    unsigned repeats_;
+    unsigned jobs_;
+    unsigned seed_;
+    std::string tempDirectoryString_;
+    boost::filesystem::path tempDirectory_;
+    std::string outputString_;
+
+public:
+    BenchmarkOptions();
+
+private:
+    std::string usagePrefix() const {return "isaac-bench";}
+    void postProcess(boost::program_options::variables_map &vm);
+};
+
+} // namespace options
+} // namespace isaac
+
+#endif // #ifndef iSAAC_OPTIONS_BENCHMARK_OPTIONS_HH
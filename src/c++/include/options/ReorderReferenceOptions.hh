@@ -38,6 +38,8 @@ public:
     std::vector<std::string> newOrder_;
     boost::filesystem::path newXmlPath_;
     boost::filesystem::path newDataDirectory_;
+    bool packedCache_;
+    unsigned jobs_;
 
 public:
     ReorderReferenceOptions();
@@ -0,0 +1,61 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SimulateRunOptions.hh
+ **
+ ** Command line options for 'simulateRun'
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_OPTIONS_SIMULATE_RUN_OPTIONS_HH
+#define iSAAC_OPTIONS_SIMULATE_RUN_OPTIONS_HH
+
+#include <string>
+#include <boost/filesystem.hpp>
+
+#include "common/Program.hh"
+
+namespace isaac
+{
+namespace options
+{
+
+class SimulateRunOptions : public common::Options
+{
+public:
+    std::string outputDirectoryString_;
+    boost::filesystem::path outputDirectory_;
+    uint64_t referenceLength_;
+    unsigned contigs_;
+    double repeatFraction_;
+    unsigned readLength_;
+    unsigned clusters_;
+    unsigned fragmentLengthMean_;
+    unsigned fragmentLengthSd_;
+    double errorRate_;
+    double indelRate_;
+    double duplicateRate_;
+    unsigned seed_;
+
+public:
+    SimulateRunOptions();
+
+private:
+    std::string usagePrefix() const {return "simulateRun";}
+    void postProcess(boost::program_options::variables_map &vm);
+};
+
+} // namespace options
+} // namespace isaac
+
+#endif // #ifndef iSAAC_OPTIONS_SIMULATE_RUN_OPTIONS_HH
@@ -20,10 +20,12 @@
 #ifndef iSAAC_REFERENCE_CONTIGS_LOADER_HH
 #define iSAAC_REFERENCE_CONTIGS_LOADER_HH
 
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 
 #include "common/Threads.hpp"
 #include "reference/Contig.hh"
+#include "reference/PackedReference.hh"
 #include "reference/SortedReferenceMetadata.hh"
 
 namespace isaac
@@ -35,11 +37,16 @@ void loadContig(
     const reference::SortedReferenceMetadata::Contig &xmlContig,
     ContigList::UpdateRange &contig);
 
+void loadContig(
+    const reference::SortedReferenceMetadata::Contig &xmlContig,
+    std::vector<char> &bases);
+
 template <typename ShouldLoadF> void loadContigsParallel(
     ShouldLoadF &shouldLoad,
     std::vector<reference::SortedReferenceMetadata::Contig>::const_iterator &nextContigToLoad,
     const std::vector<reference::SortedReferenceMetadata::Contig>::const_iterator contigsEnd,
     reference::ContigList &contigList,
+    const PackedReferences &packedReferences,
     boost::mutex &mutex)
 {
     const unsigned traceStep = pow(10, int(log10((contigList.size() + 99) / 100)));
@@ -52,7 +59,10 @@ template <typename ShouldLoadF> void loadContigsParallel(
             common::unlock_guard<boost::mutex> unlock(mutex);
             const reference::SortedReferenceMetadata::Contig &xmlContig = *ourContig;
             ContigList::UpdateRange rwContig = contigList.getUpdateRange(ourContig->index_);
-            loadContig(xmlContig, rwContig);
+            if (!packedReferences.load(xmlContig, rwContig))
+            {
+                loadContig(xmlContig, rwContig);
+            }
             if (!(xmlContig.index_ % traceStep))
             {
                 ISAAC_THREAD_CERR << (boost::format("Contig(%3d:%8d) %s : %s\n") % xmlContig.index_ % xmlContig.totalBases_ % xmlContig.name_ % xmlContig.filePath_).str();
@@ -68,7 +78,8 @@ template <typename ShouldLoadF> void loadContigsParallel(
 }
 
 /**
- * \brief loads the fasta file contigs into memory on multiple threads unless shouldLoad(contig->index_) returns false
+ * \brief loads the fasta file contigs into memory on multiple threads unless shouldLoad(contig->index_) returns false.
+ *        Contigs that have a valid copy in the packed reference store get unpacked from there instead.
  */
 template <typename ShouldLoadF> reference::ContigList loadContigs(
     const reference::SortedReferenceMetadata::Contigs &xmlContigs,
@@ -77,6 +88,7 @@ template <typename ShouldLoadF> reference::ContigList loadContigs(
     common::ThreadVector &loadThreads)
 {
     reference::ContigList ret(xmlContigs, spacing);
+    const PackedReferences packedReferences(xmlContigs);
     std::vector<reference::SortedReferenceMetadata::Contig>::const_iterator nextContigToLoad = xmlContigs.begin();
     boost::mutex mutex;
     loadThreads.execute(boost::bind(&loadContigsParallel<ShouldLoadF>,
@@ -84,6 +96,7 @@ template <typename ShouldLoadF> reference::ContigList loadContigs(
                                     boost::ref(nextContigToLoad),
                                     xmlContigs.end(),
                                     boost::ref(ret),
+                                    boost::cref(packedReferences),
                                     boost::ref(mutex)));
 
 //    ISAAC_TRACE_STAT("loadContigs(xmlContigs) done ");
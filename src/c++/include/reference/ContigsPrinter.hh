@@ -21,25 +21,58 @@
 #define iSAAC_REFERENCE_CONTIGS_PRINTER_HH
 
 #include <string>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
 
 namespace isaac
 {
 namespace reference
 {
 
+/**
+ * \brief Finds the contigs in a single pass over the fasta, then counts the bases and computes the md5 of
+ *        each contig on the first available thread. The metadata is printed in the order of the fasta.
+ */
 class ContigsPrinter: boost::noncopyable
 {
 public:
     ContigsPrinter(
         const boost::filesystem::path &originalSortedReferenceXml,
-        const boost::filesystem::path &genomeFile
+        const boost::filesystem::path &genomeFile,
+        const unsigned jobs
     );
     void run();
 private:
+    static const std::size_t READ_BUFFER_SIZE = 1024 * 1024;
+
+    struct ContigLocation
+    {
+        std::string header_;
+        // bytes from the one following the header line up to the next header line or the end of file
+        uint64_t begin_;
+        uint64_t end_;
+    };
+
+    struct ContigSummary
+    {
+        uint64_t totalBases_;
+        uint64_t acgtBases_;
+        std::string md5_;
+    };
+
     const boost::filesystem::path originalSortedReferenceXml_;
     const boost::filesystem::path genomeFile_;
+    const unsigned jobs_;
+
+    std::vector<ContigLocation> findContigs() const;
+    void summarizeContig(const ContigLocation &location, std::vector<char> &buffer, ContigSummary &summary) const;
+    void summarizeContigsThread(
+        const std::vector<ContigLocation> &locations,
+        std::size_t &nextContig,
+        boost::mutex &mutex,
+        std::vector<ContigSummary> &summaries) const;
 };
 
 } // namespace reference
@@ -0,0 +1,137 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file PackedReference.hh
+ **
+ ** Binary 2-bit copy of the fasta contigs that loads without parsing text.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_REFERENCE_PACKED_REFERENCE_HH
+#define iSAAC_REFERENCE_PACKED_REFERENCE_HH
+
+#include <map>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "reference/Contig.hh"
+#include "reference/SortedReferenceMetadata.hh"
+
+namespace isaac
+{
+namespace reference
+{
+
+namespace packedReference
+{
+
+/**
+ * \brief Layout of the store file: Header, ContigEntry[contigCount_], then for each contig the 2-bit packed
+ *        bases padded to 8 bytes followed by NRun[nRuns_]. Entries are sorted by fastaOffset_.
+ */
+struct Header
+{
+    char magic_[8];
+    uint32_t version_;
+    uint32_t contigCount_;
+    // size and modification time of the fasta the store was produced from
+    uint64_t sourceSize_;
+    int64_t sourceMtime_;
+};
+
+struct ContigEntry
+{
+    // offset of the contig bases in the fasta file. Same as SortedReferenceMetadata::Contig::offset_
+    uint64_t fastaOffset_;
+    uint64_t totalBases_;
+    uint64_t acgtBases_;
+    // offset of the packed bases from the beginning of the store
+    uint64_t dataOffset_;
+    uint64_t nRuns_;
+    // crc32 of the packed bases and the N runs
+    uint32_t crc32_;
+    uint32_t reserved_;
+};
+
+/**
+ * \brief Stretch of bases that are not A, C, G or T. All of them load as N
+ */
+struct NRun
+{
+    uint64_t begin_;
+    uint64_t length_;
+};
+
+} // namespace packedReference
+
+class PackedReference: boost::noncopyable
+{
+public:
+    static const char MAGIC[8];
+    static const uint32_t VERSION = 1;
+
+    /**
+     * \brief Maps <fastaPath>.isaac-packed if it exists and was produced from the fasta as it is now.
+     *        Otherwise isOpen() returns false.
+     */
+    explicit PackedReference(const boost::filesystem::path &fastaPath);
+
+    bool isOpen() const {return 0 != header_;}
+
+    /**
+     * \brief Unpacks the contig into its place in the contig list
+     *
+     * \return false if the store has no valid copy of the contig
+     */
+    bool load(const SortedReferenceMetadata::Contig &xmlContig, ContigList::UpdateRange &contig) const;
+
+    static boost::filesystem::path getStorePath(const boost::filesystem::path &fastaPath);
+
+    /**
+     * \brief Parses the contigs stored in fastaPath and writes their packed copy next to it
+     */
+    static void store(const SortedReferenceMetadata::Contigs &contigs, const boost::filesystem::path &fastaPath);
+
+private:
+    boost::iostreams::mapped_file_source file_;
+    const packedReference::Header *header_;
+    const packedReference::ContigEntry *contigsBegin_;
+    const packedReference::ContigEntry *contigsEnd_;
+
+    bool map(const boost::filesystem::path &storePath, const boost::filesystem::path &fastaPath);
+};
+
+/**
+ * \brief Packed stores of all fasta files the contigs come from
+ */
+class PackedReferences: boost::noncopyable
+{
+public:
+    explicit PackedReferences(const SortedReferenceMetadata::Contigs &contigs);
+
+    /**
+     * \return false if the contig has to be loaded from fasta
+     */
+    bool load(const SortedReferenceMetadata::Contig &xmlContig, ContigList::UpdateRange &contig) const;
+
+private:
+    std::map<boost::filesystem::path, std::unique_ptr<PackedReference> > stores_;
+};
+
+} // namespace reference
+} // namespace isaac
+
+#endif // #ifndef iSAAC_REFERENCE_PACKED_REFERENCE_HH
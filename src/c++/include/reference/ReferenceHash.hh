@@ -21,6 +21,7 @@
 #define iSAAC_REFERENCE_REFERENCE_HASH_HH
 
 #include <boost/format.hpp>
+#include "common/BitHacks.hh"
 #include "common/NumaContainer.hh"
 #include "oligo/Kmer.hh"
 
@@ -30,10 +31,128 @@ namespace reference
 {
 template <typename KmerT> class ReferenceHasher;
 
-template <typename KmerType, typename AllocatorT = std::allocator<void> >
+namespace referenceHash
+{
+
+/**
+ * \brief Hash policies turn the kmer bits into the bucket number in [0, bucketCount).
+ *        All but ModuloPrime are division-free.
+ */
+struct ModuloPrime
+{
+    static const char *name() {return "modulo-prime";}
+    ModuloPrime(const uint64_t bucketCount, const unsigned kmerBases) :
+        a_(3308323), b_(7048005), largePrime_(1699023365707), bucketCount_(bucketCount) {}
+    uint64_t operator()(const uint64_t bits) const {return ((bits * a_ + b_) % largePrime_) % bucketCount_;}
+    friend std::ostream &operator <<(std::ostream &os, const ModuloPrime &p)
+    {
+        return os << p.name() << " a:" << p.a_ << " b:" << p.b_ << " prime:" << p.largePrime_;
+    }
+private:
+    uint64_t a_;
+    uint64_t b_;
+    uint64_t largePrime_;
+    uint64_t bucketCount_;
+};
+
+/**
+ * \brief Dietzfelbinger multiply-shift: top bits of a 64-bit multiply-add. Requires power of 2 bucket count.
+ */
+struct MultiplyShift
+{
+    static const char *name() {return "multiply-shift";}
+    MultiplyShift(const uint64_t bucketCount, const unsigned kmerBases) :
+        a_(0x9e3779b97f4a7c15UL), b_(0x7f4a7c159e3779b9UL), shift_(63 - log2(bucketCount)) {}
+    // two shifts so that single bucket does not require shifting by 64
+    uint64_t operator()(const uint64_t bits) const {return ((bits * a_ + b_) >> 1) >> shift_;}
+    friend std::ostream &operator <<(std::ostream &os, const MultiplyShift &p)
+    {
+        return os << p.name() << " a:" << p.a_ << " b:" << p.b_ << " shift:" << p.shift_ + 1;
+    }
+    static unsigned log2(const uint64_t bucketCount)
+    {
+        if (bucketCount & (bucketCount - 1))
+        {
+            BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+                (boost::format("Bucket count %d is not a power of 2") % bucketCount).str()));
+        }
+        unsigned ret = 0;
+        while (bucketCount >> ret > 1)
+        {
+            ++ret;
+        }
+        return ret;
+    }
+private:
+    uint64_t a_;
+    uint64_t b_;
+    unsigned shift_;
+};
+
+/**
+ * \brief Lemire fast range reduction of a 64-bit multiplicative hash. Any bucket count.
+ */
+struct FastRange
+{
+    static const char *name() {return "fast-range";}
+    FastRange(const uint64_t bucketCount, const unsigned kmerBases) :
+        a_(0x9e3779b97f4a7c15UL), b_(0x7f4a7c159e3779b9UL), bucketCount_(bucketCount) {}
+    uint64_t operator()(const uint64_t bits) const
+    {
+        return uint64_t((__uint128_t(bits * a_ + b_) * bucketCount_) >> 64);
+    }
+    friend std::ostream &operator <<(std::ostream &os, const FastRange &p)
+    {
+        return os << p.name() << " a:" << p.a_ << " b:" << p.b_;
+    }
+private:
+    uint64_t a_;
+    uint64_t b_;
+    uint64_t bucketCount_;
+};
+
+/**
+ * \brief Multiply-shift within the width of the kmer. Requires power of 2 bucket count not exceeding the number
+ *        of distinct kmers. When the two are equal (the isaac-align default) each kmer gets a bucket of its own.
+ */
+struct PowerOfTwo
+{
+    static const char *name() {return "power-of-two";}
+    PowerOfTwo(const uint64_t bucketCount, const unsigned kmerBases) :
+        a_(0x9e3779b97f4a7c15UL),
+        // single bucket of a 32-mer would need a shift by 64. Zero mask puts everything into bucket 0 instead.
+        mask_(1 == bucketCount ? 0UL : ~0UL >> (64 - kmerBases * oligo::BITS_PER_BASE)),
+        shift_(1 == bucketCount ? 0 : kmerBases * oligo::BITS_PER_BASE - MultiplyShift::log2(bucketCount))
+    {
+        if (kmerBases * oligo::BITS_PER_BASE < MultiplyShift::log2(bucketCount))
+        {
+            BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+                (boost::format("Bucket count %d exceeds the number of %d-mers") % bucketCount % kmerBases).str()));
+        }
+    }
+    // odd multiplier makes it a bijection on kmers
+    uint64_t operator()(const uint64_t bits) const {return ((bits * a_) & mask_) >> shift_;}
+    friend std::ostream &operator <<(std::ostream &os, const PowerOfTwo &p)
+    {
+        return os << p.name() << " a:" << p.a_ << " shift:" << p.shift_;
+    }
+private:
+    uint64_t a_;
+    uint64_t mask_;
+    unsigned shift_;
+};
+
+} // namespace referenceHash
+
+/**
+ * \brief ModuloPrime stays the default: the bucket collisions, and therefore the match ordering and the alignment
+ *        output, are the same as before the policies were introduced. The division-free policies are opt-in.
+ */
+template <typename KmerType, typename AllocatorT = std::allocator<void>, typename HashPolicyT = referenceHash::ModuloPrime>
 class ReferenceHash
 {
-    typedef ReferenceHash<KmerType, AllocatorT> MyT;
+    typedef ReferenceHash<KmerType, AllocatorT, HashPolicyT> MyT;
+    BOOST_STATIC_ASSERT_MSG(oligo::KmerTraits<KmerType>::KMER_BASES * oligo::BITS_PER_BASE <= 64, "Hash policies take 64-bit kmers");
 
 public:
     typedef typename AllocatorT::template rebind<reference::ContigList::Offset> ReferenceOffsetAllocatorRebind;
@@ -57,6 +176,31 @@ public:
     // numbers even for genomes larger than 4B bases.
     typedef std::vector<Offset, OffsetAllocator> Offsets;
 
+    // few bits of the kmer not used in the bucket key. Allow telling apart the kmers colliding in the same bucket
+    typedef uint8_t Fingerprint;
+    typedef typename AllocatorT::template rebind<Fingerprint> FingerprintAllocatorRebind;
+    typedef typename FingerprintAllocatorRebind::other FingerprintAllocator;
+    // one per position, bucket positions are ordered by fingerprint first
+    typedef std::vector<Fingerprint, FingerprintAllocator> Fingerprints;
+
+    // bucket (or bucket fingerprint group) that has at least repeatFilterThreshold_ positions
+    struct RepeatGroup
+    {
+        KeyT key_;
+        Fingerprint fingerprint_;
+        // 0 for unused slot
+        Offset count_;
+    };
+    typedef typename AllocatorT::template rebind<RepeatGroup> RepeatGroupAllocatorRebind;
+    typedef typename RepeatGroupAllocatorRebind::other RepeatGroupAllocator;
+    // open addressing table, size is power of 2
+    typedef std::vector<RepeatGroup, RepeatGroupAllocator> RepeatGroups;
+
+    /**
+     * \brief In canonical mode, the kmer and its reverse complement share the bucket. Each bucket is split in two
+     *        by the lowest bit of the key: positions where the reference has the canonical (smaller) kmer go first,
+     *        followed by the positions where the reference has its reverse complement.
+     */
     KeyT keyFromKmer(KmerT kmer) const
     {
 //        if (kmer == KmerT(/*0x02cee3cc14 */0x02e2c0c82b))
@@ -66,38 +210,61 @@ public:
 //        }
 
 //        return kmer.bits_;
-        return ((kmer.bits_ * a_ + b_) % largePrime_) % bucketCount_;
+        if (canonical_)
+        {
+            const KmerT rc = oligo::reverseComplement(kmer);
+            return rc < kmer ? KeyT(bucketFromKmer(rc) << 1 | 1) : KeyT(bucketFromKmer(kmer) << 1);
+        }
+        return bucketFromKmer(kmer);
     }
 
-    ReferenceHash(const uint64_t bucketCount)
-        : a_(3308323), b_(7048005), largePrime_(1699023365707), bucketCount_(bucketCount), offsets_(bucketCount_, 0)
+    /**
+     * \brief Fingerprint of the kmer as stored in the hash. In canonical mode both the kmer and its
+     *        reverse complement have the fingerprint of the canonical one.
+     */
+    Fingerprint fingerprintFromKmer(const KmerT &kmer) const
+    {
+        return fingerprintFromCanonicalKmer(canonical_ ? std::min(kmer, oligo::reverseComplement(kmer)) : kmer);
+    }
+
+    typedef HashPolicyT HashPolicy;
+
+    ReferenceHash(const uint64_t bucketCount, const bool canonical = false, const bool fingerprints = false)
+        : hashPolicy_(bucketCount, SEED_LENGTH), bucketCount_(bucketCount), canonical_(canonical),
+          fingerprints_(fingerprints), repeatFilterThreshold_(0), offsets_(bucketCount_ << canonical_, 0)
     {
         if (!bucketCount_)
         {
             BOOST_THROW_EXCEPTION(common::InvalidParameterException("Bucket count 0 is invalid"));
         }
-        if (std::numeric_limits<KeyT>::max() < bucketCount_ - 1)
+        if (std::numeric_limits<KeyT>::max() < (bucketCount_ << canonical_) - 1)
         {
             BOOST_THROW_EXCEPTION(common::InvalidParameterException(
                 (boost::format("Bucket count %d is too large for key type %s. Max possible key value is %d") % bucketCount_ %
-                    typeid(KeyT).name() % std::numeric_limits<KeyT>::max()
+                    typeid(KeyT).name() % (std::numeric_limits<KeyT>::max() >> canonical_)
             ).str()));
         }
 //        ISAAC_THREAD_CERR << "ReferenceHash()" << std::endl;
     }
 
     ReferenceHash(ReferenceHash &&that, const AllocatorT &allocator = AllocatorT())
-        : a_(that.a_), b_(that.b_), largePrime_(that.largePrime_), bucketCount_(that.bucketCount_)
+        : hashPolicy_(that.hashPolicy_), bucketCount_(that.bucketCount_), canonical_(that.canonical_)
+        , fingerprints_(that.fingerprints_), repeatFilterThreshold_(that.repeatFilterThreshold_)
     {
         offsets_.swap(that.offsets_);
         positions_.swap(that.positions_);
+        positionFingerprints_.swap(that.positionFingerprints_);
+        repeatGroups_.swap(that.repeatGroups_);
 //        ISAAC_THREAD_CERR << "ReferenceHash(ReferenceHash &&that, allocator)" << std::endl;
     }
 
     ReferenceHash(const ReferenceHash &that, const AllocatorT &allocator)
-        : a_(that.a_), b_(that.b_), largePrime_(that.largePrime_), bucketCount_(that.bucketCount_)
+        : hashPolicy_(that.hashPolicy_), bucketCount_(that.bucketCount_), canonical_(that.canonical_)
+        , fingerprints_(that.fingerprints_), repeatFilterThreshold_(that.repeatFilterThreshold_)
         , offsets_(that.offsets_, allocator)
         , positions_(that.positions_, allocator)
+        , positionFingerprints_(that.positionFingerprints_, allocator)
+        , repeatGroups_(that.repeatGroups_, allocator)
     {
 //        ISAAC_THREAD_CERR << "ReferenceHash(ReferenceHash &that, allocator)" << std::endl;
     }
@@ -129,13 +296,128 @@ public:
 //        return *this;
 //    }
 
+    /**
+     * \return positions where reference has the kmer. In canonical mode, same as the forward matches of
+     *         the two-strand findMatches
+     */
     MatchRange iSAAC_PROFILING_NOINLINE findMatches(const KmerT &kmer) const
     {
+        if (canonical_)
+        {
+            MatchRange fwMatches;
+            MatchRange rvMatches;
+            findMatches(kmer, fwMatches, rvMatches);
+            return fwMatches;
+        }
+        return getKeyMatches(keyFromKmer(kmer), fingerprintFromKmer(kmer));
+    }
+
+    /**
+     * \brief Finds positions where reference has kmer and positions where reference has its reverse complement.
+     *        In canonical mode this costs a single bucket lookup.
+     */
+    void iSAAC_PROFILING_NOINLINE findMatches(const KmerT &kmer, MatchRange &fwMatches, MatchRange &rvMatches) const
+    {
+        const KmerT rc = oligo::reverseComplement(kmer);
+        if (!canonical_)
+        {
+            fwMatches = getKeyMatches(keyFromKmer(kmer), fingerprintFromCanonicalKmer(kmer));
+            rvMatches = getKeyMatches(keyFromKmer(rc), fingerprintFromCanonicalKmer(rc));
+        }
+        else if (rc == kmer)
+        {
+            // palindromes are stored as canonical only. They match both strands
+            fwMatches = rvMatches = getKeyMatches(KeyT(bucketFromKmer(kmer) << 1), fingerprintFromCanonicalKmer(kmer));
+        }
+        else
+        {
+            const KmerT canonicalKmer = std::min(kmer, rc);
+            const KeyT key = KeyT(bucketFromKmer(canonicalKmer) << 1);
+            const Fingerprint fingerprint = fingerprintFromCanonicalKmer(canonicalKmer);
+            const MatchRange canonicalMatches = getKeyMatches(key, fingerprint);
+            const MatchRange rcMatches = getKeyMatches(key + 1, fingerprint);
+            fwMatches = kmer < rc ? canonicalMatches : rcMatches;
+            rvMatches = kmer < rc ? rcMatches : canonicalMatches;
+        }
+    }
+
+    MatchRange getEmptyRange() const
+    {
+        return std::make_pair(positions_.end(), positions_.end());
+    }
+
+    uint64_t getBucketCount() const {return bucketCount_;}
+    const HashPolicyT &getHashPolicy() const {return hashPolicy_;}
+    bool isCanonical() const {return canonical_;}
+    bool hasFingerprints() const {return fingerprints_;}
+    std::size_t getRepeatFilterThreshold() const {return repeatFilterThreshold_;}
+
+    /**
+     * \brief Consults the small table of repeat buckets instead of the offsets and positions.
+     *
+     * \return true if findMatches(kmer) is known to return at least seedRepeatThreshold positions.
+     *         false if it is not or if the filter cannot tell for this threshold.
+     */
+    bool isKnownRepeat(const KmerT &kmer, const std::size_t seedRepeatThreshold) const
+    {
+        if (!repeatFilterThreshold_ || seedRepeatThreshold < repeatFilterThreshold_ || repeatGroups_.empty())
+        {
+            return false;
+        }
         const KeyT key = keyFromKmer(kmer);
+        const Fingerprint fingerprint = fingerprints_ ? fingerprintFromKmer(kmer) : 0;
+        const std::size_t mask = repeatGroups_.size() - 1;
+        for (std::size_t slot = repeatGroupSlot(key, fingerprint) & mask; ; slot = (slot + 1) & mask)
+        {
+            const RepeatGroup &group = repeatGroups_[slot];
+            if (!group.count_)
+            {
+                return false;
+            }
+            if (key == group.key_ && fingerprint == group.fingerprint_)
+            {
+                return seedRepeatThreshold <= group.count_;
+            }
+        }
+    }
+private:
+    uint64_t bucketFromKmer(const KmerT &kmer) const
+    {
+        return hashPolicy_(uint64_t(kmer.bits_));
+    }
+
+    /**
+     * \brief top bits of the murmur3 finalizer. Unrelated to the bucket key produced by HashPolicyT.
+     */
+    static Fingerprint fingerprintFromCanonicalKmer(const KmerT &kmer)
+    {
+        return Fingerprint(common::murmur3Mix(uint64_t(kmer.bits_)) >> (64 - 8 * sizeof(Fingerprint)));
+    }
+
+    static std::size_t repeatGroupSlot(const KeyT key, const Fingerprint fingerprint)
+    {
+        return common::murmur3Mix((uint64_t(key) << (8 * sizeof(Fingerprint))) | fingerprint);
+    }
+
+    /**
+     * \return positions of the bucket that have the fingerprint. As positions within the bucket are ordered
+     *         by fingerprint, the result is a contiguous subrange still ordered by position.
+     */
+    MatchRange getKeyMatches(const KeyT key, const Fingerprint fingerprint) const
+    {
         Offset positionsBegin = !key ? 0 : offsets_[key - 1];
         Offset positionsEnd = offsets_[key];
-        ISAAC_ASSERT_MSG(positionsBegin <= positions_.size(), "Positions buffer overrun by positionsBegin:" << positionsBegin << " for kmer " << kmer);
-        ISAAC_ASSERT_MSG(positionsBegin <= positionsEnd, "positionsEnd:" << positionsEnd << " overrun by positionsBegin:" << positionsBegin << " for kmer " << kmer);
+        ISAAC_ASSERT_MSG(positionsBegin <= positions_.size(), "Positions buffer overrun by positionsBegin:" << positionsBegin << " for key " << key);
+        ISAAC_ASSERT_MSG(positionsBegin <= positionsEnd, "positionsEnd:" << positionsEnd << " overrun by positionsBegin:" << positionsBegin << " for key " << key);
+
+        if (fingerprints_ && positionsBegin != positionsEnd)
+        {
+            typedef typename Fingerprints::const_iterator FingerprintIterator;
+            const std::pair<FingerprintIterator, FingerprintIterator> fingerprintRange = std::equal_range(
+                positionFingerprints_.begin() + positionsBegin, positionFingerprints_.begin() + positionsEnd, fingerprint);
+            positionsBegin = std::distance(positionFingerprints_.begin(), fingerprintRange.first);
+            positionsEnd = std::distance(positionFingerprints_.begin(), fingerprintRange.second);
+        }
 
         const MatchRange ret = std::make_pair(positions_.begin() + positionsBegin, positions_.begin() + positionsEnd);
 
@@ -147,23 +429,18 @@ public:
         return ret;
     }
 
-    MatchRange getEmptyRange() const
-    {
-        return std::make_pair(positions_.end(), positions_.end());
-    }
-
-    uint64_t getBucketCount() const {return bucketCount_;}
-    uint64_t getA() const {return a_;}
-    uint64_t getB() const {return b_;}
-    uint64_t getLargePrime() const {return largePrime_;}
-private:
-    uint64_t a_;
-    uint64_t b_;
-    uint64_t largePrime_;
+    HashPolicyT hashPolicy_;
     uint64_t bucketCount_;
+    bool canonical_;
+    bool fingerprints_;
+    // 0 if no repeat filter has been built
+    std::size_t repeatFilterThreshold_;
     Offsets offsets_;
 //    std::vector<KmerT> uniqueKmers_;
     Positions positions_;
+    // empty unless fingerprints_ is set
+    Fingerprints positionFingerprints_;
+    RepeatGroups repeatGroups_;
 
     friend class ReferenceHasher<MyT>;
 };
@@ -191,6 +468,18 @@ public:
     {
         return replicas_.threadNodeContainer().findMatches(kmer);
     }
+
+    void findMatches(const KmerT &kmer, MatchRange &fwMatches, MatchRange &rvMatches) const
+    {
+        replicas_.threadNodeContainer().findMatches(kmer, fwMatches, rvMatches);
+    }
+
+    bool isCanonical() const {return replicas_.threadNodeContainer().isCanonical();}
+
+    bool isKnownRepeat(const KmerT &kmer, const std::size_t seedRepeatThreshold) const
+    {
+        return replicas_.threadNodeContainer().isKnownRepeat(kmer, seedRepeatThreshold);
+    }
 };
 
 } // namespace reference
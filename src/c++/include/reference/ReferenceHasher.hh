@@ -47,7 +47,15 @@ public:
 
     ReferenceHasher(const ContigList &contigList, common::ThreadVector &threads, const unsigned threadsMax);
 
-    ReferenceHashT generate(const uint64_t bucketCount);
+    /**
+     * \param repeatFilterThreshold if not 0, the hash gets a table of buckets that have at least that many positions.
+     *                              See ReferenceHash::isKnownRepeat
+     */
+    ReferenceHashT generate(
+        const uint64_t bucketCount,
+        const bool canonical = false,
+        const bool fingerprints = false,
+        const std::size_t repeatFilterThreshold = 0);
     void generate(ReferenceHashT &ret);
 
 private:
@@ -89,6 +97,7 @@ private:
 
     static void sortPositions(ReferenceHashT &referenceHash, const unsigned threadNumber, const std::size_t threads);
     static void updateEmptyOffsets(Offsets& offsets);
+    static void buildRepeatFilter(ReferenceHashT &referenceHash, const std::size_t repeatFilterThreshold);
     static Offset countsToOffsets(Offsets& offsets);
     static void dumpCounts(boost::mutex& mutex, MutexBuffer& buffer, ReferenceHashT& referenceHash);
     static void dumpPositions(boost::mutex& mutex, MutexBuffer& buffer, ReferenceHashT& referenceHash);
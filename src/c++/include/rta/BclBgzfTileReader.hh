@@ -28,6 +28,7 @@
 #include "common/Debug.hh"
 #include "common/FileSystem.hh"
 #include "common/Memory.hh"
+#include "common/SystemCompatibility.hh"
 #include "common/Threads.hpp"
 #include "flowcell/BclBgzfLayout.hh"
 #include "flowcell/TileMetadata.hh"
@@ -109,6 +110,26 @@ public:
         }
     }
 
+    /**
+     * \brief Lets the kernel read the compressed blocks of a tile that is going to be loaded later while the
+     *        current one is being processed. The tile must belong to the lane for which the bci mappers are loaded.
+     */
+    void prefetchTileCycle(
+        const flowcell::Layout &flowcellLayout,
+        const flowcell::TileMetadata &tile,
+        const unsigned cycle)
+    {
+        flowcellLayout.getLaneCycleAttribute<
+            flowcell::Layout::BclBgzf,flowcell::BclFilePathAttributeTag>(tile.getLane(), cycle, prefetchFilePath_);
+        const rta::CycleBciMapper &cycleBciMapper = cycleBciMappers_.at(cycle);
+        const unsigned tileBciIndex = tileBciIndexMap_.at(tile.getOriginalIndex());
+        const std::size_t begin = cycleBciMapper.getTileOffset(tileBciIndex).compressedOffset;
+        // last tile of the lane goes to the end of the file
+        const std::size_t end = cycleBciMapper.getTilesCount() > tileBciIndex + 1 ?
+            std::size_t(cycleBciMapper.getTileOffset(tileBciIndex + 1).compressedOffset) : begin;
+        common::readAhead(prefetchFilePath_.c_str(), begin, end - begin);
+    }
+
 private:
     const bool ignoreMissingBcls_;
     const std::vector<unsigned> &tileBciIndexMap_;
@@ -117,6 +138,7 @@ private:
     boost::filesystem::path cycleFilePath_;
     io::FileBufWithReopen bclFileBuffer_;
     boost::filesystem::path openFilePath_;
+    boost::filesystem::path prefetchFilePath_;
 
     typedef boost::error_info<struct tag_errmsg, std::string> errmsg_info;
 
@@ -129,6 +151,9 @@ private:
 
         openFilePath_ = std::string(reservePathLength, 'a').c_str();
         openFilePath_.clear();
+
+        prefetchFilePath_ = std::string(reservePathLength, 'a').c_str();
+        prefetchFilePath_.clear();
     }
 
     unsigned loadCompressedBcl(std::istream &source,
@@ -20,6 +20,8 @@
 #ifndef iSAAC_RTA_BCL_MAPPER_HH
 #define iSAAC_RTA_BCL_MAPPER_HH
 
+#include <chrono>
+
 #include <boost/format.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -223,7 +225,15 @@ public:
         ISAAC_TRACE_STAT("ParallelBclMapper::ParallelBclMapper for maxInputLoaders=" << maxInputLoaders)
     }
 
-    void mapTile(const flowcell::Layout &flowcell, const flowcell::TileMetadata &tileMetadata)
+    /**
+     * \param nextTileMetadata if not 0, once the tile is loaded, the loader threads tell the kernel to start
+     *                         reading the cycle files of nextTileMetadata so that its io overlaps with the
+     *                         processing of tileMetadata.
+     */
+    void mapTile(
+        const flowcell::Layout &flowcell,
+        const flowcell::TileMetadata &tileMetadata,
+        const flowcell::TileMetadata *nextTileMetadata = 0)
     {
         ISAAC_ASSERT_MSG(cycleNumbers_.capacity() >= flowcell.getDataCycles().size() + flowcell.getBarcodeCycles().size(),
                          "Insufficient capacity in cycleNumbers_ need " << flowcell.getDataCycles().size() + flowcell.getBarcodeCycles().size() << " got " << cycleNumbers_.size());
@@ -236,12 +246,16 @@ public:
 
         setGeometry(cycleNumbers_.size(), tileMetadata.getClusterCount());
 
+        const std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
         threads_.execute(boost::bind(
             &ParallelBclMapper::threadLoadBcls, this, _1, _2,
             tileMetadata.getClusterCount(),
-            boost::ref(flowcell), boost::ref(tileMetadata),
+            boost::ref(flowcell), boost::ref(tileMetadata), nextTileMetadata,
             cycleNumbers_.begin(),
             cycleNumbers_.end()), std::min<unsigned>(cycleNumbers_.size(), maxInputLoaders_));
+        ISAAC_THREAD_CERR << "Loaded " << cycleNumbers_.size() << " cycles for " << tileMetadata << " in " <<
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count() <<
+            "ms" << std::endl;
     }
 
     template <typename RandomAccessIteratorT>
@@ -279,6 +293,7 @@ private:
         const unsigned threadsTotal,
         const unsigned clusterCount,
         const flowcell::Layout &flowcell, const flowcell::TileMetadata &tileMetadata,
+        const flowcell::TileMetadata *nextTileMetadata,
         std::vector<unsigned>::const_iterator threadCyclesBegin,
         std::vector<unsigned>::const_iterator threadCyclesEnd)
     {
@@ -298,6 +313,19 @@ private:
 
             //ISAAC_THREAD_CERR << "Read " << clusters << " clusters from " << *threadCyclePathsBegin << std::endl;
         }
+
+        if (nextTileMetadata)
+        {
+            // the cycles of the current tile are in memory. Let the kernel fetch the same cycles of the next tile
+            // while the current one is being processed.
+            for(unsigned thistThreadCycleOffset = threadNumber;
+                std::distance(threadCyclesBegin, threadCyclesEnd) > thistThreadCycleOffset;
+                thistThreadCycleOffset += threadsTotal)
+            {
+                threadReaders_[threadNumber].prefetchTileCycle(
+                    flowcell, *nextTileMetadata, *(threadCyclesBegin + thistThreadCycleOffset));
+            }
+        }
     }
 };
 
@@ -28,6 +28,7 @@
 #include "common/Debug.hh"
 #include "common/FileSystem.hh"
 #include "common/Memory.hh"
+#include "common/SystemCompatibility.hh"
 #include "common/Threads.hpp"
 #include "flowcell/BclLayout.hh"
 #include "flowcell/TileMetadata.hh"
@@ -87,9 +88,25 @@ public:
         }
     }
 
+    /**
+     * \brief Lets the kernel read the cycle file of a tile that is going to be loaded later while the
+     *        current one is being processed.
+     */
+    void prefetchTileCycle(
+        const flowcell::Layout &flowcellLayout,
+        const flowcell::TileMetadata &tile,
+        const unsigned cycle)
+    {
+        flowcellLayout.getLaneTileCycleAttribute<flowcell::Layout::Bcl, flowcell::BclFilePathAttributeTag>(
+            tile.getLane(), tile.getTile(), cycle, prefetchFilePath_);
+        // missing files are dealt with when the tile actually gets loaded
+        common::readAhead(prefetchFilePath_.c_str(), 0, 0);
+    }
+
 private:
     const bool ignoreMissingBcls_;
     boost::filesystem::path cycleFilePath_;
+    boost::filesystem::path prefetchFilePath_;
     io::InflateGzipDecompressor<std::vector<char> > decompressor_;
 
     io::FileBufCache<io::FileBufWithReopen> bclFileBuffer_;
@@ -102,6 +119,8 @@ private:
         // ensure the cycleFilePath_ owns a buffer of maxFilePathLen capacity
         {cycleFilePath_ = std::string(reservePathLength, 'a');}
         cycleFilePath_.clear();
+        {prefetchFilePath_ = std::string(reservePathLength, 'a');}
+        prefetchFilePath_.clear();
 
         bclFileBuffer_.reservePathBuffers(reservePathLength);
     }
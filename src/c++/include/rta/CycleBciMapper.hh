@@ -100,6 +100,8 @@ public:
         return tileOffsets_.at(tileIndex);
     }
 
+    std::size_t getTilesCount() const {return tileOffsets_.size();}
+
 private:
     std::vector<VirtualOffset> tileOffsets_;
 };
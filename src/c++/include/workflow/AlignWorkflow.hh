@@ -35,6 +35,7 @@
 #include "alignment/TemplateLengthStatistics.hh"
 #include "alignment/matchFinder/TileClusterInfo.hh"
 #include "build/BinSorter.hh"
+#include "common/SystemCompatibility.hh"
 #include "common/Threads.hpp"
 #include "demultiplexing/BarcodeLoader.hh"
 #include "demultiplexing/BarcodeResolver.hh"
@@ -80,6 +81,9 @@ public:
         const std::vector<std::string> &argv,
         const std::string &description,
         const std::size_t hashTableBucketCount,
+        const bool canonicalKmerHash,
+        const bool kmerFingerprints,
+        const unsigned seedMinimizerWindow,
         const std::vector<flowcell::Layout> &flowcellLayoutList,
         const unsigned seedLength,
         const flowcell::BarcodeMetadataList &barcodeMetadataList,
@@ -114,12 +118,15 @@ public:
         const bool preAllocateBins,
         const bool putUnalignedInTheBack,
         const bool realignGapsVigorously,
+        const build::GapRealignerEngine realignEngine,
+        const bool realignmentCache,
         const bool realignDodgyFragments,
         const unsigned realignedGapsPerFragment,
         const bool clipSemialigned,
         const bool clipOverlapping,
         const bool scatterRepeats,
         const bool rescueShadows,
+        const bool bitParallelShadowRescue,
         const bool trimPEAdapters,
         const unsigned gappedMismatchesMax,
         const unsigned smitWatermanGapsMax,
@@ -144,6 +151,7 @@ public:
         const int bamGzipLevel,
         const std::string &bamPuFormat,
         const bool bamProduceMd5,
+        const bool bamMergeRuns,
         const std::vector<std::string> &bamHeaderTags,
         const double expectedBgzfCompressionRatio,
         const bool singleLibrarySamples,
@@ -210,6 +218,9 @@ private:
     const std::vector<std::string> &argv_;
     const std::string &description_;
     const std::size_t hashTableBucketCount_;
+    const bool canonicalKmerHash_;
+    const bool kmerFingerprints_;
+    const unsigned seedMinimizerWindow_;
     const std::vector<flowcell::Layout> &flowcellLayoutList_;
     const unsigned seedLength_;
     const bfs::path tempDirectory_;
@@ -252,12 +263,15 @@ private:
     const bool preAllocateBins_;
     const bool putUnalignedInTheBack_;
     const bool realignGapsVigorously_;
+    const build::GapRealignerEngine realignEngine_;
+    const bool realignmentCache_;
     const bool realignDodgyFragments_;
     const unsigned realignedGapsPerFragment_;
     const bool clipSemialigned_;
     const bool clipOverlapping_;
     const bool scatterRepeats_;
     const bool rescueShadows_;
+    const bool bitParallelShadowRescue_;
     const bool trimPEAdapters_;
     const unsigned gappedMismatchesMax_;
     const unsigned smitWatermanGapsMax_;
@@ -277,6 +291,7 @@ private:
     const int bamGzipLevel_;
     const std::string &bamPuFormat_;
     const bool bamProduceMd5_;
+    const bool bamMergeRuns_;
     const std::vector<std::string> &bamHeaderTags_;
     const bool singleLibrarySamples_;
     const bool keepDuplicates_;
@@ -314,6 +329,10 @@ private:
         std::vector<alignment::TemplateLengthStatistics> &barcodeTemplateLengthStatistics) const;
     void cleanupBins() const;
     void generateAlignmentReports() const;
+    void storeStageUsage(
+        const std::string &stage,
+        const uint64_t beginNs,
+        const common::ResourceUsage &begin) const;
     const demultiplexing::BarcodePathMap generateBam(
         const SelectedMatchesMetadata &binPaths,
         const std::vector<alignment::TemplateLengthStatistics> &barcodeTemplateLengthStatistics) const;
@@ -0,0 +1,148 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BenchmarkWorkflow.hh
+ **
+ ** \brief Times the alignment hot kernels in isolation on synthetic in-memory data
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_WORKFLOW_BENCHMARK_WORKFLOW_HH
+#define iSAAC_WORKFLOW_BENCHMARK_WORKFLOW_HH
+
+#include <string>
+#include <vector>
+
+#include <boost/assign.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "common/Threads.hpp"
+#include "reference/Contig.hh"
+
+namespace isaac
+{
+namespace workflow
+{
+
+namespace bfs = boost::filesystem;
+
+namespace benchmarkWorkflow
+{
+
+/**
+ * \brief Read sampled from the synthetic reference
+ */
+struct SyntheticRead
+{
+    // bases as sequenced, reverse-complemented for reverse reads
+    std::vector<char> bases_;
+    // bases in the orientation of the reference
+    std::vector<char> strandBases_;
+    uint64_t position_;
+    bool reverse_;
+    // offset in strandBases_ of the indel. 0 if the read has none
+    unsigned indelOffset_;
+    // positive for deletions, negative for insertions, as in gapRealigner::Gap
+    int indelLength_;
+};
+
+struct KernelResult
+{
+    std::string name_;
+    std::string unit_;
+    uint64_t items_;
+    double seconds_;
+    // sum of the kernel outputs. Same input and code path must produce the same checksum
+    uint64_t checksum_;
+};
+
+/**
+ * \brief Distribution of the reference kmers over the buckets of a hash policy
+ */
+struct HashOccupancy
+{
+    std::string policy_;
+    uint64_t buckets_;
+    uint64_t usedBuckets_;
+    uint64_t maxBucketKmers_;
+    // average number of kmers in the bucket of a reference kmer. Approximates the probe cost
+    double probedKmers_;
+};
+
+} // namespace benchmarkWorkflow
+
+class BenchmarkWorkflow: boost::noncopyable
+{
+public:
+    BenchmarkWorkflow(
+        const std::vector<std::string> &kernels,
+        const uint64_t referenceLength,
+        const unsigned readLength,
+        const unsigned reads,
+        const unsigned repeats,
+        const unsigned jobs,
+        const unsigned seed,
+        const bfs::path &tempDirectory,
+        const std::string &output);
+
+    void run();
+
+    static const std::vector<std::string> &getKernelNames()
+    {
+        static const std::vector<std::string> kernelNames = boost::assign::list_of
+            ("findMatches")("findReadMatches")("countMismatchesFast")("bandedSmithWaterman")
+            ("gapRealigner")("bgzfCompress")("fastqParse")("barcodeResolve")("hashPolicies");
+        return kernelNames;
+    }
+
+    /// shortest synthetic reference that leaves room to place the reads with indels away from the contig ends
+    static uint64_t getReferenceLengthMin(const unsigned readLength);
+
+private:
+    const std::vector<std::string> kernels_;
+    const unsigned readLength_;
+    const unsigned repeats_;
+    const unsigned jobs_;
+    const bfs::path tempDirectory_;
+    const std::string output_;
+
+    common::ThreadVector threads_;
+    reference::ContigLists contigLists_;
+    std::vector<benchmarkWorkflow::SyntheticRead> reads_;
+    std::vector<benchmarkWorkflow::KernelResult> results_;
+    std::vector<benchmarkWorkflow::HashOccupancy> hashOccupancy_;
+
+    template <typename PrepareT, typename RunT>
+    void measure(
+        const std::string &name, const std::string &unit, const uint64_t itemsPerThread,
+        PrepareT prepare, RunT run);
+
+    void benchmarkHash(const bool findMatches, const bool findReadMatches);
+    void benchmarkCountMismatches();
+    void benchmarkBandedSmithWaterman();
+    void benchmarkGapRealigner();
+    void benchmarkBgzfCompress();
+    void benchmarkFastqParse();
+    void benchmarkBarcodeResolve();
+    template <typename HashPolicyT> void benchmarkHashPolicy(const uint64_t bucketCount);
+    void benchmarkHashPolicies();
+
+    bool isSelected(const std::string &kernel) const;
+    void storeResults(std::ostream &os) const;
+};
+
+} // namespace workflow
+} // namespace isaac
+
+#endif // #ifndef iSAAC_WORKFLOW_BENCHMARK_WORKFLOW_HH
@@ -38,19 +38,44 @@ public:
         const bfs::path &sortedReferenceMetadata,
         const bfs::path &newXmlPath,
         const bfs::path &newDataFileDirectory,
-        const std::vector<std::string> &newOrder
+        const std::vector<std::string> &newOrder,
+        const bool packedCache,
+        const unsigned jobs
         );
 
     void run();
 
 private:
+    // large contigs are copied in pieces so that all threads get some work
+    static const std::size_t COPY_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    struct CopyChunk
+    {
+        bfs::path sourcePath_;
+        uint64_t sourceOffset_;
+        uint64_t targetOffset_;
+        uint64_t size_;
+        // contig header line to be written in front of the first chunk of the contig
+        std::string header_;
+        // the last chunk of a contig that does not end with a new line gets one appended
+        bool newLine_;
+    };
+
     const bfs::path sortedReferenceMetadata_;
     const bfs::path newXmlPath_;
     const bfs::path newDataFileDirectory_;
+    const bool packedCache_;
+    const unsigned jobs_;
 
     reference::SortedReferenceMetadata xml_;
     // translation array from new karyotype indexes to the original ones
     std::vector<unsigned> originalIndexes_;
+
+    void copyChunksThread(
+        const std::vector<CopyChunk> &chunks,
+        const bfs::path &targetPath,
+        std::size_t &nextChunk,
+        boost::mutex &mutex) const;
 };
 } // namespace workflow
 } // namespace isaac
@@ -0,0 +1,87 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SimulateRunWorkflow.hh
+ **
+ ** \brief Generates a synthetic reference and a paired-end fastq flowcell sequenced from it
+ **
+ ** \author Roman Petrovski
+ **/
+
+#ifndef iSAAC_WORKFLOW_SIMULATE_RUN_WORKFLOW_HH
+#define iSAAC_WORKFLOW_SIMULATE_RUN_WORKFLOW_HH
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace isaac
+{
+namespace workflow
+{
+
+namespace bfs = boost::filesystem;
+
+/**
+ * \brief Produces outputDirectory/genome.fa and outputDirectory/Fastq/lane1_read{1,2}.fastq.gz suitable for
+ *        isaac-sort-reference and isaac-align --base-calls-format fastq-gz. Read names carry the contig,
+ *        position and strand of the fragment so that the alignments can be checked against the truth.
+ */
+class SimulateRunWorkflow: boost::noncopyable
+{
+public:
+    SimulateRunWorkflow(
+        const bfs::path &outputDirectory,
+        const uint64_t referenceLength,
+        const unsigned contigs,
+        const double repeatFraction,
+        const unsigned readLength,
+        const unsigned clusters,
+        const unsigned fragmentLengthMean,
+        const unsigned fragmentLengthSd,
+        const double errorRate,
+        const double indelRate,
+        const double duplicateRate,
+        const unsigned seed);
+
+    void run();
+
+private:
+    const bfs::path outputDirectory_;
+    const uint64_t referenceLength_;
+    const unsigned contigCount_;
+    const double repeatFraction_;
+    const unsigned readLength_;
+    const unsigned clusters_;
+    const unsigned fragmentLengthMean_;
+    const unsigned fragmentLengthSd_;
+    const double errorRate_;
+    const double indelRate_;
+    const double duplicateRate_;
+
+    std::mt19937 generator_;
+    std::vector<std::string> contigs_;
+
+    void generateReference();
+    void storeReference(const bfs::path &fastaPath) const;
+    void generateFastq(const bfs::path &read1Path, const bfs::path &read2Path);
+    std::string makeFragment(const std::string &contig, const uint64_t position, const unsigned length);
+    void addSequencingErrors(std::string &read);
+};
+
+} // namespace workflow
+} // namespace isaac
+
+#endif // #ifndef iSAAC_WORKFLOW_SIMULATE_RUN_WORKFLOW_HH
@@ -128,6 +128,9 @@ public:
 
     FindHashMatchesTransition(
         const std::size_t hashTableBucketCount,
+        const bool canonicalKmerHash,
+        const bool kmerFingerprints,
+        const unsigned seedMinimizerWindow,
         const flowcell::FlowcellLayoutList &flowcellLayoutList,
         const flowcell::BarcodeMetadataList &barcodeMetadataList,
         const bool cleanupIntermediary,
@@ -168,6 +171,7 @@ public:
         const bool clipOverlapping,
         const bool scatterRepeats,
         const bool rescueShadows,
+        const bool bitParallelShadowRescue,
         const bool trimPEAdapters,
         const bool anchorMate,
         const unsigned gappedMismatchesMax,
@@ -224,12 +228,16 @@ private:
 
     static const unsigned SEEDS_PER_MATCH_MAX = 4;
     const std::size_t hashTableBucketCount_;
+    const bool canonicalKmerHash_;
+    const bool kmerFingerprints_;
+    const unsigned seedMinimizerWindow_;
     const flowcell::FlowcellLayoutList &flowcellLayoutList_;
     const bfs::path tempDirectory_;
     const bfs::path demultiplexingStatsXmlPath_;
     const unsigned coresMax_;
     const std::size_t candidateMatchesMax_;
     const unsigned matchFinderMaxRepeats_;
+    const unsigned matchFinderMinRepeats_;
     const unsigned seedBaseQualityMin_;
     const unsigned seedLength_;
     const unsigned repeatThreshold_;
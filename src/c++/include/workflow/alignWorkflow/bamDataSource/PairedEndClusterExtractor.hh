@@ -30,6 +30,7 @@
 
 #include "bam/Bam.hh"
 #include "bam/BamParser.hh"
+#include "common/BitHacks.hh"
 #include "common/FastIo.hh"
 #include "common/FileSystem.hh"
 #include "flowcell/ReadMetadata.hh"
@@ -64,19 +65,29 @@ struct IndexRecord
     }
 
     IndexRecord(
-        const bam::BamBlockHeader &block) : bamRecordPointer_(&block)
+        const bam::BamBlockHeader &block) : nameHash_(hashName(block.nameBegin(), block.nameEnd())), bamRecordPointer_(&block)
     {
-        nameHash_ = 0;
-        const std::size_t hashBytes = std::min<std::size_t>(block.getReadNameLength(), sizeof(nameHash_));
-        std::copy(block.nameEnd() - hashBytes, block.nameEnd(), reinterpret_cast<char*>(&nameHash_));
-
-        // This should not happen as names are normally made of printable characters
         if (EXTRACTED == nameHash_)
         {
             nameHash_ = 0;
         }
     }
 
+    /**
+     * \brief FNV-1a over the whole name followed by the murmur3 finalizer. Unlike the last 8 bytes of the name,
+     *        the result is uniform in all bits which keeps strcmp tie-breaks in the sort rare.
+     */
+    static NameHashType hashName(const char *nameBegin, const char *nameEnd)
+    {
+        NameHashType ret = 0xcbf29ce484222325UL;
+        for (; nameEnd != nameBegin; ++nameBegin)
+        {
+            ret ^= static_cast<unsigned char>(*nameBegin);
+            ret *= 0x100000001b3UL;
+        }
+        return common::murmur3Mix(ret);
+    }
+
     const bam::BamBlockHeader &getBlock() const {return *bamRecordPointer_;}
     void markExtracted() {nameHash_ = EXTRACTED;}
     bool isExtracted() const {return EXTRACTED == nameHash_;}
@@ -142,6 +153,7 @@ public:
     bool isEmpty() const {return recordIndex_.end() == firstUnextracted_;}
 
     void open(const boost::filesystem::path &tempFilePath, std::streamsize expectedFileSize);
+    void open(std::vector<char> &records);
 
     template <typename ClusterInsertIt, typename PfInsertIt>
     unsigned extractClusters(
@@ -207,6 +219,8 @@ public:
     }
 
 private:
+    void indexRecords();
+
     static std::vector<char>::const_iterator getNextRecord(const std::vector<char>::const_iterator it)
         {return it + reinterpret_cast<const unsigned &>(*it);}
 
@@ -298,18 +312,23 @@ class UnpairedReadsCache
     std::vector<common::PathStringType>::const_iterator extractorFileIterator_;
     bool extracting_;
     std::vector<io::FileBufHolder<io::FileBufWithReopen> > tempFiles_;
+    // unpaired records of each partition stay in memory until the partition buffer fills up. Only then they go
+    // to the partition temp file
+    std::vector<std::vector<char> > partitionBuffers_;
     common::PathStringType tempFilePathBuffer_;
     TempFileClusterExtractor extractor_;
+public:
     // aim to have ~3 gigabyte temp files assuming none of the input reads pair
     static const std::size_t UNPAIRED_BUFFER_SIZE = 1024UL * 1024UL * 1024UL * 3UL;
-public:
+
     UnpairedReadsCache(
         const boost::filesystem::path &tempDirectoryPath,
         const std::size_t maxBamFileSize,
         const std::size_t maxFlowcellIdLength,
         const std::size_t maxReadNameLength,
         const std::size_t minClusterLength,
-        const bool cleanupIntermediary) :
+        const bool cleanupIntermediary,
+        const std::size_t unpairedMemoryMax) :
             crcWidth_(log2(std::max<std::size_t>(1, maxBamFileSize / UNPAIRED_BUFFER_SIZE))),
             maxReadNameLength_(maxReadNameLength),
             cleanupIntermediary_(cleanupIntermediary),
@@ -322,6 +341,7 @@ public:
                 1 << getEffectiveCrcWidth<7>(crcWidth_),
                 io::FileBufHolder<io::FileBufWithReopen>(std::ios_base::out | std::ios_base::app | std::ios_base::binary,
                                                          getMaxTempFilePathLength(maxFlowcellIdLength))),
+            partitionBuffers_(tempFilePaths_.size()),
             extractor_(getMaxTempFilePathLength(maxFlowcellIdLength), UNPAIRED_BUFFER_SIZE, minClusterLength)
     {
         tempFilePathBuffer_.reserve(getMaxTempFilePathLength(maxFlowcellIdLength));
@@ -329,6 +349,10 @@ public:
         {
             tempPath.reserve(tempFilePathBuffer_.capacity());
         }
+        BOOST_FOREACH(std::vector<char> &partitionBuffer, partitionBuffers_)
+        {
+            partitionBuffer.reserve(unpairedMemoryMax / partitionBuffers_.size());
+        }
     }
 
     ~UnpairedReadsCache()
@@ -372,21 +396,13 @@ public:
             common::deleteFile(tempPath.c_str());
             tempFiles_[i].reopen(tempPath.c_str(), io::FileBufWithReopen::SequentialOnce);
             tempFileSizes_[i] = 0;
+            partitionBuffers_[i].clear();
             ++i;
         }
         extracting_ = false;
     }
 
-    void startExtractingUnpaired()
-    {
-        ISAAC_THREAD_CERR << "startExtractingUnpaired " << std::endl;
-        std::for_each(tempFiles_.begin(), tempFiles_.end(), boost::bind(&io::FileBufHolder<io::FileBufWithReopen>::flush, _1));
-
-        extractorFileIterator_ = tempFilePaths_.begin();
-        extractor_.open(
-            *extractorFileIterator_, tempFileSizes_[extractorFileIterator_ - tempFilePaths_.begin()]);
-        extracting_ = true;
-    }
+    void startExtractingUnpaired();
 
     template <typename IteratorT>
     void storeUnpaired(
@@ -411,9 +427,7 @@ public:
                 ++extractorFileIterator_;
                 if (tempFilePaths_.end() != extractorFileIterator_)
                 {
-                    extractor_.open(
-                        *extractorFileIterator_,
-                        tempFileSizes_[extractorFileIterator_ - tempFilePaths_.begin()]);
+                    openExtractor();
                 }
             }
         }
@@ -422,6 +436,9 @@ public:
 
 
 private:
+    void spillPartition(const unsigned partition);
+    void openExtractor();
+
     const common::PathCharType* makeTempFilePath(const std::string &flowcellId, unsigned crc)
     {
         return makeTempFilePath(flowcellId, crc, tempFilePathBuffer_).c_str();
@@ -499,7 +516,8 @@ public:
         const std::size_t maxReadNameLength,
         const std::size_t minClusterLength,
         const bool cleanupIntermediary,
-        const std::size_t expectedClustersPerClusterBlock) :
+        const std::size_t expectedClustersPerClusterBlock,
+        const std::size_t unpairedMemoryMax) :
             firstUnextracted_(end()),
             unpairedReadCache_(
                 tempDirectoryPath,
@@ -507,7 +525,8 @@ public:
                 maxFlowcellIdLength,
                 maxReadNameLength,
                 minClusterLength,
-                cleanupIntermediary)
+                cleanupIntermediary,
+                unpairedMemoryMax)
     {
         ISAAC_THREAD_CERR << "Reserving IndexRecord buffer for " << expectedClustersPerClusterBlock << " records" << std::endl;
         reserve(expectedClustersPerClusterBlock);
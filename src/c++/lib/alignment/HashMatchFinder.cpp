@@ -20,6 +20,7 @@
 #include "flowcell/Layout.hh"
 #include "alignment/HashMatchFinder.hh"
 #include "alignment/Quality.hh"
+#include "common/BitHacks.hh"
 #include "oligo/KmerGenerator.hpp"
 #include "reference/Seed.hh"
 
@@ -122,9 +123,11 @@ ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::ClusterHashMatchFinder(
     const ReferenceHash& referenceHash,
     const std::size_t candidateMatchesMax,
     const unsigned seedBaseQualityMin,
-    const unsigned seedRepeatsMax) :
+    const unsigned seedRepeatsMax,
+    const unsigned minimizerWindow) :
     SeedHashMatchFinder<ReferenceHash>(referenceHash, seedBaseQualityMin),
-    candidateMatchesMax_(candidateMatchesMax)
+    candidateMatchesMax_(candidateMatchesMax),
+    minimizerWindow_(minimizerWindow)
 {
 }
 
@@ -392,28 +395,110 @@ void iSAAC_PROFILING_NOINLINE ClusterHashMatchFinder<ReferenceHash, seedsPerMatc
     // else we either have too many candidate alignments or we have not used enough seeds to trust them.
 }
 
+/**
+ * \brief turns bases below seedBaseQualityMin into INVALID_OLIGO so that the kmer generator steps over them
+ */
+struct SeedBaseMasker
+{
+    SeedBaseMasker(const unsigned char seedBaseQualityMin = 0) : seedBaseQualityMin_(seedBaseQualityMin){}
+    unsigned char seedBaseQualityMin_;
+    unsigned char operator[](const char &base) const
+    {
+        return oligo::getQuality(base) < seedBaseQualityMin_ ?
+            oligo::INVALID_OLIGO : static_cast<unsigned char>(base & oligo::BCL_BASE_MASK);
+    }
+};
+
+template <typename ReferenceHash, unsigned seedsPerMatchMax>
+typename ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::SeedProbeResult
+ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::probeSeed(
+    const Cluster& cluster,
+    const KmerT &seedKmer,
+    const unsigned seedOffset,
+    const std::size_t seedRepeatThreshold,
+    SeedsHits& seedsHits,
+    std::size_t &repeatProbesAvoided) const
+{
+    ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(
+        cluster.getId(), "seed at offset : " << seedOffset << " " <<
+        (oligo::Bases<oligo::BITS_PER_BASE, KmerT>(seedKmer, oligo::KmerTraits<KmerT>::KMER_BASES)) << "/" <<
+        (oligo::ReverseBases<oligo::BITS_PER_BASE, KmerT>(seedKmer, oligo::KmerTraits<KmerT>::KMER_BASES)));
+    if (BaseT::referenceHash_.isKnownRepeat(seedKmer, seedRepeatThreshold))
+    {
+        ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "findReadMatches: " << seedOffset << " known repeat");
+        ++repeatProbesAvoided;
+        return SEED_REPEAT;
+    }
+
+    typename ReferenceHash::MatchRange fwMatchRange;
+    typename ReferenceHash::MatchRange rvMatchRange;
+    if (BaseT::referenceHash_.isCanonical())
+    {
+        // single probe gives both strands
+        BaseT::referenceHash_.findMatches(seedKmer, fwMatchRange, rvMatchRange);
+    }
+    else
+    {
+        fwMatchRange = BaseT::referenceHash_.findMatches(seedKmer);
+    }
+//        ISAAC_ASSERT_MSG(fwMatchRange.second == std::adjacent_find(fwMatchRange.first, fwMatchRange.second),
+//                         "Duplicate matches unexpected:" << *std::adjacent_find(fwMatchRange.first, fwMatchRange.second) << " " << oligo::bases<2>(seedKmer, Seed::KMER_BASES));
+//            for(auto it = fwMatchRange.first; it != fwMatchRange.second; ++it)
+//            {
+//                const reference::ContigList::Offset &referenceOffset = *it;
+//                ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "fw Hit offset:" << referenceOffset);
+//            }
+    if (std::size_t(std::distance(fwMatchRange.first, fwMatchRange.second)) >= seedRepeatThreshold)
+    {
+        ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "findReadMatches: " << seedOffset << " fwMatchRange: MatchRange(" << std::distance(fwMatchRange.first, fwMatchRange.second) << ")");
+        return SEED_REPEAT;
+    }
+
+    if (!BaseT::referenceHash_.isCanonical())
+    {
+        rvMatchRange = BaseT::referenceHash_.findMatches(oligo::reverseComplement(seedKmer));
+    }
+//            ISAAC_ASSERT_MSG(rvMatchRange.second == std::adjacent_find(rvMatchRange.first, rvMatchRange.second),
+//                             "Duplicate matches unexpected:" << *std::adjacent_find(rvMatchRange.first, rvMatchRange.second) << " " << oligo::bases<2>(seedKmer, Seed::KMER_BASES));
+//            for(auto it = rvMatchRange.first; it != rvMatchRange.second; ++it)
+//            {
+//                const reference::ContigList::Offset &referenceOffset = *it;
+//                ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "rv Hit offset:" << referenceOffset);
+//            }
+    const SeedHits hits = { seedOffset, fwMatchRange, rvMatchRange };
+    ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "findReadMatches: " << seedOffset << " " << hits);
+    if (hits.hitCount() >= seedRepeatThreshold)
+    {
+        return SEED_REPEAT;
+    }
+    else if (!hits.empty()) //empty hits are either due to no match (unlikely in human) or seed base quality filtering.
+    {
+        seedsHits.push_back(hits);
+        return SEED_HIT;
+    }
+    return SEED_NO_HITS;
+}
+
 template <typename ReferenceHash, unsigned seedsPerMatchMax>
 std::size_t iSAAC_PROFILING_NOINLINE ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::collectSeedHits(
     const Cluster& cluster,
     const unsigned readIndex,
     const std::size_t seedRepeatThreshold,
     const unsigned endSeedOffset,
-    SeedsHits& seedsHits) const
+    SeedsHits& seedsHits,
+    std::size_t &repeatProbesAvoided) const
 {
-    struct BadBaseMasker
+    if (minimizerWindow_ > 1 && MINIMIZER_READ_LENGTH_MIN <= endSeedOffset &&
+        minimizerWindow_ <= getMinimizerWindowMax(SEED_LENGTH, endSeedOffset))
     {
-        BadBaseMasker(const unsigned char seedBaseQualityMin = 0) : seedBaseQualityMin_(seedBaseQualityMin){}
-        unsigned char seedBaseQualityMin_;
-        unsigned char operator[](const char &base) const
-        {
-            return oligo::getQuality(base) < seedBaseQualityMin_ ?
-                oligo::INVALID_OLIGO : static_cast<unsigned char>(base & oligo::BCL_BASE_MASK);
-        }
-    } translator(BaseT::seedBaseQualityMin_);
+        return collectMinimizerSeedHits(cluster, readIndex, seedRepeatThreshold, endSeedOffset, seedsHits, repeatProbesAvoided);
+    }
+
+    const SeedBaseMasker translator(BaseT::seedBaseQualityMin_);
 
     typedef reference::Seed <KmerT> Seed;
     const BclClusters::const_iterator bclBegin = cluster.getBclData(readIndex);
-    oligo::InterleavedKmerGenerator<Seed::KMER_BASES, typename Seed::KmerType, BclClusters::const_iterator, Seed::STEP, decltype(translator)>
+    oligo::InterleavedKmerGenerator<Seed::KMER_BASES, typename Seed::KmerType, BclClusters::const_iterator, Seed::STEP, SeedBaseMasker>
         kmerGenerator(bclBegin, bclBegin + endSeedOffset, translator);
 
     std::size_t repeatSeeds = 0;
@@ -422,47 +507,109 @@ std::size_t iSAAC_PROFILING_NOINLINE ClusterHashMatchFinder<ReferenceHash, seeds
     while (kmerGenerator.next(seedKmer, bclCurrent))
     {
         const unsigned seedOffset = std::distance(bclBegin, bclCurrent);
-
-        ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(
-            cluster.getId(), "seed at offset : " << seedOffset << " " <<
-            (oligo::Bases<oligo::BITS_PER_BASE, KmerT>(seedKmer, oligo::KmerTraits<KmerT>::KMER_BASES)) << "/" <<
-            (oligo::ReverseBases<oligo::BITS_PER_BASE, KmerT>(seedKmer, oligo::KmerTraits<KmerT>::KMER_BASES)) << " endSeedOffset:" << endSeedOffset);
-        const typename ReferenceHash::MatchRange fwMatchRange = BaseT::referenceHash_.findMatches(seedKmer);
-//        ISAAC_ASSERT_MSG(fwMatchRange.second == std::adjacent_find(fwMatchRange.first, fwMatchRange.second),
-//                         "Duplicate matches unexpected:" << *std::adjacent_find(fwMatchRange.first, fwMatchRange.second) << " " << oligo::bases<2>(seedKmer, Seed::KMER_BASES));
-//            for(auto it = fwMatchRange.first; it != fwMatchRange.second; ++it)
-//            {
-//                const reference::ContigList::Offset &referenceOffset = *it;
-//                ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "fw Hit offset:" << referenceOffset);
-//            }
-        if (std::size_t(std::distance(fwMatchRange.first, fwMatchRange.second)) >= seedRepeatThreshold)
+        const SeedProbeResult result = probeSeed(cluster, seedKmer, seedOffset, seedRepeatThreshold, seedsHits, repeatProbesAvoided);
+        if (SEED_REPEAT == result)
         {
-            ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "findReadMatches: " << seedOffset << " fwMatchRange: MatchRange(" << std::distance(fwMatchRange.first, fwMatchRange.second) << ")");
             ++repeatSeeds;
         }
-        else
+        else if (SEED_HIT == result)
+        {
+            kmerGenerator.skip(KmerT::KMER_BASES - 1);
+        }
+    }
+    return repeatSeeds;
+}
+
+/**
+ * \brief Order of kmers for minimizer selection. Same for the kmer and its reverse complement so that both
+ *        strands of the read choose the same seeds. Hashed to avoid preferring low-complexity poly-A seeds.
+ */
+template <typename KmerT>
+inline uint64_t minimizerOrder(const KmerT &kmer)
+{
+    return common::murmur3Mix(uint64_t(std::min(kmer, oligo::reverseComplement(kmer)).bits_));
+}
+
+/**
+ * \brief Probes only the (minimizerWindow_, SEED_LENGTH) minimizers of the read instead of every kmer position.
+ *        Seeds that overlap a seed that had hits are skipped, same as in collectSeedHits.
+ */
+template <typename ReferenceHash, unsigned seedsPerMatchMax>
+std::size_t iSAAC_PROFILING_NOINLINE ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::collectMinimizerSeedHits(
+    const Cluster& cluster,
+    const unsigned readIndex,
+    const std::size_t seedRepeatThreshold,
+    const unsigned endSeedOffset,
+    SeedsHits& seedsHits,
+    std::size_t &repeatProbesAvoided) const
+{
+    const SeedBaseMasker translator(BaseT::seedBaseQualityMin_);
+
+    typedef reference::Seed <KmerT> Seed;
+    const BclClusters::const_iterator bclBegin = cluster.getBclData(readIndex);
+    oligo::InterleavedKmerGenerator<Seed::KMER_BASES, typename Seed::KmerType, BclClusters::const_iterator, Seed::STEP, SeedBaseMasker>
+        kmerGenerator(bclBegin, bclBegin + endSeedOffset, translator);
+
+    struct ReadKmer
+    {
+        uint64_t order_;
+        typename KmerT::BitsType bits_;
+        unsigned offset_;
+    };
+    common::StaticVector<ReadKmer, ISAAC_READ_LENGTH_MAX> readKmers;
+
+    KmerT kmer(0);
+    BclClusters::const_iterator bclCurrent;
+    while (kmerGenerator.next(kmer, bclCurrent))
+    {
+        const ReadKmer readKmer = {minimizerOrder(kmer), kmer.bits_, unsigned(std::distance(bclBegin, bclCurrent))};
+        readKmers.push_back(readKmer);
+    }
+
+    // if there are fewer kmers than the window size, the whole read is one window
+    const std::size_t windowSize = std::min<std::size_t>(minimizerWindow_, readKmers.size());
+    // monotone deque of readKmers indexes. Orders increase strictly from front to back and the front is the
+    // leftmost smallest kmer of the current window. Each index enters once, so the deque never wraps.
+    common::StaticVector<unsigned, ISAAC_READ_LENGTH_MAX> candidates;
+    std::size_t candidatesFront = 0;
+
+    std::size_t repeatSeeds = 0;
+    std::size_t lastMinimizer = readKmers.size();
+    unsigned seedOffsetMin = 0;
+    for (std::size_t windowEnd = 0; readKmers.size() != windowEnd; ++windowEnd)
+    {
+        while (candidates.size() != candidatesFront && readKmers[candidates.back()].order_ > readKmers[windowEnd].order_)
         {
-            seedKmer = oligo::reverseComplement(seedKmer);
+            candidates.pop_back();
+        }
+        candidates.push_back(windowEnd);
 
-            const typename ReferenceHash::MatchRange rvMatchRange = BaseT::referenceHash_.findMatches(seedKmer);
-//            ISAAC_ASSERT_MSG(rvMatchRange.second == std::adjacent_find(rvMatchRange.first, rvMatchRange.second),
-//                             "Duplicate matches unexpected:" << *std::adjacent_find(rvMatchRange.first, rvMatchRange.second) << " " << oligo::bases<2>(seedKmer, Seed::KMER_BASES));
-//            for(auto it = rvMatchRange.first; it != rvMatchRange.second; ++it)
-//            {
-//                const reference::ContigList::Offset &referenceOffset = *it;
-//                ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "rv Hit offset:" << referenceOffset);
-//            }
-            const SeedHits hits = { seedOffset, fwMatchRange, rvMatchRange };
-            ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(cluster.getId(), "findReadMatches: " << seedOffset << " " << hits);
-            if (hits.hitCount() >= seedRepeatThreshold)
-            {
-                ++repeatSeeds;
-            }
-            else if (!hits.empty()) //empty hits are either due to no match (unlikely in human) or seed base quality filtering.
-            {
-                seedsHits.push_back(hits);
-                kmerGenerator.skip(KmerT::KMER_BASES - 1);
-            }
+        if (windowEnd + 1 < windowSize)
+        {
+            continue;
+        }
+        if (candidates[candidatesFront] + windowSize <= windowEnd)
+        {
+            ++candidatesFront;
+        }
+
+        const std::size_t minimizerIndex = candidates[candidatesFront];
+        const ReadKmer &minimizer = readKmers[minimizerIndex];
+        if (lastMinimizer == minimizerIndex || seedOffsetMin > minimizer.offset_)
+        {
+            continue;
+        }
+        lastMinimizer = minimizerIndex;
+
+        const SeedProbeResult result = probeSeed(
+            cluster, KmerT(minimizer.bits_), minimizer.offset_, seedRepeatThreshold, seedsHits, repeatProbesAvoided);
+        if (SEED_REPEAT == result)
+        {
+            ++repeatSeeds;
+        }
+        else if (SEED_HIT == result)
+        {
+            seedOffsetMin = minimizer.offset_ + KmerT::KMER_BASES;
         }
     }
     return repeatSeeds;
@@ -477,7 +624,8 @@ std::size_t ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::findReadMat
     const std::size_t seedRepeatThreshold,
     MatchLists& matchLists,
     ReferenceOffsetLists& fwMergeBuffers,
-    ReferenceOffsetLists& rvMergeBuffers) const
+    ReferenceOffsetLists& rvMergeBuffers,
+    std::size_t &repeatProbesAvoided) const
 {
     //ISAAC_ASSERT_CERR << "findReadMatches" << std::endl;
     ISAAC_ASSERT_MSG(matchLists.capacity() > seedsPerMatchMax,
@@ -485,10 +633,14 @@ std::size_t ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::findReadMat
     for (Matches &matches : matchLists) {matches.clear();}
 
     SeedsHits seedsHits;
-    const std::size_t repeatSeeds = collectSeedHits(cluster, readMetadata.getIndex(), seedRepeatThreshold, readMetadata.getLength(), seedsHits);
+    // don't look for seeds in the padding of the variable-length reads. Kmer generator needs at least some data.
+    const unsigned readLength = std::min<unsigned>(
+        readMetadata.getLength(), std::max<unsigned>(SEED_LENGTH, cluster.at(readMetadata.getIndex()).getUnpaddedLength()));
+    const std::size_t repeatSeeds = collectSeedHits(
+        cluster, readMetadata.getIndex(), seedRepeatThreshold, readLength, seedsHits, repeatProbesAvoided);
 
     // demand LONG_READ_SEEDS_MIN unless read is too short, otherwise demand SHORT_READ_SEEDS_MIN.
-    const unsigned seedsMin = std::min(LONG_READ_SEEDS_MIN, std::max(SHORT_READ_SEEDS_MIN, readMetadata.getLength() / 2 / SEED_LENGTH));
+    const unsigned seedsMin = std::min(LONG_READ_SEEDS_MIN, std::max(SHORT_READ_SEEDS_MIN, readLength / 2 / SEED_LENGTH));
     if (seedsMin <= seedsHits.size())
     {
         std::sort(seedsHits.begin(), seedsHits.end());
@@ -510,7 +662,8 @@ std::size_t ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::findHeadAnc
     const unsigned headSeedOffsetMax,
     MatchLists& matchLists,
     ReferenceOffsetLists& fwMergeBuffers,
-    ReferenceOffsetLists& rvMergeBuffers) const
+    ReferenceOffsetLists& rvMergeBuffers,
+    std::size_t &repeatProbesAvoided) const
 {
     //ISAAC_ASSERT_CERR << "findReadMatches" << std::endl;
     ISAAC_ASSERT_MSG(matchLists.capacity() > seedsPerMatchMax,
@@ -521,7 +674,8 @@ std::size_t ClusterHashMatchFinder<ReferenceHash, seedsPerMatchMax>::findHeadAnc
 //    if (headSeedOffsetMax + reference::Seed<KmerT>::SEED_LENGTH <= readMetadata.getLength())
     {
         SeedsHits seedsHits;
-        const std::size_t repeatSeeds = collectSeedHits(cluster, readMetadata.getIndex(), seedRepeatThreshold, headSeedOffsetMax, seedsHits);
+        const std::size_t repeatSeeds = collectSeedHits(
+            cluster, readMetadata.getIndex(), seedRepeatThreshold, headSeedOffsetMax, seedsHits, repeatProbesAvoided);
         if (SV_READ_SEEDS_MIN <= seedsHits.size())
         {
             std::sort(seedsHits.begin(), seedsHits.end());
@@ -32,6 +32,7 @@
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
 #include "common/FastIo.hh"
+#include "common/Trace.hh"
 #include "reference/Contig.hh"
 #include "reference/ContigLoader.hh"
 
@@ -85,6 +86,7 @@ MatchSelector::MatchSelector(
         const bool clipOverlapping,
         const bool scatterRepeats,
         const bool rescueShadows,
+        const bool bitParallelShadowRescue,
         const bool trimPEAdapters,
         const bool anchorMate,
         const unsigned gappedMismatchesMax,
@@ -155,7 +157,8 @@ MatchSelector::MatchSelector(
                                                               smithWatermanGapSizeMax,
                                                               splitAlignments,
                                                               alignmentCfg,
-                                                              dodgyAlignmentScore, anomalousPairHandicap, reserveBuffers));
+                                                              dodgyAlignmentScore, anomalousPairHandicap, reserveBuffers,
+                                                              bitParallelShadowRescue));
     }
     ISAAC_TRACE_STAT("Constructed match selector");
 }
@@ -240,19 +243,28 @@ void MatchSelector::alignThread(
     const flowcell::ReadMetadataList &tileReads = flowcell.getReadMetadataList();
     const std::size_t barcodeLength = flowcell.getBarcodeLength();
     const unsigned readNameLength = flowcell.getReadNameLength();
+    const bool variableReadLength = flowcell.isVariableReadLength();
 
     const reference::ContigLists &threadContigLists = contigLists_.threadNodeContainer();
+    const bool learnTemplateLengths = 2 == tileReads.size() && templateDetector_.learnsFromAlignedClusters();
 
     boost::unique_lock<boost::mutex> lock(mutex_);
 
     while (tileMetadata.getClusterCount() != threadClusterId)
     {
         const unsigned clustersBegin = threadClusterId;
-        static const unsigned clustersAtATime = CLUSTERS_AT_A_TIME;
-        threadClusterId += std::min(clustersAtATime, tileMetadata.getClusterCount() - threadClusterId);
+        const unsigned clustersLeft = tileMetadata.getClusterCount() - threadClusterId;
+        // guided scheduling: blocks shrink as the tile drains so that all threads run out of work at about the
+        // same time instead of waiting for the one that grabbed the last full block.
+        static const unsigned clustersAtATimeMin = CLUSTERS_AT_A_TIME_MIN;
+        static const unsigned clustersAtATimeMax = CLUSTERS_AT_A_TIME;
+        const unsigned clustersAtATime = std::max(
+            clustersAtATimeMin, std::min<unsigned>(clustersAtATimeMax, clustersLeft / (computeThreads_.size() * 2)));
+        threadClusterId += std::min(clustersAtATime, clustersLeft);
         const unsigned clustersEnd = threadClusterId;
         {
             common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+            ISAAC_TRACE_SPAN("select");
             for (unsigned clusterId = clustersBegin; clustersEnd != clusterId; ++clusterId)
             {
                 if (!clusterIdList_.empty() && clusterIdList_.end() == std::find(clusterIdList_.begin(), clusterIdList_.end(), clusterId))
@@ -279,6 +291,10 @@ void MatchSelector::alignThread(
                     ISAAC_ASSERT_MSG(clusterId < tileMetadata.getClusterCount(), "Cluster ids are expected to be 0-based within the tile.");
 
                     trimLowQualityEnds(ourThreadCluster, baseQualityCutoff_);
+                    if (variableReadLength)
+                    {
+                        maskPadding(ourThreadCluster);
+                    }
 
                     // if pfOnly_ is set, this non-pf cluster will not be reported as a regularly-processed one.
                     // if match list begins with noMatchReferencePosition, then this cluster does not have any matches at all. This is
@@ -292,6 +308,13 @@ void MatchSelector::alignThread(
                             restOfGenomeCorrections_[barcodeMetadata.getIndex()],
                             threadNumber, ourThreadTemplateBuilder, ourThreadCluster, bamTemplate, ourThreadStats,
                             fragmentStorage);
+
+                        if (learnTemplateLengths && bclData.pf(clusterId) &&
+                            !templateLengthStatistics[barcodeMetadata.getIndex()].isStable())
+                        {
+                            templateDetector_.collectAlignedTemplate(
+                                threadNumber, barcodeMetadata.getIndex(), ourThreadTemplateBuilder.getFragments());
+                        }
                     }
                 }
                 ourThreadStats.recordTemplate(
@@ -337,6 +360,8 @@ void MatchSelector::parallelSelect(
 
     ISAAC_THREAD_CERR << "Selecting matches on " <<  computeThreads_.size() << " threads for " << tileMetadata << "\n" << std::endl;
     unsigned clusterId = 0;
+    const std::size_t repeatProbesAvoidedBefore = getRepeatProbesAvoided();
+    const std::size_t fastPathTemplatesBefore = getFastPathTemplates();
     computeThreads_.execute(boost::bind(&MatchSelector::alignThread<MatchFinderT>, this, _1,
                                         boost::ref(tileMetadata),
                                         boost::ref(tileClusterInfo.at(tileMetadata.getIndex())),
@@ -346,12 +371,21 @@ void MatchSelector::parallelSelect(
                                         boost::cref(barcodeTemplateLengthStatistics),
                                         boost::ref(fragmentStorage)));
 
+    ISAAC_TRACE_COUNTER("clustersSelected", clusterId);
     ISAAC_THREAD_CERR << "Selecting matches done on " <<  computeThreads_.size() << " threads for " << clusterId << " clusters of " << tileMetadata  << std::endl;
+    const std::size_t repeatProbesAvoided = getRepeatProbesAvoided() - repeatProbesAvoidedBefore;
+    ISAAC_THREAD_CERR << "Repeat filter avoided " << repeatProbesAvoided << " hash probes for " << tileMetadata << std::endl;
+    ISAAC_TRACE_COUNTER("fastPathTemplates", getFastPathTemplates() - fastPathTemplatesBefore);
+    ISAAC_THREAD_CERR << "Fast path resolved " << getFastPathTemplates() - fastPathTemplatesBefore <<
+        " templates of " << tileMetadata << std::endl;
+
+    templateDetector_.publishAlignedTemplates(tileMetadata, barcodeTemplateLengthStatistics);
 
     BOOST_FOREACH(const matchSelector::MatchSelectorStats &threadStats, threadStats_)
     {
         allStats_.at(tileMetadata.getIndex()) += threadStats;
     }
+    allStats_.at(tileMetadata.getIndex()).recordRepeatProbesAvoided(repeatProbesAvoided);
 }
 
 void MatchSelector::reserveMemory(
@@ -128,6 +128,24 @@ void trimLowQualityEnd(Read &read, const unsigned baseQualityCutoff)
     }
 }
 
+/**
+ * \brief Variable-length reads are padded with no-calls up to the read length. Mask the padding so that
+ *        the aligners don't spend time on it and it gets soft-clipped instead of reported as mismatches.
+ *        Reads that have no called bases at all are left alone.
+ */
+void maskPadding(Cluster &cluster)
+{
+    for (unsigned readIndex = 0; cluster.getNonEmptyReadsCount() > readIndex; ++readIndex)
+    {
+        Read &read = cluster[readIndex];
+        const unsigned padding = read.getLength() - read.getUnpaddedLength();
+        if (read.getUnpaddedLength() && padding > read.getEndCyclesMasked())
+        {
+            read.maskCyclesFromEnd(padding);
+        }
+    }
+}
+
 void trimLowQualityEnds(Cluster &cluster, const unsigned baseQualityCutoff)
 {
     if (!baseQualityCutoff)
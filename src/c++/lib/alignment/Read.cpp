@@ -48,12 +48,14 @@ void Read::decodeBcl(
     reverseQuality_.clear();
     /*beginCyclesMasked_ = 0L;*/
     endCyclesMasked_ = 0L;
+    unpaddedLength_ = 0;
 
     for (BclClusters::const_iterator bcl = bclBegin; bclEnd > bcl; ++bcl)
     {
 
         if (!oligo::isBclN(*bcl))
         {
+            unpaddedLength_ = std::distance(bclBegin, bcl) + 1;
             forwardSequence_.push_back(oligo::getBase((*bcl) & 3, true));
             reverseSequence_.push_back(oligo::getBase((~(*bcl)) & 3, true));
             forwardQuality_.push_back(oligo::getQuality(*bcl));
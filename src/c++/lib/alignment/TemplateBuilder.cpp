@@ -62,7 +62,9 @@ TemplateBuilder::TemplateBuilder(
     const AlignmentCfg &alignmentCfg,
     const DodgyAlignmentScore dodgyAlignmentScore,
     const unsigned anomalousPairHandicap,
-    const bool reserveBuffers)
+    const bool reserveBuffers,
+    const bool bitParallelShadowRescue,
+    const bool fastPath)
     : repeatThreshold_(repeatThreshold)
     , seedLength_(seedLength)
     , matchFinderTooManyRepeats_(matchFinderTooManyRepeats)
@@ -70,6 +72,7 @@ TemplateBuilder::TemplateBuilder(
     , matchFinderShadowSplitRepeats_(matchFinderShadowSplitRepeats)
     , scatterRepeats_(scatterRepeats)
     , rescueShadows_(rescueShadows)
+    , fastPath_(fastPath)
     , dodgyAlignmentScore_(dodgyAlignmentScore)
     , anomalousPairHandicap_(pow10(double(anomalousPairHandicap) / 10.0) - 1.0)//anomalousPairHandicap)
     , smitWatermanGapsMax_(smitWatermanGapsMax)
@@ -84,10 +87,12 @@ TemplateBuilder::TemplateBuilder(
         smartSmithWaterman, smithWatermanGapSizeMax, !smitWatermanGapsMax_, splitAlignments,
         alignmentCfg_, cigarBuffer_, reserveBuffers)
     , shadowAligner_(collectMismatchCycles, flowcellLayoutList,
-                     gappedMismatchesMax, smitWatermanGapsMax_, smartSmithWaterman, !smitWatermanGapsMax_, splitAlignments, alignmentCfg_, cigarBuffer_)
+                     gappedMismatchesMax, smitWatermanGapsMax_, smartSmithWaterman, !smitWatermanGapsMax_, splitAlignments, alignmentCfg_, cigarBuffer_,
+                     bitParallelShadowRescue)
     , splitReadAligner_(collectMismatchCycles, alignmentCfg_)
     , bestCombinationPairInfo_(0)
     , bestRescuedPair_(0)
+    , fastPathTemplates_(0)
 
 {
 //    if (reserveBuffers)
@@ -121,6 +126,35 @@ TemplateBuilder::TemplateBuilder(
     }
 }
 
+bool TemplateBuilder::isFastPathTemplate(const BamTemplate &bamTemplate) const
+{
+    if (2 != bamTemplate.getFragmentCount() || !bamTemplate.isProperPair())
+    {
+        return false;
+    }
+
+    for (unsigned i = 0; bamTemplate.getFragmentCount() != i; ++i)
+    {
+        const FragmentMetadata &fragment = bamTemplate.getFragmentMetadata(i);
+        if (!fragment.isAligned() || 1 != fragment.repeatCount || !fragment.isUniquelyAligned() ||
+            fragment.gapCount || fragment.isSplit() || fragment.decoyAlignment ||
+            fragment.getBeginClippedLength() || fragment.getEndClippedLength() ||
+            FAST_PATH_EDITS_MAX < fragment.getMismatchCount() || FAST_PATH_EDITS_MAX < fragment.getEditDistance() ||
+            seedLength_ > fragment.getObservedLength())
+        {
+            return false;
+        }
+
+        // N does not count as edit but does count as mismatch when anchors are made
+        const std::vector<char> &sequence = fragment.getRead().getForwardSequence();
+        if (sequence.end() != std::find(sequence.begin(), sequence.end(), 'N'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * \return false if template needs to go into unaligned bin
  */
@@ -323,6 +323,16 @@ void TemplateLengthDistribution::appendModel(
     }
 }
 
+void TemplateLengthDistribution::accumulateModel(
+    const TemplateLengthStatistics::AlignmentModel am,
+    const uint64_t length)
+{
+    if (histograms_[am].append(length))
+    {
+        ++count_;
+    }
+}
+
 bool TemplateLengthDistribution::appendUniqueTemplate(const FragmentMetadata &perfect0, const FragmentMetadata &perfect1)
 {
     const AlignmentModel model = getAlignmentModel(perfect0, perfect1);
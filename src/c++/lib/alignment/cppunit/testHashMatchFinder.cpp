@@ -55,7 +55,11 @@ void TestHashMatchFinder::tearDown()
 
 TestMatchStorage TestHashMatchFinder::findMatches(
     const std::string& reference, const std::string& sequence,
-    const isaac::flowcell::ReadMetadataList &readMetadataList)
+    const isaac::flowcell::ReadMetadataList &readMetadataList,
+    const bool canonical,
+    const bool fingerprints,
+    const std::size_t bucketCount,
+    const unsigned minimizerWindow)
 {
     TestContigList contigList(reference);
 
@@ -63,7 +67,7 @@ TestMatchStorage TestHashMatchFinder::findMatches(
     isaac::reference::ReferenceHasher<isaac::reference::ReferenceHash<isaac::oligo::VeryShortKmerType> > referenceHasher(
         contigList, threads, threads.size());
 
-    const isaac::reference::ReferenceHash<isaac::oligo::VeryShortKmerType> referenceHash = referenceHasher.generate(0x10000);
+    const isaac::reference::ReferenceHash<isaac::oligo::VeryShortKmerType> referenceHash = referenceHasher.generate(bucketCount >> canonical, canonical, fingerprints);
 
     isaac::flowcell::FlowcellLayoutList flowcells(1, isaac::flowcell::Layout("", isaac::flowcell::Layout::Fastq, isaac::flowcell::FastqFlowcellData(false, '!', false), 8, 0, std::vector<unsigned>(),
                                          readMetadataList, "blah"));
@@ -92,15 +96,17 @@ TestMatchStorage TestHashMatchFinder::findMatches(
 //        referenceHash, flowcells, isaac::flowcell::BarcodeMetadataList(), 0, repeatThreshold, std::vector<std::size_t>(),
 //        sortedReferenceMetadataList, seedMetadataList, seedMetadataList.size());
     isaac::alignment::ClusterHashMatchFinder< isaac::reference::ReferenceHash<isaac::oligo::VeryShortKmerType>, 4> matchFinder(
-        referenceHash, 1000, 0, 1000);
+        referenceHash, 1000, 0, 1000, minimizerWindow);
 
     isaac::alignment::ReferenceOffsetLists fwMergeBuffers(11, isaac::alignment::ReferenceOffsetList(1000));
     isaac::alignment::ReferenceOffsetLists rvMergeBuffers(11, isaac::alignment::ReferenceOffsetList(1000));
 
     isaac::alignment::matchFinder::TileClusterInfo tileClusterInfo(tileMetadataList);
     tileClusterInfo.setBarcodeIndex(0, 0, 0);
+    std::size_t repeatProbesAvoided = 0;
     matchFinder.findReadMatches(
-        contigList, cluster, flowcells.front().getReadMetadataList().front(), 1000, matchLists, fwMergeBuffers, rvMergeBuffers);
+        contigList, cluster, flowcells.front().getReadMetadataList().front(), 1000, matchLists, fwMergeBuffers, rvMergeBuffers,
+        repeatProbesAvoided);
 
     return matchLists;
 }
@@ -278,3 +284,137 @@ void TestHashMatchFinder::testEverything()
 //    }
     }
 }
+
+void TestHashMatchFinder::testCanonical()
+{
+    {
+        std::string reference("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        std::string sequence ("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length() + 1, 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, true);
+
+        CPPUNIT_ASSERT_EQUAL(0UL, matchLists.at(1).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(false, matchLists.at(4).at(0).reverse_);
+    }
+
+    {
+        std::string reference("ATGAGAATTGCTTGAATCACAGAGGTGGAGGTTACAGTGAGCTGAAATGGCGCCGCTGCACTCCAGCCTGGGCGACAAAGTGAGACTCAGCTTCCCCCAC");
+        std::string sequence ("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, 100, 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, true);
+
+        CPPUNIT_ASSERT_EQUAL(0UL, matchLists.at(1).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(true, matchLists.at(4).at(0).reverse_);
+    }
+}
+
+void TestHashMatchFinder::testFingerprints()
+{
+    // with so few buckets every bucket is shared by many kmers. Fingerprints should keep the collisions out
+    {
+        std::string reference("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        std::string sequence ("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length() + 1, 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, false, true, 0x10);
+
+        CPPUNIT_ASSERT_EQUAL(0UL, matchLists.at(1).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(false, matchLists.at(4).at(0).reverse_);
+    }
+
+    {
+        std::string reference("ATGAGAATTGCTTGAATCACAGAGGTGGAGGTTACAGTGAGCTGAAATGGCGCCGCTGCACTCCAGCCTGGGCGACAAAGTGAGACTCAGCTTCCCCCAC");
+        std::string sequence ("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, 100, 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, true, true, 0x10);
+
+        CPPUNIT_ASSERT_EQUAL(0UL, matchLists.at(1).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(true, matchLists.at(4).at(0).reverse_);
+    }
+}
+
+/**
+ * \brief deterministic sequence with no long repeats
+ */
+static std::string makeSequence(const unsigned length)
+{
+    std::string ret;
+    unsigned state = 12345;
+    while (length != ret.length())
+    {
+        state = state * 1103515245 + 12345;
+        ret.push_back("ACGT"[(state >> 16) & 3]);
+    }
+    return ret;
+}
+
+static std::string reverseComplement(const std::string &sequence)
+{
+    std::string ret;
+    for (std::string::const_reverse_iterator it = sequence.rbegin(); sequence.rend() != it; ++it)
+    {
+        ret.push_back('A' == *it ? 'T' : 'C' == *it ? 'G' : 'G' == *it ? 'C' : 'A');
+    }
+    return ret;
+}
+
+void TestHashMatchFinder::testMinimizers()
+{
+    // long read seeded with minimizers finds the same match as with every seed probed
+    {
+        std::string reference(makeSequence(300));
+        std::string sequence(reference);
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length(), 0, 0));
+        TestMatchStorage allSeedsMatchLists = findMatches(reference, sequence, readMetadataList);
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, false, false, 0x10000, 10);
+
+        CPPUNIT_ASSERT_EQUAL(1UL, allSeedsMatchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(false, matchLists.at(4).at(0).reverse_);
+    }
+
+    // minimizer order is strand-independent, reverse reads find their match too
+    {
+        std::string reference(makeSequence(300));
+        std::string sequence(reverseComplement(reference));
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length(), 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, false, false, 0x10000, 10);
+
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(true, matchLists.at(4).at(0).reverse_);
+    }
+
+    // window too wide to leave enough seeds in the read falls back to probing every seed, so the read still matches
+    {
+        std::string reference(makeSequence(300));
+        std::string sequence(reference);
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length(), 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, false, false, 0x10000, 1000);
+
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(false, matchLists.at(4).at(0).reverse_);
+    }
+
+    // short reads ignore the minimizer window
+    {
+        std::string reference("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        std::string sequence ("GTGGGGGAAGCTGAGTCTCACTTTGTCGCCCAGGCTGGAGTGCAGCGGCGCCATTTCAGCTCACTGTAACCTCCACCTCTGTGATTCAAGCAATTCTCAT");
+        isaac::flowcell::ReadMetadataList readMetadataList(1, isaac::flowcell::ReadMetadata(1, sequence.length() + 1, 0, 0));
+        TestMatchStorage matchLists = findMatches(reference, sequence, readMetadataList, false, false, 0x10000, 10);
+
+        CPPUNIT_ASSERT_EQUAL(0UL, matchLists.at(1).size());
+        CPPUNIT_ASSERT_EQUAL(1UL, matchLists.at(4).size());
+        CPPUNIT_ASSERT_EQUAL(1000U, matchLists.at(4).at(0).contigListOffset_);
+        CPPUNIT_ASSERT_EQUAL(false, matchLists.at(4).at(0).reverse_);
+    }
+}
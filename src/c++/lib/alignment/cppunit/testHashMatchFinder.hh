@@ -38,6 +38,9 @@ class TestHashMatchFinder : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( TestHashMatchFinder );
     CPPUNIT_TEST( testEverything );
+    CPPUNIT_TEST( testCanonical );
+    CPPUNIT_TEST( testFingerprints );
+    CPPUNIT_TEST( testMinimizers );
     CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -46,12 +49,19 @@ public:
     void setUp();
     void tearDown();
     void testEverything();
+    void testCanonical();
+    void testFingerprints();
+    void testMinimizers();
 
 private:
     TestMatchStorage findMatches(
         const std::string& reference,
         const std::string& sequence,
-        const isaac::flowcell::ReadMetadataList &readMetadataList);
+        const isaac::flowcell::ReadMetadataList &readMetadataList,
+        const bool canonical = false,
+        const bool fingerprints = false,
+        const std::size_t bucketCount = 0x10000,
+        const unsigned minimizerWindow = 0);
 };
 
 #endif // #ifndef iSAAC_ALIGNMENT_TEST_SEQUENCING_ADAPTER_HH
@@ -261,3 +261,87 @@ void TestShadowAligner::testRescueShadowLongest()
     }
     }
 }
+
+void TestShadowAligner::testBitParallelMatcher()
+{
+    using isaac::alignment::templateBuilder::BitParallelMatcher;
+
+    // pattern longer than one 64-bit word to exercise carrying between blocks
+    const std::string patternString(
+        "ACGTTGCAACGGTACCTAGGATCCAGTCAGTTGACCATGGTACGATCGATGCATGCTAGCTAGGCTAACGTTAGCATCGATCGGATC");
+    const std::vector<char> pattern(patternString.begin(), patternString.end());
+    // the pattern with one base deleted placed after 20 bases of unrelated sequence
+    const std::string textString =
+        std::string("TTTTTTTTTTTTTTTTTTTT") + patternString.substr(0, 40) + patternString.substr(41) + "TTTTTTTTTT";
+    isaac::reference::Contig::ReferenceSequence text;
+    text = textString;
+
+    BitParallelMatcher matcher(ISAAC_READ_LENGTH_MAX);
+    matcher.setPattern(pattern);
+    CPPUNIT_ASSERT_EQUAL(unsigned(pattern.size()), matcher.getPatternLength());
+
+    BitParallelMatcher::Placements placements;
+    // scan does not grow the placements
+    placements.reserve(10);
+    CPPUNIT_ASSERT_EQUAL(0UL, matcher.scan(text.cbegin(), text.cend(), 0, placements));
+
+    CPPUNIT_ASSERT_EQUAL(1UL, matcher.scan(text.cbegin(), text.cend(), 1, placements));
+    CPPUNIT_ASSERT_EQUAL(unsigned(20 + pattern.size() - 2), placements[0].end_);
+    CPPUNIT_ASSERT_EQUAL(1U, placements[0].edits_);
+
+    // N never matches, so it costs an extra edit
+    std::vector<char> patternWithN(pattern);
+    patternWithN[10] = 'N';
+    matcher.setPattern(patternWithN);
+    CPPUNIT_ASSERT_EQUAL(0UL, matcher.scan(text.cbegin(), text.cend(), 1, placements));
+    CPPUNIT_ASSERT_EQUAL(1UL, matcher.scan(text.cbegin(), text.cend(), 2, placements));
+    CPPUNIT_ASSERT_EQUAL(2U, placements[0].edits_);
+}
+
+void TestShadowAligner::testRescueShadowBitParallel()
+{
+    ISAAC_SCOPE_BLOCK_CERR
+    {
+    using isaac::alignment::templateBuilder::ShadowAligner;
+    using isaac::alignment::TemplateLengthStatistics;
+    using isaac::alignment::Cluster;
+    using isaac::alignment::FragmentMetadata;
+
+    isaac::alignment::Cigar cigarBuffer;
+    cigarBuffer.reserve(10000);
+    ShadowAligner<7> shadowAligner(true, flowcells, 8, 2, false, false, false, alignmentCfg, cigarBuffer, true);
+    {
+        const TemplateLengthStatistics tls(200, 400, 312, 38, 26, TemplateLengthStatistics::FRp, TemplateLengthStatistics::RFm, -1);
+        const isaac::alignment::BclClusters bcl0(getBcl(readMetadataList, contigList, 0, 0, 0, false, true));
+        Cluster cluster0(getMaxReadLength(readMetadataList));
+        cluster0.init(readMetadataList, bcl0.cluster(0), 1101, 999, isaac::alignment::ClusterXy(0,0), true, 0, 0);
+        FragmentMetadata fragment0, fragment1;
+        isaac::alignment::FragmentMetadataList shadowList(50);
+        fragment0.cluster = &cluster0;
+        fragment0.readIndex = 0;
+        fragment0.contigId = 0;
+        fragment0.position = 0;
+        fragment0.reverse = false;
+        // rescue the first read
+        CPPUNIT_ASSERT(shadowAligner.rescueShadows(contigList, fragment0, 100, shadowList, readMetadataList[1], testAdapters, tls));
+        fragment1 = shadowList[0];
+        CPPUNIT_ASSERT_EQUAL(fragment0.contigId, fragment1.contigId);
+        CPPUNIT_ASSERT_EQUAL((fragment0.readIndex + 1) % 2, fragment1.readIndex);
+        CPPUNIT_ASSERT_EQUAL(98L, fragment1.position);
+        CPPUNIT_ASSERT_EQUAL(true, fragment1.reverse);
+        CPPUNIT_ASSERT_EQUAL(92U, fragment1.getObservedLength());
+        CPPUNIT_ASSERT_EQUAL(0U, fragment1.mismatchCount);
+        CPPUNIT_ASSERT_EQUAL(isaac::alignment::Cigar::toString(fragment1.cigarBegin(), fragment1.cigarEnd()), std::string("92M"));
+        // rescue the second read
+        cigarBuffer.clear();
+        CPPUNIT_ASSERT(shadowAligner.rescueShadows(contigList, fragment1, 100, shadowList, readMetadataList[0], testAdapters, tls));
+        fragment0 = shadowList[0];
+        CPPUNIT_ASSERT_EQUAL((fragment1.readIndex + 1) % 2, fragment0.readIndex);
+        CPPUNIT_ASSERT_EQUAL(0L, fragment0.position);
+        CPPUNIT_ASSERT_EQUAL(false, fragment0.reverse);
+        CPPUNIT_ASSERT_EQUAL(81U, fragment0.getObservedLength());
+        CPPUNIT_ASSERT_EQUAL(0U, fragment0.mismatchCount);
+        CPPUNIT_ASSERT_EQUAL(isaac::alignment::Cigar::toString(fragment0.cigarBegin(), fragment0.cigarEnd()), std::string("81M"));
+    }
+    }
+}
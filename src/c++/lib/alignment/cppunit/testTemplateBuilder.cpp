@@ -25,6 +25,9 @@ using namespace std;
 #include "RegistryName.hh"
 #include "testTemplateBuilder.hh"
 #include "BuilderInit.hh"
+#include "alignment/HashMatchFinder.hh"
+#include "common/Threads.hpp"
+#include "reference/ReferenceHasher.hh"
 
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestTemplateBuilder, registryName("TemplateBuilder"));
 
@@ -462,6 +465,141 @@ void TestTemplateBuilder::testMultiple()
 
 }
 
+void TestTemplateBuilder::testFastPath()
+{
+    using isaac::alignment::TemplateBuilder;
+    using isaac::alignment::BamTemplate;
+    using isaac::alignment::FragmentMetadata;
+    const isaac::alignment::AlignmentCfg alignmentCfg(ELAND_MATCH_SCORE, ELAND_MISMATCH_SCORE, ELAND_GAP_OPEN_SCORE, ELAND_GAP_EXTEND_SCORE, ELAND_MIN_GAP_EXTEND_SCORE, 20000);
+    TemplateBuilder templateBuilder(true, flowcells, 10, 10, 16, 4, 1000, 1000, 1000, false, true, false, false, 8, 2, false, 32, true,
+                                    alignmentCfg,
+                                    TemplateBuilder::DODGY_ALIGNMENT_SCORE_UNALIGNED, 4, false);
+    FragmentMetadata r0 = f0_0;
+    r0.repeatCount = 1;
+    // unlike f0_1, observed length agrees with the cigar so that the anchors are checked against the right bases
+    FragmentMetadata r1 = getFragmentMetadata(0, 107, 100, 1, true, 1, 1, &cigarBuffer, 1, -12.0, 253, &cluster0);
+    r1.repeatCount = 1;
+    r1.editDistance = 1;
+
+    BamTemplate bamTemplate;
+    isaac::alignment::TemplateBuilder::FragmentMetadataLists fragments;
+    fragments[0].push_back(r0);
+    fragments[1].push_back(r1);
+    templateBuilder.buildCombinationTemplate(contigList, restOfGenomeCorrection, readMetadataList, fragments, cluster0, tls, bamTemplate);
+    CPPUNIT_ASSERT(bamTemplate.isProperPair());
+    CPPUNIT_ASSERT(templateBuilder.isFastPathTemplate(bamTemplate));
+    // parity: the full path would only attempt to rescue a possibly semialigned mate
+    CPPUNIT_ASSERT(!bamTemplate.getFragmentMetadata(0).possiblySemialigned(contigList, 16));
+    CPPUNIT_ASSERT(!bamTemplate.getFragmentMetadata(1).possiblySemialigned(contigList, 16));
+
+    // too many mismatches
+    fragments[1].front().mismatchCount = 2;
+    fragments[1].front().editDistance = 2;
+    templateBuilder.buildCombinationTemplate(contigList, restOfGenomeCorrection, readMetadataList, fragments, cluster0, tls, bamTemplate);
+    CPPUNIT_ASSERT(!templateBuilder.isFastPathTemplate(bamTemplate));
+
+    // repeat
+    fragments[1].front() = r1;
+    fragments[1].push_back(r1);
+    fragments[1].back().position = 7;
+    fragments[1].front().repeatCount = fragments[1].back().repeatCount = 2;
+    templateBuilder.buildCombinationTemplate(contigList, restOfGenomeCorrection, readMetadataList, fragments, cluster0, tls, bamTemplate);
+    CPPUNIT_ASSERT(!templateBuilder.isFastPathTemplate(bamTemplate));
+
+    // singleton
+    fragments[1].clear();
+    templateBuilder.buildCombinationTemplate(contigList, restOfGenomeCorrection, readMetadataList, fragments, cluster0, tls, bamTemplate);
+    CPPUNIT_ASSERT(!templateBuilder.isFastPathTemplate(bamTemplate));
+}
+
+/**
+ * \brief deterministic sequence that does not advance rand() for the tests that depend on it
+ */
+static std::string makeSequence(const unsigned length)
+{
+    std::string ret;
+    unsigned state = 12345;
+    while (length != ret.length())
+    {
+        state = state * 1103515245 + 12345;
+        ret.push_back("ACGT"[(state >> 16) & 3]);
+    }
+    return ret;
+}
+
+/**
+ * \brief buildTemplate on a fast path pair must produce the same template with and without the shortcut
+ */
+void TestTemplateBuilder::testFastPathParity()
+{
+    using isaac::alignment::TemplateBuilder;
+    using isaac::alignment::BamTemplate;
+    using isaac::alignment::FragmentMetadata;
+    typedef isaac::reference::ReferenceHash<isaac::oligo::VeryShortKmerType> ReferenceHash;
+
+    const TestContigList fastPathContigList(makeSequence(1000));
+    isaac::common::ThreadVector threads(1);
+    isaac::reference::ReferenceHasher<ReferenceHash> referenceHasher(fastPathContigList, threads, threads.size());
+    const ReferenceHash referenceHash = referenceHasher.generate(0x10000, false, false);
+    const isaac::alignment::ClusterHashMatchFinder<ReferenceHash, 4> matchFinder(referenceHash, 1000, 0, 1000);
+    const isaac::alignment::RestOfGenomeCorrection rog(fastPathContigList, readMetadataList);
+
+    // forward read 0 at 300 and reverse read 1 ending at 490 make a FR pair of tls median length
+    std::vector<char> bcl = getBclVector(readMetadataList, fastPathContigList, 0, 300, 1000 - 490);
+    // one mismatch in read 0
+    bcl[50] = (bcl[50] & ~3) | ((bcl[50] + 1) & 3);
+    const isaac::alignment::BclClusters bclClusters = getBclClusters(readMetadataList, bcl);
+    isaac::alignment::Cluster cluster(isaac::flowcell::getMaxReadLength(readMetadataList));
+    cluster.init(readMetadataList, bclClusters.cluster(0), tile0, clusterId0, isaac::alignment::ClusterXy(0,0), true, 0, 0);
+
+    const isaac::alignment::AlignmentCfg alignmentCfg(ELAND_MATCH_SCORE, ELAND_MISMATCH_SCORE, ELAND_GAP_OPEN_SCORE, ELAND_GAP_EXTEND_SCORE, ELAND_MIN_GAP_EXTEND_SCORE, 20000);
+    TemplateBuilder fastBuilder(true, flowcells, 10, 10, ReferenceHash::SEED_LENGTH, 4, 1000, 1000, 1000, false, true, false, false, 8, 2, false, 32, true,
+                                alignmentCfg, TemplateBuilder::DODGY_ALIGNMENT_SCORE_UNALIGNED, 4, false, false, true);
+    TemplateBuilder fullBuilder(true, flowcells, 10, 10, ReferenceHash::SEED_LENGTH, 4, 1000, 1000, 1000, false, true, false, false, 8, 2, false, 32, true,
+                                alignmentCfg, TemplateBuilder::DODGY_ALIGNMENT_SCORE_UNALIGNED, 4, false, false, false);
+
+    BamTemplate fastTemplate;
+    BamTemplate fullTemplate;
+    CPPUNIT_ASSERT_EQUAL(
+        fullBuilder.buildTemplate(fastPathContigList, rog, readMetadataList, isaac::alignment::SequencingAdapterList(),
+                                  cluster, tls, true, matchFinder, fullTemplate),
+        fastBuilder.buildTemplate(fastPathContigList, rog, readMetadataList, isaac::alignment::SequencingAdapterList(),
+                                  cluster, tls, true, matchFinder, fastTemplate));
+    // the shortcut was taken
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), fastBuilder.getFastPathTemplates());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), fullBuilder.getFastPathTemplates());
+
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.getFragmentCount(), fastTemplate.getFragmentCount());
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.isProperPair(), fastTemplate.isProperPair());
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.getAlignmentScore(), fastTemplate.getAlignmentScore());
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.isUniquelyAligned(), fastTemplate.isUniquelyAligned());
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.isRepeat(), fastTemplate.isRepeat());
+    CPPUNIT_ASSERT_EQUAL(fullTemplate.isUnanchored(), fastTemplate.isUnanchored());
+    for (unsigned i = 0; fastTemplate.getFragmentCount() != i; ++i)
+    {
+        const FragmentMetadata &fast = fastTemplate.getFragmentMetadata(i);
+        const FragmentMetadata &full = fullTemplate.getFragmentMetadata(i);
+        CPPUNIT_ASSERT_EQUAL(full.contigId, fast.contigId);
+        CPPUNIT_ASSERT_EQUAL(full.position, fast.position);
+        CPPUNIT_ASSERT_EQUAL(full.reverse, fast.reverse);
+        CPPUNIT_ASSERT_EQUAL(full.getCigarString(), fast.getCigarString());
+        CPPUNIT_ASSERT_EQUAL(full.mismatchCount, fast.mismatchCount);
+        CPPUNIT_ASSERT_EQUAL(full.getEditDistance(), fast.getEditDistance());
+        CPPUNIT_ASSERT_EQUAL(full.alignmentScore, fast.alignmentScore);
+        CPPUNIT_ASSERT_EQUAL(full.logProbability, fast.logProbability);
+        CPPUNIT_ASSERT_EQUAL(full.repeatCount, fast.repeatCount);
+        CPPUNIT_ASSERT_EQUAL(full.gapCount, fast.gapCount);
+        CPPUNIT_ASSERT_EQUAL(full.isAligned(), fast.isAligned());
+        CPPUNIT_ASSERT_EQUAL(full.isUniquelyAligned(), fast.isUniquelyAligned());
+        CPPUNIT_ASSERT_EQUAL(full.isSplit(), fast.isSplit());
+        CPPUNIT_ASSERT_EQUAL(full.decoyAlignment, fast.decoyAlignment);
+        CPPUNIT_ASSERT_EQUAL(int(full.mapQ), int(fast.mapQ));
+    }
+    CPPUNIT_ASSERT_EQUAL(300L, fastTemplate.getFragmentMetadata(0).position);
+    CPPUNIT_ASSERT_EQUAL(390L, fastTemplate.getFragmentMetadata(1).position);
+    CPPUNIT_ASSERT_EQUAL(1U, fastTemplate.getFragmentMetadata(0).mismatchCount);
+}
+
 void TestTemplateBuilder::testAll()
 {
     {
@@ -471,6 +609,8 @@ void TestTemplateBuilder::testAll()
         testUnique();
         testPeAdapterTrim();
         testMultiple();
+        testFastPath();
+        testFastPathParity();
     }
 }
 
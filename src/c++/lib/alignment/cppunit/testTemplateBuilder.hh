@@ -81,6 +81,8 @@ public:
     void testUnique();
     void testPeAdapterTrim();
     void testMultiple();
+    void testFastPath();
+    void testFastPathParity();
     void testAll();
 };
 
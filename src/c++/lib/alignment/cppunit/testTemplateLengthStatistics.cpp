@@ -178,6 +178,29 @@ void TestTemplateLengthStatistics::testNoMateDriftRange()
 }
 
 
+void TestTemplateLengthStatistics::testAccumulatedStatistics()
+{
+    using isaac::alignment::TemplateLengthDistribution;
+    using isaac::alignment::TemplateLengthStatistics;
+    TemplateLengthDistribution tls(10000, -1);
+
+    // uniformly distributed lengths, accumulated in reverse order
+    for (unsigned int i = 10000; i >= 1; --i)
+    {
+        tls.accumulateModel(TemplateLengthStatistics::FRp, i + 15);
+    }
+    // nothing gets computed until finalize
+    CPPUNIT_ASSERT_EQUAL(false, tls.isStable());
+    CPPUNIT_ASSERT_EQUAL(false, tls.finalize());
+    const TemplateLengthStatistics first = tls.getStatistics();
+    // no new templates, same statistics
+    CPPUNIT_ASSERT_EQUAL(true, tls.finalize());
+    CPPUNIT_ASSERT_EQUAL(first.getMin(), tls.getStatistics().getMin());
+    CPPUNIT_ASSERT_EQUAL(first.getMedian(), tls.getStatistics().getMedian());
+    CPPUNIT_ASSERT_EQUAL(first.getMax(), tls.getStatistics().getMax());
+    CPPUNIT_ASSERT(first.getMin() < first.getMedian() && first.getMedian() < first.getMax());
+}
+
 void TestTemplateLengthStatistics::testMateOrientation()
 {
     using isaac::alignment::TemplateLengthStatistics;
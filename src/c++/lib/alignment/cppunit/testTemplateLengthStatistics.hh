@@ -51,6 +51,7 @@ public:
         testStatistics();
         testMateDriftRange();
         testNoMateDriftRange();
+        testAccumulatedStatistics();
     }
     void testAlignmentModels();
     void testAlignmentClassNames();
@@ -60,6 +61,7 @@ public:
     void testStatistics();
     void testMateDriftRange();
     void testNoMateDriftRange();
+    void testAccumulatedStatistics();
 };
 
 #endif // #ifndef iSAAC_ALIGNMENT_TEST_TEMPLATE_LENGTH_STATISTICS_HH
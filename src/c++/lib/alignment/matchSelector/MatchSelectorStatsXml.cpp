@@ -254,6 +254,8 @@ void MatchSelectorStatsXml::serlializeTile(
     ISAAC_XML_WRITER_ELEMENT_BLOCK(xmlWriter, "Tile")
     {
         xmlWriter.writeAttribute("number", tile.getTile());
+        xmlWriter.writeElement("LoadMilliseconds", stats_.at(tile.getIndex()).getLoadMilliseconds());
+        xmlWriter.writeElement("RepeatProbesAvoided", stats_.at(tile.getIndex()).getRepeatProbesAvoided());
         ISAAC_XML_WRITER_ELEMENT_BLOCK(xmlWriter, "Pf")
         {
             BOOST_FOREACH(const flowcell::ReadMetadata& read, flowcellLayoutList_.at(tile.getFlowcellIndex()).getReadMetadataList())
@@ -25,6 +25,7 @@
 #include "alignment/matchSelector/TemplateDetector.hh"
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
+#include "common/Trace.hh"
 
 namespace isaac
 {
@@ -50,14 +51,77 @@ TemplateDetector::TemplateDetector(
   contigLists_(contigLists),
   userTemplateLengthStatistics_(userTemplateLengthStatistics),
   perTileTls_(perTileTls),
+  detectTemplateBlockSize_(detectTemplateBlockSize),
   threadCluster_(computeThreads_.size(),
                  Cluster(flowcell::getMaxReadLength(flowcellLayoutList_) +
                          flowcell::getMaxBarcodeLength(flowcellLayoutList_))),
   threadTemplateBuilders_(threadTemplateBuilders),
   templateLengthDistributions_(barcodeMetadataList_.size(), TemplateLengthDistribution(detectTemplateBlockSize, mateDriftRange)),
   unprocessedClusterId_(0),
-  pendingClusterId_(0)
+  pendingClusterId_(0),
+  threadAlignedTemplates_(learnsFromAlignedClusters() ? computeThreads_.size() : 0),
+  barcodeAlignedTemplates_(barcodeMetadataList_.size(), 0)
 {
+    for (std::vector<BarcodeAlignmentModel> &alignedTemplates : threadAlignedTemplates_)
+    {
+        alignedTemplates.reserve(CLUSTERS_AT_A_TIME);
+    }
+}
+
+void TemplateDetector::mergeAlignedTemplates(std::vector<BarcodeAlignmentModel> &alignedTemplates)
+{
+    for (const BarcodeAlignmentModel &bm : alignedTemplates)
+    {
+        templateLengthDistributions_[bm.first].accumulateModel(bm.second.first, bm.second.second);
+        ++barcodeAlignedTemplates_[bm.first];
+    }
+    alignedTemplates.clear();
+}
+
+void TemplateDetector::collectAlignedTemplate(
+    const unsigned threadNumber,
+    const unsigned barcodeIndex,
+    const TemplateBuilder::FragmentMetadataLists &fragments)
+{
+    const TemplateLengthDistribution::AlignmentModel am = TemplateLengthDistribution::getAlignmentModel(fragments[0], fragments[1]);
+    if (TemplateLengthStatistics::InvalidAlignmentModel != am.first)
+    {
+        std::vector<BarcodeAlignmentModel> &alignedTemplates = threadAlignedTemplates_.at(threadNumber);
+        alignedTemplates.push_back(std::make_pair(barcodeIndex, am));
+        if (alignedTemplates.capacity() == alignedTemplates.size())
+        {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            mergeAlignedTemplates(alignedTemplates);
+        }
+    }
+}
+
+void TemplateDetector::publishAlignedTemplates(
+    const flowcell::TileMetadata &tileMetadata,
+    std::vector<alignment::TemplateLengthStatistics> &templateLengthStatistics)
+{
+    for (std::vector<BarcodeAlignmentModel> &alignedTemplates : threadAlignedTemplates_)
+    {
+        mergeAlignedTemplates(alignedTemplates);
+    }
+
+    std::size_t barcode = 0;
+    BOOST_FOREACH(TemplateLengthDistribution &templateLengthDistribution, templateLengthDistributions_)
+    {
+        // Histograms don't depend on the order in which the threads merged the templates. Don't judge the stability
+        // until at least as many new templates have been seen as the detection pass would use.
+        if (!templateLengthStatistics[barcode].isStable() && detectTemplateBlockSize_ <= barcodeAlignedTemplates_[barcode])
+        {
+            barcodeAlignedTemplates_[barcode] = 0;
+            if (templateLengthDistribution.finalize())
+            {
+                templateLengthStatistics[barcode] = templateLengthDistribution.getStatistics();
+                ISAAC_THREAD_CERR << "Template length learned from aligned clusters of " << tileMetadata << ", " <<
+                    barcodeMetadataList_[barcode] << ":" << templateLengthStatistics[barcode] << std::endl;
+            }
+        }
+        ++barcode;
+    }
 }
 
 template <typename MatchFinderT>
@@ -224,7 +288,11 @@ void TemplateDetector::determineTemplateLengths(
             });
     }
 
-    std::for_each(templateLengthDistributions_.begin(), templateLengthDistributions_.end(), boost::bind(&TemplateLengthDistribution::clear, _1));
+    if (perTileTls_)
+    {
+        std::for_each(templateLengthDistributions_.begin(), templateLengthDistributions_.end(), boost::bind(&TemplateLengthDistribution::clear, _1));
+    }
+    // otherwise keep accumulating the templates seen in the previous tiles
 
     std::size_t statsToBuild = 0;
     std::size_t barcode = 0;
@@ -241,6 +309,7 @@ void TemplateDetector::determineTemplateLengths(
 
     if (statsToBuild)
     {
+        ISAAC_TRACE_SPAN("tlsDetect");
         unprocessedClusterId_ = 0;
         pendingClusterId_ = 0;
 
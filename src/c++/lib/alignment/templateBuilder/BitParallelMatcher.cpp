@@ -0,0 +1,164 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BitParallelMatcher.cpp
+ **
+ ** \brief See BitParallelMatcher.hh
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include "alignment/templateBuilder/BitParallelMatcher.hh"
+#include "common/Debug.hh"
+#include "oligo/Nucleotides.hh"
+
+namespace isaac
+{
+namespace alignment
+{
+namespace templateBuilder
+{
+
+BitParallelMatcher::BitParallelMatcher(const unsigned patternLengthMax) :
+    patternLength_(0),
+    blocks_(0)
+{
+    const unsigned blocksMax = (patternLengthMax + WORD_BITS - 1) / WORD_BITS;
+    peq_.reserve(ALPHABET_SIZE * blocksMax);
+    pv_.reserve(blocksMax);
+    mv_.reserve(blocksMax);
+}
+
+void BitParallelMatcher::setPattern(const std::vector<char> &pattern)
+{
+    static const oligo::Translator<> translator = {};
+    patternLength_ = pattern.size();
+    blocks_ = (patternLength_ + WORD_BITS - 1) / WORD_BITS;
+    peq_.clear();
+    peq_.resize(ALPHABET_SIZE * blocks_, 0);
+
+    unsigned pos = 0;
+    for (const char base : pattern)
+    {
+        const unsigned oligo = translator[base];
+        if (oligo::INVALID_OLIGO != oligo)
+        {
+            peq_[oligo * blocks_ + pos / WORD_BITS] |= Word(1) << (pos % WORD_BITS);
+        }
+        ++pos;
+    }
+}
+
+/**
+ * \brief Advances one block of the vertical delta vectors by one text base.
+ *
+ * \param hin       horizontal delta entering the block at its top row: -1, 0 or +1
+ * \param scoreBit  row at which the horizontal delta leaving the block is taken
+ *
+ * \return horizontal delta at scoreBit
+ */
+inline int BitParallelMatcher::advanceBlock(const int hin, Word &pv, Word &mv, Word eq, const Word scoreBit)
+{
+    const Word xv = eq | mv;
+    if (hin < 0)
+    {
+        eq |= 1;
+    }
+    const Word xh = (((eq & pv) + pv) ^ pv) | eq;
+    Word ph = mv | ~(xh | pv);
+    Word mh = pv & xh;
+
+    const int hout = (ph & scoreBit) ? 1 : (mh & scoreBit) ? -1 : 0;
+
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0)
+    {
+        mh |= 1;
+    }
+    else if (hin > 0)
+    {
+        ph |= 1;
+    }
+
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+std::size_t BitParallelMatcher::scan(
+    const reference::Contig::const_iterator textBegin,
+    const reference::Contig::const_iterator textEnd,
+    const unsigned editsMax,
+    Placements &placements)
+{
+    static const oligo::Translator<> translator = {};
+    placements.clear();
+    if (!patternLength_)
+    {
+        return 0;
+    }
+
+    pv_.assign(blocks_, ~Word(0));
+    mv_.assign(blocks_, 0);
+    // zero-initialized at load time. scan runs with dynamic memory allocations blocked
+    static const Word noMatch[ISAAC_READ_LENGTH_MAX / WORD_BITS + 1] = {0};
+    ISAAC_ASSERT_MSG(sizeof(noMatch) / sizeof(noMatch[0]) >= blocks_, "Pattern too long: " << patternLength_);
+
+    const Word topBit = Word(1) << (WORD_BITS - 1);
+    const Word lastScoreBit = Word(1) << ((patternLength_ - 1) % WORD_BITS);
+    const unsigned lastBlock = blocks_ - 1;
+
+    int score = patternLength_;
+    bool inRun = false;
+    for (reference::Contig::const_iterator it = textBegin; textEnd != it; ++it)
+    {
+        const unsigned oligo = translator[*it];
+        const Word *eq = oligo::INVALID_OLIGO == oligo ? noMatch : &peq_[oligo * blocks_];
+
+        // top row of the matrix is all zeroes: the pattern may start anywhere in the text
+        int hin = 0;
+        for (unsigned block = 0; lastBlock != block; ++block)
+        {
+            hin = advanceBlock(hin, pv_[block], mv_[block], eq[block], topBit);
+        }
+        score += advanceBlock(hin, pv_[lastBlock], mv_[lastBlock], eq[lastBlock], lastScoreBit);
+
+        if (unsigned(score) <= editsMax)
+        {
+            const unsigned end = std::distance(textBegin, it);
+            if (inRun && placements.back().edits_ > unsigned(score))
+            {
+                placements.back() = Placement(end, score);
+            }
+            else if (!inRun)
+            {
+                if (placements.size() == placements.capacity())
+                {
+                    // too many placements. Just stop here. The alignment score will be miserable anyway.
+                    break;
+                }
+                placements.push_back(Placement(end, score));
+                inRun = true;
+            }
+        }
+        else
+        {
+            inRun = false;
+        }
+    }
+    return placements.size();
+}
+
+} // namespace templateBuilder
+} // namespace alignment
+} // namespace isaac
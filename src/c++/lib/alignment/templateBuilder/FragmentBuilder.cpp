@@ -66,6 +66,7 @@ FragmentBuilder::FragmentBuilder(
     , ungappedAligner_(collectMismatchCycles, alignmentCfg_)
     , gappedAligner_(collectMismatchCycles, flowcellLayoutList, smartSmithWaterman, smithWatermanGapSizeMax, alignmentCfg_)
     , matchLists_(maxSeedsPerMatch + 1)
+    , repeatProbesAvoided_(0)
 {
 //    if (reserveBuffers)
     {
@@ -45,17 +45,24 @@ ShadowAligner<SHADOW_KMER_LENGTH>::ShadowAligner(
     const bool noSmithWaterman,
     const bool splitAlignments,
     const AlignmentCfg &alignmentCfg,
-    Cigar &cigarBuffer)
+    Cigar &cigarBuffer,
+    const bool bitParallelShadowRescue)
     : gappedMismatchesMax_(gappedMismatchesMax),
       smitWatermanGapsMax_(smitWatermanGapsMax),
       noSmithWaterman_(noSmithWaterman),
       splitAlignments_(splitAlignments),
+      bitParallelShadowRescue_(bitParallelShadowRescue),
       flowcellLayoutList_(flowcellLayoutList),
       ungappedAligner_(collectMismatchCycles, alignmentCfg),
-      cigarBuffer_(cigarBuffer)
+      cigarBuffer_(cigarBuffer),
+      bitParallelMatcher_(bitParallelShadowRescue ? ISAAC_READ_LENGTH_MAX : 0)
 {
     static const std::size_t SHADOW_CANDIDATE_POSITIONS_MAX_EVER = 10000;
     shadowCandidatePositions_.reserve(SHADOW_CANDIDATE_POSITIONS_MAX_EVER);
+    if (bitParallelShadowRescue_)
+    {
+        bitParallelPlacements_.reserve(SHADOW_CANDIDATE_POSITIONS_MAX_EVER);
+    }
 }
 
 template <unsigned SHADOW_KMER_LENGTH>
@@ -133,6 +140,38 @@ bool ShadowAligner<SHADOW_KMER_LENGTH>::findShadowCandidatePositions(
     return false;
 }
 
+template <unsigned SHADOW_KMER_LENGTH>
+bool ShadowAligner<SHADOW_KMER_LENGTH>::findBitParallelShadowCandidatePositions(
+    const std::pair<int64_t, int64_t> &alignmentStartPositionRange,
+    const int64_t referenceOffset,
+    const reference::Contig::const_iterator referenceBegin,
+    const reference::Contig::const_iterator referenceEnd,
+    const std::vector<char> &shadowSequence,
+    std::vector<int64_t> &shadowCandidatePositions)
+{
+    bitParallelMatcher_.setPattern(shadowSequence);
+    bitParallelMatcher_.scan(referenceBegin, referenceEnd, gappedMismatchesMax_, bitParallelPlacements_);
+
+    for (const BitParallelMatcher::Placement &placement : bitParallelPlacements_)
+    {
+        // the start is exact for placements without indels. Otherwise it is off by the net indel length and
+        // gets corrected by the gapped realignment of the rescued shadow
+        const int64_t candidatePosition = referenceOffset + placement.end_ + 1 - int64_t(shadowSequence.size());
+        if (alignmentStartPositionRange.first <= candidatePosition && alignmentStartPositionRange.second >= candidatePosition)
+        {
+            if (shadowCandidatePositions.size() == shadowCandidatePositions.capacity())
+            {
+                // too many candidate positions. Just stop here. The alignment score will be miserable anyway.
+                break;
+            }
+            shadowCandidatePositions.push_back(candidatePosition);
+        }
+    }
+
+    // placements come in increasing order of end positions, so the candidate positions are sorted and unique
+    return !shadowCandidatePositions.empty();
+}
+
 /**
  * \brief if the best template is longer than the dominant template, attempt to rescue shadow
  *        within a wider range
@@ -177,13 +216,28 @@ bool ShadowAligner<SHADOW_KMER_LENGTH>::findShadowCandidatePositions(
     shadowCandidatePositions.clear();
     const std::vector<char>& shadowSequence = shadowReverse ? shadowRead.getReverseSequence() : shadowRead.getForwardSequence();
     const int64_t candidatePositionOffset = std::min((int64_t) (contig.size()), std::max(int64_t(0), shadowRescueRange.first));
-    findShadowCandidatePositions(
-        shadowRescueRange,
-        candidatePositionOffset,
-        contig.begin() + candidatePositionOffset,
-        contig.begin() + std::min((int64_t) (contig.size()), std::max(int64_t(0), shadowRescueRange.second) + 1),
-        shadowSequence,
-        shadowCandidatePositions);
+    if (bitParallelShadowRescue_)
+    {
+        // the window must include the whole shadow placed at the rightmost start, plus room for deletions
+        findBitParallelShadowCandidatePositions(
+            shadowRescueRange,
+            candidatePositionOffset,
+            contig.begin() + candidatePositionOffset,
+            contig.begin() + std::min((int64_t) (contig.size()),
+                                      std::max(int64_t(0), shadowRescueRange.second) + int64_t(shadowSequence.size() + gappedMismatchesMax_)),
+            shadowSequence,
+            shadowCandidatePositions);
+    }
+    else
+    {
+        findShadowCandidatePositions(
+            shadowRescueRange,
+            candidatePositionOffset,
+            contig.begin() + candidatePositionOffset,
+            contig.begin() + std::min((int64_t) (contig.size()), std::max(int64_t(0), shadowRescueRange.second) + 1),
+            shadowSequence,
+            shadowCandidatePositions);
+    }
 
     ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(
         orphan.getCluster().getId(),
@@ -43,21 +43,27 @@ void BamIndexPart::initStructures()
 
 void BamIndexPart::processFragment( const build::FragmentAccessorBamAdapter& alignment, uint32_t serializedLength )
 {
-    if (alignment.pos() >= 0)
+    processFragment(alignment.pos(), alignment.refId(), alignment.seqLen(), alignment.observedLength(),
+                    alignment.unmapped(), serializedLength);
+}
+
+void BamIndexPart::processFragment( const int pos, const int refId, const uint32_t seqLen, const uint32_t observedLength,
+                                    const bool unmapped, const uint32_t serializedLength )
+{
+    if (pos >= 0)
     {
-        uint32_t observedLength = alignment.observedLength();
-        const uint32_t bin(bam_reg2bin(alignment.pos(), alignment.pos() + alignment.seqLen())); // it would be more correct to use observedLength instead of alignment.seqLen(), but samtools is doing it this way.
+        const uint32_t bin(bam_reg2bin(pos, pos + seqLen)); // it would be more correct to use observedLength instead of seqLen, but samtools is doing it this way.
 
-        addToBinIndexChunks( localUncompressedOffset_, localUncompressedOffset_ + serializedLength, bin, alignment.refId() );
-        addToLinearIndex( alignment.pos(), localUncompressedOffset_ );
+        addToBinIndexChunks( localUncompressedOffset_, localUncompressedOffset_ + serializedLength, bin, refId );
+        addToLinearIndex( pos, localUncompressedOffset_ );
         if (observedLength > 0)
         {
-            addToLinearIndex( alignment.pos() + observedLength - 1, localUncompressedOffset_ );
+            addToLinearIndex( pos + observedLength - 1, localUncompressedOffset_ );
         }
     }
 
     // Update bamStats for samtools' special bin
-    if (alignment.unmapped())
+    if (unmapped)
     {
         ++bamStatsNmapped_;
     }
@@ -0,0 +1,114 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "RegistryName.hh"
+#include "testBamBlockWriter.hh"
+
+#include "bam/BamBlockWriter.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestBamBlockWriter, registryName("BamBlockWriter"));
+
+void TestBamBlockWriter::setUp()
+{
+}
+
+void TestBamBlockWriter::tearDown()
+{
+}
+
+/**
+ * \brief Minimal alignment with the interface expected by serializeAlignment
+ */
+struct TestAlignment
+{
+    unsigned id_;
+    std::string name_;
+    std::vector<unsigned> cigar_;
+    std::vector<char> seq_;
+    std::vector<char> qual_;
+    std::string sa_;
+
+    explicit TestAlignment(const unsigned id, const unsigned readLength) :
+        id_(id), name_("read" + std::to_string(id)), cigar_(1 + id % 3, (readLength / (1 + id % 3)) << 4),
+        seq_((readLength + 1) / 2, char(id)), qual_(readLength, char(30 + id % 10)), sa_(id % 2 ? "chr1,100,+,50M,60,0;" : "")
+    {
+    }
+
+    typedef std::pair<const unsigned *, const unsigned *> CigarBeginEnd;
+    typedef std::pair<const char *, const char *> SeqBeginEnd;
+    typedef std::pair<const char *, const char *> QualBeginEnd;
+
+    int refId() const {return id_ % 4 ? 1 : -1;}
+    int pos() const {return id_ % 4 ? id_ * 100 : -1;}
+    const char *readName() const {return name_.c_str();}
+    int observedLength() const {return qual_.size();}
+    unsigned char mapq() const {return id_ % 61;}
+    CigarBeginEnd cigar() const {return CigarBeginEnd(&cigar_.front(), &cigar_.front() + cigar_.size());}
+    unsigned flag() const {return id_ % 0x800;}
+    int seqLen() const {return qual_.size();}
+    int nextRefId() const {return 1;}
+    int nextPos() const {return id_ * 100 + 300;}
+    int tlen() const {return 400;}
+    SeqBeginEnd seq() const {return SeqBeginEnd(&seq_.front(), &seq_.front() + seq_.size());}
+    QualBeginEnd qual() const {return QualBeginEnd(&qual_.front(), &qual_.front() + qual_.size());}
+
+    isaac::bam::iTag getFragmentSM() const {return isaac::bam::iTag("SM", id_);}
+    isaac::bam::iTag getFragmentAS() const {return id_ % 3 ? isaac::bam::iTag("AS", id_ * 2) : isaac::bam::iTag();}
+    isaac::bam::zTag getFragmentRG() const {return isaac::bam::zTag("RG", "0");}
+    isaac::bam::iTag getFragmentNM() const {return isaac::bam::iTag("NM", id_ % 5);}
+    isaac::bam::zTag getFragmentBC() const {return id_ % 2 ? isaac::bam::zTag() : isaac::bam::zTag("BC", "ACGTAC");}
+    isaac::bam::zTag getFragmentOC() const {return isaac::bam::zTag();}
+    isaac::bam::iTag getFragmentOP() const {return isaac::bam::iTag();}
+    isaac::bam::iTag getFragmentZX() const {return isaac::bam::iTag("ZX", 1000 + id_);}
+    isaac::bam::iTag getFragmentZY() const {return isaac::bam::iTag("ZY", 2000 + id_);}
+    isaac::bam::zTag getFragmentSA() const {return sa_.empty() ? isaac::bam::zTag() : isaac::bam::zTag("SA", sa_.c_str());}
+};
+
+static void checkSame(const std::vector<TestAlignment> &alignments)
+{
+    std::ostringstream expected;
+    std::ostringstream actual;
+    isaac::bam::BamBlockWriter<isaac::bam::StreamBlockSink> writer((isaac::bam::StreamBlockSink(actual)));
+    for (const TestAlignment &alignment : alignments)
+    {
+        const unsigned expectedLength = isaac::bam::serializeAlignment(expected, alignment);
+        CPPUNIT_ASSERT_EQUAL(expectedLength, writer.write(alignment));
+    }
+    writer.flush();
+    CPPUNIT_ASSERT_EQUAL(expected.str().size(), actual.str().size());
+    CPPUNIT_ASSERT(expected.str() == actual.str());
+}
+
+void TestBamBlockWriter::testSameAsSerializeAlignment()
+{
+    std::vector<TestAlignment> alignments;
+    // enough records to fill several blocks
+    for (unsigned i = 0; i < 2000; ++i)
+    {
+        alignments.push_back(TestAlignment(i, 50 + i % 101));
+    }
+    checkSame(alignments);
+}
+
+void TestBamBlockWriter::testLongerThanBlock()
+{
+    std::vector<TestAlignment> alignments;
+    alignments.push_back(TestAlignment(1, 100));
+    alignments.push_back(TestAlignment(2, isaac::bam::BamBlockWriter<isaac::bam::StreamBlockSink>::BLOCK_CAPACITY));
+    alignments.push_back(TestAlignment(3, 100));
+    checkSame(alignments);
+}
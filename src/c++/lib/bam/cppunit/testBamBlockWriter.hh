@@ -0,0 +1,32 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BAM_TEST_BAM_BLOCK_WRITER_HH
+#define iSAAC_BAM_TEST_BAM_BLOCK_WRITER_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class TestBamBlockWriter : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestBamBlockWriter );
+    CPPUNIT_TEST( testSameAsSerializeAlignment );
+    CPPUNIT_TEST( testLongerThanBlock );
+    CPPUNIT_TEST_SUITE_END();
+public:
+    void setUp();
+    void tearDown();
+    void testSameAsSerializeAlignment();
+    void testLongerThanBlock();
+};
+
+#endif // #ifndef iSAAC_BAM_TEST_BAM_BLOCK_WRITER_HH
@@ -0,0 +1,128 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "RegistryName.hh"
+#include "testBgzfBlockCompressor.hh"
+
+#include "bgzf/BgzfBlockCompressor.hh"
+
+using isaac::bgzf::BgzfBlockCompressor;
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestBgzfBlockCompressor, registryName("BgzfBlockCompressor"));
+
+void TestBgzfBlockCompressor::setUp()
+{
+}
+
+void TestBgzfBlockCompressor::tearDown()
+{
+}
+
+/**
+ * \brief Inflates each bgzf block separately and checks its header, size and CRC
+ *
+ * \return number of blocks
+ */
+static std::size_t decompress(const std::vector<char> &bgzf, std::string &data)
+{
+    std::size_t blocks = 0;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    CPPUNIT_ASSERT_EQUAL(Z_OK, inflateInit2(&strm, -MAX_WBITS));
+    std::size_t offset = 0;
+    while (bgzf.size() != offset)
+    {
+        CPPUNIT_ASSERT(bgzf.size() >= offset + sizeof(isaac::bgzf::Header) + sizeof(isaac::bgzf::Footer));
+        const isaac::bgzf::Header &header = *reinterpret_cast<const isaac::bgzf::Header*>(&bgzf.at(offset));
+        CPPUNIT_ASSERT_EQUAL(31U, unsigned(header.ID1));
+        CPPUNIT_ASSERT_EQUAL(139U, unsigned(header.ID2));
+        CPPUNIT_ASSERT_EQUAL(8U, unsigned(header.CM));
+        CPPUNIT_ASSERT_EQUAL(4U, unsigned(header.FLG));
+        CPPUNIT_ASSERT_EQUAL(unsigned('B'), unsigned(header.xfield.SI1));
+        CPPUNIT_ASSERT_EQUAL(unsigned('C'), unsigned(header.xfield.SI2));
+
+        const std::size_t blockSize = header.xfield.getBSIZE() + 1;
+        CPPUNIT_ASSERT(BgzfBlockCompressor::BGZF_BLOCK_SIZE_MAX >= blockSize);
+        CPPUNIT_ASSERT(bgzf.size() >= offset + blockSize);
+        const isaac::bgzf::Footer &footer = *reinterpret_cast<const isaac::bgzf::Footer*>(
+            &bgzf.at(offset + sizeof(header) + header.getCDATASize()));
+        CPPUNIT_ASSERT_EQUAL(blockSize, sizeof(header) + header.getCDATASize() + sizeof(footer));
+        CPPUNIT_ASSERT(BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX >= footer.getISIZE());
+
+        std::vector<char> block(footer.getISIZE() + 1);
+        CPPUNIT_ASSERT_EQUAL(Z_OK, inflateReset(&strm));
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&bgzf.at(offset + sizeof(header))));
+        strm.avail_in = header.getCDATASize();
+        strm.next_out = reinterpret_cast<Bytef*>(block.data());
+        strm.avail_out = block.size();
+        CPPUNIT_ASSERT_EQUAL(Z_STREAM_END, inflate(&strm, Z_FINISH));
+        CPPUNIT_ASSERT_EQUAL(uLong(footer.getISIZE()), strm.total_out);
+
+        unsigned expectedCrc = 0;
+        isaac::common::extractLittleEndian(footer.CRC32, expectedCrc);
+        CPPUNIT_ASSERT_EQUAL(
+            expectedCrc,
+            unsigned(crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef *>(block.data()), footer.getISIZE())));
+
+        data.append(block.begin(), block.begin() + footer.getISIZE());
+        offset += blockSize;
+        ++blocks;
+    }
+    inflateEnd(&strm);
+    return blocks;
+}
+
+static std::size_t roundTrip(const std::string &data)
+{
+    BgzfBlockCompressor compressor(6);
+    std::vector<char> compressed;
+    compressor.compress(data.c_str(), data.size(), compressed);
+    std::string decompressed;
+    const std::size_t ret = decompress(compressed, decompressed);
+    CPPUNIT_ASSERT_EQUAL(data.size(), decompressed.size());
+    CPPUNIT_ASSERT(data == decompressed);
+    return ret;
+}
+
+void TestBgzfBlockCompressor::testCompressible()
+{
+    std::string data;
+    while (data.size() < BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX * 3 + 1000)
+    {
+        data += "ACGTACGGTTACGATTTAGC";
+    }
+    // full blocks plus a partial one
+    CPPUNIT_ASSERT_EQUAL(4UL, roundTrip(data));
+}
+
+void TestBgzfBlockCompressor::testIncompressible()
+{
+    std::string data(BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX * 2, 0);
+    srand(1);
+    for (char &c : data)
+    {
+        c = rand();
+    }
+    // depending on the zlib version, a block of random data might not fit into a bgzf block once compressed
+    CPPUNIT_ASSERT(2UL <= roundTrip(data));
+}
+
+void TestBgzfBlockCompressor::testEmpty()
+{
+    CPPUNIT_ASSERT_EQUAL(0UL, roundTrip(std::string()));
+}
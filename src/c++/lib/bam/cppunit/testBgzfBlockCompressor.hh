@@ -0,0 +1,34 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BAM_TEST_BGZF_BLOCK_COMPRESSOR_HH
+#define iSAAC_BAM_TEST_BGZF_BLOCK_COMPRESSOR_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class TestBgzfBlockCompressor : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestBgzfBlockCompressor );
+    CPPUNIT_TEST( testCompressible );
+    CPPUNIT_TEST( testIncompressible );
+    CPPUNIT_TEST( testEmpty );
+    CPPUNIT_TEST_SUITE_END();
+public:
+    void setUp();
+    void tearDown();
+    void testCompressible();
+    void testIncompressible();
+    void testEmpty();
+};
+
+#endif // #ifndef iSAAC_BAM_TEST_BGZF_BLOCK_COMPRESSOR_HH
@@ -0,0 +1,92 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BgzfBlockCompressor.cpp
+ **
+ ** Compresses memory blocks into complete bgzf blocks going directly to zlib deflate.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <cstring>
+
+#include "bgzf/BgzfBlockCompressor.hh"
+#include "common/Debug.hh"
+
+namespace isaac
+{
+namespace bgzf
+{
+
+BgzfBlockCompressor::BgzfBlockCompressor(const int level)
+{
+    memset(&strm_, 0, sizeof(strm_));
+    // negative window bits produce raw deflate data. The gzip wrapping is done here.
+    const int ret = deflateInit2(&strm_, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (Z_OK != ret)
+    {
+        BOOST_THROW_EXCEPTION(BgzfDeflateException(ret, strm_));
+    }
+}
+
+BgzfBlockCompressor::~BgzfBlockCompressor()
+{
+    deflateEnd(&strm_);
+}
+
+std::size_t BgzfBlockCompressor::compressBlock(const char *data, const std::size_t size)
+{
+    ISAAC_ASSERT_MSG(UNCOMPRESSED_PER_BLOCK_MAX >= size, "Too much data for a bgzf block: " << size);
+    int ret = deflateReset(&strm_);
+    if (Z_OK != ret)
+    {
+        BOOST_THROW_EXCEPTION(BgzfDeflateException(ret, strm_));
+    }
+
+    strm_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    strm_.avail_in = size;
+    strm_.next_out = reinterpret_cast<Bytef *>(block_ + sizeof(Header));
+    strm_.avail_out = sizeof(block_) - sizeof(Header) - sizeof(Footer);
+    ret = deflate(&strm_, Z_FINISH);
+    if (Z_OK == ret || Z_BUF_ERROR == ret)
+    {
+        // ran out of space
+        return 0;
+    }
+    if (Z_STREAM_END != ret)
+    {
+        BOOST_THROW_EXCEPTION(BgzfDeflateException(ret, strm_));
+    }
+
+    const std::size_t blockSize = sizeof(Header) + strm_.total_out + sizeof(Footer);
+    const unsigned bsize = blockSize - 1;
+    const Header header =
+    {
+        31, 139, 8, 0x04, {0, 0, 0, 0}, 0, 0xff,
+        {{6, 0}, 66, 67, {2, 0}, {(unsigned char)(bsize), (unsigned char)(bsize / 256)}}
+    };
+    memcpy(block_, &header, sizeof(header));
+
+    const unsigned crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef *>(data), size);
+    Footer footer;
+    for (unsigned i = 0; 4 != i; ++i)
+    {
+        footer.CRC32[i] = (crc >> (i * 8)) & 0xFF;
+        footer.ISIZE[i] = (size >> (i * 8)) & 0xFF;
+    }
+    memcpy(block_ + sizeof(Header) + strm_.total_out, &footer, sizeof(footer));
+
+    return blockSize;
+}
+
+} // namespace bgzf
+} // namespace isaac
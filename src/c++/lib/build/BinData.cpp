@@ -77,7 +77,7 @@ const gapRealigner::RealignerGaps &BinData::getRealignerGaps(const unsigned barc
 
 void BinData::reserveGaps(
     const alignment::BinMetadata& bin,
-    const gapRealigner::Gaps &knownIndels,
+    const KnownIndels &knownIndels,
     const flowcell::BarcodeMetadataList &barcodeMetadataList)
 {
     std::vector<std::size_t> gapsByGroup(getGapGroupsCount(), 0);
@@ -87,10 +87,9 @@ void BinData::reserveGaps(
             bin.getBarcodeGapCount(barcode.getIndex());
     }
 
-    BOOST_FOREACH(const gapRealigner::Gap &gap, knownIndels)
-    {
-        if ((gap.getBeginPos() >= bin.getBinStart() && gap.getBeginPos() < bin.getBinEnd()) ||
-            (gap.getEndPos(false) >= bin.getBinStart() && gap.getEndPos(false) < bin.getBinEnd()))
+    knownIndels.forEachOverlapping(
+        bin.getBinStart(), bin.getBinEnd(),
+        [&](const gapRealigner::Gap &gap)
         {
             std::for_each(
                 realignerGaps_.begin(), realignerGaps_.end(),
@@ -98,8 +97,7 @@ void BinData::reserveGaps(
                 {
                     gapGroup.addGap(gapRealigner::Gap(gap.pos_, gap.length_, gap.HIGHEST_PRIORITY));
                 });
-        }
-    }
+        });
 
     unsigned gapGroupId = 0;
     BOOST_FOREACH(const std::size_t gaps, gapsByGroup)
@@ -27,6 +27,7 @@
 
 #include "build/BinLoader.hh"
 #include "common/Memory.hh"
+#include "common/Trace.hh"
 
 namespace isaac
 {
@@ -55,6 +56,7 @@ void verifyFragmentIntegrity(const io::FragmentAccessor &fragment)
 
 void BinLoader::loadData(BinData &binData)
 {
+    ISAAC_TRACE_SPAN("binLoad");
     ISAAC_THREAD_CERR << "Loading unsorted data" << std::endl;
     const clock_t startLoad = clock();
 
@@ -27,67 +27,24 @@
 
 #include "build/BinSorter.hh"
 #include "common/Memory.hh"
+#include "common/Trace.hh"
 
 namespace isaac
 {
 namespace build
 {
 
-uint64_t BinSorter::serialize(
-    BinData &binData,
-    boost::ptr_vector<boost::iostreams::filtering_ostream> &bgzfStreams,
-    boost::ptr_vector<bam::BamIndexPart> &bamIndexParts)
+void BinSorter::prepareForSerialization(BinData &binData)
 {
     if (!binData.getUniqueRecordsCount())
     {
-        return 0;
+        return;
     }
     ISAAC_THREAD_CERR << "Sorting offsets for bam " << binData.bin_ << std::endl;
 
     bamSerializer_.prepareForBam(contigLists_.front(), binData.data_, binData, binData.additionalCigars_, binData.splitInfoList_);
 
     ISAAC_THREAD_CERR << "Sorting offsets for bam done " << binData.bin_ << std::endl;
-
-    ISAAC_THREAD_CERR << "Serializing records: " << binData.getUniqueRecordsCount() <<  " of them for bin " << binData.bin_ << std::endl;
-
-    std::time_t serTimeStart = common::time();
-
-    if (binData.isUnalignedBin())
-    {
-        uint64_t offset = 0;
-        while(binData.data_.size() != offset)
-        {
-            const io::FragmentAccessor &fragment = binData.data_.getFragment(offset);
-//            ISAAC_THREAD_CERR << "storeUnaligned: " << offset << "/" << binData.data_.size() << " " << fragment << std::endl;
-            bamSerializer_.storeUnaligned(fragment, bgzfStreams, bamIndexParts, binData.bamAdapter_(fragment));
-            offset += fragment.getTotalLength();
-        }
-    }
-    else
-    {
-        BOOST_FOREACH(const PackedFragmentBuffer::Index& idx, binData)
-        {
-            // realigning reads that don't belong to the bin is not very useful
-            // also, it can move the read position and cause more than one copy of the
-            // read to be stored in the bam file.
-            if (binData.bin_.hasPosition(idx.pos_))
-            {
-                const io::FragmentAccessor &fragment = binData.data_.getFragment(idx);
-                bamSerializer_.storeAligned(fragment, bgzfStreams, bamIndexParts, binData.bamAdapter_(idx, fragment));
-            }
-            //else the fragment got split into a bit that does not belong to the current bin. it will get stored by another bin BinSorter.
-        }
-    }
-
-    BOOST_FOREACH(boost::iostreams::filtering_ostream &bgzfStream, bgzfStreams)
-    {
-        ISAAC_VERIFY_MSG(bgzfStream.strict_sync(), "Expecting the compressor to flush all the data");
-    }
-
-    std::time_t serTimeEnd = common::time();
-
-    ISAAC_THREAD_CERR << "Serializing records done: " << binData.getUniqueRecordsCount() <<  " of them for bin " << binData.bin_ << " in " << ::std::difftime(serTimeEnd, serTimeStart) << "seconds." << std::endl;
-    return binData.size();
 }
 
 void BinSorter::resolveDuplicates(
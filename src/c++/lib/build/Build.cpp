@@ -34,10 +34,10 @@
 #include "bam/BamIndexer.hh"
 #include "bgzf/BgzfCompressor.hh"
 #include "build/Build.hh"
-#include "build/IndelLoader.hh"
 #include "common/Debug.hh"
 #include "common/FileSystem.hh"
 #include "common/Threads.hpp"
+#include "common/Trace.hh"
 #include "io/Fragment.hh"
 #include "reference/ContigLoader.hh"
 
@@ -88,7 +88,7 @@ uint64_t Build::estimateBinCompressedDataRequirements(
     }
 
     // assume all data will take the same fraction or less than the number derived from demultiplexed fragments.
-    return EMPTY_BGZF_BLOCK_SIZE +
+    return EMPTY_BGZF_BLOCK_SIZE + ParallelBinSerializer::estimateChunkingOverhead(binMetadata.getTotalElements()) +
         ((getBinTotalSize(binMetadata) * thisOutputFileBarcodeElements +
             binMetadata.getTotalElements() - 1) / binMetadata.getTotalElements()) * expectedBgzfCompressionRatio_;
 }
@@ -295,6 +295,7 @@ Build::Build(const std::vector<std::string> &argv,
              const reference::SortedReferenceMetadataList &sortedReferenceMetadataList,
              const reference::ContigLists &contigLists,
              const boost::filesystem::path outputDirectory,
+             const boost::filesystem::path &tempDirectory,
              const unsigned maxLoaders,
              const unsigned maxComputers,
              const unsigned maxSavers,
@@ -304,6 +305,7 @@ Build::Build(const std::vector<std::string> &argv,
              const int bamGzipLevel,
              const std::string &bamPuFormat,
              const bool bamProduceMd5,
+             const bool bamMergeRuns,
              const std::vector<std::string> &bamHeaderTags,
              const unsigned expectedCoverage,
              const uint64_t targetBinSize,
@@ -313,6 +315,8 @@ Build::Build(const std::vector<std::string> &argv,
              const bool markDuplicates,
              const bool anchorMate,
              const bool realignGapsVigorously,
+             const GapRealignerEngine realignEngine,
+             const bool realignmentCache,
              const bool realignDodgyFragments,
              const unsigned realignedGapsPerFragment,
              const bool clipSemialigned,
@@ -338,6 +342,7 @@ Build::Build(const std::vector<std::string> &argv,
      maxLoaders_(maxLoaders),
      maxComputers_(maxComputers),
      allocatedBins_(0),
+     storedRunBins_(0),
      maxSavers_(maxSavers),
      bamGzipLevel_(bamGzipLevel),
      bamPuFormat_(bamPuFormat),
@@ -366,25 +371,23 @@ Build::Build(const std::vector<std::string> &argv,
      bamFileStreams_(createOutputFileStreams(tileMetadataList_, barcodeMetadataList_, bamIndexes_)),
      stats_(binRefs_, barcodeMetadataList_),
      threadBgzfBuffers_(threads_.size(), BgzfBuffers(bamFileStreams_.size())),
-     threadBgzfStreams_(threads_.size()),
      threadBamIndexParts_(threads_.size()),
-     knownIndels_((build::GapRealignerMode::REALIGN_NONE == realignGaps_ || knownIndelsPath.empty()) ?
-         gapRealigner::Gaps() : loadIndels(knownIndelsPath, sortedReferenceMetadataList_)),
+     knownIndels_(build::GapRealignerMode::REALIGN_NONE == realignGaps_ ? boost::filesystem::path() : knownIndelsPath,
+                  sortedReferenceMetadataList_, outputDirectory),
      gapRealigner_(threads_.size(),
-         realignGapsVigorously, realignDodgyFragments, realignedGapsPerFragment, clipSemialigned,
+         realignGapsVigorously, realignEngine, realignmentCache, realignDodgyFragments, realignedGapsPerFragment, clipSemialigned,
 //         alignmentCfg_.normalizedMismatchScore_,
 //         alignmentCfg_.normalizedGapOpenScore_,
 //         alignmentCfg_.normalizedGapExtendScore_,
 //         alignmentCfg_.normalizedMaxGapExtendScore_,
          barcodeMetadataList, barcodeTemplateLengthStatistics, contigLists_),
      binSorter_(singleLibrarySamples_, keepDuplicates_, markDuplicates_, anchorMate_,
-               barcodeBamMapping_, barcodeMetadataList_, contigLists_, alignmentCfg_.splitGapLength_)
+               barcodeBamMapping_, barcodeMetadataList_, contigLists_, alignmentCfg_.splitGapLength_),
+     binSerializer_(threads_.size(), bamFileStreams_.size(), bamGzipLevel_, barcodeBamMapping_.getSampleIndexMap()),
+     runMerger_(bamMergeRuns ? tempDirectory / "sorted-runs" : boost::filesystem::path(),
+                bamFileStreams_.size(), binRefs_.size(), !putUnalignedInTheBack, bamGzipLevel_)
 {
     computeSlotWaitingBins_.reserve(threads_.size());
-    while(threadBgzfStreams_.size() < threads_.size())
-    {
-        threadBgzfStreams_.push_back(new boost::ptr_vector<boost::iostreams::filtering_ostream>(bamFileStreams_.size()));
-    }
     while(threadBamIndexParts_.size() < threads_.size())
     {
         threadBamIndexParts_.push_back(new boost::ptr_vector<bam::BamIndexPart>(bamFileStreams_.size()));
@@ -434,6 +437,13 @@ void Build::run(common::ScopedMallocBlock &mallocBlock)
         std::ostream *stm = bamFileStreams_.at(fileIndex).get();
         if (stm)
         {
+            if (runMerger_.isEnabled())
+            {
+                ISAAC_THREAD_CERR << "Merging sorted runs into " << bamFilePath.c_str() << std::endl;
+                common::ScopedMallocBlockUnblock unblockMalloc(mallocBlock);
+                runMerger_.merge(fileIndex, threads_, *stm, bamIndexes_.at(fileIndex));
+                ISAAC_THREAD_CERR << "Merging sorted runs done into " << bamFilePath.c_str() << std::endl;
+            }
             bam::serializeBgzfFooter(*stm);
             stm->flush();
             ISAAC_THREAD_CERR << "BAM file generated: " << bamFilePath.c_str() << "\n";
@@ -446,6 +456,8 @@ void Build::run(common::ScopedMallocBlock &mallocBlock)
 
 void Build::dumpStats(const boost::filesystem::path &statsXmlPath)
 {
+    ISAAC_THREAD_CERR << "Realignment cache hits: " << stats_.getRealignmentCacheHits() <<
+        " misses: " << stats_.getRealignmentCacheMisses() << std::endl;
     BuildStatsXml statsXml(sortedReferenceMetadataList_, binRefs_, barcodeMetadataList_, stats_);
     std::ofstream os(statsXmlPath.string().c_str());
     if (!os) {
@@ -503,25 +515,22 @@ void Build::reserveBuffers(
     boost::shared_ptr<BinData> &binDataPtr)
 {
     common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
-    boost::ptr_vector<boost::iostreams::filtering_ostream> &bgzfStreams = threadBgzfStreams_.at(threadNumber);
     boost::ptr_vector<bam::BamIndexPart> &bamIndexParts = threadBamIndexParts_.at(threadNumber);
     // bin stats have an entry per filtered bin reference.
     const unsigned binStatsIndex = std::distance<alignment::BinMetadataCRefList::const_iterator>(binRefs_.begin(), thisThreadBinIt);
     common::ScopedMallocBlockUnblock unblockMalloc(mallocBlock);
     ISAAC_TRACE_STAT("Before allocating data for " << bin);
     reserveBuffers(
-        bin, binStatsIndex, contigLists_, bgzfStreams, bamIndexParts,
+        bin, binStatsIndex, contigLists_, bamIndexParts,
         threadBgzfBuffers_.at(threadNumber), binDataPtr);
     ISAAC_TRACE_STAT("After  allocating data for " << bin);
 }
 
 void Build::cleanupBinAllocationFailure(
     const alignment::BinMetadata& bin,
-    boost::ptr_vector<boost::iostreams::filtering_ostream>& bgzfStreams,
     boost::ptr_vector<bam::BamIndexPart>& bamIndexParts,
     boost::shared_ptr<BinData>& binDataPtr, BgzfBuffers& bgzfBuffers)
 {
-    bgzfStreams.clear();
     bamIndexParts.clear();
     // give a chance other threads to allocate what they need... TODO: this is not required anymore as allocation happens orderly
     binDataPtr.reset();
@@ -542,7 +551,6 @@ void Build::reserveBuffers(
     const alignment::BinMetadata &bin,
     const unsigned binStatsIndex,
     const reference::ContigLists &contigLists,
-    boost::ptr_vector<boost::iostreams::filtering_ostream> &bgzfStreams,
     boost::ptr_vector<bam::BamIndexPart> &bamIndexParts,
     BgzfBuffers &bgzfBuffers,
     boost::shared_ptr<BinData> &binDataPtr)
@@ -562,17 +570,6 @@ void Build::reserveBuffers(
             bgzfBuffer.reserve(estimateBinCompressedDataRequirements(bin, outputFileIndex++));
         }
 
-        ISAAC_ASSERT_MSG(!bgzfStreams.size(), "Expecting empty pool of streams");
-        while(bgzfStreams.size() < bamFileStreams_.size())
-        {
-            bgzfStreams.push_back(new boost::iostreams::filtering_ostream);
-            bgzfStreams.back().push(bgzf::BgzfCompressor(bamGzipLevel_), 65535, 0);
-            bgzfStreams.back().push(
-                boost::iostreams::back_insert_device<bam::BgzfBuffer >(
-                    bgzfBuffers.at(bgzfStreams.size()-1)));
-            bgzfStreams.back().exceptions(std::ios_base::badbit);
-        }
-
         ISAAC_ASSERT_MSG(!bamIndexParts.size(), "Expecting empty pool of bam index parts");
         while(bamIndexParts.size() < bamFileStreams_.size())
         {
@@ -581,7 +578,7 @@ void Build::reserveBuffers(
     }
     catch (...)
     {
-        cleanupBinAllocationFailure(bin, bgzfStreams, bamIndexParts, binDataPtr, bgzfBuffers);
+        cleanupBinAllocationFailure(bin, bamIndexParts, binDataPtr, bgzfBuffers);
         throw;
     }
 }
@@ -695,7 +692,7 @@ boost::shared_ptr<BinData> Build::allocateBin(
         catch (std::bad_alloc &a)
         {
             uint64_t totalBuffersNeeded = 0UL;
-            for(unsigned outputFileIndex = 0; outputFileIndex < threadBgzfStreams_.at(threadNumber).size(); ++outputFileIndex)
+            for(unsigned outputFileIndex = 0; outputFileIndex < bamFileStreams_.size(); ++outputFileIndex)
             {
                 totalBuffersNeeded += estimateBinCompressedDataRequirements(bin, outputFileIndex++);
             }
@@ -1038,7 +1035,10 @@ void Build::sortBinParallel(alignment::BinMetadataCRefList::iterator &nextUnproc
                             ISAAC_THREAD_CERR << "Realigning against " << getTotalGapsCount(binDataPtr->realignerGaps_) <<
                                 " unique gaps. " << binDataPtr->bin_ << std::endl;
                         }
-                        gapRealigner_.threadRealignGaps(l, *binDataPtr, nextUnprocessed, tn);
+                        {
+                            ISAAC_TRACE_SPAN("realign");
+                            gapRealigner_.threadRealignGaps(l, *binDataPtr, nextUnprocessed, tn, stats_);
+                        }
                         if (!--threadsIn)
                         {
                             ISAAC_THREAD_CERR << "Realigning gaps done. " << binDataPtr->bin_ << std::endl;
@@ -1052,21 +1052,33 @@ void Build::sortBinParallel(alignment::BinMetadataCRefList::iterator &nextUnproc
 
             preemptComputeSlot(
                 lock, 1, std::distance(binRefs_.begin(), thisThreadBinIt),
-                [this, &binDataPtr, &threadNumber](boost::unique_lock<boost::mutex> &l, const unsigned tn)
+                [this, &binDataPtr](boost::unique_lock<boost::mutex> &l, const unsigned tn)
+                {
+                    common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(l);
+                    binSorter_.prepareForSerialization(*binDataPtr);
+                },
+                threadNumber);
+
+            // Don't use tn for the output!!! the buffers have been allocated for the threadNumber.
+            ParallelBinSerializer::BinState serializerState(
+                *binDataPtr, threadBgzfBuffers_.at(threadNumber), threadBamIndexParts_.at(threadNumber));
+            ISAAC_THREAD_CERR << "Serializing records: " << binDataPtr->getUniqueRecordsCount() <<
+                " of them for bin " << binDataPtr->bin_ << std::endl;
+            const std::time_t serTimeStart = common::time();
+            preemptComputeSlot(
+                lock, -1, std::distance(binRefs_.begin(), thisThreadBinIt),
+                [this, &serializerState](boost::unique_lock<boost::mutex> &l, const unsigned tn)
                 {
                     ++serializingThreads;
             //        ISAAC_THREAD_CERR << "Threads:" << allocatedBins_ << "," << dedupingThreads << "," << realigningThreads << "," << serializingThreads << "," << savingThreads << "," << loadingThreads << std::endl;
-                    {
-                        common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(l);
-                        // Don't use tn!!! the streams have been allocated for the threadNumber.
-                        binSorter_.serialize(
-                            *binDataPtr, threadBgzfStreams_.at(threadNumber), threadBamIndexParts_.at(threadNumber));
-                        threadBgzfStreams_.at(threadNumber).clear();
-                    }
+                    binSerializer_.threadSerialize(l, serializerState, tn);
                     --serializingThreads;
             //        ISAAC_THREAD_CERR << "Threads:" << allocatedBins_ << "," << dedupingThreads << "," << realigningThreads << "," << serializingThreads << "," << savingThreads << "," << loadingThreads << std::endl;
                 },
                 threadNumber);
+            ISAAC_THREAD_CERR << "Serializing records done: " << binDataPtr->getUniqueRecordsCount() <<
+                " of them for bin " << binDataPtr->bin_ << " in " <<
+                std::difftime(common::time(), serTimeStart) << "seconds." << std::endl;
         }
         // give back some memory to allow other threads to load
         // data while we're waiting for our turn to save
@@ -1075,18 +1087,30 @@ void Build::sortBinParallel(alignment::BinMetadataCRefList::iterator &nextUnproc
 
         ++savingThreads;
 //        ISAAC_THREAD_CERR << "Threads:" << allocatedBins_ << "," << dedupingThreads << "," << realigningThreads << "," << serializingThreads << "," << savingThreads << "," << loadingThreads << std::endl;
-        // wait for our turn to store bam data
-        waitForSaveSlot(lock, thisThreadBinIt, nextUnsavedBinIt);
-        ISAAC_BLOCK_WITH_CLENAUP(boost::bind(&Build::returnSaveSlot, this, boost::ref(nextUnsavedBinIt), thisThreadBinsEndIt, _1))
+        if (runMerger_.isEnabled())
         {
-            saveAndReleaseBuffers(lock, thisThreadBinIt->get().getPath(), threadNumber);
+            // runs get merged at the end. No need to wait for the preceding bins
+            ISAAC_BLOCK_WITH_CLENAUP(boost::bind(&Build::returnRunSlot, this, std::distance(thisThreadBinIt, thisThreadBinsEndIt), _1))
+            {
+                storeRunsAndReleaseBuffers(lock, std::distance(binRefs_.begin(), thisThreadBinIt), mallocBlock, threadNumber);
+            }
+        }
+        else
+        {
+            // wait for our turn to store bam data
+            waitForSaveSlot(lock, thisThreadBinIt, nextUnsavedBinIt);
+            ISAAC_BLOCK_WITH_CLENAUP(boost::bind(&Build::returnSaveSlot, this, boost::ref(nextUnsavedBinIt), thisThreadBinsEndIt, _1))
+            {
+                saveAndReleaseBuffers(lock, thisThreadBinIt->get().getPath(), threadNumber);
+            }
         }
         --savingThreads;
 //        ISAAC_THREAD_CERR << "Threads:" << allocatedBins_ << "," << dedupingThreads << "," << realigningThreads << "," << serializingThreads << "," << savingThreads << "," << loadingThreads << std::endl;
     }
 
     // Don't release thread until all saving is done. Use threads that don't get anything to process for preemptive tasks such as realignment.
-    while(!forceTermination_ && binRefs_.end() != nextUnsavedBinIt)
+    while(!forceTermination_ &&
+        (runMerger_.isEnabled() ? binRefs_.size() != storedRunBins_ : binRefs_.end() != nextUnsavedBinIt))
     {
         if (!yieldIfPossible(lock, threadNumber, 0))
         {
@@ -1131,6 +1155,44 @@ void Build::saveAndReleaseBuffers(
     threadBamIndexParts_.at(threadNumber).clear();
 }
 
+void Build::returnRunSlot(const std::size_t bins, const bool exceptionUnwinding)
+{
+    storedRunBins_ += bins;
+    if (exceptionUnwinding)
+    {
+        forceTermination_ = true;
+    }
+    stateChangedCondition_.notify_all();
+}
+
+/**
+ * \brief Store bgzf compressed buffers as sorted runs of the corresponding sample files and release associated memory
+ */
+void Build::storeRunsAndReleaseBuffers(
+    boost::unique_lock<boost::mutex> &lock,
+    const std::size_t run,
+    common::ScopedMallocBlock &mallocBlock,
+    const std::size_t threadNumber)
+{
+    {
+        common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+        common::ScopedMallocBlockUnblock unblockMalloc(mallocBlock);
+        unsigned index = 0;
+        for (bam::BgzfBuffer &bgzfBuffer : threadBgzfBuffers_.at(threadNumber))
+        {
+            ISAAC_ASSERT_MSG(bamFileStreams_.at(index) || bgzfBuffer.empty(),
+                             "Unexpected data for bam file belonging to a sample with unmapped reference");
+            runMerger_.storeRun(index, run, bgzfBuffer);
+            // release rest of the memory that was reserved for this bin
+            bam::BgzfBuffer().swap(bgzfBuffer);
+            ++index;
+        }
+    }
+    --allocatedBins_;
+    // the merge produces its own index
+    threadBamIndexParts_.at(threadNumber).clear();
+}
+
 void Build::saveBuffer(
     const bam::BgzfBuffer &bgzfBuffer,
     std::ostream &bamStream,
@@ -1138,6 +1200,7 @@ void Build::saveBuffer(
     bam::BamIndex &bamIndex,
     const boost::filesystem::path &filePath)
 {
+    ISAAC_TRACE_SPAN("binSave");
     ISAAC_THREAD_CERR << "Saving " << bgzfBuffer.size() << " bytes of sorted data for bin " << filePath.c_str() << std::endl;
     const clock_t start = clock();
     if(!bgzfBuffer.empty() && !bamStream.write(&bgzfBuffer.front(), bgzfBuffer.size())/* ||
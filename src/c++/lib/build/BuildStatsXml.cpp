@@ -180,6 +180,12 @@ void BuildStatsXml::serialize(std::ostream &os)
             xmlWriter.endElement(); //close Sample
             xmlWriter.endElement(); //close Project
         }
+
+        ISAAC_XML_WRITER_ELEMENT_BLOCK(xmlWriter, "RealignmentCache")
+        {
+            xmlWriter.writeElement("Hits", buildStats_.getRealignmentCacheHits());
+            xmlWriter.writeElement("Misses", buildStats_.getRealignmentCacheMisses());
+        }
     }
     ISAAC_THREAD_CERR << "Generating Build statistics done" << std::endl;
 }
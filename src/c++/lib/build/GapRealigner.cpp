@@ -16,6 +16,7 @@
  **
  ** \author Roman Petrovski
  **/
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 
@@ -36,6 +37,12 @@ inline std::ostream & operator << (std::ostream &os, const GapRealigner::Realign
         fragmentGaps.endPos_ << ")";
 }
 
+inline bool orderByBeginPos(const gapRealigner::Gap &left, const gapRealigner::Gap &right)
+{
+    return left.getBeginPos() < right.getBeginPos() ||
+        (left.getBeginPos() == right.getBeginPos() && left.length_ < right.length_);
+}
+
 const GapRealigner::RealignmentBounds GapRealigner::extractRealignmentBounds(
     const PackedFragmentBuffer::Index &index) const
 {
@@ -1139,6 +1146,332 @@ bool GapRealigner::findBetterGapsChoice(
     return ret;
 }
 
+/**
+ * \brief Collects the alignment positions from which the read can reach one of the anchorDiagonals_ by
+ *        introducing at most gapsPerFragmentMax_ of the gaps. Same bin restrictions as in findStartPos apply.
+ */
+void GapRealigner::collectStartDiagonals(
+    const gapRealigner::GapsRange& gaps,
+    const reference::ReferencePosition& binStartPos,
+    const reference::ReferencePosition& binEndPos)
+{
+    // gap lengths repeat a lot. Only the distinct ones matter for the diagonal shifts
+    gapLengths_.clear();
+    BOOST_FOREACH(const gapRealigner::Gap& gap, std::make_pair(gaps.first, gaps.second))
+    {
+        gapLengths_.push_back(gap.length_);
+    }
+    std::sort(gapLengths_.begin(), gapLengths_.end());
+    gapLengths_.erase(std::unique(gapLengths_.begin(), gapLengths_.end()), gapLengths_.end());
+
+    // deletions move the read diagonal right, insertions move it left
+    startDiagonals_.clear();
+    startDiagonals_.push_back(0);
+    for (unsigned gapsCount = 0; gapsPerFragmentMax_ != gapsCount; ++gapsCount)
+    {
+        const std::size_t shiftsCount = startDiagonals_.size();
+        for (std::size_t i = 0; shiftsCount != i; ++i)
+        {
+            BOOST_FOREACH(const int length, gapLengths_)
+            {
+                if (startDiagonals_.size() == startDiagonals_.capacity())
+                {
+                    // too many combinations of gap lengths. Just stop here. The shifts collected so far cover
+                    // the paths with fewer gaps.
+                    break;
+                }
+                startDiagonals_.push_back(startDiagonals_[i] + length);
+            }
+        }
+        std::sort(startDiagonals_.begin(), startDiagonals_.end());
+        startDiagonals_.erase(std::unique(startDiagonals_.begin(), startDiagonals_.end()), startDiagonals_.end());
+    }
+
+    const std::size_t shiftsEnd = startDiagonals_.size();
+    BOOST_FOREACH(const int64_t anchorDiagonal, anchorDiagonals_)
+    {
+        for (std::size_t i = 0; shiftsEnd != i; ++i)
+        {
+            const int64_t startDiagonal = anchorDiagonal - startDiagonals_[i];
+            if (int64_t(binStartPos.getPosition()) <= startDiagonal && int64_t(binEndPos.getPosition()) >= startDiagonal &&
+                startDiagonals_.size() != startDiagonals_.capacity())
+            {
+                startDiagonals_.push_back(startDiagonal);
+            }
+        }
+    }
+    startDiagonals_.erase(startDiagonals_.begin(), startDiagonals_.begin() + shiftsEnd);
+    std::sort(startDiagonals_.begin(), startDiagonals_.end());
+    startDiagonals_.erase(std::unique(startDiagonals_.begin(), startDiagonals_.end()), startDiagonals_.end());
+}
+
+/**
+ * \brief Aligns the read bases between the node and the gap nextGapIndex without gaps and introduces the gap.
+ *        The resulting node replaces the one that reached the same state at a higher cost.
+ */
+void GapRealigner::extendGraphNode(
+    const unsigned nodeIndex,
+    const unsigned nextGapIndex,
+    const gapRealigner::GapsRange& gaps,
+    const reference::Contig& contig,
+    const reference::ContigList& reference,
+    const io::FragmentAccessor& fragment)
+{
+    const GraphNode &from = graphNodes_[nodeIndex];
+    if (gapsPerFragmentMax_ == from.gaps_)
+    {
+        return;
+    }
+
+    const gapRealigner::Gap &gap = *(gaps.first + nextGapIndex);
+    const int64_t gapBeginPos = gap.getBeginPos().getPosition();
+    if (gap.getBeginPos().getContigId() != contig.getIndex() || from.referencePos_ > gapBeginPos)
+    {
+        return;
+    }
+
+    if (std::size_t(std::distance(gaps.first, gaps.second)) != from.gapIndex_ &&
+        (gaps.first + from.gapIndex_)->isInsertion() && from.referencePos_ == gapBeginPos)
+    {
+        // see verifyGapsChoice for why gaps are not allowed to start at the same position
+        return;
+    }
+
+    const unsigned unclippedEnd = fragment.readLength_ - fragment.rightClipped();
+    const int64_t gapReadOffset = from.readOffset_ + (gapBeginPos - from.referencePos_);
+    if (unclippedEnd <= from.readOffset_ || (!fragment.rightClipped() && unclippedEnd <= gapReadOffset))
+    {
+        // verifyGapsChoice rejects gaps that begin after the read ends and ignores the ones that follow the gap
+        // which has reached the right clipping.
+        return;
+    }
+
+    GraphNode to = from;
+    to.gapIndex_ = nextGapIndex;
+    to.previous_ = nodeIndex;
+    ++to.gaps_;
+
+    // gap in the right-clipped part of the read still moves the read, same as in verifyGapsChoice
+    const unsigned unclippedBegin = std::max<unsigned>(from.readOffset_, fragment.leftClipped());
+    const int64_t mappedEnd = std::min<int64_t>(gapReadOffset, unclippedEnd);
+    if (unclippedBegin < mappedEnd)
+    {
+        const unsigned mm = alignment::countEditDistanceMismatches(
+            reference, fragment.basesBegin() + unclippedBegin,
+            reference::ReferencePosition(contig.getIndex(), from.referencePos_ + unclippedBegin - from.readOffset_),
+            mappedEnd - unclippedBegin);
+        to.cost_ += mm * mismatchCost_;
+        to.editDistance_ += mm;
+    }
+
+    unsigned clippedGapLength = 0;
+    if (gap.isInsertion())
+    {
+        clippedGapLength = unclippedEnd > gapReadOffset ? std::min<unsigned>(unclippedEnd - gapReadOffset, gap.getLength()) : 0;
+        to.readOffset_ = gapReadOffset + clippedGapLength;
+        to.referencePos_ = gapBeginPos;
+    }
+    else
+    {
+        clippedGapLength = fragment.leftClipped() > gapReadOffset ? 0 : gap.getLength();
+        to.readOffset_ = gapReadOffset;
+        to.referencePos_ = gapBeginPos + gap.getLength();
+    }
+
+    if (clippedGapLength)
+    {
+        to.cost_ += gapOpenCost_ + (clippedGapLength - 1) * gapExtendCost_;
+        to.editDistance_ += clippedGapLength;
+    }
+
+    to.totalPriority_ = gapRealigner::Gap::HIGHEST_PRIORITY - to.totalPriority_ >= gap.priority_ ?
+        to.totalPriority_ + gap.priority_ : gapRealigner::Gap::HIGHEST_PRIORITY;
+    // insertion clipped by the end of the read still shifts the diagonal by its full length, same as in the
+    // combinatorial search. Otherwise it would not find its way back to the anchor.
+    to.diagonal_ = to.referencePos_ - (gap.isInsertion() ? gapReadOffset + gap.getLength() : to.readOffset_);
+    to.anchored_ = to.anchored_ || std::binary_search(anchorDiagonals_.begin(), anchorDiagonals_.end(), to.diagonal_);
+
+    std::vector<unsigned> &gapNodes = gapGraphNodes_[nextGapIndex];
+    BOOST_FOREACH(const unsigned existing, gapNodes)
+    {
+        GraphNode &node = graphNodes_[existing];
+        if (node.diagonal_ == to.diagonal_ && node.gaps_ == to.gaps_ && node.anchored_ == to.anchored_)
+        {
+            if (to.isBetterThan(node))
+            {
+                node = to;
+            }
+            return;
+        }
+    }
+    if (gapNodes.size() == gapNodes.capacity())
+    {
+        // too many distinct states after this gap. Keep the best ones. Nodes of this gap are not referenced yet as
+        // the following gaps get extended only once all the preceding ones are done.
+        GraphNode &worst = graphNodes_[*std::max_element(
+            gapNodes.begin(), gapNodes.end(),
+            [this](const unsigned left, const unsigned right){return graphNodes_[right].isBetterThan(graphNodes_[left]);})];
+        if (to.isBetterThan(worst))
+        {
+            worst = to;
+        }
+        return;
+    }
+    gapNodes.push_back(graphNodes_.size());
+    graphNodes_.push_back(to);
+}
+
+/**
+ * \brief Aligns the read bases after the last gap of the path without gaps
+ *
+ * \return false if the path runs off the contig
+ */
+bool GapRealigner::finishGraphPath(
+    const GraphNode &node,
+    const reference::Contig& contig,
+    const reference::ContigList& reference,
+    const io::FragmentAccessor& fragment,
+    GraphNode &finished) const
+{
+    finished = node;
+    const unsigned unclippedEnd = fragment.readLength_ - fragment.rightClipped();
+    const unsigned unclippedBegin = std::max<unsigned>(node.readOffset_, fragment.leftClipped());
+    if (unclippedBegin < unclippedEnd)
+    {
+        const int64_t unclippedBeginPos = node.referencePos_ + unclippedBegin - node.readOffset_;
+        if (int64_t(contig.size()) < unclippedBeginPos)
+        {
+            return false;
+        }
+        const unsigned mm = alignment::countEditDistanceMismatches(
+            reference, fragment.basesBegin() + unclippedBegin,
+            reference::ReferencePosition(contig.getIndex(), unclippedBeginPos), unclippedEnd - unclippedBegin);
+        finished.cost_ += mm * mismatchCost_;
+        finished.editDistance_ += mm;
+    }
+    return true;
+}
+
+/**
+ * \brief Finds the cheapest alignment of the fragment through the graph of the reference and the gaps.
+ *
+ * Nodes represent the read state right after a gap has been introduced. Since gaps are ordered by position,
+ * edges only go from lower to higher gap index which allows to process the graph in a single pass. Nodes
+ * reaching the same diagonal with the same number of gaps are merged keeping the cheaper one. This makes
+ * the cost polynomial in the number of gaps instead of exponential.
+ *
+ * The winning path is verified with verifyGapsChoice so that the result is costed exactly as the
+ * combinatorial search would cost it.
+ */
+bool GapRealigner::findBestGapsPath(
+    const gapRealigner::GapsRange& gaps,
+    const reference::ReferencePosition& binStartPos,
+    const reference::ReferencePosition& binEndPos,
+    const reference::ContigList& reference,
+    const io::FragmentAccessor& fragment,
+    const PackedFragmentBuffer::Index& index,
+    GapChoice &bestChoice)
+{
+    const unsigned gapsCount = std::distance(gaps.first, gaps.second);
+    ISAAC_ASSERT_MSG(MAX_GAPS_AT_A_TIME >= gapsCount, "Too many gaps for a choice bitmask: " << gapsCount);
+    const reference::Contig &contig = reference.at(index.pos_.getContigId());
+
+    anchorDiagonals_.clear();
+    anchorDiagonals_.push_back(undoExistingGaps(index, index.pos_));
+    fragmentGaps_.clear();
+    fragmentGaps_.addGaps(index.pos_, index.cigarBegin_, index.cigarEnd_);
+    const gapRealigner::GapsRange fragmentGapsRange = fragmentGaps_.allGaps();
+    BOOST_FOREACH(const gapRealigner::Gap& undoPivotGap, std::make_pair(fragmentGapsRange.first, fragmentGapsRange.second))
+    {
+        if (anchorDiagonals_.size() == anchorDiagonals_.capacity())
+        {
+            break;
+        }
+        anchorDiagonals_.push_back(undoExistingGaps(index, undoPivotGap.getEndPos(false)));
+    }
+    std::sort(anchorDiagonals_.begin(), anchorDiagonals_.end());
+    anchorDiagonals_.erase(std::unique(anchorDiagonals_.begin(), anchorDiagonals_.end()), anchorDiagonals_.end());
+
+    collectStartDiagonals(gaps, binStartPos, binEndPos);
+
+    graphNodes_.clear();
+    std::for_each(gapGraphNodes_.begin(), gapGraphNodes_.end(), boost::bind(&std::vector<unsigned>::clear, _1));
+    std::vector<unsigned> &startNodes = gapGraphNodes_.at(MAX_GAPS_AT_A_TIME);
+    BOOST_FOREACH(const int64_t startDiagonal, startDiagonals_)
+    {
+        const GraphNode start =
+        {
+            startDiagonal, startDiagonal, 0, gapsCount, 0,
+            std::binary_search(anchorDiagonals_.begin(), anchorDiagonals_.end(), startDiagonal),
+            0, 0, 0, -1U
+        };
+        startNodes.push_back(graphNodes_.size());
+        graphNodes_.push_back(start);
+    }
+
+    for (std::size_t i = 0; startNodes.size() != i; ++i)
+    {
+        for (unsigned nextGapIndex = 0; gapsCount != nextGapIndex; ++nextGapIndex)
+        {
+            extendGraphNode(startNodes[i], nextGapIndex, gaps, contig, reference, fragment);
+        }
+    }
+    for (unsigned gapIndex = 0; gapsCount != gapIndex; ++gapIndex)
+    {
+        // nodes only get added to the buckets of the gaps that follow
+        const std::vector<unsigned> &gapNodes = gapGraphNodes_[gapIndex];
+        for (std::size_t i = 0; gapNodes.size() != i; ++i)
+        {
+            for (unsigned nextGapIndex = gapIndex + 1; gapsCount != nextGapIndex; ++nextGapIndex)
+            {
+                extendGraphNode(gapNodes[i], nextGapIndex, gaps, contig, reference, fragment);
+            }
+        }
+    }
+
+    unsigned bestNodeIndex = -1U;
+    GraphNode bestNode = GraphNode();
+    GraphNode finished;
+    for (unsigned gapIndex = 0; gapsCount != gapIndex; ++gapIndex)
+    {
+        BOOST_FOREACH(const unsigned nodeIndex, gapGraphNodes_[gapIndex])
+        {
+            const GraphNode &node = graphNodes_[nodeIndex];
+            // paths that never touch the original alignment are not reachable by the combinatorial search either
+            if (node.anchored_ && finishGraphPath(node, contig, reference, fragment, finished) &&
+                (-1U == bestNodeIndex || finished.isBetterThan(bestNode)))
+            {
+                bestNodeIndex = nodeIndex;
+                bestNode = finished;
+            }
+        }
+    }
+
+    if (-1U == bestNodeIndex)
+    {
+        ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, "No anchored gap path among " << graphNodes_.size() << " nodes");
+        return false;
+    }
+
+    GapChoiceBitmask choice = 0;
+    unsigned nodeIndex = bestNodeIndex;
+    for (; -1U != graphNodes_[nodeIndex].previous_; nodeIndex = graphNodes_[nodeIndex].previous_)
+    {
+        choice |= GapChoiceBitmask(1) << graphNodes_[nodeIndex].gapIndex_;
+    }
+
+    const GapChoice thisChoice = verifyGapsChoice(
+        choice, gaps, reference::ReferencePosition(contig.getIndex(), graphNodes_[nodeIndex].referencePos_), fragment, reference);
+    if (isBetterChoice(thisChoice, bestChoice.mismatchesPercent_, bestChoice))
+    {
+        ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, thisChoice << "better than " << bestChoice);
+        bestChoice = thisChoice;
+        return true;
+    }
+    ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, thisChoice << "no better than " << bestChoice);
+    return false;
+}
+
 /**
  * \brief Perform full realignment discarding all the existing gaps
  */
@@ -1212,6 +1545,9 @@ bool GapRealigner::realign(
 
     GapChoice bestChoice = getAlignmentCost(fragment, index);
 
+    const reference::ReferencePosition originalPos = index.pos_;
+    bool firstAttempt = true;
+    uint64_t cacheKey = 0;
     do
     {
         makesSenseToTryAgain = false;
@@ -1236,7 +1572,14 @@ bool GapRealigner::realign(
         }
 
         RealignmentBounds bounds = extractRealignmentBounds(index);
-        const gapRealigner::GapsRange gaps = realignerGaps.findGaps(fragment.clusterId_, binStartPos, bounds.beginPos_, bounds.endPos_, 8, currentAttemptGaps_);
+        const gapRealigner::GapsRange gaps = realignerGaps.findGaps(
+            fragment.clusterId_, binStartPos, bounds.beginPos_, bounds.endPos_,
+            REALIGN_ENGINE_GRAPH == engine_ ? MAX_GAPS_AT_A_TIME : COMBINATORIAL_GAPS_MAX, currentAttemptGaps_);
+        if (REALIGN_ENGINE_GRAPH == engine_)
+        {
+            // graph edges go from lower to higher gap index
+            std::sort(currentAttemptGaps_.begin(), currentAttemptGaps_.end(), orderByBeginPos);
+        }
 
 //            if (!firstAttempt && lastAttemptGaps_.size() == currentAttemptGaps_.size() &&
 //                std::equal(lastAttemptGaps_.begin(), lastAttemptGaps_.end(), currentAttemptGaps_.begin()))
@@ -1256,8 +1599,32 @@ bool GapRealigner::realign(
 
         ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, "Found Gaps " << gaps << " for bounds " << bounds);
 
+        if (firstAttempt && cache_.isEnabled())
+        {
+            cacheKey = makeCacheKey(binStartPos, binEndPos, fragment, index, gaps);
+            if (const gapRealigner::RealignmentCache::Entry *entry = cache_.find(cacheKey, originalPos))
+            {
+                ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, "GapRealigner::realign: cached " << entry->realigned_);
+                if (!entry->realigned_)
+                {
+                    return false;
+                }
+                const std::size_t before = realignedCigars.size();
+                realignedCigars.addOperations(entry->cigar_, entry->cigar_ + entry->cigarLength_);
+                index.pos_ = entry->newPos_;
+                index.cigarBegin_ = &realignedCigars.at(before);
+                index.cigarEnd_ = &realignedCigars.back() + 1;
+                newRStrandPosition = entry->newRStrandPosition_;
+                newEditDistance = entry->newEditDistance_;
+                return true;
+            }
+        }
+        firstAttempt = false;
+
         // false means none of the gaps apply. It also means the original alignment should be kept.
-        if (findBetterGapsChoice(gaps, binStartPos, binEndPos, reference, fragment, index, leftToEvaluate, bestChoice))
+        if (REALIGN_ENGINE_GRAPH == engine_ ?
+            findBestGapsPath(gaps, binStartPos, binEndPos, reference, fragment, index, bestChoice) :
+            findBetterGapsChoice(gaps, binStartPos, binEndPos, reference, fragment, index, leftToEvaluate, bestChoice))
         {
             if (binEndPos > bestChoice.startPos_)
             {
@@ -1312,9 +1679,43 @@ bool GapRealigner::realign(
     {
         compactRealignedCigarBuffer(bufferSizeBeforeRealignment, index, realignedCigars);
         ISAAC_THREAD_CERR_DEV_TRACE_CLUSTER_ID(fragment.clusterId_, "after compactRealignedCigarBuffer:" << index);
-        return true;
     }
-    return false;
+
+    if (!firstAttempt && cache_.isEnabled())
+    {
+        cache_.store(cacheKey, originalPos, ret, index.pos_, index.cigarBegin_, index.cigarEnd_, newRStrandPosition, newEditDistance);
+    }
+    return ret;
+}
+
+/**
+ * \brief Hashes everything the outcome of realign depends on. The realignerGaps are the same for the
+ *        same bin and barcode.
+ */
+uint64_t GapRealigner::makeCacheKey(
+    const reference::ReferencePosition binStartPos,
+    const reference::ReferencePosition binEndPos,
+    const io::FragmentAccessor &fragment,
+    const PackedFragmentBuffer::Index &index,
+    const gapRealigner::GapsRange &gaps) const
+{
+    gapRealigner::RealignmentCache::KeyBuilder key;
+    key << binStartPos.getValue() << binEndPos.getValue() << fragment.barcode_ << index.pos_.getValue() <<
+        fragment.flags_.reverse_ << fragment.readLength_ << fragment.leftClipped() << fragment.rightClipped() <<
+        fragment.editDistance_;
+    BOOST_FOREACH(const uint32_t operation, std::make_pair(index.cigarBegin_, index.cigarEnd_))
+    {
+        key << operation;
+    }
+    BOOST_FOREACH(const unsigned char base, std::make_pair(fragment.basesBegin(), fragment.basesEnd()))
+    {
+        key << oligo::getReferenceBaseFromBcl(base);
+    }
+    BOOST_FOREACH(const gapRealigner::Gap& gap, std::make_pair(gaps.first, gaps.second))
+    {
+        key << gap.getBeginPos().getValue() << gap.length_ << gap.priority_;
+    }
+    return key.get();
 }
 
 void GapRealigner::compactRealignedCigarBuffer(
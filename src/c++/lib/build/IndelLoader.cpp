@@ -20,6 +20,8 @@
 #include <algorithm>
 #include <unordered_map>
 
+#include <zlib.h>
+
 #include "build/IndelLoader.hh"
 #include "common/Debug.hh"
 #include "vcf/VcfUtils.hh"
@@ -30,6 +32,27 @@ namespace isaac
 namespace build
 {
 
+/**
+ * \brief gzgets that does not limit the line length
+ *
+ * \return false at the end of file
+ */
+static bool gzGetLine(gzFile file, std::string &line)
+{
+    line.clear();
+    char buffer[4096];
+    while (gzgets(file, buffer, sizeof(buffer)))
+    {
+        line.append(buffer);
+        if ('\n' == line[line.size() - 1])
+        {
+            line.resize(line.size() - 1);
+            return true;
+        }
+    }
+    return !line.empty();
+}
+
 build::gapRealigner::Gaps loadIndels(
     const boost::filesystem::path& vcfFilePath,
     const reference::SortedReferenceMetadata& sortedReferenceMetadata)
@@ -47,8 +70,9 @@ build::gapRealigner::Gaps loadIndels(
         }
     );
 
-    std::ifstream ifs(vcfFilePath.c_str());
-    if (!ifs)
+    // zlib reads uncompressed files as they are and handles the concatenated gzip members of bgzip
+    const std::unique_ptr<gzFile_s, int(*)(gzFile)> file(gzopen(vcfFilePath.c_str(), "rb"), &gzclose);
+    if (!file)
     {
         BOOST_THROW_EXCEPTION(common::IoException(errno,
             (boost::format("ERROR: Unable to open known indels file: %s") % vcfFilePath.c_str()).str()));
@@ -60,7 +84,8 @@ build::gapRealigner::Gaps loadIndels(
     ParsedLine parsedLine;
     std::size_t insertions = 0;
     std::size_t deletions = 0;
-    while (std::getline(ifs, line) || ifs.eof())
+    gzbuffer(file.get(), 1024 * 1024);
+    while (gzGetLine(file.get(), line))
     {
         ++lineNumber;
         vcf::parseVcfLine<std::string::const_iterator>(line.begin(), line.end(),
@@ -104,10 +129,14 @@ build::gapRealigner::Gaps loadIndels(
             }
         }
 //            ISAAC_THREAD_CERR << ret.back() << std::endl;
-        if (ifs.eof())
-        {
-            break;
-        }
+    }
+
+    int error = Z_OK;
+    const char *message = gzerror(file.get(), &error);
+    if (Z_OK != error && Z_BUF_ERROR != error)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(Z_ERRNO == error ? errno : EINVAL,
+            (boost::format("ERROR: Failed to read known indels file: %s: %s") % vcfFilePath.c_str() % message).str()));
     }
 
     ISAAC_THREAD_CERR << "Read " << insertions << " known insertions and " << deletions << " deletions from " << vcfFilePath.c_str() << std::endl;
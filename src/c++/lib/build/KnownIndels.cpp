@@ -0,0 +1,293 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file KnownIndels.cpp
+ **
+ ** Memory-mapped store of known indels sorted by position.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <algorithm>
+#include <fstream>
+
+#include <boost/format.hpp>
+
+#include "build/IndelLoader.hh"
+#include "build/KnownIndels.hh"
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+
+namespace isaac
+{
+namespace build
+{
+
+namespace bfs = boost::filesystem;
+
+const char KnownIndels::MAGIC[8] = {'i', 'S', 'A', 'A', 'C', 'K', 'I', 'S'};
+const uint32_t KnownIndels::VERSION;
+
+static const std::string STORE_EXTENSION = ".isaac-indels";
+
+inline bool orderByPositionAndLength(const knownIndels::Record &left, const knownIndels::Record &right)
+{
+    return left.pos_ < right.pos_ || (left.pos_ == right.pos_ && left.length_ < right.length_);
+}
+
+inline bool comparePositionAndLength(const knownIndels::Record &left, const knownIndels::Record &right)
+{
+    return left.pos_ == right.pos_ && left.length_ == right.length_;
+}
+
+inline bool orderByPosition(const knownIndels::Record &left, const reference::ReferencePosition::value_type right)
+{
+    return left.pos_ < right;
+}
+
+KnownIndels::KnownIndels() :
+    header_(0), contigs_(0), blockStarts_(0), recordsBegin_(0), recordsEnd_(0)
+{
+}
+
+KnownIndels::KnownIndels(
+    const bfs::path &path,
+    const reference::SortedReferenceMetadataList &sortedReferenceMetadataList,
+    const bfs::path &fallbackDirectory) :
+    header_(0), contigs_(0), blockStarts_(0), recordsBegin_(0), recordsEnd_(0)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    ISAAC_ASSERT_MSG(1 == sortedReferenceMetadataList.size(), "Multiple references are not supported");
+    const reference::SortedReferenceMetadata &sortedReferenceMetadata  = sortedReferenceMetadataList.front();
+    const uint64_t referenceFingerprint = getReferenceFingerprint(sortedReferenceMetadata);
+
+    bfs::path storePath = path;
+    if (!isStore(path))
+    {
+        storePath = path.string() + STORE_EXTENSION;
+        if (!isUpToDate(storePath, path, referenceFingerprint))
+        {
+            try
+            {
+                convert(path, sortedReferenceMetadata, storePath);
+            }
+            catch (const common::IoException &e)
+            {
+                storePath = fallbackDirectory / (path.filename().string() + STORE_EXTENSION);
+                ISAAC_THREAD_CERR << "WARNING: " << e.what() << ". Storing known indels in " << storePath << std::endl;
+                if (!isUpToDate(storePath, path, referenceFingerprint))
+                {
+                    convert(path, sortedReferenceMetadata, storePath);
+                }
+            }
+        }
+    }
+
+    map(storePath);
+    if (referenceFingerprint != header_->referenceFingerprint_)
+    {
+        BOOST_THROW_EXCEPTION(common::InvalidParameterException(
+            (boost::format("Known indels %s were stored for a different reference") % storePath.string()).str()));
+    }
+    ISAAC_THREAD_CERR << "Mapped " << size() << " known indels from " << storePath << std::endl;
+}
+
+uint64_t KnownIndels::getReferenceFingerprint(const reference::SortedReferenceMetadata &sortedReferenceMetadata)
+{
+    // FNV-1a
+    uint64_t ret = 0xcbf29ce484222325UL;
+    for (const reference::SortedReferenceMetadata::Contig &contig : sortedReferenceMetadata.getContigs())
+    {
+        for (const char c : contig.name_)
+        {
+            ret = (ret ^ uint64_t(c)) * 0x100000001b3UL;
+        }
+        ret = (ret ^ contig.index_) * 0x100000001b3UL;
+        ret = (ret ^ contig.totalBases_) * 0x100000001b3UL;
+    }
+    return ret;
+}
+
+bool KnownIndels::isStore(const bfs::path &path)
+{
+    char magic[sizeof(MAGIC)] = {0};
+    std::ifstream is(path.c_str(), std::ios_base::binary);
+    return is.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), MAGIC);
+}
+
+bool KnownIndels::isUpToDate(
+    const bfs::path &storePath,
+    const bfs::path &vcfPath,
+    const uint64_t referenceFingerprint)
+{
+    knownIndels::Header header;
+    std::ifstream is(storePath.c_str(), std::ios_base::binary);
+    if (!is.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        !std::equal(header.magic_, header.magic_ + sizeof(header.magic_), MAGIC) || VERSION != header.version_)
+    {
+        return false;
+    }
+
+    return referenceFingerprint == header.referenceFingerprint_ &&
+        bfs::file_size(vcfPath) == header.sourceSize_ &&
+        bfs::last_write_time(vcfPath) == header.sourceMtime_;
+}
+
+void KnownIndels::convert(
+    const bfs::path &vcfPath,
+    const reference::SortedReferenceMetadata &sortedReferenceMetadata,
+    const bfs::path &storePath)
+{
+    ISAAC_THREAD_CERR << "Converting known indels " << vcfPath << " into " << storePath << std::endl;
+
+    std::vector<knownIndels::Record> records;
+    {
+        const gapRealigner::Gaps gaps = loadIndels(vcfPath, sortedReferenceMetadata);
+        records.reserve(gaps.size());
+        for (const gapRealigner::Gap &gap : gaps)
+        {
+            const knownIndels::Record record = {gap.pos_.getValue(), gap.length_};
+            records.push_back(record);
+        }
+    }
+    std::sort(records.begin(), records.end(), orderByPositionAndLength);
+    records.erase(std::unique(records.begin(), records.end(), comparePositionAndLength), records.end());
+
+    const reference::SortedReferenceMetadata::Contigs &contigs = sortedReferenceMetadata.getContigs();
+    knownIndels::Header header;
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), header.magic_);
+    header.version_ = VERSION;
+    header.contigCount_ = contigs.size();
+    header.referenceFingerprint_ = getReferenceFingerprint(sortedReferenceMetadata);
+    header.sourceSize_ = bfs::file_size(vcfPath);
+    header.sourceMtime_ = bfs::last_write_time(vcfPath);
+    header.records_ = records.size();
+    header.maxDeletionLength_ = 0;
+    for (const knownIndels::Record &record : records)
+    {
+        header.maxDeletionLength_ = std::max<int64_t>(header.maxDeletionLength_, record.length_);
+    }
+
+    std::vector<knownIndels::ContigEntry> contigEntries(contigs.size());
+    std::vector<uint64_t> blockStarts;
+    for (const reference::SortedReferenceMetadata::Contig &contig : contigs)
+    {
+        knownIndels::ContigEntry &entry = contigEntries.at(contig.index_);
+        entry.firstBlock_ = blockStarts.size();
+        entry.blocks_ = (contig.totalBases_ >> BLOCK_BASES_BITS) + 1;
+        for (uint64_t block = 0; entry.blocks_ != block; ++block)
+        {
+            blockStarts.push_back(std::distance(records.begin(), std::lower_bound(
+                records.begin(), records.end(),
+                reference::ReferencePosition(contig.index_, block << BLOCK_BASES_BITS).getValue(), orderByPosition)));
+        }
+        entry.recordsEnd_ = std::distance(records.begin(), std::partition_point(
+            records.begin(), records.end(),
+            [&contig](const knownIndels::Record &record)
+            {
+                return reference::ReferencePosition(record.pos_).getContigId() <= contig.index_;
+            }));
+    }
+    header.blocks_ = blockStarts.size();
+
+    // write into a temporary file first so that an interrupted conversion does not leave a broken store behind.
+    // The name is unique so that concurrent runs converting the same vcf don't write into the same file.
+    const bfs::path tmpPath = storePath.string() + bfs::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp").string();
+    {
+        std::ofstream os(tmpPath.c_str(), std::ios_base::binary);
+        if (!os)
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to open for writing " + tmpPath.string()));
+        }
+        if (!os.write(reinterpret_cast<const char *>(&header), sizeof(header)) ||
+            !os.write(reinterpret_cast<const char *>(contigEntries.data()), sizeof(knownIndels::ContigEntry) * contigEntries.size()) ||
+            !os.write(reinterpret_cast<const char *>(blockStarts.data()), sizeof(uint64_t) * blockStarts.size()) ||
+            !os.write(reinterpret_cast<const char *>(records.data()), sizeof(knownIndels::Record) * records.size()) ||
+            !os.flush())
+        {
+            const int error = errno;
+            os.close();
+            boost::system::error_code ignored;
+            bfs::remove(tmpPath, ignored);
+            BOOST_THROW_EXCEPTION(common::IoException(error, "Failed to write " + tmpPath.string()));
+        }
+    }
+
+    // IoException, not filesystem_error, so that the caller falls back to another location
+    boost::system::error_code error;
+    bfs::rename(tmpPath, storePath, error);
+    if (error)
+    {
+        boost::system::error_code ignored;
+        bfs::remove(tmpPath, ignored);
+        BOOST_THROW_EXCEPTION(common::IoException(error.value(),
+            "Failed to rename " + tmpPath.string() + " to " + storePath.string() + ": " + error.message()));
+    }
+}
+
+void KnownIndels::map(const bfs::path &storePath)
+{
+    file_.open(storePath.string());
+    if (!file_.is_open() || sizeof(knownIndels::Header) > file_.size())
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(EINVAL, "Failed to map known indels " + storePath.string()));
+    }
+
+    header_ = reinterpret_cast<const knownIndels::Header *>(file_.data());
+    if (!std::equal(header_->magic_, header_->magic_ + sizeof(header_->magic_), MAGIC) || VERSION != header_->version_)
+    {
+        BOOST_THROW_EXCEPTION(common::UnsupportedVersionException(
+            (boost::format("Unsupported known indels store version %d in %s. Expected %d") %
+                header_->version_ % storePath.string() % VERSION).str()));
+    }
+
+    contigs_ = reinterpret_cast<const knownIndels::ContigEntry *>(header_ + 1);
+    blockStarts_ = reinterpret_cast<const uint64_t *>(contigs_ + header_->contigCount_);
+    recordsBegin_ = reinterpret_cast<const knownIndels::Record *>(blockStarts_ + header_->blocks_);
+    recordsEnd_ = recordsBegin_ + header_->records_;
+    if (file_.data() + file_.size() != reinterpret_cast<const char *>(recordsEnd_))
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(EINVAL, "Truncated or corrupt known indels " + storePath.string()));
+    }
+}
+
+const knownIndels::Record *KnownIndels::findFirst(const reference::ReferencePosition binStart) const
+{
+    if (recordsBegin_ == recordsEnd_)
+    {
+        return recordsEnd_;
+    }
+
+    const uint64_t contigId = binStart.getContigId();
+    if (header_->contigCount_ <= contigId)
+    {
+        // special positions such as the ones of the unaligned bin
+        return std::lower_bound(recordsBegin_, recordsEnd_, binStart.getValue(), orderByPosition);
+    }
+
+    // deletions that begin before the bin but end inside it
+    const reference::ReferencePosition searchStart(
+        contigId, binStart.getPosition() - std::min<uint64_t>(binStart.getPosition(), header_->maxDeletionLength_));
+    const knownIndels::ContigEntry &contig = contigs_[contigId];
+    const uint64_t block = std::min<uint64_t>(searchStart.getPosition() >> BLOCK_BASES_BITS, contig.blocks_ - 1);
+    const knownIndels::Record *blockBegin = recordsBegin_ + blockStarts_[contig.firstBlock_ + block];
+    const knownIndels::Record *blockEnd = recordsBegin_ +
+        (contig.blocks_ != block + 1 ? blockStarts_[contig.firstBlock_ + block + 1] : contig.recordsEnd_);
+    return std::lower_bound(blockBegin, blockEnd, searchStart.getValue(), orderByPosition);
+}
+
+} // namespace build
+} // namespace isaac
@@ -0,0 +1,300 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file ParallelBinSerializer.cpp
+ **
+ ** Serializes a single bin into bgzf-compressed bam data on multiple threads.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include "build/ParallelBinSerializer.hh"
+#include "common/Debug.hh"
+#include "common/Threads.hpp"
+#include "common/Trace.hh"
+
+namespace isaac
+{
+namespace build
+{
+
+void ParallelBinSerializer::CompressingSink::operator()(const char *block, const std::size_t size) const
+{
+    threadState_->compress(outputFile_, block, size);
+}
+
+ParallelBinSerializer::ThreadState::ThreadState(const unsigned outputFiles, const int bamGzipLevel) :
+    compressor_(bamGzipLevel)
+{
+    blockWriters_.reserve(outputFiles);
+    for (unsigned outputFile = 0; outputFiles != outputFile; ++outputFile)
+    {
+        blockWriters_.push_back(bam::BamBlockWriter<CompressingSink>(CompressingSink(*this, outputFile)));
+        blockWriters_.back().reserve();
+    }
+    compressed_.reserve(THREAD_COMPRESSED_RESERVE);
+    compressedRanges_.reserve(THREAD_COMPRESSED_RESERVE / bgzf::BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX + outputFiles);
+    indexRecords_.reserve(CHUNK_RECORDS);
+}
+
+template <typename AdapterT>
+void ParallelBinSerializer::ThreadState::write(const unsigned outputFile, AdapterT &adapter)
+{
+    const unsigned serializedLength = blockWriters_.at(outputFile).write(adapter);
+    const IndexRecord indexRecord =
+    {
+        outputFile, adapter.pos(), adapter.refId(), unsigned(adapter.seqLen()), unsigned(adapter.observedLength()),
+        adapter.unmapped(), serializedLength
+    };
+    indexRecords_.push_back(indexRecord);
+}
+
+void ParallelBinSerializer::ThreadState::compress(const unsigned outputFile, const char *block, const std::size_t size)
+{
+    const std::size_t before = compressed_.size();
+    compressor_.compress(block, size, compressed_);
+    if (!compressedRanges_.empty() && outputFile == compressedRanges_.back().outputFile_)
+    {
+        compressedRanges_.back().size_ += compressed_.size() - before;
+    }
+    else
+    {
+        const CompressedRange range = {outputFile, compressed_.size() - before};
+        compressedRanges_.push_back(range);
+    }
+}
+
+void ParallelBinSerializer::ThreadState::flush(const unsigned outputFile)
+{
+    blockWriters_.at(outputFile).flush();
+}
+
+void ParallelBinSerializer::ThreadState::store(
+    BgzfBuffers &bgzfBuffers,
+    boost::ptr_vector<bam::BamIndexPart> &bamIndexParts)
+{
+    const char *data = compressed_.data();
+    for (const CompressedRange &range : compressedRanges_)
+    {
+        bam::BgzfBuffer &bgzfBuffer = bgzfBuffers.at(range.outputFile_);
+        bgzfBuffer.insert(bgzfBuffer.end(), data, data + range.size_);
+        data += range.size_;
+    }
+
+    for (const IndexRecord &indexRecord : indexRecords_)
+    {
+        bamIndexParts.at(indexRecord.outputFile_).processFragment(
+            indexRecord.pos_, indexRecord.refId_, indexRecord.seqLen_, indexRecord.observedLength_,
+            indexRecord.unmapped_, indexRecord.serializedLength_);
+    }
+
+    compressed_.clear();
+    compressedRanges_.clear();
+    indexRecords_.clear();
+}
+
+ParallelBinSerializer::ParallelBinSerializer(
+    const unsigned threads,
+    const unsigned outputFiles,
+    const int bamGzipLevel,
+    const demultiplexing::BarcodePathMap::BarcodeSampleIndexMap &barcodeOutputFileIndexMap) :
+        barcodeOutputFileIndexMap_(barcodeOutputFileIndexMap)
+{
+    while (threadStates_.size() < threads)
+    {
+        threadStates_.push_back(new ThreadState(outputFiles, bamGzipLevel));
+    }
+}
+
+template <typename AdapterT>
+void ParallelBinSerializer::write(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    const unsigned outputFile,
+    AdapterT &adapter,
+    ThreadState &threadState)
+{
+    if (threadState.full())
+    {
+        storeChunkPart(lock, state, chunk, threadState);
+    }
+    threadState.write(outputFile, adapter);
+}
+
+void ParallelBinSerializer::flush(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    ThreadState &threadState)
+{
+    for (unsigned outputFile = 0; threadState.getOutputFiles() != outputFile; ++outputFile)
+    {
+        if (threadState.full())
+        {
+            storeChunkPart(lock, state, chunk, threadState);
+        }
+        threadState.flush(outputFile);
+    }
+}
+
+void ParallelBinSerializer::serializeChunk(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    const BinData::iterator begin,
+    const BinData::iterator end,
+    ThreadState &threadState)
+{
+    BinData &binData = state.binData_;
+    // the adapter keeps the current record state. Each thread needs its own
+    FragmentAccessorBamAdapter adapter(binData.bamAdapter_);
+    for (BinData::iterator it = begin; end != it; ++it)
+    {
+        const PackedFragmentBuffer::Index &idx = *it;
+        // realigning reads that don't belong to the bin is not very useful
+        // also, it can move the read position and cause more than one copy of the
+        // read to be stored in the bam file.
+        if (binData.bin_.hasPosition(idx.pos_))
+        {
+            const io::FragmentAccessor &fragment = binData.data_.getFragment(idx);
+            write(lock, state, chunk, barcodeOutputFileIndexMap_.at(fragment.barcode_), adapter(idx, fragment), threadState);
+        }
+        //else the fragment got split into a bit that does not belong to the current bin. it will get stored by another bin.
+    }
+    flush(lock, state, chunk, threadState);
+}
+
+void ParallelBinSerializer::serializeUnalignedChunk(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    uint64_t offset,
+    const uint64_t endOffset,
+    ThreadState &threadState)
+{
+    BinData &binData = state.binData_;
+    FragmentAccessorBamAdapter adapter(binData.bamAdapter_);
+    while (endOffset != offset)
+    {
+        const io::FragmentAccessor &fragment = binData.data_.getFragment(offset);
+        write(lock, state, chunk, barcodeOutputFileIndexMap_.at(fragment.barcode_), adapter(fragment), threadState);
+        offset += fragment.getTotalLength();
+    }
+    flush(lock, state, chunk, threadState);
+}
+
+void ParallelBinSerializer::waitForChunkTurn(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk)
+{
+    while (chunk != state.nextChunkToStore_)
+    {
+        if (state.failed_)
+        {
+            BOOST_THROW_EXCEPTION(common::ThreadingException("Terminating due to failures on other threads"));
+        }
+        chunkStoredCondition_.wait(lock);
+    }
+}
+
+void ParallelBinSerializer::storeChunkPart(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    ThreadState &threadState)
+{
+    {
+        // chunk serialization runs without the lock. Take it only to wait for the turn of the chunk
+        boost::lock_guard<boost::unique_lock<boost::mutex> > relock(lock);
+        waitForChunkTurn(lock, state, chunk);
+    }
+    // the chunk stays current until storeChunk, so the bin buffers are ours
+    threadState.store(state.bgzfBuffers_, state.bamIndexParts_);
+}
+
+void ParallelBinSerializer::storeChunk(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned chunk,
+    ThreadState &threadState)
+{
+    waitForChunkTurn(lock, state, chunk);
+
+    {
+        // nobody else touches the bin buffers until nextChunkToStore_ moves on
+        common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+        threadState.store(state.bgzfBuffers_, state.bamIndexParts_);
+    }
+    ++state.nextChunkToStore_;
+    chunkStoredCondition_.notify_all();
+}
+
+void ParallelBinSerializer::threadSerialize(
+    boost::unique_lock<boost::mutex> &lock,
+    BinState &state,
+    const unsigned threadNumber)
+{
+    ThreadState &threadState = threadStates_.at(threadNumber);
+    BinData &binData = state.binData_;
+
+    try
+    {
+        if (binData.isUnalignedBin())
+        {
+            while (binData.data_.size() != state.nextUnprocessedOffset_)
+            {
+                const uint64_t beginOffset = state.nextUnprocessedOffset_;
+                for (std::size_t records = 0;
+                    CHUNK_RECORDS != records && binData.data_.size() != state.nextUnprocessedOffset_; ++records)
+                {
+                    state.nextUnprocessedOffset_ += binData.data_.getFragment(state.nextUnprocessedOffset_).getTotalLength();
+                }
+                const uint64_t endOffset = state.nextUnprocessedOffset_;
+                const unsigned chunk = state.nextChunk_++;
+                {
+                    common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+                    ISAAC_TRACE_SPAN("serialize");
+                    serializeUnalignedChunk(lock, state, chunk, beginOffset, endOffset, threadState);
+                }
+                storeChunk(lock, state, chunk, threadState);
+            }
+        }
+        else
+        {
+            while (binData.indexEnd() != state.nextUnprocessed_)
+            {
+                const BinData::iterator begin = state.nextUnprocessed_;
+                state.nextUnprocessed_ += std::min<std::size_t>(
+                    CHUNK_RECORDS, std::distance(state.nextUnprocessed_, binData.indexEnd()));
+                const BinData::iterator end = state.nextUnprocessed_;
+                const unsigned chunk = state.nextChunk_++;
+                {
+                    common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+                    ISAAC_TRACE_SPAN("serialize");
+                    serializeChunk(lock, state, chunk, begin, end, threadState);
+                }
+                storeChunk(lock, state, chunk, threadState);
+            }
+        }
+    }
+    catch (...)
+    {
+        state.failed_ = true;
+        chunkStoredCondition_.notify_all();
+        throw;
+    }
+}
+
+} // namespace build
+} // namespace isaac
@@ -70,7 +70,9 @@ void ParallelGapRealigner::realign(
     }
 }
 
-void ParallelGapRealigner::threadRealignGaps(boost::unique_lock<boost::mutex> &lock, BinData &binData, BinData::iterator &nextUnprocessed, uint64_t threadNumber)
+void ParallelGapRealigner::threadRealignGaps(
+    boost::unique_lock<boost::mutex> &lock, BinData &binData, BinData::iterator &nextUnprocessed,
+    uint64_t threadNumber, BuildStats &buildStats)
 {
 //    ISAAC_THREAD_CERR << "threadRealignGaps this " << this  << std::endl;
 
@@ -84,6 +86,8 @@ void ParallelGapRealigner::threadRealignGaps(boost::unique_lock<boost::mutex> &l
         BinData::iterator ourBegin = nextUnprocessed;
         const std::size_t readsToProcess = std::min<std::size_t>(READS_AT_A_TIME, std::distance(ourBegin, binData.indexEnd()));
         nextUnprocessed += readsToProcess;
+        const uint64_t cacheHits = realigner.getCacheHits();
+        const uint64_t cacheMisses = realigner.getCacheMisses();
         {
             common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
             for (const BinData::iterator ourEnd = ourBegin + readsToProcess; ourEnd != ourBegin; ++ourBegin)
@@ -97,6 +101,9 @@ void ParallelGapRealigner::threadRealignGaps(boost::unique_lock<boost::mutex> &l
                 }
             }
         }
+        // lock is held again, safe to update the shared stats
+        buildStats.addRealignmentCacheStats(
+            realigner.getCacheHits() - cacheHits, realigner.getCacheMisses() - cacheMisses);
 //        ++blockCount;
     }
 
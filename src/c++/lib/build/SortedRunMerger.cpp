@@ -0,0 +1,377 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SortedRunMerger.cpp
+ **
+ ** Stores bgzf-compressed sorted runs on disk and merges them into coordinate-sorted bam.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <algorithm>
+
+#include <boost/format.hpp>
+
+#include "alignment/Cigar.hh"
+#include "bgzf/BgzfReader.hh"
+#include "build/SortedRunMerger.hh"
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+
+namespace isaac
+{
+namespace build
+{
+
+static void initInflate(z_stream &strm)
+{
+    memset(&strm, 0, sizeof(strm));
+    // bgzf blocks are parsed by hand, zlib gets only the raw deflate data
+    const int ret = inflateInit2(&strm, -MAX_WBITS);
+    if (Z_OK != ret)
+    {
+        BOOST_THROW_EXCEPTION(bgzf::BgzfInflateException(ret, strm));
+    }
+}
+
+SortedRunMerger::SortedRunMerger(
+    const boost::filesystem::path &directory,
+    const unsigned outputFiles,
+    const std::size_t maxRuns,
+    const bool unalignedFirst,
+    const int bamGzipLevel) :
+    directory_(directory),
+    unalignedFirst_(unalignedFirst),
+    bamGzipLevel_(bamGzipLevel)
+{
+    memset(&strm_, 0, sizeof(strm_));
+    if (isEnabled())
+    {
+        boost::filesystem::create_directories(directory_);
+        runs_.resize(outputFiles, Runs(maxRuns));
+        initInflate(strm_);
+    }
+}
+
+SortedRunMerger::~SortedRunMerger()
+{
+    if (strm_.state)
+    {
+        inflateEnd(&strm_);
+    }
+}
+
+uint64_t SortedRunMerger::getKey(const bam::BamBlockHeader &record) const
+{
+    // records without reference (refId -1) go either in front of or behind all the aligned ones
+    const uint32_t refRank = unalignedFirst_ ? uint32_t(record.getRefId() + 1) : uint32_t(record.getRefId());
+    return uint64_t(refRank) << 32 | uint32_t(record.getPos() + 1);
+}
+
+/**
+ * \brief Appends uncompressed content of the bgzf block to data
+ * \return size of the uncompressed content
+ */
+std::size_t SortedRunMerger::inflateBlock(z_stream &strm, const char *block, std::vector<char> &data)
+{
+    const bgzf::Header &header = *reinterpret_cast<const bgzf::Header*>(block);
+    if (31U != header.ID1 || 139U != header.ID2 || 66U != header.xfield.SI1 || 67U != header.xfield.SI2)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(EINVAL, "Invalid bgzf block header in sorted run"));
+    }
+    const bgzf::Footer &footer = *reinterpret_cast<const bgzf::Footer*>(
+        block + sizeof(bgzf::Header) + header.getCDATASize());
+    const std::size_t isize = footer.getISIZE();
+
+    const std::size_t before = data.size();
+    data.resize(before + isize);
+
+    inflateReset(&strm);
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char*>(block + sizeof(bgzf::Header)));
+    strm.avail_in = header.getCDATASize();
+    strm.next_out = reinterpret_cast<Bytef *>(data.data() + before);
+    strm.avail_out = isize;
+    const int err = inflate(&strm, Z_FINISH);
+    if (Z_STREAM_END != err || strm.avail_out)
+    {
+        BOOST_THROW_EXCEPTION(bgzf::BgzfInflateException(err, strm));
+    }
+    return isize;
+}
+
+void SortedRunMerger::storeRun(const unsigned outputFile, const std::size_t run, const bam::BgzfBuffer &bgzfBuffer)
+{
+    if (bgzfBuffer.empty())
+    {
+        return;
+    }
+
+    Run &ret = runs_.at(outputFile).at(run);
+    ret.path_ = directory_ / (boost::format("run-%d-%d.bgzf") % outputFile % run).str();
+    {
+        std::ofstream os(ret.path_.c_str(), std::ios_base::binary);
+        if (!os || !os.write(&bgzfBuffer.front(), bgzfBuffer.size()) || !os.flush())
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to store sorted run " + ret.path_.string()));
+        }
+    }
+
+    // the merge does not need to open the run until it reaches the first record
+    z_stream strm;
+    initInflate(strm);
+    std::vector<char> data;
+    try
+    {
+        inflateBlock(strm, &bgzfBuffer.front(), data);
+    }
+    catch(...)
+    {
+        inflateEnd(&strm);
+        throw;
+    }
+    inflateEnd(&strm);
+    ISAAC_ASSERT_MSG(sizeof(int32_t) * 3 <= data.size(), "First bgzf block of a run is too short to contain record position");
+    ret.firstKey_ = getKey(*reinterpret_cast<const bam::BamBlockHeader*>(&data.front()));
+}
+
+SortedRunMerger::RunReader::RunReader(const boost::filesystem::path &path, const std::size_t run) :
+    path_(path), run_(run), is_(path.c_str(), std::ios_base::binary), offset_(0), length_(0)
+{
+    if (!is_)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to open sorted run " + path_.string()));
+    }
+    compressed_.reserve(bgzf::BgzfBlockCompressor::BGZF_BLOCK_SIZE_MAX);
+    data_.reserve(bgzf::BgzfBlockCompressor::BGZF_BLOCK_SIZE_MAX * 2);
+}
+
+bool SortedRunMerger::RunReader::readBlock(z_stream &strm)
+{
+    data_.erase(data_.begin(), data_.begin() + offset_);
+    offset_ = 0;
+
+    compressed_.resize(sizeof(bgzf::Header));
+    if (!is_.read(&compressed_.front(), sizeof(bgzf::Header)))
+    {
+        if (is_.eof() && !is_.gcount())
+        {
+            return false;
+        }
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to read bgzf header from sorted run " + path_.string()));
+    }
+    const std::size_t rest = reinterpret_cast<const bgzf::Header&>(compressed_.front()).getCDATASize() + sizeof(bgzf::Footer);
+    compressed_.resize(sizeof(bgzf::Header) + rest);
+    if (!is_.read(&compressed_.front() + sizeof(bgzf::Header), rest))
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to read bgzf block from sorted run " + path_.string()));
+    }
+    inflateBlock(strm, &compressed_.front(), data_);
+    return true;
+}
+
+bool SortedRunMerger::RunReader::next(z_stream &strm)
+{
+    offset_ += length_;
+    length_ = 0;
+    while (true)
+    {
+        const std::size_t available = data_.size() - offset_;
+        // records can span bgzf blocks
+        if (sizeof(int32_t) <= available && recordLength() <= available)
+        {
+            length_ = recordLength();
+            return true;
+        }
+        if (!readBlock(strm))
+        {
+            if (data_.size() != offset_)
+            {
+                BOOST_THROW_EXCEPTION(common::IoException(EINVAL, "Truncated record at the end of sorted run " + path_.string()));
+            }
+            return false;
+        }
+    }
+}
+
+void SortedRunMerger::compressMergedThread(const unsigned threadNumber, const std::size_t sliceSize)
+{
+    const std::size_t begin = std::min(merged_.size(), threadNumber * sliceSize);
+    const std::size_t end = std::min(merged_.size(), begin + sliceSize);
+    if (begin != end)
+    {
+        compressors_.at(threadNumber).compress(&merged_.front() + begin, end - begin, threadCompressed_.at(threadNumber));
+    }
+}
+
+void SortedRunMerger::flushMerged(
+    common::ThreadVector &threads,
+    bam::BamIndexPart &bamIndexPart,
+    std::ostream &bamStream,
+    bam::BamIndex &bamIndex,
+    bam::BgzfBuffer &bgzfBuffer)
+{
+    // slice on block boundaries so that the concatenation has the same blocks as the single-threaded compression
+    static const std::size_t BLOCK = bgzf::BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX;
+    const std::size_t blocks = (merged_.size() + BLOCK - 1) / BLOCK;
+    const std::size_t sliceSize = (blocks + threads.size() - 1) / threads.size() * BLOCK;
+    threads.execute(boost::bind(&SortedRunMerger::compressMergedThread, this, _1, sliceSize));
+
+    std::size_t compressedSize = 0;
+    for (const std::vector<char> &compressed : threadCompressed_)
+    {
+        compressedSize += compressed.size();
+    }
+    bgzfBuffer.clear();
+    bgzfBuffer.reserve(compressedSize);
+    for (std::vector<char> &compressed : threadCompressed_)
+    {
+        bgzfBuffer.insert(bgzfBuffer.end(), compressed.begin(), compressed.end());
+        compressed.clear();
+    }
+
+    if (!bamStream.write(&bgzfBuffer.front(), bgzfBuffer.size()))
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(
+            errno, (boost::format("Failed to write bgzf block of %d bytes into bam stream") % bgzfBuffer.size()).str()));
+    }
+    bamIndex.processIndexPart(bamIndexPart, bgzfBuffer);
+
+    bamIndexPart = bam::BamIndexPart();
+    merged_.clear();
+}
+
+struct RunHead
+{
+    uint64_t key_;
+    std::size_t run_;
+    std::size_t reader_;
+};
+
+/**
+ * \brief std heap functions keep the largest element in front. The merge needs the smallest key of the lowest run
+ */
+inline bool headsAfter(const RunHead &left, const RunHead &right)
+{
+    return left.key_ > right.key_ || (left.key_ == right.key_ && left.run_ > right.run_);
+}
+
+void SortedRunMerger::merge(
+    const unsigned outputFile,
+    common::ThreadVector &threads,
+    std::ostream &bamStream,
+    bam::BamIndex &bamIndex)
+{
+    Runs &runs = runs_.at(outputFile);
+    std::vector<std::size_t> pending;
+    for (std::size_t run = 0; runs.size() != run; ++run)
+    {
+        if (!runs[run].path_.empty())
+        {
+            pending.push_back(run);
+        }
+    }
+    // runs are opened in the order in which the merge needs their first records
+    std::stable_sort(pending.begin(), pending.end(),
+                     [&runs](const std::size_t left, const std::size_t right)
+                     {
+                         return runs[left].firstKey_ < runs[right].firstKey_;
+                     });
+
+    ISAAC_THREAD_CERR << "Merging " << pending.size() << " sorted runs" << std::endl;
+
+    while (compressors_.size() < threads.size())
+    {
+        compressors_.push_back(new bgzf::BgzfBlockCompressor(bamGzipLevel_));
+    }
+    threadCompressed_.resize(threads.size());
+    const std::size_t mergedCapacity =
+        threads.size() * BLOCKS_PER_THREAD * bgzf::BgzfBlockCompressor::UNCOMPRESSED_PER_BLOCK_MAX;
+    merged_.reserve(mergedCapacity);
+
+    // readers of the runs that can still have records
+    std::vector<boost::shared_ptr<RunReader> > readers;
+    std::vector<RunHead> heads;
+    std::vector<std::size_t>::const_iterator nextPending = pending.begin();
+
+    bam::BamIndexPart bamIndexPart;
+    bam::BgzfBuffer bgzfBuffer;
+    int partRefId = 0;
+    while (true)
+    {
+        // open the runs which might have records that go before the smallest one available
+        while (pending.end() != nextPending && (heads.empty() || runs[*nextPending].firstKey_ <= heads.front().key_))
+        {
+            readers.push_back(boost::shared_ptr<RunReader>(new RunReader(runs[*nextPending].path_, *nextPending)));
+            if (readers.back()->next(strm_))
+            {
+                const RunHead head = {getKey(readers.back()->record()), *nextPending, readers.size() - 1};
+                heads.push_back(head);
+                std::push_heap(heads.begin(), heads.end(), &headsAfter);
+            }
+            ++nextPending;
+        }
+
+        if (heads.empty())
+        {
+            break;
+        }
+
+        std::pop_heap(heads.begin(), heads.end(), &headsAfter);
+        RunHead &head = heads.back();
+        RunReader &reader = *readers.at(head.reader_);
+        const bam::BamBlockHeader &record = reader.record();
+
+        // index part cannot span multiple references
+        if (!merged_.empty() && (partRefId != record.getRefId() || mergedCapacity <= merged_.size()))
+        {
+            flushMerged(threads, bamIndexPart, bamStream, bamIndex, bgzfBuffer);
+        }
+        partRefId = record.getRefId();
+
+        const std::size_t length = reader.recordLength();
+        bamIndexPart.processFragment(
+            record.getPos(), record.getRefId(), record.getLSeq(),
+            alignment::computeObservedLength(record.getCigar(), record.getCigar() + record.getCigarLength()),
+            record.isUnmapped(), length);
+        const char *recordBegin = reinterpret_cast<const char *>(&record);
+        merged_.insert(merged_.end(), recordBegin, recordBegin + length);
+
+        if (reader.next(strm_))
+        {
+            head.key_ = getKey(reader.record());
+            std::push_heap(heads.begin(), heads.end(), &headsAfter);
+        }
+        else
+        {
+            // close the file and release the buffers
+            readers.at(head.reader_).reset();
+            heads.pop_back();
+        }
+    }
+
+    if (!merged_.empty())
+    {
+        flushMerged(threads, bamIndexPart, bamStream, bamIndex, bgzfBuffer);
+    }
+
+    for (Run &run : runs)
+    {
+        if (!run.path_.empty())
+        {
+            boost::filesystem::remove(run.path_);
+            run.path_.clear();
+        }
+    }
+}
+
+} // namespace build
+} // namespace isaac
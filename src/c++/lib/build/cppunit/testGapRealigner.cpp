@@ -156,13 +156,15 @@ struct RealignResult
             originalPos_(fStrandPosition),
             originalCigar_(originalCigar),
             originalEditDistance_(editDistance),
-            realignedEditDistance_(0){}
+            realignedEditDistance_(0),
+            realignedCost_(0){}
     reference::ReferencePosition originalPos_;
     reference::ReferencePosition realignedPos_;
     std::string originalCigar_;
     std::string realignedCigar_;
     unsigned short originalEditDistance_;
     unsigned short realignedEditDistance_;
+    unsigned realignedCost_;
 };
 
 TestFragmentAccessor initFragment(
@@ -348,35 +350,41 @@ void addGaps(const std::string &ref, const std::string &gaps, RealignerGapsT &re
     }
 }
 
-RealignResult realign(
+/**
+ * \brief Cost the way the realigner compares the choices: mismatches and gap openings. Gap extension is free in
+ *        these tests.
+ */
+unsigned alignmentCost(
     const unsigned mismatchCost,
     const unsigned gapOpenCost,
-    const std::string &read,
-    const std::string &ref,
-    const build::gapRealigner::RealignerGaps &realignerGaps,
-    const io::FragmentHeader &init,
-    const reference::ReferencePosition binStartPos = reference::ReferencePosition(0, 0),
-    reference::ReferencePosition binEndPos = reference::ReferencePosition(reference::ReferencePosition::NoMatch))
+    const unsigned *cigarBegin,
+    const unsigned *cigarEnd,
+    const unsigned editDistance)
 {
-
-//    ISAAC_THREAD_CERR << "Initialized " <<
-    const TestFragmentAccessor fragment = initFragment(init, read, ref);
-//        oligo::bclToString(fragment.basesBegin(), fragment.basesEnd() - fragment.basesBegin()) << " " << fragment << std::endl;
-
-    std::string contig;
-    std::remove_copy_if(ref.begin(), ref.end(), std::back_inserter(contig),
-                        [](char c){return c == '*' || c == ' ';});
-
-    reference::ContigLists contigLists;
-    contigLists.push_back(TestContigList(contig));
-
-    if (binEndPos.isNoMatch())
+    unsigned gaps = 0;
+    unsigned gapBases = 0;
+    for (const unsigned *it = cigarBegin; cigarEnd != it; ++it)
     {
-        binEndPos = binStartPos + contigLists.at(0).at(0).size();
-        ISAAC_THREAD_CERR << "binEndPos:" << binEndPos << std::endl;
+        const alignment::Cigar::Component component = alignment::Cigar::decode(*it);
+        if (alignment::Cigar::INSERT == component.second || alignment::Cigar::DELETE == component.second)
+        {
+            ++gaps;
+            gapBases += component.first;
+        }
     }
+    return (editDistance - gapBases) * mismatchCost + gaps * gapOpenCost;
+}
 
-
+RealignResult realign(
+    const build::GapRealignerEngine engine,
+    const unsigned mismatchCost,
+    const unsigned gapOpenCost,
+    const TestFragmentAccessor &fragment,
+    const reference::ContigLists &contigLists,
+    const build::gapRealigner::RealignerGaps &realignerGaps,
+    const reference::ReferencePosition binStartPos,
+    const reference::ReferencePosition binEndPos)
+{
     isaac::flowcell::BarcodeMetadataList barcodeMetadataList(1);
     barcodeMetadataList.at(0).setUnknown();
     barcodeMetadataList.at(0).setIndex(0);
@@ -394,7 +402,7 @@ RealignResult realign(
     build::PackedFragmentBuffer dataBuffer;
     alignment::BinMetadata realBin(bin);
     realBin.incrementDataSize(isaac::reference::ReferencePosition(0,0), sizeof(fragment));
-    realBin.incrementCigarLength(isaac::reference::ReferencePosition(0,0), 1024, 0);
+    realBin.incrementCigarLength(isaac::reference::ReferencePosition(0,0), 1024, 0, 0);
     dataBuffer.resize(realBin);
     std::copy(fragment.begin(), fragment.end(), dataBuffer.begin());
 
@@ -404,16 +412,64 @@ RealignResult realign(
     const unsigned realignedGapsPerFragment = 8;
     alignment::Cigar realignedCigars; realignedCigars.reserve(1024);
     realignedCigars.reserve(realBin.getTotalCigarLength() + realBin.getTotalElements() * (1 + realignedGapsPerFragment * 2));
-    build::GapRealigner realigner(false, false, 4, mismatchCost, gapOpenCost, 0, false, barcodeMetadataList);
-    realigner.realign(realignerGaps, binStartPos, binEndPos, index, dataBuffer.getFragment(index), dataBuffer, realignedCigars, contigLists);
+    build::GapRealigner realigner(engine, false, false, false, 4, mismatchCost, gapOpenCost, 0, barcodeMetadataList);
+    reference::ReferencePosition newRStrandPosition = fragment.rStrandPosition_;
+    unsigned short newEditDistance = fragment.editDistance_;
+    realigner.realign(realignerGaps, binStartPos, binEndPos, dataBuffer.getFragment(index), index,
+                      newRStrandPosition, newEditDistance, dataBuffer, realignedCigars, contigLists);
 
     ret.realignedPos_ = index.pos_;
     ret.realignedCigar_ = alignment::Cigar::toString(index.cigarBegin_, index.cigarEnd_);
-    const io::FragmentAccessor &updatedFragment = dataBuffer.getFragment(index);
-// this is broken until updatePairDetails is called.
-//    CPPUNIT_ASSERT_EQUAL(updatedFragment.fStrandPosition_, index.pos_);
+    ret.realignedEditDistance_ = newEditDistance;
+    ret.realignedCost_ = alignmentCost(mismatchCost, gapOpenCost, index.cigarBegin_, index.cigarEnd_, newEditDistance);
 
-    ret.realignedEditDistance_ = updatedFragment.editDistance_;
+    return ret;
+}
+
+/**
+ * \brief Realigns with the combinatorial engine, whose results the tests check, and verifies that the graph
+ *        engine finds an equivalent or better alignment of the same fragment.
+ */
+RealignResult realign(
+    const unsigned mismatchCost,
+    const unsigned gapOpenCost,
+    const std::string &read,
+    const std::string &ref,
+    const build::gapRealigner::RealignerGaps &realignerGaps,
+    const io::FragmentHeader &init,
+    const reference::ReferencePosition binStartPos = reference::ReferencePosition(0, 0),
+    reference::ReferencePosition binEndPos = reference::ReferencePosition(reference::ReferencePosition::NoMatch))
+{
+
+//    ISAAC_THREAD_CERR << "Initialized " <<
+    const TestFragmentAccessor fragment = initFragment(init, read, ref);
+//        oligo::bclToString(fragment.basesBegin(), fragment.basesEnd() - fragment.basesBegin()) << " " << fragment << std::endl;
+
+    std::string contig;
+    std::remove_copy_if(ref.begin(), ref.end(), std::back_inserter(contig),
+                        [](char c){return c == '*' || c == ' ';});
+
+    reference::ContigLists contigLists;
+    contigLists.push_back(TestContigList(contig));
+
+    if (binEndPos.isNoMatch())
+    {
+        binEndPos = binStartPos + contigLists.at(0).at(0).size();
+        ISAAC_THREAD_CERR << "binEndPos:" << binEndPos << std::endl;
+    }
+
+    const RealignResult ret = realign(
+        build::REALIGN_ENGINE_COMBINATORIAL, mismatchCost, gapOpenCost, fragment, contigLists, realignerGaps, binStartPos, binEndPos);
+    const RealignResult graph = realign(
+        build::REALIGN_ENGINE_GRAPH, mismatchCost, gapOpenCost, fragment, contigLists, realignerGaps, binStartPos, binEndPos);
+
+    if (graph.realignedCigar_ != ret.realignedCigar_ || graph.realignedPos_ != ret.realignedPos_)
+    {
+        ISAAC_THREAD_CERR << "graph engine: " << graph.realignedPos_ << " " << graph.realignedCigar_ <<
+            " cost " << graph.realignedCost_ << ", combinatorial engine: " << ret.realignedPos_ << " " <<
+            ret.realignedCigar_ << " cost " << ret.realignedCost_ << std::endl;
+        CPPUNIT_ASSERT(graph.realignedCost_ <= ret.realignedCost_);
+    }
 
     return ret;
 }
@@ -0,0 +1,143 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <fstream>
+#include <vector>
+
+#include "build/KnownIndels.hh"
+#include "common/Exceptions.hh"
+
+using isaac::build::KnownIndels;
+using isaac::build::gapRealigner::Gap;
+using isaac::reference::ReferencePosition;
+
+#include "RegistryName.hh"
+#include "testKnownIndels.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestKnownIndels, registryName("TestKnownIndels"));
+
+void TestKnownIndels::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+
+    vcfPath_ = directory_ / "known.vcf";
+    std::ofstream os(vcfPath_.c_str());
+    os << "##fileformat=VCFv4.1\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n"
+        "chr1\t100\t.\tACGT\tA\t.\t.\t.\n"
+        // past the first block of chr1
+        "chr1\t2097200\t.\tA\tACG\t.\t.\t.\n"
+        "chr2\t50\t.\tAC\tA\t.\t.\t.\n"
+        // duplicate
+        "chr2\t50\t.\tAC\tA\t.\t.\t.\n"
+        "chrUnknown\t10\t.\tA\tAT\t.\t.\t.\n";
+    CPPUNIT_ASSERT(os.flush());
+
+    isaac::reference::SortedReferenceMetadata sortedReferenceMetadata;
+    sortedReferenceMetadata.putContig(
+        isaac::reference::SortedReferenceMetadata::Contig(
+            0, "chr1", false, directory_ / "genome.fa", 0, 0, 0, 3000000, 3000000, "", "", ""));
+    sortedReferenceMetadata.putContig(
+        isaac::reference::SortedReferenceMetadata::Contig(
+            1, "chr2", false, directory_ / "genome.fa", 0, 0, 3000000, 1000, 1000, "", "", ""));
+    sortedReferenceMetadataList_.assign(1, sortedReferenceMetadata);
+}
+
+void TestKnownIndels::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+static std::vector<Gap> getOverlapping(
+    const KnownIndels &knownIndels, const ReferencePosition binStart, const ReferencePosition binEnd)
+{
+    std::vector<Gap> ret;
+    knownIndels.forEachOverlapping(binStart, binEnd, [&ret](const Gap &gap){ret.push_back(gap);});
+    return ret;
+}
+
+void TestKnownIndels::testConvert()
+{
+    // vcf gets converted next to itself
+    {
+        const KnownIndels knownIndels(vcfPath_, sortedReferenceMetadataList_, directory_ / "fallback");
+        CPPUNIT_ASSERT_EQUAL(std::size_t(3), knownIndels.size());
+    }
+    const boost::filesystem::path storePath = vcfPath_.string() + ".isaac-indels";
+    CPPUNIT_ASSERT(KnownIndels::isStore(storePath));
+    CPPUNIT_ASSERT(!KnownIndels::isStore(vcfPath_));
+
+    // only the vcf and the store, no leftover temporary files
+    CPPUNIT_ASSERT_EQUAL(2L, std::distance(boost::filesystem::directory_iterator(directory_),
+                                           boost::filesystem::directory_iterator()));
+
+    // explicit conversion into another file maps the same records
+    const boost::filesystem::path otherPath = directory_ / "other.isaac-indels";
+    KnownIndels::convert(vcfPath_, sortedReferenceMetadataList_.front(), otherPath);
+    const KnownIndels knownIndels(otherPath, sortedReferenceMetadataList_, directory_ / "fallback");
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), knownIndels.size());
+
+    // converting into a directory that does not exist fails with IoException
+    CPPUNIT_ASSERT_THROW(
+        KnownIndels::convert(vcfPath_, sortedReferenceMetadataList_.front(), directory_ / "missing" / "store"),
+        isaac::common::IoException);
+}
+
+void TestKnownIndels::testIsUpToDate()
+{
+    const boost::filesystem::path storePath = directory_ / "known.isaac-indels";
+    const uint64_t fingerprint = KnownIndels::getReferenceFingerprint(sortedReferenceMetadataList_.front());
+    CPPUNIT_ASSERT(!KnownIndels::isUpToDate(storePath, vcfPath_, fingerprint));
+
+    KnownIndels::convert(vcfPath_, sortedReferenceMetadataList_.front(), storePath);
+    CPPUNIT_ASSERT(KnownIndels::isUpToDate(storePath, vcfPath_, fingerprint));
+    CPPUNIT_ASSERT(!KnownIndels::isUpToDate(storePath, vcfPath_, fingerprint + 1));
+
+    {
+        std::ofstream os(vcfPath_.c_str(), std::ios_base::app);
+        os << "chr2\t70\t.\tA\tAT\t.\t.\t.\n";
+    }
+    CPPUNIT_ASSERT(!KnownIndels::isUpToDate(storePath, vcfPath_, fingerprint));
+}
+
+void TestKnownIndels::testFindFirst()
+{
+    const boost::filesystem::path storePath = directory_ / "known.isaac-indels";
+    KnownIndels::convert(vcfPath_, sortedReferenceMetadataList_.front(), storePath);
+    const KnownIndels knownIndels(storePath, sortedReferenceMetadataList_, directory_);
+
+    // deletion at chr1:100 ends at 103
+    CPPUNIT_ASSERT(getOverlapping(knownIndels, ReferencePosition(0, 0), ReferencePosition(0, 100)).empty());
+    std::vector<Gap> gaps = getOverlapping(knownIndels, ReferencePosition(0, 0), ReferencePosition(0, 101));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), gaps.size());
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(0, 100), gaps.front().getBeginPos());
+    CPPUNIT_ASSERT_EQUAL(3, int(gaps.front().length_));
+
+    // deletion begins before the bin and ends inside it
+    gaps = getOverlapping(knownIndels, ReferencePosition(0, 102), ReferencePosition(0, 200));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), gaps.size());
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(0, 100), gaps.front().getBeginPos());
+    CPPUNIT_ASSERT(getOverlapping(knownIndels, ReferencePosition(0, 104), ReferencePosition(0, 2000000)).empty());
+
+    // insertion in the third block of chr1
+    gaps = getOverlapping(knownIndels, ReferencePosition(0, 2097152), ReferencePosition(1, 0));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), gaps.size());
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(0, 2097200), gaps.front().getBeginPos());
+    CPPUNIT_ASSERT_EQUAL(-2, int(gaps.front().length_));
+
+    // duplicate records are stored once
+    gaps = getOverlapping(knownIndels, ReferencePosition(1, 0), ReferencePosition(1, 1000));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), gaps.size());
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(1, 50), gaps.front().getBeginPos());
+}
@@ -0,0 +1,43 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BUILD_TEST_KNOWN_INDELS_HH
+#define iSAAC_BUILD_TEST_KNOWN_INDELS_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+#include "reference/SortedReferenceMetadata.hh"
+
+class TestKnownIndels : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestKnownIndels );
+    CPPUNIT_TEST( testConvert );
+    CPPUNIT_TEST( testIsUpToDate );
+    CPPUNIT_TEST( testFindFirst );
+    CPPUNIT_TEST_SUITE_END();
+
+    boost::filesystem::path directory_;
+    boost::filesystem::path vcfPath_;
+    isaac::reference::SortedReferenceMetadataList sortedReferenceMetadataList_;
+public:
+    void setUp();
+    void tearDown();
+
+    void testConvert();
+    void testIsUpToDate();
+    void testFindFirst();
+};
+
+#endif // #ifndef iSAAC_BUILD_TEST_KNOWN_INDELS_HH
@@ -0,0 +1,266 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "alignment/Cigar.hh"
+#include "build/BuildContigMap.hh"
+#include "build/ParallelBinSerializer.hh"
+#include "common/Threads.hpp"
+
+using isaac::reference::ReferencePosition;
+
+#include "RegistryName.hh"
+#include "testParallelBinSerializer.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestParallelBinSerializer, registryName("TestParallelBinSerializer"));
+
+void TestParallelBinSerializer::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+}
+
+void TestParallelBinSerializer::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+namespace
+{
+
+const unsigned READ_LENGTH = 300;
+// several chunks, each compressing into more than the per-thread buffer holds
+const unsigned RECORDS = 40000;
+const unsigned CONTIG_LENGTH = RECORDS * 10;
+
+isaac::flowcell::BarcodeMetadataList makeBarcodeMetadataList()
+{
+    isaac::flowcell::BarcodeMetadataList ret(1);
+    ret.at(0).setUnknown();
+    ret.at(0).setIndex(0);
+    ret.at(0).setReferenceIndex(0);
+    return ret;
+}
+
+isaac::reference::SortedReferenceMetadataList makeSortedReferenceMetadataList(const boost::filesystem::path &directory)
+{
+    isaac::reference::SortedReferenceMetadata sortedReferenceMetadata;
+    sortedReferenceMetadata.putContig(
+        isaac::reference::SortedReferenceMetadata::Contig(
+            0, "chr1", false, directory / "genome.fa", 0, 0, 0, CONTIG_LENGTH, CONTIG_LENGTH, "", "", ""));
+    return isaac::reference::SortedReferenceMetadataList(1, sortedReferenceMetadata);
+}
+
+/**
+ * \brief BinData filled with single-ended fragments of random bases and qualities along with everything it refers to
+ */
+struct TestBin
+{
+    const isaac::flowcell::BarcodeMetadataList barcodeMetadataList_;
+    const isaac::demultiplexing::BarcodePathMap barcodePathMap_;
+    const isaac::build::KnownIndels knownIndels_;
+    const isaac::flowcell::TileMetadataList tileMetadataList_;
+    const isaac::reference::SortedReferenceMetadataList sortedReferenceMetadataList_;
+    const isaac::build::BuildContigMap contigMap_;
+    const isaac::reference::ContigLists contigLists_;
+    const isaac::flowcell::FlowcellLayoutList flowcellLayoutList_;
+    isaac::alignment::BinMetadata binMetadata_;
+    boost::scoped_ptr<isaac::build::BinData> binData_;
+
+    TestBin(const boost::filesystem::path &directory, const bool unaligned) :
+        barcodeMetadataList_(makeBarcodeMetadataList()),
+        barcodePathMap_(
+            isaac::demultiplexing::BarcodePathMap::BarcodeProjectIndexMap(1, 0),
+            isaac::demultiplexing::BarcodePathMap::BarcodeSampleIndexMap(1, 0),
+            std::vector<boost::filesystem::path>(1, directory / "sample.bam")),
+        tileMetadataList_(std::vector<isaac::flowcell::TileMetadata>(
+            1, isaac::flowcell::TileMetadata("FC1", 0, 1101, 1, RECORDS, 0))),
+        sortedReferenceMetadataList_(makeSortedReferenceMetadataList(directory)),
+        contigMap_(barcodeMetadataList_, isaac::alignment::BinMetadataCRefList(), sortedReferenceMetadataList_, false),
+        binMetadata_(
+            barcodeMetadataList_.size(), 0,
+            unaligned ? ReferencePosition(ReferencePosition::TooManyMatch) : ReferencePosition(0, 0),
+            CONTIG_LENGTH, directory / "bin.dat")
+    {
+        const unsigned fragmentLength = isaac::io::FragmentAccessor::getTotalLength(
+            READ_LENGTH, sizeof(isaac::alignment::Cigar::value_type), 0);
+        binMetadata_.incrementDataSize(ReferencePosition(0, 0), uint64_t(fragmentLength) * RECORDS);
+        // BinData opens the bin file
+        std::ofstream(binMetadata_.getPathString().c_str());
+        binData_.reset(new isaac::build::BinData(
+            0, barcodePathMap_, barcodeMetadataList_, isaac::build::REALIGN_NONE, 0, knownIndels_, binMetadata_, 0,
+            tileMetadataList_, contigMap_, contigLists_, READ_LENGTH, 255, flowcellLayoutList_,
+            isaac::build::IncludeTags(true, false, true, false, true, true, false, false), false, 10000, 1));
+
+        isaac::build::BinData &binData = *binData_;
+        binData.data_.resize(binMetadata_.getDataSize());
+        binData.reserve(RECORDS);
+        isaac::alignment::Cigar cigar;
+        cigar.addOperation(READ_LENGTH, isaac::alignment::Cigar::ALIGN);
+        srand(1);
+        for (unsigned i = 0; RECORDS != i; ++i)
+        {
+            const uint64_t offset = uint64_t(fragmentLength) * i;
+            isaac::io::FragmentAccessor &fragment = binData.data_.getFragment(offset);
+            new (&fragment) isaac::io::FragmentHeader();
+            fragment.fStrandPosition_ =
+                unaligned ? ReferencePosition(ReferencePosition::NoMatch) : ReferencePosition(0, i * 10);
+            fragment.fStrandOriginalPosition_ = fragment.fStrandPosition_;
+            fragment.rStrandPosition_ =
+                unaligned ? fragment.fStrandPosition_ : fragment.fStrandPosition_ + READ_LENGTH - 1;
+            fragment.mateFStrandPosition_ = fragment.fStrandPosition_;
+            fragment.readLength_ = READ_LENGTH;
+            fragment.cigarLength_ = 1;
+            fragment.flags_ = isaac::io::FragmentHeader::Flags(
+                false, unaligned, unaligned, !unaligned && i % 2, false, false, false, false, false, false, false);
+            fragment.tile_ = 0;
+            fragment.barcode_ = 0;
+            fragment.clusterId_ = i;
+            fragment.mapQ_ = 60;
+            fragment.editDistance_ = i % 5;
+            fragment.alignmentScore_ = 100;
+            fragment.templateAlignmentScore_ = 100;
+            for (unsigned char *base = fragment.basesBegin(); fragment.basesEnd() != base; ++base)
+            {
+                *base = (2 + rand() % 40) << 2 | rand() % 4;
+            }
+            std::copy(cigar.begin(), cigar.end(), fragment.cigarBegin());
+            CPPUNIT_ASSERT_EQUAL(fragmentLength, fragment.getTotalLength());
+            if (!unaligned)
+            {
+                binData.push_back(isaac::build::PackedFragmentBuffer::Index(
+                    fragment.fStrandPosition_, offset, offset,
+                    fragment.cigarBegin(), fragment.cigarEnd(), fragment.isReverse()));
+            }
+        }
+    }
+};
+
+std::string decompress(const isaac::bam::BgzfBuffer &bgzf)
+{
+    std::string ret;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    CPPUNIT_ASSERT_EQUAL(Z_OK, inflateInit2(&strm, -MAX_WBITS));
+    std::size_t offset = 0;
+    while (bgzf.size() != offset)
+    {
+        const isaac::bgzf::Header &header = *reinterpret_cast<const isaac::bgzf::Header*>(&bgzf.at(offset));
+        const isaac::bgzf::Footer &footer = *reinterpret_cast<const isaac::bgzf::Footer*>(
+            &bgzf.at(offset + sizeof(header) + header.getCDATASize()));
+        std::vector<char> block(footer.getISIZE());
+        inflateReset(&strm);
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&bgzf.at(offset + sizeof(header))));
+        strm.avail_in = header.getCDATASize();
+        strm.next_out = reinterpret_cast<Bytef*>(block.data());
+        strm.avail_out = block.size();
+        CPPUNIT_ASSERT_EQUAL(Z_STREAM_END, inflate(&strm, Z_FINISH));
+        ret.append(block.begin(), block.end());
+        offset += sizeof(header) + header.getCDATASize() + sizeof(footer);
+    }
+    inflateEnd(&strm);
+    return ret;
+}
+
+unsigned countRecords(const std::string &records)
+{
+    unsigned ret = 0;
+    std::size_t offset = 0;
+    while (records.size() != offset)
+    {
+        int blockSize = 0;
+        CPPUNIT_ASSERT(records.size() >= offset + sizeof(blockSize));
+        memcpy(&blockSize, records.c_str() + offset, sizeof(blockSize));
+        offset += sizeof(blockSize) + blockSize;
+        CPPUNIT_ASSERT(records.size() >= offset);
+        ++ret;
+    }
+    return ret;
+}
+
+void serialize(
+    TestBin &testBin,
+    const unsigned threads,
+    std::string &records,
+    isaac::bam::BamIndexPart &bamIndexPart)
+{
+    isaac::build::ParallelBinSerializer serializer(
+        threads, 1, 1, testBin.barcodePathMap_.getSampleIndexMap());
+    isaac::build::ParallelBinSerializer::BgzfBuffers bgzfBuffers(1);
+    bgzfBuffers.front().reserve(testBin.binData_->data_.size() * 2);
+    boost::ptr_vector<isaac::bam::BamIndexPart> bamIndexParts;
+    bamIndexParts.push_back(new isaac::bam::BamIndexPart);
+    isaac::build::ParallelBinSerializer::BinState state(*testBin.binData_, bgzfBuffers, bamIndexParts);
+
+    boost::mutex mutex;
+    isaac::common::ThreadVector threadVector(threads);
+    threadVector.execute(
+        [&serializer, &state, &mutex](const unsigned threadNumber, const unsigned threadsTotal)
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            serializer.threadSerialize(lock, state, threadNumber);
+        });
+
+    records = decompress(bgzfBuffers.front());
+    bamIndexPart = bamIndexParts.front();
+}
+
+void checkSameAsSingleThreaded(TestBin &testBin)
+{
+    std::string expectedRecords;
+    isaac::bam::BamIndexPart expectedIndex;
+    serialize(testBin, 1, expectedRecords, expectedIndex);
+    CPPUNIT_ASSERT_EQUAL(RECORDS, countRecords(expectedRecords));
+
+    std::string actualRecords;
+    isaac::bam::BamIndexPart actualIndex;
+    serialize(testBin, 4, actualRecords, actualIndex);
+
+    CPPUNIT_ASSERT_EQUAL(expectedRecords.size(), actualRecords.size());
+    CPPUNIT_ASSERT(expectedRecords == actualRecords);
+
+    // unresolved offsets point into the uncompressed stream, so the index is the same if they are
+    CPPUNIT_ASSERT_EQUAL(expectedIndex.localUncompressedOffset_, actualIndex.localUncompressedOffset_);
+    CPPUNIT_ASSERT(expectedIndex.linearIndex_ == actualIndex.linearIndex_);
+    CPPUNIT_ASSERT_EQUAL(expectedIndex.chunks_.size(), actualIndex.chunks_.size());
+    for (std::size_t i = 0; expectedIndex.chunks_.size() != i; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(expectedIndex.chunks_[i].startPos, actualIndex.chunks_[i].startPos);
+        CPPUNIT_ASSERT_EQUAL(expectedIndex.chunks_[i].endPos, actualIndex.chunks_[i].endPos);
+        CPPUNIT_ASSERT_EQUAL(expectedIndex.chunks_[i].bin, actualIndex.chunks_[i].bin);
+        CPPUNIT_ASSERT_EQUAL(expectedIndex.chunks_[i].refId, actualIndex.chunks_[i].refId);
+    }
+    CPPUNIT_ASSERT_EQUAL(expectedIndex.bamStatsMapped_, actualIndex.bamStatsMapped_);
+    CPPUNIT_ASSERT_EQUAL(expectedIndex.bamStatsNmapped_, actualIndex.bamStatsNmapped_);
+}
+
+} // namespace
+
+void TestParallelBinSerializer::testAlignedBin()
+{
+    TestBin testBin(directory_, false);
+    checkSameAsSingleThreaded(testBin);
+}
+
+void TestParallelBinSerializer::testUnalignedBin()
+{
+    TestBin testBin(directory_, true);
+    checkSameAsSingleThreaded(testBin);
+}
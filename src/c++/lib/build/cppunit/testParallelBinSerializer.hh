@@ -0,0 +1,37 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BUILD_TEST_PARALLEL_BIN_SERIALIZER_HH
+#define iSAAC_BUILD_TEST_PARALLEL_BIN_SERIALIZER_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+class TestParallelBinSerializer : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestParallelBinSerializer );
+    CPPUNIT_TEST( testAlignedBin );
+    CPPUNIT_TEST( testUnalignedBin );
+    CPPUNIT_TEST_SUITE_END();
+
+    boost::filesystem::path directory_;
+public:
+    void setUp();
+    void tearDown();
+
+    void testAlignedBin();
+    void testUnalignedBin();
+};
+
+#endif // #ifndef iSAAC_BUILD_TEST_PARALLEL_BIN_SERIALIZER_HH
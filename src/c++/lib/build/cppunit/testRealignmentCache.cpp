@@ -0,0 +1,231 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <string>
+
+#include "alignment/Cigar.hh"
+#include "build/GapRealigner.hh"
+#include "build/gapRealigner/RealignmentCache.hh"
+
+using isaac::alignment::Cigar;
+using isaac::build::gapRealigner::RealignmentCache;
+using isaac::reference::ReferencePosition;
+
+#include "BuilderInit.hh"
+#include "RegistryName.hh"
+#include "testRealignmentCache.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestRealignmentCache, registryName("TestRealignmentCache"));
+
+void TestRealignmentCache::setUp()
+{
+}
+
+void TestRealignmentCache::tearDown()
+{
+}
+
+static uint64_t makeKey(const uint64_t value)
+{
+    RealignmentCache::KeyBuilder key;
+    key << value;
+    return key.get();
+}
+
+void TestRealignmentCache::testHitMiss()
+{
+    RealignmentCache cache(true);
+    cache.reserve();
+
+    Cigar cigar;
+    cigar.addOperation(10, Cigar::ALIGN);
+    cigar.addOperation(2, Cigar::DELETE);
+    cigar.addOperation(90, Cigar::ALIGN);
+
+    const ReferencePosition pos(0, 1000);
+    CPPUNIT_ASSERT(!cache.find(makeKey(1), pos));
+    cache.store(makeKey(1), pos, true, ReferencePosition(0, 1001), cigar.begin(), cigar.end(), ReferencePosition(0, 1102), 3);
+
+    const RealignmentCache::Entry *entry = cache.find(makeKey(1), pos);
+    CPPUNIT_ASSERT(entry);
+    CPPUNIT_ASSERT(entry->realigned_);
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(0, 1001), entry->newPos_);
+    CPPUNIT_ASSERT_EQUAL(ReferencePosition(0, 1102), entry->newRStrandPosition_);
+    CPPUNIT_ASSERT_EQUAL(3U, unsigned(entry->newEditDistance_));
+    CPPUNIT_ASSERT_EQUAL(std::string("10M2D90M"), Cigar::toString(entry->cigar_, entry->cigar_ + entry->cigarLength_));
+
+    // same key, different original position
+    CPPUNIT_ASSERT(!cache.find(makeKey(1), ReferencePosition(0, 1001)));
+    CPPUNIT_ASSERT(!cache.find(makeKey(2), pos));
+
+    CPPUNIT_ASSERT_EQUAL(1UL, cache.getHits());
+    CPPUNIT_ASSERT_EQUAL(3UL, cache.getMisses());
+}
+
+void TestRealignmentCache::testOverwrite()
+{
+    RealignmentCache cache(true);
+    cache.reserve();
+
+    Cigar cigar;
+    cigar.addOperation(100, Cigar::ALIGN);
+
+    // find a key that maps onto the same slot as the first one
+    const uint64_t first = makeKey(1);
+    uint64_t second = 2;
+    while (makeKey(second) % RealignmentCache::SLOTS != first % RealignmentCache::SLOTS)
+    {
+        ++second;
+    }
+    second = makeKey(second);
+
+    const ReferencePosition pos(1, 10);
+    cache.store(first, pos, true, pos, cigar.begin(), cigar.end(), pos + 99, 1);
+    cache.store(second, pos, false, pos, cigar.begin(), cigar.end(), pos, 0);
+
+    CPPUNIT_ASSERT(!cache.find(first, pos));
+    const RealignmentCache::Entry *entry = cache.find(second, pos);
+    CPPUNIT_ASSERT(entry);
+    CPPUNIT_ASSERT(!entry->realigned_);
+    CPPUNIT_ASSERT_EQUAL(0U, entry->cigarLength_);
+}
+
+void TestRealignmentCache::testLongCigar()
+{
+    RealignmentCache cache(true);
+    cache.reserve();
+
+    Cigar cigar;
+    for (unsigned i = 0; RealignmentCache::CIGAR_LENGTH_MAX / 2 + 1 != i; ++i)
+    {
+        cigar.addOperation(5, Cigar::ALIGN);
+        cigar.addOperation(1, Cigar::INSERT);
+    }
+
+    const ReferencePosition pos(0, 0);
+    cache.store(makeKey(1), pos, true, pos, cigar.begin(), cigar.end(), pos + 100, 10);
+    CPPUNIT_ASSERT(!cache.find(makeKey(1), pos));
+}
+
+namespace
+{
+
+/**
+ * \brief Single-end fragment aligned without gaps at the start of the reference
+ */
+struct UngappedFragment : public isaac::io::FragmentAccessor
+{
+    unsigned char buffer_[1000 + 100 * sizeof(unsigned)];
+    UngappedFragment(const std::string &read, const std::string &reference)
+    {
+        unsigned char *b = basesBegin();
+        BOOST_FOREACH(const char base, read)
+        {
+            *b++ = (0x03 & isaac::oligo::getValue(base)) | 0x20;
+            editDistance_ += reference.at(readLength_) != base;
+            ++readLength_;
+        }
+        Cigar cigar;
+        cigar.addOperation(readLength_, Cigar::ALIGN);
+        std::copy(cigar.begin(), cigar.end(), cigarBegin());
+        cigarLength_ = cigar.size();
+        fStrandPosition_ = ReferencePosition(0, 0);
+        rStrandPosition_ = fStrandPosition_ + readLength_ - 1;
+        mateFStrandPosition_ = fStrandPosition_;
+        alignmentScore_ = 1;
+        mapQ_ = 30;
+    }
+
+    const char *begin() const {return reinterpret_cast<const char *>(this);}
+    const char *end() const {return reinterpret_cast<const char *>(cigarEnd());}
+};
+
+struct RealignOutcome
+{
+    bool realigned_;
+    ReferencePosition pos_;
+    std::string cigar_;
+    ReferencePosition rStrandPosition_;
+    unsigned short editDistance_;
+};
+
+RealignOutcome realign(
+    isaac::build::GapRealigner &realigner,
+    const isaac::build::gapRealigner::RealignerGaps &realignerGaps,
+    const UngappedFragment &fragment,
+    const isaac::reference::ContigLists &contigLists)
+{
+    isaac::alignment::BinMetadata bin(1, 0, ReferencePosition(0, 0), 1000000, "tada");
+    bin.incrementDataSize(ReferencePosition(0, 0), sizeof(fragment));
+    bin.incrementCigarLength(ReferencePosition(0, 0), 1024, 0, 0);
+    isaac::build::PackedFragmentBuffer dataBuffer;
+    dataBuffer.resize(bin);
+    std::copy(fragment.begin(), fragment.end(), dataBuffer.begin());
+
+    isaac::build::PackedFragmentBuffer::Index index(
+        fragment.fStrandPosition_, 0, 0, fragment.cigarBegin(), fragment.cigarEnd(), fragment.isReverse());
+    Cigar realignedCigars;
+    realignedCigars.reserve(1024);
+
+    const ReferencePosition binEndPos(0, contigLists.at(0).at(0).size());
+    RealignOutcome ret;
+    ret.rStrandPosition_ = fragment.rStrandPosition_;
+    ret.editDistance_ = fragment.editDistance_;
+    ret.realigned_ = realigner.realign(
+        realignerGaps, ReferencePosition(0, 0), binEndPos, dataBuffer.getFragment(index), index,
+        ret.rStrandPosition_, ret.editDistance_, dataBuffer, realignedCigars, contigLists);
+    ret.pos_ = index.pos_;
+    ret.cigar_ = Cigar::toString(index.cigarBegin_, index.cigarEnd_);
+    return ret;
+}
+
+} // namespace
+
+void TestRealignmentCache::testRealignCacheHit()
+{
+    const std::string read =
+        "GACCTCAATCAGGCAATATGAAGTTGCAGGAACTGGAAGAGGAGAGATAGTTCAGGCTTATCTTGGCCATACCATTCTTCTCAAGAACCACTACTTCCTT";
+    const std::string reference =
+        "GACCTCAATCAGGCAATATGAAGTTGCAGGAACTGGAAGAGGAGAGATAGTTCAGGCTTATCTTGGCCATACCATTCTCAAGAACCACTACTTCCTTAAAAAAAA";
+
+    isaac::reference::ContigLists contigLists;
+    contigLists.push_back(TestContigList(reference));
+
+    isaac::flowcell::BarcodeMetadataList barcodeMetadataList(1);
+    barcodeMetadataList.at(0).setUnknown();
+    barcodeMetadataList.at(0).setIndex(0);
+    barcodeMetadataList.at(0).setReferenceIndex(0);
+
+    // 3-base insertion after the first 74 bases of the read
+    isaac::build::gapRealigner::RealignerGaps realignerGaps;
+    realignerGaps.addGap(isaac::build::gapRealigner::Gap(ReferencePosition(0, 74), -3));
+    realignerGaps.finalizeGaps();
+
+    const UngappedFragment fragment(read, reference);
+    isaac::build::GapRealigner realigner(
+        isaac::build::REALIGN_ENGINE_COMBINATORIAL, true, false, false, 4, 1, 0, 0, barcodeMetadataList);
+
+    const RealignOutcome computed = realign(realigner, realignerGaps, fragment, contigLists);
+    CPPUNIT_ASSERT_EQUAL(0UL, realigner.getCacheHits());
+    CPPUNIT_ASSERT_EQUAL(1UL, realigner.getCacheMisses());
+    CPPUNIT_ASSERT(computed.realigned_);
+    CPPUNIT_ASSERT_EQUAL(std::string("74M3I23M"), computed.cigar_);
+
+    const RealignOutcome cached = realign(realigner, realignerGaps, fragment, contigLists);
+    CPPUNIT_ASSERT_EQUAL(1UL, realigner.getCacheHits());
+    CPPUNIT_ASSERT_EQUAL(computed.realigned_, cached.realigned_);
+    CPPUNIT_ASSERT_EQUAL(computed.pos_, cached.pos_);
+    CPPUNIT_ASSERT_EQUAL(computed.cigar_, cached.cigar_);
+    CPPUNIT_ASSERT_EQUAL(computed.rStrandPosition_, cached.rStrandPosition_);
+    CPPUNIT_ASSERT_EQUAL(computed.editDistance_, cached.editDistance_);
+}
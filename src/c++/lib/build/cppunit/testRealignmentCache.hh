@@ -0,0 +1,38 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BUILD_TEST_REALIGNMENT_CACHE_HH
+#define iSAAC_BUILD_TEST_REALIGNMENT_CACHE_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class TestRealignmentCache : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestRealignmentCache );
+    CPPUNIT_TEST( testHitMiss );
+    CPPUNIT_TEST( testOverwrite );
+    CPPUNIT_TEST( testLongCigar );
+    CPPUNIT_TEST( testRealignCacheHit );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testHitMiss();
+    void testOverwrite();
+    void testLongCigar();
+    void testRealignCacheHit();
+};
+
+#endif // #ifndef iSAAC_BUILD_TEST_REALIGNMENT_CACHE_HH
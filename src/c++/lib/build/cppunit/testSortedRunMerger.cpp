@@ -0,0 +1,170 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <sstream>
+
+#include "build/SortedRunMerger.hh"
+
+using isaac::build::SortedRunMerger;
+
+#include "RegistryName.hh"
+#include "testSortedRunMerger.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestSortedRunMerger, registryName("TestSortedRunMerger"));
+
+void TestSortedRunMerger::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+}
+
+void TestSortedRunMerger::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+template <typename T>
+static void append(std::string &data, const T value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * \brief minimal bam record with no sequence and cigarOps operations 1M each
+ */
+static std::string makeRecord(const int refId, const int pos, const std::string &name, const unsigned cigarOps = 1)
+{
+    std::string ret;
+    append(ret, int(32 + name.length() + 1 + cigarOps * sizeof(unsigned)));
+    append(ret, refId);
+    append(ret, pos);
+    append(ret, unsigned(name.length() + 1));
+    append(ret, (-1 == refId ? 0x4U : 0U) << 16 | cigarOps);
+    append(ret, int(0));
+    append(ret, int(-1));
+    append(ret, int(-1));
+    append(ret, int(0));
+    ret.append(name.c_str(), name.length() + 1);
+    for (unsigned i = 0; cigarOps != i; ++i)
+    {
+        append(ret, 1U << 4);
+    }
+    return ret;
+}
+
+static isaac::bam::BgzfBuffer compress(const std::string &data)
+{
+    isaac::bgzf::BgzfBlockCompressor compressor(1);
+    std::vector<char> compressed;
+    compressor.compress(data.c_str(), data.size(), compressed);
+    isaac::bam::BgzfBuffer ret;
+    ret.reserve(compressed.size());
+    ret.insert(ret.end(), compressed.begin(), compressed.end());
+    return ret;
+}
+
+static std::string decompress(const std::string &bgzf)
+{
+    std::string ret;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    CPPUNIT_ASSERT_EQUAL(Z_OK, inflateInit2(&strm, -MAX_WBITS));
+    std::size_t offset = 0;
+    while (bgzf.size() != offset)
+    {
+        const isaac::bgzf::Header &header = *reinterpret_cast<const isaac::bgzf::Header*>(bgzf.c_str() + offset);
+        const isaac::bgzf::Footer &footer = *reinterpret_cast<const isaac::bgzf::Footer*>(
+            bgzf.c_str() + offset + sizeof(header) + header.getCDATASize());
+        std::vector<char> block(footer.getISIZE());
+        inflateReset(&strm);
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bgzf.c_str() + offset + sizeof(header)));
+        strm.avail_in = header.getCDATASize();
+        strm.next_out = reinterpret_cast<Bytef*>(block.data());
+        strm.avail_out = block.size();
+        CPPUNIT_ASSERT_EQUAL(Z_STREAM_END, inflate(&strm, Z_FINISH));
+        ret.append(block.begin(), block.end());
+        offset += sizeof(header) + header.getCDATASize() + sizeof(footer);
+    }
+    inflateEnd(&strm);
+    return ret;
+}
+
+static std::string merge(
+    const boost::filesystem::path &directory,
+    const bool unalignedFirst,
+    const std::vector<std::string> &runs)
+{
+    SortedRunMerger merger(directory / "runs", 1, runs.size(), unalignedFirst, 1);
+    for (std::size_t run = 0; runs.size() != run; ++run)
+    {
+        merger.storeRun(0, run, compress(runs[run]));
+    }
+
+    isaac::common::ThreadVector threads(3);
+    std::ostringstream os;
+    isaac::bam::BamIndex bamIndex(directory / "merged.bam", 2, 0);
+    merger.merge(0, threads, os, bamIndex);
+    bamIndex.flush();
+
+    CPPUNIT_ASSERT(boost::filesystem::is_empty(directory / "runs"));
+    return decompress(os.str());
+}
+
+void TestSortedRunMerger::testUnalignedFirst()
+{
+    std::vector<std::string> runs(4);
+    runs[0] = makeRecord(0, 10, "a") + makeRecord(0, 30, "c") + makeRecord(1, 5, "g");
+    runs[1] = makeRecord(0, 20, "b") + makeRecord(0, 30, "d") + makeRecord(1, 1, "f");
+    runs[2] = makeRecord(-1, -1, "x") + makeRecord(-1, -1, "y");
+    // empty runs don't get stored
+
+    const std::string expected =
+        makeRecord(-1, -1, "x") + makeRecord(-1, -1, "y") +
+        makeRecord(0, 10, "a") + makeRecord(0, 20, "b") +
+        // same position keeps the run order
+        makeRecord(0, 30, "c") + makeRecord(0, 30, "d") +
+        makeRecord(1, 1, "f") + makeRecord(1, 5, "g");
+    CPPUNIT_ASSERT(expected == merge(directory_, true, runs));
+}
+
+void TestSortedRunMerger::testUnalignedLast()
+{
+    std::vector<std::string> runs(3);
+    runs[0] = makeRecord(-1, -1, "x");
+    runs[1] = makeRecord(1, 1, "f");
+    runs[2] = makeRecord(0, 10, "a") + makeRecord(1, 5, "g");
+
+    const std::string expected =
+        makeRecord(0, 10, "a") + makeRecord(1, 1, "f") + makeRecord(1, 5, "g") + makeRecord(-1, -1, "x");
+    CPPUNIT_ASSERT(expected == merge(directory_, false, runs));
+}
+
+void TestSortedRunMerger::testRecordSpanningBlocks()
+{
+    std::vector<std::string> runs(2);
+    for (unsigned i = 0; 10000 != i; ++i)
+    {
+        runs[i % 2] += makeRecord(0, i, "r" + boost::lexical_cast<std::string>(i), 1 + i % 16);
+    }
+    // longer than a bgzf block
+    runs[1] += makeRecord(1, 0, "long", 20000);
+
+    std::string expected;
+    for (unsigned i = 0; 10000 != i; ++i)
+    {
+        expected += makeRecord(0, i, "r" + boost::lexical_cast<std::string>(i), 1 + i % 16);
+    }
+    expected += makeRecord(1, 0, "long", 20000);
+
+    CPPUNIT_ASSERT(expected == merge(directory_, true, runs));
+}
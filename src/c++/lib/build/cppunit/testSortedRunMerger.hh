@@ -0,0 +1,39 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_BUILD_TEST_SORTED_RUN_MERGER_HH
+#define iSAAC_BUILD_TEST_SORTED_RUN_MERGER_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+class TestSortedRunMerger : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestSortedRunMerger );
+    CPPUNIT_TEST( testUnalignedFirst );
+    CPPUNIT_TEST( testUnalignedLast );
+    CPPUNIT_TEST( testRecordSpanningBlocks );
+    CPPUNIT_TEST_SUITE_END();
+
+    boost::filesystem::path directory_;
+public:
+    void setUp();
+    void tearDown();
+
+    void testUnalignedFirst();
+    void testUnalignedLast();
+    void testRecordSpanningBlocks();
+};
+
+#endif // #ifndef iSAAC_BUILD_TEST_SORTED_RUN_MERGER_HH
@@ -0,0 +1,201 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file AsyncMD5Sum.cpp
+ **
+ ** \brief MD5 digest computed on a shared hashing thread.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include "common/AsyncMD5Sum.hh"
+#include "common/Threads.hpp"
+
+namespace isaac
+{
+namespace common
+{
+
+MD5HashingQueue::MD5HashingQueue(const std::size_t buffers, const std::size_t bufferSize) :
+    bufferSize_(bufferSize), memory_(buffers * bufferSize), hashing_(0), hashedBytes_(0), terminate_(false)
+{
+    free_.reserve(buffers);
+    for (std::size_t buffer = 0; buffers != buffer; ++buffer)
+    {
+        free_.push_back(&memory_.front() + buffer * bufferSize_);
+    }
+    jobs_.reserve(buffers);
+    thread_ = boost::thread(boost::bind(&MD5HashingQueue::hashThread, this));
+}
+
+MD5HashingQueue::~MD5HashingQueue()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        terminate_ = true;
+        stateChangedCondition_.notify_all();
+    }
+    thread_.join();
+}
+
+MD5HashingQueue &MD5HashingQueue::instance()
+{
+    static MD5HashingQueue queue(DEFAULT_BUFFERS, DEFAULT_BUFFER_SIZE);
+    return queue;
+}
+
+char *MD5HashingQueue::tryAcquire()
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    if (free_.empty())
+    {
+        return 0;
+    }
+    char *ret = free_.back();
+    free_.pop_back();
+    return ret;
+}
+
+void MD5HashingQueue::submit(MD5Sum &md5Sum, char *buffer, const std::size_t size)
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    const Job job = {&md5Sum, buffer, size};
+    jobs_.push_back(job);
+    stateChangedCondition_.notify_all();
+}
+
+std::size_t MD5HashingQueue::getHashedBytes()
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    return hashedBytes_;
+}
+
+bool MD5HashingQueue::isPending(const MD5Sum &md5Sum) const
+{
+    if (&md5Sum == hashing_)
+    {
+        return true;
+    }
+    for (const Job &job : jobs_)
+    {
+        if (&md5Sum == job.md5Sum_)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MD5HashingQueue::wait(const MD5Sum &md5Sum)
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (isPending(md5Sum))
+    {
+        stateChangedCondition_.wait(lock);
+    }
+}
+
+void MD5HashingQueue::hashThread()
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (true)
+    {
+        while (jobs_.empty() && !terminate_)
+        {
+            stateChangedCondition_.wait(lock);
+        }
+        if (jobs_.empty())
+        {
+            break;
+        }
+        const Job job = jobs_.front();
+        jobs_.erase(jobs_.begin());
+        hashing_ = job.md5Sum_;
+        {
+            // nobody touches the job buffer or the digest until hashing_ is reset
+            common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+            job.md5Sum_->update(job.buffer_, job.size_);
+        }
+        hashing_ = 0;
+        hashedBytes_ += job.size_;
+        free_.push_back(job.buffer_);
+        stateChangedCondition_.notify_all();
+    }
+}
+
+AsyncMD5Sum::AsyncMD5Sum(MD5HashingQueue &queue) :
+    queue_(queue), fill_(queue.getBufferSize()), fillSize_(0)
+{
+}
+
+AsyncMD5Sum::~AsyncMD5Sum()
+{
+    // the hashing thread must be done with md5Sum_
+    queue_.wait(md5Sum_);
+}
+
+void AsyncMD5Sum::flush()
+{
+    char *buffer = queue_.tryAcquire();
+    if (buffer)
+    {
+        std::memcpy(buffer, &fill_.front(), fillSize_);
+        queue_.submit(md5Sum_, buffer, fillSize_);
+    }
+    else
+    {
+        // all buffers are busy. Hash here once the data submitted earlier is done
+        queue_.wait(md5Sum_);
+        md5Sum_.update(&fill_.front(), fillSize_);
+    }
+    fillSize_ = 0;
+}
+
+void AsyncMD5Sum::update(const char* buffer, std::size_t bufferLength)
+{
+    while (bufferLength)
+    {
+        const std::size_t copy = std::min(bufferLength, fill_.size() - fillSize_);
+        std::memcpy(&fill_.front() + fillSize_, buffer, copy);
+        fillSize_ += copy;
+        buffer += copy;
+        bufferLength -= copy;
+        if (fill_.size() == fillSize_)
+        {
+            flush();
+        }
+    }
+}
+
+MD5Sum::Digest AsyncMD5Sum::getDigest()
+{
+    if (fillSize_)
+    {
+        flush();
+    }
+    queue_.wait(md5Sum_);
+    return md5Sum_.getDigest();
+}
+
+void AsyncMD5Sum::clear()
+{
+    fillSize_ = 0;
+    queue_.wait(md5Sum_);
+    md5Sum_.clear();
+}
+
+} // namespace common
+} // namespace isaac
@@ -19,8 +19,13 @@
 #include <stdio.h>
 
 #include <new>
+#include <fstream>
 #include <iostream>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif // #ifndef _WIN32
+
 #include <boost/format.hpp>
 #include <boost/thread.hpp>
 
@@ -124,6 +129,22 @@ int linuxFtruncate(int fd, std::size_t len)
     return 0;
 }
 
+int readAhead(const PathCharType *filePath, std::size_t offset, std::size_t len)
+{
+#ifdef HAVE_FCNTL_H
+    const int fd = open(filePath, O_RDONLY);
+    if (-1 == fd)
+    {
+        return -1;
+    }
+    const int ret = posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
+    close(fd);
+    return ret;
+#else // #ifdef HAVE_FCNTL_H
+    return 0;
+#endif // #ifdef HAVE_FCNTL_H
+}
+
 }//namespace common
 }//namespace isaac
 
@@ -207,6 +228,12 @@ boost::filesystem::path getModuleFileName()
 	return boost::filesystem::path(buffer);
 }
 
+ResourceUsage getResourceUsage()
+{
+	const ResourceUsage ret = {0, 0, 0};
+	return ret;
+}
+
 void configureMemoryManagement(const bool disableMultipleArenas, const bool disableFastbins)
 {
 }
@@ -391,6 +418,33 @@ boost::filesystem::path getModuleFileName()
     return boost::filesystem::path(szBuffer);
 }
 
+ResourceUsage getResourceUsage()
+{
+    ResourceUsage ret = {0, 0, 0};
+    struct rusage usage;
+    if (!getrusage(RUSAGE_SELF, &usage))
+    {
+        // ru_maxrss is in kilobytes on linux
+        ret.peakRss_ = uint64_t(usage.ru_maxrss) * 1024;
+    }
+
+    std::ifstream io("/proc/self/io");
+    std::string name;
+    uint64_t value = 0;
+    while (io >> name >> value)
+    {
+        if ("rchar:" == name)
+        {
+            ret.bytesRead_ = value;
+        }
+        else if ("wchar:" == name)
+        {
+            ret.bytesWritten_ = value;
+        }
+    }
+    return ret;
+}
+
 } // namespace common
 } // namespace isaac
 
@@ -0,0 +1,287 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file Trace.cpp
+ **
+ ** \brief See Trace.hh
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "common/SystemCompatibility.hh"
+#include "common/Trace.hh"
+
+namespace isaac
+{
+namespace common
+{
+namespace trace
+{
+
+#if ISAAC_PERFORMANCE_TRACE
+
+namespace
+{
+
+struct Event
+{
+    const char *name_;
+    uint64_t beginNs_;
+    // span duration or counter value
+    int64_t value_;
+    bool counter_;
+};
+
+// span totals survive the ring wrapping around so that the summary covers the whole run
+struct SpanTotals
+{
+    const char *name_;
+    uint64_t count_;
+    int64_t total_;
+    int64_t max_;
+};
+
+// power of two to make the ring index a mask
+static const unsigned EVENTS_PER_THREAD = 1 << 13;
+// power of two to make the hash a mask
+static const unsigned SPAN_NAMES_PER_THREAD = 1 << 6;
+static const unsigned THREADS_MAX = 256;
+
+struct ThreadRing
+{
+    std::atomic<uint64_t> recorded_;
+    Event events_[EVENTS_PER_THREAD];
+    SpanTotals spans_[SPAN_NAMES_PER_THREAD];
+};
+
+// allocated by start() so that untraced runs don't carry the rings. Recording must work inside malloc-blocked regions.
+std::atomic<ThreadRing *> rings(0);
+std::atomic<unsigned> ringsInUse(0);
+std::atomic<uint64_t> eventsDropped(0);
+const uint64_t traceStartNs = nowNs();
+
+iSAAC_THREAD_LOCAL int threadRing = -1;
+
+inline ThreadRing *getThreadRing()
+{
+    ThreadRing * const allRings = rings.load(std::memory_order_acquire);
+    if (!allRings)
+    {
+        return 0;
+    }
+    if (-1 == threadRing)
+    {
+        const unsigned ring = ringsInUse.fetch_add(1);
+        threadRing = THREADS_MAX > ring ? ring : THREADS_MAX;
+    }
+    if (THREADS_MAX == unsigned(threadRing))
+    {
+        eventsDropped.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    return allRings + threadRing;
+}
+
+inline void record(ThreadRing &ring, const Event &event)
+{
+    const uint64_t recorded = ring.recorded_.load(std::memory_order_relaxed);
+    if (EVENTS_PER_THREAD <= recorded)
+    {
+        // the oldest event of the thread gets overwritten
+        eventsDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    ring.events_[recorded & (EVENTS_PER_THREAD - 1)] = event;
+    ring.recorded_.store(recorded + 1, std::memory_order_release);
+}
+
+/**
+ * \brief open addressing on the name pointer. Names are string literals, so the pointer identifies the name
+ *        within the binary. The summary merges same names that have different pointers.
+ */
+inline void addSpan(ThreadRing &ring, const char *name, const int64_t duration)
+{
+    for (unsigned i = 0, slot = (uintptr_t(name) >> 3) & (SPAN_NAMES_PER_THREAD - 1);
+        SPAN_NAMES_PER_THREAD != i; ++i, slot = (slot + 1) & (SPAN_NAMES_PER_THREAD - 1))
+    {
+        SpanTotals &totals = ring.spans_[slot];
+        if (!totals.name_)
+        {
+            totals.name_ = name;
+        }
+        if (name == totals.name_)
+        {
+            ++totals.count_;
+            totals.total_ += duration;
+            totals.max_ = std::max(totals.max_, duration);
+            return;
+        }
+    }
+    // too many different names on one thread
+    eventsDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline unsigned getRingsUsed(const ThreadRing *allRings)
+{
+    return allRings ? std::min<unsigned>(THREADS_MAX, ringsInUse.load()) : 0;
+}
+
+template <typename CallbackT>
+void forEachEvent(CallbackT callback)
+{
+    const ThreadRing * const allRings = rings.load(std::memory_order_acquire);
+    const unsigned ringsUsed = getRingsUsed(allRings);
+    for (unsigned ring = 0; ringsUsed != ring; ++ring)
+    {
+        const uint64_t recorded = allRings[ring].recorded_.load(std::memory_order_acquire);
+        for (uint64_t i = recorded - std::min<uint64_t>(recorded, EVENTS_PER_THREAD); recorded != i; ++i)
+        {
+            callback(ring, allRings[ring].events_[i & (EVENTS_PER_THREAD - 1)]);
+        }
+    }
+}
+
+} // anonymous namespace
+
+void recordSpan(const char *name, const uint64_t beginNs, const uint64_t endNs)
+{
+    ThreadRing *ring = getThreadRing();
+    if (ring)
+    {
+        const Event event = {name, beginNs, int64_t(endNs - beginNs), false};
+        record(*ring, event);
+        addSpan(*ring, name, event.value_);
+    }
+}
+
+void recordCounter(const char *name, const int64_t value)
+{
+    ThreadRing *ring = getThreadRing();
+    if (ring)
+    {
+        const Event event = {name, nowNs(), value, true};
+        record(*ring, event);
+    }
+}
+
+bool enabled()
+{
+    return true;
+}
+
+void start()
+{
+    if (!rings.load())
+    {
+        // value-initialized so that recorded_ counters start at 0
+        rings.store(new ThreadRing[THREADS_MAX](), std::memory_order_release);
+    }
+}
+
+void dumpChromeTrace(std::ostream &os)
+{
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    forEachEvent(
+        [&os, &first](const unsigned ring, const Event &event)
+        {
+            const double tsUs = double(event.beginNs_ - traceStartNs) / 1000.0;
+            os << (first ? "\n" : ",\n");
+            first = false;
+            if (event.counter_)
+            {
+                os << boost::format("{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"tid\":%d,\"args\":{\"value\":%d}}") %
+                    event.name_ % tsUs % ring % event.value_;
+            }
+            else
+            {
+                os << boost::format("{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}") %
+                    event.name_ % tsUs % (double(event.value_) / 1000.0) % ring;
+            }
+        });
+    os << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"eventsDropped\":" << eventsDropped.load() << "}}" << std::endl;
+}
+
+void dumpSummary(std::ostream &os)
+{
+    struct Totals
+    {
+        uint64_t count_;
+        int64_t total_;
+        int64_t max_;
+    };
+    std::map<std::string, Totals> spans;
+    const ThreadRing * const allRings = rings.load(std::memory_order_acquire);
+    const unsigned ringsUsed = getRingsUsed(allRings);
+    for (unsigned ring = 0; ringsUsed != ring; ++ring)
+    {
+        for (const SpanTotals &threadTotals : allRings[ring].spans_)
+        {
+            if (threadTotals.name_)
+            {
+                Totals &totals = spans.insert(std::make_pair(std::string(threadTotals.name_), Totals{0, 0, 0})).first->second;
+                totals.count_ += threadTotals.count_;
+                totals.total_ += threadTotals.total_;
+                totals.max_ = std::max(totals.max_, threadTotals.max_);
+            }
+        }
+    }
+
+    for (const std::pair<const std::string, Totals> &span : spans)
+    {
+        os << boost::format("%-16s count:%-8d total:%10.1fms max:%10.1fms\n") %
+            span.first % span.second.count_ % (double(span.second.total_) / 1000000.0) %
+            (double(span.second.max_) / 1000000.0);
+    }
+    os << "events dropped from the trace: " << eventsDropped.load() << "\n";
+}
+
+#else //ISAAC_PERFORMANCE_TRACE
+
+void recordSpan(const char *, const uint64_t, const uint64_t)
+{
+}
+
+void recordCounter(const char *, const int64_t)
+{
+}
+
+bool enabled()
+{
+    return false;
+}
+
+void start()
+{
+}
+
+void dumpChromeTrace(std::ostream &os)
+{
+    os << "{\"traceEvents\":[]}" << std::endl;
+}
+
+void dumpSummary(std::ostream &)
+{
+}
+
+#endif //ISAAC_PERFORMANCE_TRACE
+
+} // namespace trace
+} // namespace common
+} // namespace isaac
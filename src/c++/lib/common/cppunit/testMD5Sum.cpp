@@ -14,7 +14,9 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
+#include <boost/ptr_container/ptr_vector.hpp>
 
 #include "RegistryName.hh"
 #include "testMD5Sum.hh"
@@ -56,3 +58,80 @@ void TestMD5Sum::testMD5Digest()
     // more tests here
 }
 
+
+void TestMD5Sum::testAsyncMD5Digest()
+{
+    // small buffers to get the data spread over many hand-overs
+    isaac::common::MD5HashingQueue queue(2, 1000);
+    isaac::common::AsyncMD5Sum async(queue);
+    async.update("Hello World\n", 12);
+    CPPUNIT_ASSERT_EQUAL( string("e59ff97941044f85df5297e1c302d260"), async.getHexStringDigest() );
+
+    async.clear();
+    std::string input;
+    for (unsigned i = 0; 100000 != i; ++i)
+    {
+        input.push_back(char(i * 7 + i / 13));
+    }
+    // uneven pieces to cross the buffer boundaries at various offsets
+    for (std::size_t offset = 0, piece = 1; input.size() != offset; piece = piece * 3 % 4093 + 1)
+    {
+        const std::size_t size = std::min(piece, input.size() - offset);
+        async.update(input.c_str() + offset, size);
+        offset += size;
+    }
+    CPPUNIT_ASSERT_EQUAL(calcMd5Sum(input), async.getHexStringDigest());
+    // digest does not stop the accumulation
+    async.update("A", 1);
+    CPPUNIT_ASSERT_EQUAL(calcMd5Sum(input + "A"), async.getHexStringDigest());
+}
+
+void TestMD5Sum::testSharedMD5Queue()
+{
+    // fewer buffers than digests, so some of the data gets hashed on the caller thread
+    isaac::common::MD5HashingQueue queue(1, 1000);
+    std::vector<std::string> inputs(3);
+    boost::ptr_vector<isaac::common::AsyncMD5Sum> asyncs;
+    for (std::size_t i = 0; inputs.size() != i; ++i)
+    {
+        asyncs.push_back(new isaac::common::AsyncMD5Sum(queue));
+    }
+
+    for (unsigned piece = 0; 200 != piece; ++piece)
+    {
+        for (std::size_t i = 0; inputs.size() != i; ++i)
+        {
+            const std::string data(1 + (piece * 37 + i * 11) % 700, char(piece + i));
+            inputs[i] += data;
+            asyncs[i].update(data.c_str(), data.size());
+        }
+    }
+
+    for (std::size_t i = 0; inputs.size() != i; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(calcMd5Sum(inputs[i]), asyncs[i].getHexStringDigest());
+    }
+}
+
+void TestMD5Sum::testQuietOutputs()
+{
+    // more outputs than buffers. The quiet ones must not keep the busy one from using the hashing thread
+    isaac::common::MD5HashingQueue queue(2, 1000);
+    boost::ptr_vector<isaac::common::AsyncMD5Sum> quiet;
+    for (std::size_t i = 0; 4 != i; ++i)
+    {
+        quiet.push_back(new isaac::common::AsyncMD5Sum(queue));
+        quiet.back().update("Hello World\n", 12);
+    }
+
+    isaac::common::AsyncMD5Sum busy(queue);
+    const std::string input(queue.getBufferSize(), 'A');
+    busy.update(input.c_str(), input.size());
+    CPPUNIT_ASSERT_EQUAL(calcMd5Sum(input), busy.getHexStringDigest());
+    CPPUNIT_ASSERT_EQUAL(input.size(), queue.getHashedBytes());
+
+    for (isaac::common::AsyncMD5Sum &async : quiet)
+    {
+        CPPUNIT_ASSERT_EQUAL(string("e59ff97941044f85df5297e1c302d260"), async.getHexStringDigest());
+    }
+}
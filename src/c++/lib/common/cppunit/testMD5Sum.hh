@@ -15,17 +15,24 @@
 #define iSAAC_COMMON_TEST_MD5_HH
 
 #include <cppunit/extensions/HelperMacros.h>
+#include "common/AsyncMD5Sum.hh"
 #include "common/MD5Sum.hh"
 
 class TestMD5Sum : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( TestMD5Sum );
     CPPUNIT_TEST( testMD5Digest );
+    CPPUNIT_TEST( testAsyncMD5Digest );
+    CPPUNIT_TEST( testSharedMD5Queue );
+    CPPUNIT_TEST( testQuietOutputs );
     CPPUNIT_TEST_SUITE_END();
 public:
     void setUp();
     void tearDown();
     void testMD5Digest();
+    void testAsyncMD5Digest();
+    void testSharedMD5Queue();
+    void testQuietOutputs();
 };
 
 #endif // #ifndef iSAAC_COMMON_TEST_MD5_HH
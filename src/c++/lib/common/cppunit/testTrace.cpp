@@ -0,0 +1,77 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <sstream>
+#include <string>
+
+#include "RegistryName.hh"
+#include "testTrace.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestTrace, registryName("Trace"));
+
+void TestTrace::setUp()
+{
+}
+
+void TestTrace::tearDown()
+{
+}
+
+void TestTrace::testChromeTrace()
+{
+    isaac::common::trace::start();
+    {
+        ISAAC_TRACE_SPAN("testSpan");
+        ISAAC_TRACE_COUNTER("testCounter", 42);
+    }
+
+    std::ostringstream trace;
+    isaac::common::trace::dumpChromeTrace(trace);
+    const std::string json = trace.str();
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"traceEvents\":["), json.substr(0, 16));
+
+    std::ostringstream summary;
+    isaac::common::trace::dumpSummary(summary);
+
+    if (isaac::common::trace::enabled())
+    {
+        CPPUNIT_ASSERT(std::string::npos != json.find("{\"name\":\"testSpan\",\"ph\":\"X\""));
+        CPPUNIT_ASSERT(std::string::npos != json.find("\"args\":{\"value\":42}"));
+        CPPUNIT_ASSERT_EQUAL(std::string("testSpan"), summary.str().substr(0, 8));
+    }
+    else
+    {
+        CPPUNIT_ASSERT_EQUAL(std::string("{\"traceEvents\":[]}\n"), json);
+        CPPUNIT_ASSERT(summary.str().empty());
+    }
+}
+
+void TestTrace::testSummaryAfterWrap()
+{
+    isaac::common::trace::start();
+    // well over the ring capacity
+    static const unsigned SPANS = 100000;
+    for (unsigned i = 0; SPANS != i; ++i)
+    {
+        isaac::common::trace::recordSpan("wrapSpan", 0, 1000000);
+    }
+
+    std::ostringstream summary;
+    isaac::common::trace::dumpSummary(summary);
+
+    if (isaac::common::trace::enabled())
+    {
+        CPPUNIT_ASSERT(std::string::npos != summary.str().find("wrapSpan         count:100000   total:  100000.0ms max:       1.0ms"));
+        CPPUNIT_ASSERT(std::string::npos == summary.str().find("events dropped from the trace: 0\n"));
+    }
+}
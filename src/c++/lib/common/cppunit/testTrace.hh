@@ -0,0 +1,33 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_COMMON_TEST_TRACE_HH
+#define iSAAC_COMMON_TEST_TRACE_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "common/Trace.hh"
+
+class TestTrace : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestTrace );
+    CPPUNIT_TEST( testChromeTrace );
+    CPPUNIT_TEST( testSummaryAfterWrap );
+    CPPUNIT_TEST_SUITE_END();
+public:
+    void setUp();
+    void tearDown();
+    void testChromeTrace();
+    void testSummaryAfterWrap();
+};
+
+#endif // #ifndef iSAAC_COMMON_TEST_TRACE_HH
@@ -112,13 +112,21 @@ void MD5Open(MD5Context *md5)
   }
 
 
+/* LITTLE_ENDIAN is not defined by the headers included here. Where <endian.h> defines it, it is only the name of
+   a byte order, not the host one. Ask the compiler instead. */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MD5_LITTLE_ENDIAN_HOST 1
+#else
+#define MD5_LITTLE_ENDIAN_HOST 0
+#endif
+
 /* MD5 basic transformation. Transforms state based on block. */
 
 static void MD5Transform(UINT4 state[4], const unsigned char block[64])
 {
   UINT4 a = state[0], b = state[1], c = state[2], d = state[3], x[16];
   /* Move contents of block to x, putting bytes in little-endian order. */
-  #ifdef LITTLE_ENDIAN
+  #if MD5_LITTLE_ENDIAN_HOST
     memcpy(x, block, 64);
   #else
   {
@@ -202,8 +210,7 @@ static void MD5Transform(UINT4 state[4], const unsigned char block[64])
   state[1] += b;
   state[2] += c;
   state[3] += d;
-  /* Zeroize sensitive information. */
-  memset(x, 0, sizeof(x));
+  /* Not zeroizing x here. The digests are checksums, not secrets, and it costs a store per block. */
 }
 
 void MD5Digest(MD5Context *md5, const void *input, unsigned int inputLen)
@@ -238,8 +245,8 @@ void MD5Digest(MD5Context *md5, const void *input, unsigned int inputLen)
    order.
 */
 
-#ifdef LITTLE_ENDIAN
-#define ENCODE(p,n) *(UINT4 *)(p) = n
+#if MD5_LITTLE_ENDIAN_HOST
+#define ENCODE(p,n) do {const UINT4 v = (n); memcpy((p), &v, 4);} while(0)
 #else
 #define ENCODE(p,n) (p)[0]=n,(p)[1]=n>>8,(p)[2]=n>>16,(p)[3]=n>>24
 #endif
@@ -47,6 +47,19 @@ Layout::Layout(const boost::filesystem::path &baseCallsDirectory,
 {
 }
 
+bool Layout::isVariableReadLength() const
+{
+    switch (format_)
+    {
+    case Fastq:
+        return boost::get<FastqFlowcellData>(formatSpecificData_).allowVariableLength_;
+    case Bam:
+        return boost::get<BamFlowcellData>(formatSpecificData_).allowVariableLength_;
+    default:
+        return false;
+    }
+}
+
 
 } // namespace flowcell
 } // namespace isaac
@@ -33,7 +33,9 @@
 #include <boost/algorithm/string/regex.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include "alignment/HashMatchFinder.hh"
 #include "common/Exceptions.hh"
+#include "common/Trace.hh"
 #include "demultiplexing/SampleSheetCsv.hh"
 #include "oligo/Mask.hh"
 #include "options/AlignOptions.hh"
@@ -91,6 +93,9 @@ AlignOptions::AlignOptions()
 #endif //ISAAC_DEV_STATS_ENABLED
     , barcodeMismatchesStringList(1, "1")
     , hashTableBucketCount(0)
+    , canonicalKmerHash(false)
+    , kmerFingerprints(false)
+    , seedMinimizerWindow(0)
     , referenceName("default")
     , tempDirectoryString("./Temp")
     , outputDirectoryString("./Aligned")
@@ -137,12 +142,16 @@ AlignOptions::AlignOptions()
     , preAllocateBins(false) //off by default as on genomes with large number of tiny contigs (such as hg38) it happens to consume terabytes of temp disk space
     , putUnalignedInTheBack(false)
     , realignGapsVigorously(false)
+    , realignEngineString("combinatorial")
+    , realignEngine(build::REALIGN_ENGINE_COMBINATORIAL)
+    , realignmentCache(true)
     , realignDodgyFragments(false) // true slows down pile-ups on DNA but seems to clear up picture significantly in RNA
     , realignedGapsPerFragment(4)
     , clipSemialigned(false) // Note that GATK jumps to 9000 conflict from 5000 if clipSemialigned is off
     , clipOverlapping(true)
     , scatterRepeats(true)
     , rescueShadows(true)
+    , bitParallelShadowRescue(false)
     , trimPEAdapters(true)
     , gappedMismatchesMax(5)
     , smitWatermanGapsMax(realignedGapsPerFragment)
@@ -180,6 +189,7 @@ AlignOptions::AlignOptions()
     , bamGzipLevel(boost::iostreams::gzip::best_speed)
     , bamPuFormat("%F:%L:%B")
     , bamProduceMd5(true)
+    , bamMergeRuns(false)
     , expectedBgzfCompressionRatio(1)
     , singleLibrarySamples(true)
     , keepDuplicates(true)
@@ -272,13 +282,19 @@ AlignOptions::AlignOptions()
         ("realign-mapq-min"     , bpo::value<unsigned>(&realignMapqMin)->default_value(realignMapqMin),
                 "Gaps from alignments with lower MAPQ will not be used as candidates for gap realignment")
         ("known-indels"           , bpo::value<std::string>(&knownIndelsPathString),
-                "path to a VCF file containing known indels fore realignment.")
+                "path to a VCF file containing known indels fore realignment. The file can be gzip or bgzip compressed. "
+                "On first use the indels are converted into <path>.isaac-indels which is then memory-mapped by the "
+                "subsequent runs. The .isaac-indels file can also be supplied directly.")
         ("bam-gzip-level"           , bpo::value<int>(&bamGzipLevel)->default_value(bamGzipLevel),
                 "Gzip level to use for BAM")
         ("bam-header-tag"           , bpo::value<std::vector<std::string> >(&bamHeaderTags)->multitoken(),
                 "Additional bam entries that are copied into the header of each produced bam file. Use '\\t' to represent tab separators.")
         ("bam-produce-md5"     , bpo::value<bool>(&bamProduceMd5)->default_value(bamProduceMd5),
                 "Controls whether a separate file containing md5 checksum is produced for each output bam.")
+        ("bam-merge-runs"     , bpo::value<bool>(&bamMergeRuns)->default_value(bamMergeRuns),
+                "If set, each bin is stored in the temporary directory as a sorted run as soon as it is processed and "
+                "the runs are merged into the bam files at the end. This frees the bin memory without waiting for "
+                "the preceding bins to be saved at the expense of writing the compressed data twice.")
         ("bam-pu-format"           , bpo::value<std::string>(&bamPuFormat)->default_value(bamPuFormat),
                 "Template string for bam header RG tag PU field. Ordinary characters are directly copied. The following placeholders are supported:"
                 "\n  - %F             : Flowcell ID"
@@ -401,7 +417,20 @@ AlignOptions::AlignOptions()
         ("hash-table-buckets"         , bpo::value<uint64_t>(&hashTableBucketCount)->default_value(hashTableBucketCount),
                 "Number of buckets to use for reference hash table. Larger number of buckets requires more RAM but it tends "
                 "to speed up the execution and improve sensitivity. "
-                "Value of 0 indicates default bucket count: 2^({seed-length}*2)")
+                "Value of 0 indicates default bucket count: 2^({seed-length}*2), or 2^({seed-length}*2-1) "
+                "with --canonical-kmer-hash")
+        ("canonical-kmer-hash"        , bpo::value<bool>(&canonicalKmerHash)->default_value(canonicalKmerHash),
+                "Store each reference k-mer together with its reverse complement so that a single hash table lookup "
+                "finds seed matches on both strands.")
+        ("kmer-fingerprints"          , bpo::value<bool>(&kmerFingerprints)->default_value(kmerFingerprints),
+                "Store a one-byte fingerprint of the k-mer with each hash table position so that positions of k-mers "
+                "colliding in the same bucket are not reported as seed matches. Costs one byte per reference position "
+                "and allows for smaller --hash-table-buckets without loss of precision.")
+        ("seed-minimizer-window"      , bpo::value<unsigned>(&seedMinimizerWindow)->default_value(seedMinimizerWindow),
+                "When greater than 1, reads of 250 bases or longer are seeded only at the minimizers of each window of "
+                "that many consecutive k-mers instead of at every non-overlapping k-mer. Reduces the number of hash "
+                "table probes for long reads. Must leave at least 3 non-overlapping seeds in each of those reads: "
+                "(read length - seed length + 1) / 3 - seed length at most. 0 disables.")
 
         ("mapq-threshold"           , bpo::value<int>(&mapqThreshold)->default_value(mapqThreshold),
                 "If any fragment alignment in template is below the threshold, template is not stored in the BAM.")
@@ -420,6 +449,9 @@ AlignOptions::AlignOptions()
                 "When set, extra care will be taken to scatter pairs aligning to repeats across the repeat locations ")
         ("rescue-shadows"                  , bpo::value<bool>(&rescueShadows)->default_value(rescueShadows),
                 "Scan within dominant template range off an orphan, for a possible shadow alignment")
+        ("shadow-rescue-bit-parallel"      , bpo::value<bool>(&bitParallelShadowRescue)->default_value(bitParallelShadowRescue),
+                "Find shadow rescue candidates with a bit-parallel approximate matcher allowing up to --gapped-mismatches "
+                "edits instead of exact k-mer matches. Rescues shadows that have no error-free k-mer")
         ("trim-pe"                  , bpo::value<bool>(&trimPEAdapters)->default_value(trimPEAdapters),
                 "Trim overhanging ends of PE alignments")
         ("base-quality-cutoff"     , bpo::value<unsigned>(&baseQualityCutoff)->default_value(baseQualityCutoff),
@@ -507,6 +539,15 @@ AlignOptions::AlignOptions()
         ("realign-vigorously"         , bpo::value<bool>(&realignGapsVigorously)->default_value(realignGapsVigorously),
                 "If set, the realignment result will be used to search for more gaps and attempt another realignment, "
                 "effectively extending the realignment over multiple deletions not covered by the original alignment.")
+        ("realign-engine"         , bpo::value<std::string>(&realignEngineString)->default_value(realignEngineString),
+                "Search strategy used to place the candidate gaps into a fragment:"
+                "\n  - combinatorial   : try every combination of up to realigned-gaps-per-fragment of the 8 highest "
+                "priority candidate gaps"
+                "\n  - graph           : align the fragment to the graph of the reference and all candidate gaps. "
+                "Cost grows polynomially with the number of candidate gaps and realigned-gaps-per-fragment")
+        ("realign-cache"         , bpo::value<bool>(&realignmentCache)->default_value(realignmentCache),
+                "If set, fragments that have the same position, CIGAR, bases and candidate gaps as a fragment realigned "
+                "earlier in the same bin reuse its realignment instead of computing it again. Unset to validate the cache.")
         ("realign-dodgy"         , bpo::value<bool>(&realignDodgyFragments)->default_value(realignDodgyFragments),
                 "If not set, the reads without alignment score are not realigned against gaps found in other reads.")
         ("realigned-gaps-per-fragment"         , bpo::value<unsigned>(&realignedGapsPerFragment)->default_value(realignedGapsPerFragment),
@@ -547,6 +588,9 @@ AlignOptions::AlignOptions()
                 "Limits major memory consumption operations to a set number of gigabytes. "
                 "0 means no limit, however 0 is not allowed as in such case Isaac will most likely consume "
                 "all the memory on the system and cause it to crash. Default value is taken from ulimit -v.")
+        ("trace-file"               , bpo::value<std::string>(&traceFileString),
+                "Write the timings of the pipeline stages into the file in Chrome trace event format and log the "
+                "per-stage summary at the end of the run. Requires a build configured with -DISAAC_PERFORMANCE_TRACE=1")
         ("cluster,c"                , bpo::value<std::vector<std::size_t> >(&clusterIdList)->multitoken(),
                 "Restrict the alignment to the specified cluster Id (multiple entries allowed)")
         ("tls"                      , bpo::value<std::string>(&tlsString),
@@ -701,6 +745,20 @@ build::GapRealignerMode AlignOptions::parseGapRealignment()
     return build::REALIGN_NONE;
 }
 
+build::GapRealignerEngine AlignOptions::parseGapRealignerEngine()
+{
+    if (realignEngineString == "graph")
+    {
+        return build::REALIGN_ENGINE_GRAPH;
+    }
+    else if (realignEngineString != "combinatorial")
+    {
+        const format message = format("\n   *** The 'realign-engine' value is invalid %s ***\n") % realignEngineString;
+        BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
+    }
+    return build::REALIGN_ENGINE_COMBINATORIAL;
+}
+
 void AlignOptions::parseExecutionTargets()
 {
     const static std::vector<std::string> allowedStageStrings =
@@ -1224,6 +1282,11 @@ void AlignOptions::postProcess(bpo::variables_map &vm)
     }
 
     knownIndelsPath = knownIndelsPathString;
+    traceFile = traceFileString;
+    if (!traceFile.empty() && !common::trace::enabled())
+    {
+        ISAAC_THREAD_CERR << "WARNING: --trace-file will contain no events. Stage tracing is not compiled in" << std::endl;
+    }
 
     processLegacyOptions(vm);
     parseParallelization();
@@ -1381,6 +1444,7 @@ void AlignOptions::postProcess(bpo::variables_map &vm)
     }
 
     realignGaps = parseGapRealignment();
+    realignEngine = parseGapRealignerEngine();
     std::for_each(bamHeaderTags.begin(), bamHeaderTags.end(), unescapeSlashT);
     validateSampleSheets(realignGaps, barcodeMetadataList);
 
@@ -1395,13 +1459,40 @@ void AlignOptions::postProcess(bpo::variables_map &vm)
     parseQScoreBinValues();
     parseBamExcludeTags();
     parseHashTableBuckets();
+    parseSeedMinimizerWindow();
 }
 
 void AlignOptions::parseHashTableBuckets()
 {
     if (!hashTableBucketCount)
     {
-        hashTableBucketCount = std::size_t(1) << (seedLength * 2);
+        // kmer and its reverse complement share the bucket in canonical mode
+        hashTableBucketCount = std::size_t(1) << (seedLength * 2 - canonicalKmerHash);
+    }
+}
+
+void AlignOptions::parseSeedMinimizerWindow()
+{
+    if (1 >= seedMinimizerWindow)
+    {
+        return;
+    }
+    BOOST_FOREACH(const flowcell::Layout &flowcell, flowcellLayoutList)
+    {
+        BOOST_FOREACH(const flowcell::ReadMetadata &readMetadata, flowcell.getReadMetadataList())
+        {
+            // a window wider than that leaves too few seeds to match the read
+            const unsigned windowMax = alignment::getMinimizerWindowMax(seedLength, readMetadata.getLength());
+            if (alignment::MINIMIZER_READ_LENGTH_MIN <= readMetadata.getLength() && windowMax < seedMinimizerWindow)
+            {
+                const boost::format message = boost::format(
+                    "\n   *** --seed-minimizer-window %d is too wide for %d-base read %d of %s. "
+                    "The maximum is %d for --seed-length %d. ***\n") %
+                    seedMinimizerWindow % readMetadata.getLength() % readMetadata.getNumber() % flowcell %
+                    windowMax % seedLength;
+                BOOST_THROW_EXCEPTION(common::InvalidOptionException(message.str()));
+            }
+        }
     }
 }
 
@@ -0,0 +1,137 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BenchmarkOptions.cpp
+ **
+ ** Command line options for 'isaac-bench'
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+#include "options/BenchmarkOptions.hh"
+#include "workflow/BenchmarkWorkflow.hh"
+
+namespace isaac
+{
+namespace options
+{
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+using common::InvalidOptionException;
+using boost::format;
+
+BenchmarkOptions::BenchmarkOptions()
+    : kernelsString_(boost::join(workflow::BenchmarkWorkflow::getKernelNames(), ","))
+    , referenceLength_(4000000)
+    , readLength_(150)
+    , reads_(100000)
+    , repeats_(3)
+    , jobs_(1)
+    , seed_(1)
+    , tempDirectoryString_(bfs::temp_directory_path().string())
+    , outputString_("-")
+{
+    namedOptions_.add_options()
+        ("kernels"                  , bpo::value<std::string>(&kernelsString_)->default_value(kernelsString_),
+                "Comma-separated list of kernels to time."
+            )
+        ("reference-length"         , bpo::value<uint64_t>(&referenceLength_)->default_value(referenceLength_),
+                "Length of the synthetic reference in bases."
+            )
+        ("read-length"              , bpo::value<unsigned>(&readLength_)->default_value(readLength_),
+                "Length of the synthetic reads."
+            )
+        ("reads"                    , bpo::value<unsigned>(&reads_)->default_value(reads_),
+                "Number of synthetic reads each thread processes per repetition."
+            )
+        ("repeats"                  , bpo::value<unsigned>(&repeats_)->default_value(repeats_),
+                "Number of times each kernel is timed. The fastest repetition is reported."
+            )
+        ("jobs,j"                   , bpo::value<unsigned>(&jobs_)->default_value(jobs_),
+                "Number of threads running each kernel concurrently. Every thread processes the full input, so "
+                "the per-core throughput of a single thread can be compared with that of a loaded machine."
+            )
+        ("seed"                     , bpo::value<unsigned>(&seed_)->default_value(seed_),
+                "Seed for the synthetic data generator. Same seed produces the same input."
+            )
+        ("temp-directory,t"         , bpo::value<std::string>(&tempDirectoryString_)->default_value(tempDirectoryString_),
+                "Directory where the fastq input of the fastq parsing kernel is stored."
+            )
+        ("output,o"                 , bpo::value<std::string>(&outputString_)->default_value(outputString_),
+                "File to store the JSON results. '-' for standard output."
+            )
+        ;
+}
+
+void BenchmarkOptions::postProcess(bpo::variables_map &vm)
+{
+    if(vm.count("help") ||  vm.count("version"))
+    {
+        return;
+    }
+
+    const std::vector<std::string> &knownKernels = workflow::BenchmarkWorkflow::getKernelNames();
+    boost::split(kernels_, kernelsString_, boost::is_any_of(","), boost::token_compress_on);
+    kernels_.erase(std::remove(kernels_.begin(), kernels_.end(), std::string()), kernels_.end());
+    for (const std::string &kernel : kernels_)
+    {
+        if (knownKernels.end() == std::find(knownKernels.begin(), knownKernels.end(), kernel))
+        {
+            const format message = format("\n   *** Unknown kernel '%s'. Known kernels are: %s ***\n") %
+                kernel % boost::join(knownKernels, ",");
+            BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
+        }
+    }
+    if (kernels_.empty())
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** At least one kernel is required for --kernels ***\n"));
+    }
+
+    if (!jobs_ || !repeats_ || !reads_)
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** --jobs, --repeats and --reads must be greater than 0 ***\n"));
+    }
+
+    if (!readLength_ || ISAAC_READ_LENGTH_MAX < readLength_)
+    {
+        const format message = format("\n   *** --read-length must be between 1 and %d ***\n") % ISAAC_READ_LENGTH_MAX;
+        BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
+    }
+
+    const uint64_t referenceLengthMin = workflow::BenchmarkWorkflow::getReferenceLengthMin(readLength_);
+    if (referenceLength_ < referenceLengthMin || ISAAC_GENOME_OFFSET_MAX < referenceLength_)
+    {
+        const format message = format("\n   *** --reference-length must be between %d and %d for --read-length %d ***\n") %
+            referenceLengthMin % ISAAC_GENOME_OFFSET_MAX % readLength_;
+        BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
+    }
+
+    tempDirectory_ = bfs::absolute(tempDirectoryString_);
+    if (!bfs::exists(tempDirectory_))
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException(
+            (format("\n   *** Temporary directory does not exist: %s ***\n") % tempDirectory_.string()).str()));
+    }
+}
+
+} //namespace options
+} // namespace isaac
@@ -21,6 +21,7 @@
 #include <vector>
 #include <boost/assign.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 
 #include "options/PrintContigsOptions.hh"
 
@@ -31,7 +32,8 @@ namespace options
 
 namespace bpo = boost::program_options;
 
-PrintContigsOptions::PrintContigsOptions()
+PrintContigsOptions::PrintContigsOptions() :
+    jobs(boost::thread::hardware_concurrency())
 {
     namedOptions_.add_options()
         ("original-metadata"       , bpo::value<boost::filesystem::path>(&originalMetadataPath),
@@ -39,6 +41,8 @@ PrintContigsOptions::PrintContigsOptions()
             )
         ("genome-file,g",       bpo::value<boost::filesystem::path>(&genomeFile),
                                 "Name of the reference genome")
+        ("jobs,j",              bpo::value<unsigned>(&jobs)->default_value(jobs),
+                                "Maximum number of contigs to process in parallel")
         ;
 }
 
@@ -59,6 +63,10 @@ void PrintContigsOptions::postProcess(bpo::variables_map &vm)
             BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
         }
     }
+    if (!jobs)
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** The 'jobs' option must be strictly positive ***\n"));
+    }
 }
 
 } //namespace option
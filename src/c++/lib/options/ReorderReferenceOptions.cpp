@@ -28,6 +28,7 @@
 #include <boost/foreach.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
 
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
@@ -45,12 +46,17 @@ namespace bfs = boost::filesystem;
 using common::InvalidOptionException;
 using boost::format;
 
-ReorderReferenceOptions::ReorderReferenceOptions()
+ReorderReferenceOptions::ReorderReferenceOptions() :
+    packedCache_(false),
+    jobs_(boost::thread::hardware_concurrency())
 {
     namedOptions_.add_options()
         ("reference-genome,r"       , bpo::value<bfs::path>(&sortedReferenceMetadata_),
                 "Full path to the reference genome XML descriptor."
             )
+        ("jobs,j"       , bpo::value<unsigned>(&jobs_)->default_value(jobs_),
+                "Maximum number of parallel copy operations."
+            )
         ("order"       , bpo::value<std::string>(&newOrderString_),
                 "Comma-separated list of contig names in the order in which they will appear in the new .fa file."
             )
@@ -59,6 +65,10 @@ ReorderReferenceOptions::ReorderReferenceOptions()
             )
         ("output-xml,x"       , bpo::value<bfs::path>(&newXmlPath_),
                 "Path for the new xml file."
+            )
+        ("packed-cache"       , bpo::value<bool>(&packedCache_)->default_value(packedCache_),
+                "Also store 2-bit packed copy of the new .fa file next to it. isaac-align loads contigs from the "
+                "packed copy instead of parsing the fasta whenever the copy is up to date."
             );
 }
 
@@ -90,6 +100,11 @@ void ReorderReferenceOptions::postProcess(bpo::variables_map &vm)
         }
     }
 
+    if (!jobs_)
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** The 'jobs' option must be strictly positive ***\n"));
+    }
+
     newXmlPath_ = boost::filesystem::absolute(newXmlPath_);
 
     if (boost::filesystem::exists(newXmlPath_))
@@ -0,0 +1,131 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SimulateRunOptions.cpp
+ **
+ ** Command line options for 'simulateRun'
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <boost/format.hpp>
+
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+#include "options/SimulateRunOptions.hh"
+
+namespace isaac
+{
+namespace options
+{
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+using common::InvalidOptionException;
+using boost::format;
+
+SimulateRunOptions::SimulateRunOptions()
+    : referenceLength_(10000000)
+    , contigs_(2)
+    , repeatFraction_(0.05)
+    , readLength_(150)
+    , clusters_(1000000)
+    , fragmentLengthMean_(350)
+    , fragmentLengthSd_(35)
+    , errorRate_(0.005)
+    , indelRate_(0.0002)
+    , duplicateRate_(0.05)
+    , seed_(1)
+{
+    namedOptions_.add_options()
+        ("output-directory,o"       , bpo::value<std::string>(&outputDirectoryString_),
+                "Directory where genome.fa and the Fastq folder with lane1_read1.fastq.gz and "
+                "lane1_read2.fastq.gz are stored."
+            )
+        ("reference-length"         , bpo::value<uint64_t>(&referenceLength_)->default_value(referenceLength_),
+                "Total length of the synthetic reference in bases."
+            )
+        ("contigs"                  , bpo::value<unsigned>(&contigs_)->default_value(contigs_),
+                "Number of equally-sized contigs the reference is split into."
+            )
+        ("repeat-fraction"          , bpo::value<double>(&repeatFraction_)->default_value(repeatFraction_),
+                "Fraction of the reference made of diverged copies of earlier segments."
+            )
+        ("read-length"              , bpo::value<unsigned>(&readLength_)->default_value(readLength_),
+                "Length of each of the two reads."
+            )
+        ("clusters"                 , bpo::value<unsigned>(&clusters_)->default_value(clusters_),
+                "Number of read pairs to generate."
+            )
+        ("fragment-length-mean"     , bpo::value<unsigned>(&fragmentLengthMean_)->default_value(fragmentLengthMean_),
+                "Mean length of the sequenced fragments."
+            )
+        ("fragment-length-sd"       , bpo::value<unsigned>(&fragmentLengthSd_)->default_value(fragmentLengthSd_),
+                "Standard deviation of the sequenced fragment length."
+            )
+        ("error-rate"               , bpo::value<double>(&errorRate_)->default_value(errorRate_),
+                "Probability of a sequencing substitution at each base."
+            )
+        ("indel-rate"               , bpo::value<double>(&indelRate_)->default_value(indelRate_),
+                "Probability of a 1-4 base insertion or deletion starting at each fragment base."
+            )
+        ("duplicate-rate"           , bpo::value<double>(&duplicateRate_)->default_value(duplicateRate_),
+                "Probability of a read pair being a duplicate of the previous fragment."
+            )
+        ("seed"                     , bpo::value<unsigned>(&seed_)->default_value(seed_),
+                "Seed for the random generator. Same seed produces the same data."
+            )
+        ;
+}
+
+void SimulateRunOptions::postProcess(bpo::variables_map &vm)
+{
+    if(vm.count("help") ||  vm.count("version"))
+    {
+        return;
+    }
+
+    if (!vm.count("output-directory"))
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** The 'output-directory' option is required ***\n"));
+    }
+    outputDirectory_ = bfs::absolute(outputDirectoryString_);
+
+    if (!contigs_ || !clusters_ || !readLength_)
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** --contigs, --clusters and --read-length must be greater than 0 ***\n"));
+    }
+
+    if (fragmentLengthMean_ < readLength_)
+    {
+        BOOST_THROW_EXCEPTION(InvalidOptionException("\n   *** --fragment-length-mean must not be shorter than --read-length ***\n"));
+    }
+
+    if (referenceLength_ / contigs_ < fragmentLengthMean_ + fragmentLengthSd_ * 4 + readLength_)
+    {
+        const format message = format("\n   *** --reference-length %d is too short for %d contigs of fragments of %d bases ***\n") %
+            referenceLength_ % contigs_ % fragmentLengthMean_;
+        BOOST_THROW_EXCEPTION(InvalidOptionException(message.str()));
+    }
+
+    for (const double rate : {repeatFraction_, errorRate_, indelRate_, duplicateRate_})
+    {
+        if (0.0 > rate || 1.0 <= rate)
+        {
+            BOOST_THROW_EXCEPTION(InvalidOptionException(
+                "\n   *** --repeat-fraction, --error-rate, --indel-rate and --duplicate-rate must be in [0,1) ***\n"));
+        }
+    }
+}
+
+} //namespace options
+} // namespace isaac
@@ -26,11 +26,12 @@ namespace isaac
 namespace reference
 {
 
-void loadContig(
+template <typename IteratorT>
+static void parseContig(
     const reference::SortedReferenceMetadata::Contig &contigMetadata,
-    ContigList::UpdateRange &contig)
+    const IteratorT contigBegin,
+    const IteratorT contigEnd)
 {
-    ISAAC_ASSERT_MSG(contig.getLength() == contigMetadata.totalBases_, "Attempt to load wrong data into contig:" << contigMetadata << " " << contig)
     std::ifstream is(contigMetadata.filePath_.string().c_str());
     if (!is) {
         BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to open reference file " + contigMetadata.filePath_.string()));
@@ -46,25 +47,25 @@ void loadContig(
     static const oligo::Translator<true> translator = {};
     char base = 0;
     std::size_t acgtBases = 0;
-    auto updateIterator = contig.begin();
-    while(is && (std::size_t(std::distance(contig.begin(), updateIterator)) < contigMetadata.totalBases_) && is.get(base))
+    IteratorT updateIterator = contigBegin;
+    while(is && (std::size_t(std::distance(contigBegin, updateIterator)) < contigMetadata.totalBases_) && is.get(base))
     {
         if ('\r' != base && '\n' != base)
         {
             ISAAC_ASSERT_MSG(std::isalpha(base), "Invalid base read from " << contigMetadata << " : " << base);
             {
-                ISAAC_ASSERT_MSG(updateIterator < contig.end(), "Trying to update contig past its range " << contig << " " << contigMetadata);
+                ISAAC_ASSERT_MSG(updateIterator < contigEnd, "Trying to update contig past its range " << std::distance(contigBegin, contigEnd) << " " << contigMetadata);
                 *updateIterator = oligo::getBase(translator[base], true);
                 acgtBases += oligo::REFERENCE_OLIGO_N != *updateIterator;
                 ++updateIterator;
             }
         }
     }
-    if (contigMetadata.totalBases_ != std::size_t(std::distance(contig.begin(), updateIterator)))
+    if (contigMetadata.totalBases_ != std::size_t(std::distance(contigBegin, updateIterator)))
     {
         using common::IoException;
         using boost::format;
-        const format message = (format("Failed to read %d bases from reference file % s: %d") % contigMetadata.totalBases_ % contigMetadata.filePath_.string() % contig.getLength());
+        const format message = (format("Failed to read %d bases from reference file % s: %d") % contigMetadata.totalBases_ % contigMetadata.filePath_.string() % std::distance(contigBegin, contigEnd));
         BOOST_THROW_EXCEPTION(IoException(errno, message.str()));
     }
 
@@ -80,6 +81,22 @@ void loadContig(
     //ISAAC_TRACE_STAT("Loaded contig " << contigMetadata << " ");
 }
 
+void loadContig(
+    const reference::SortedReferenceMetadata::Contig &contigMetadata,
+    ContigList::UpdateRange &contig)
+{
+    ISAAC_ASSERT_MSG(contig.getLength() == contigMetadata.totalBases_, "Attempt to load wrong data into contig:" << contigMetadata << " " << contig)
+    parseContig(contigMetadata, contig.begin(), contig.end());
+}
+
+void loadContig(
+    const reference::SortedReferenceMetadata::Contig &contigMetadata,
+    std::vector<char> &bases)
+{
+    bases.resize(contigMetadata.totalBases_);
+    parseContig(contigMetadata, bases.begin(), bases.end());
+}
+
 struct DummyFilter {bool operator() (const unsigned contigIdx) const {return true;}} dummyFilter;
 /**
  * \brief loads all the fasta file contigs into memory on multiple threads
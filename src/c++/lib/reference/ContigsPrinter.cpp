@@ -17,13 +17,18 @@
  ** \author Roman Petrovski
  **/
 
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+
 #include <boost/assert.hpp>
+#include <boost/bind.hpp>
 #include <boost/io/ios_state.hpp>
-#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include "common/Exceptions.hh"
 #include "common/MD5Sum.hh"
-#include "io/FastaReader.hh"
+#include "common/Threads.hpp"
 #include "oligo/Nucleotides.hh"
 #include "reference/ContigsPrinter.hh"
 #include "reference/SortedReferenceXml.hh"
@@ -35,108 +40,184 @@ namespace reference
 
 ContigsPrinter::ContigsPrinter (
     const boost::filesystem::path &originalSortedReferenceXml,
-    const boost::filesystem::path &genomeFile
+    const boost::filesystem::path &genomeFile,
+    const unsigned jobs
 )
-    : originalSortedReferenceXml_(originalSortedReferenceXml), genomeFile_(genomeFile)
+    : originalSortedReferenceXml_(originalSortedReferenceXml), genomeFile_(genomeFile), jobs_(jobs)
 {
 }
 
-
-
-void ContigsPrinter::run()
+std::vector<ContigsPrinter::ContigLocation> ContigsPrinter::findContigs() const
 {
-    SortedReferenceMetadata::Contigs originalContigs;
-    if (!originalSortedReferenceXml_.empty())
-    {
-        SortedReferenceMetadata inXml(reference::loadReferenceMetadataFromXml(originalSortedReferenceXml_));
-        originalContigs = inXml.getContigs();
+    std::ifstream is(genomeFile_.string().c_str(), std::ios_base::binary);
+    if (!is) {
+        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open reference file " + genomeFile_.string()));
     }
 
-    SortedReferenceMetadata::Contigs outputContigs;
+    std::vector<ContigLocation> ret;
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    uint64_t offset = 0;
+    uint64_t headerOffset = 0;
+    bool lineStart = true;
+    bool inHeader = false;
+    std::string header;
+    while (is.read(&buffer.front(), buffer.size()) || is.gcount())
+    {
+        const char *const end = &buffer.front() + is.gcount();
+        for (const char *p = &buffer.front(); end != p;)
+        {
+            if (!inHeader && lineStart && '>' == *p)
+            {
+                inHeader = true;
+                headerOffset = offset + (p - &buffer.front());
+                header.clear();
+            }
+            const char *newLine = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (inHeader)
+            {
+                header.append(p, newLine ? newLine : end);
+            }
+            lineStart = newLine;
+            p = newLine ? newLine + 1 : end;
+            if (inHeader && lineStart)
+            {
+                inHeader = false;
+                if (!ret.empty())
+                {
+                    ret.back().end_ = headerOffset;
+                }
+                const ContigLocation location = {header, offset + (p - &buffer.front()), 0};
+                std::cerr << "header at:" << location.begin_ << "\n";
+                ret.push_back(location);
+            }
+        }
+        offset += is.gcount();
+    }
+    if (!is.eof()) {
+        BOOST_THROW_EXCEPTION(
+                isaac::common::IoException(errno, "Failed while reading sequence."
+                                             " Position:" + boost::lexical_cast<std::string>(offset) + "\n"));
+    }
+    std::cerr << "end of stream at:" << offset << "\n";
 
-    std::ifstream is(genomeFile_.string().c_str());
-    if (!is) {
-        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open reference file " + genomeFile_.string()));
+    if (inHeader)
+    {
+        // header line without end of line at the end of file
+        if (!ret.empty())
+        {
+            ret.back().end_ = headerOffset;
+        }
+        const ContigLocation location = {header, offset, 0};
+        ret.push_back(location);
+    }
+    if (!ret.empty())
+    {
+        ret.back().end_ = offset;
     }
+    return ret;
+}
 
-    int64_t lastAcgtCount(0), lastBasesCount(0), lastContigByteStart(0), lineNumber(0), lastContigGenomicStart(0), streamPos(0);
-    unsigned index = 0;
-    std::string lastHeader, line;
+void ContigsPrinter::summarizeContig(
+    const ContigLocation &location,
+    std::vector<char> &buffer,
+    ContigSummary &summary) const
+{
+    std::ifstream is(genomeFile_.string().c_str(), std::ios_base::binary);
+    if (!is || !is.seekg(location.begin_)) {
+        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open reference file " + genomeFile_.string() +
+                                                         " at " + boost::lexical_cast<std::string>(location.begin_)));
+    }
 
-    SortedReferenceMetadata outXml;
+    summary.totalBases_ = 0;
+    summary.acgtBases_ = 0;
     isaac::common::MD5Sum md5Sum;
-    // TODO: use the MultiFastaReader component to ensure consistency (particularly for the index)
-    while (std::getline(is, line))
+    for (uint64_t left = location.end_ - location.begin_; left;)
     {
-        streamPos = is.tellg();
-        ++lineNumber;
-        if ('>' == line[0])
+        const std::size_t toRead = std::min<uint64_t>(left, buffer.size());
+        if (!is.read(&buffer.front(), toRead))
         {
-            std::cerr << "header at:" << streamPos << "\n";
-            if (!lastHeader.empty())
-            {
-                const std::string contigName = lastHeader.substr(1, lastHeader.find_first_of(" \t\r") - 1);
-                SortedReferenceMetadata::Contigs::const_iterator originalContigIt =
-                    std::find_if(originalContigs.begin(), originalContigs.end(), boost::bind(&SortedReferenceMetadata::Contig::name_, _1) == contigName);
-                outXml.putContig(lastContigGenomicStart,
-                                 contigName,
-                                 genomeFile_,
-                                 lastContigByteStart,
-                                 streamPos - lastContigByteStart - (1 + line.length()), //byte length (assuming newline is one byte long)
-                                 lastBasesCount, lastAcgtCount, index,
-                                 (originalContigs.end() == originalContigIt ? "" : originalContigIt->bamSqAs_),
-                                 (originalContigs.end() == originalContigIt ? "" : originalContigIt->bamSqUr_),
-                                 isaac::common::MD5Sum::toHexString( md5Sum.getDigest().data, 16 ));
-
-                ++index;
-            }
-            // Reset counters
-            lastAcgtCount = 0;
-            lastHeader = line;
-            lastContigByteStart = streamPos;
-            lastContigGenomicStart += lastBasesCount;
-            lastBasesCount = 0;
-            md5Sum.clear();
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to read " + boost::lexical_cast<std::string>(toRead) +
+                                                             " bytes from reference file " + genomeFile_.string()));
         }
-        else
+        left -= toRead;
+
+        // MD5 with format characters stripped out. The stripped data is compacted in place
+        char *md5End = &buffer.front();
+        for (char *p = &buffer.front(); &buffer.front() + toRead != p; ++p)
         {
-            lastAcgtCount += std::count_if(line.begin(), line.end(), boost::bind(&oligo::getValue, _1) != oligo::INVALID_OLIGO);
+            const char c = *p;
+            summary.acgtBases_ += oligo::INVALID_OLIGO != oligo::getValue(c);
             // ignore untranslated '\r'
-            lastBasesCount += std::count_if(line.begin(), line.end(),
-                                            [](char c){return c != '\r';});
-//                                            boost::bind(&boost::ref<char>, _1) != '\r');
-        
-            // MD5 with format characters stripped out
-            std::string lineStd = line;
-            boost::to_upper(lineStd);
-            lineStd.erase(std::remove_if(lineStd.begin(), lineStd.end(), &isspace), lineStd.end());  // isspace should remove ' ', '\n', '\r', '\t'
-    
-            md5Sum.update( lineStd.c_str(), lineStd.size() );
+            summary.totalBases_ += '\r' != c && '\n' != c;
+            if (!isspace(c))
+            {
+                *md5End++ = toupper(c);
+            }
         }
+        md5Sum.update(&buffer.front(), md5End - &buffer.front());
     }
-    if (!is.eof()) {
-        BOOST_THROW_EXCEPTION(
-                isaac::common::IoException(errno, "Failed while reading sequence."
-                                             " Line:" + boost::lexical_cast<std::string>(lineNumber)
-                                           + " Position:" + boost::lexical_cast<std::string>(is.tellg())
-                                           + " Buffer:" + line + "\n"));
+    summary.md5_ = isaac::common::MD5Sum::toHexString(md5Sum.getDigest().data, 16);
+}
+
+void ContigsPrinter::summarizeContigsThread(
+    const std::vector<ContigLocation> &locations,
+    std::size_t &nextContig,
+    boost::mutex &mutex,
+    std::vector<ContigSummary> &summaries) const
+{
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (locations.size() != nextContig)
+    {
+        const std::size_t ourContig = nextContig++;
+        common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+        summarizeContig(locations.at(ourContig), buffer, summaries.at(ourContig));
+    }
+}
+
+void ContigsPrinter::run()
+{
+    SortedReferenceMetadata::Contigs originalContigs;
+    if (!originalSortedReferenceXml_.empty())
+    {
+        SortedReferenceMetadata inXml(reference::loadReferenceMetadataFromXml(originalSortedReferenceXml_));
+        originalContigs = inXml.getContigs();
+    }
+    // first one wins when names repeat
+    std::unordered_map<std::string, const SortedReferenceMetadata::Contig *> originalContigsByName;
+    for (const SortedReferenceMetadata::Contig &contig : originalContigs)
+    {
+        originalContigsByName.insert(std::make_pair(contig.name_, &contig));
+    }
+
+    const std::vector<ContigLocation> locations = findContigs();
+    std::vector<ContigSummary> summaries(locations.size());
+    {
+        std::size_t nextContig = 0;
+        boost::mutex mutex;
+        common::ThreadVector threads(std::max<std::size_t>(1, std::min<std::size_t>(jobs_, locations.size())));
+        threads.execute(boost::bind(&ContigsPrinter::summarizeContigsThread, this,
+                                    boost::cref(locations), boost::ref(nextContig), boost::ref(mutex), boost::ref(summaries)));
     }
-    std::cerr << "end of stream at:" << streamPos << "\n";
-    if (!lastHeader.empty())
+
+    SortedReferenceMetadata outXml;
+    uint64_t genomicStart = 0;
+    for (std::size_t index = 0; locations.size() != index; ++index)
     {
-        const std::string contigName = lastHeader.substr(1, lastHeader.find_first_of(" \t\r") - 1);
-        SortedReferenceMetadata::Contigs::const_iterator originalContigIt =
-            std::find_if(originalContigs.begin(), originalContigs.end(), boost::bind(&SortedReferenceMetadata::Contig::name_, _1) == contigName);
-        outXml.putContig(lastContigGenomicStart,
+        const ContigLocation &location = locations[index];
+        const ContigSummary &summary = summaries[index];
+        const std::string contigName = location.header_.substr(1, location.header_.find_first_of(" \t\r") - 1);
+        const auto originalContigIt = originalContigsByName.find(contigName);
+        outXml.putContig(genomicStart,
                          contigName,
                          genomeFile_,
-                         lastContigByteStart,
-                         streamPos - lastContigByteStart, //byte length
-                         lastBasesCount, lastAcgtCount, index,
-                         (originalContigs.end() == originalContigIt ? "" : originalContigIt->bamSqAs_),
-                         (originalContigs.end() == originalContigIt ? "" : originalContigIt->bamSqUr_),
-                         isaac::common::MD5Sum::toHexString( md5Sum.getDigest().data, 16 ));
-        ++index;
+                         location.begin_,
+                         location.end_ - location.begin_, //byte length
+                         summary.totalBases_, summary.acgtBases_, index,
+                         (originalContigsByName.end() == originalContigIt ? "" : originalContigIt->second->bamSqAs_),
+                         (originalContigsByName.end() == originalContigIt ? "" : originalContigIt->second->bamSqUr_),
+                         summary.md5_);
+        genomicStart += summary.totalBases_;
     }
 
     saveSortedReferenceXml(std::cout, outXml);
@@ -0,0 +1,344 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file PackedReference.cpp
+ **
+ ** Binary 2-bit copy of the fasta contigs that loads without parsing text.
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/bind.hpp>
+
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+#include "oligo/Nucleotides.hh"
+#include "reference/ContigLoader.hh"
+#include "reference/PackedReference.hh"
+
+namespace isaac
+{
+namespace reference
+{
+
+namespace bfs = boost::filesystem;
+
+const char PackedReference::MAGIC[8] = {'i', 'S', 'A', 'A', 'C', 'P', 'K', 'R'};
+const uint32_t PackedReference::VERSION;
+
+static const std::string STORE_EXTENSION = ".isaac-packed";
+
+/// packed bases are padded so that the N runs following them are aligned
+static uint64_t getPaddedPackedBytes(const uint64_t totalBases)
+{
+    return ((totalBases + 3) / 4 + 7) & ~uint64_t(7);
+}
+
+static uint32_t getChecksum(const char *packed, const uint64_t packedBytes, const packedReference::NRun *nRuns, const uint64_t count)
+{
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(packed), packedBytes);
+    // crc32 with Z_NULL buffer returns the initial value instead of crc. Empty std::vector::data() can be 0
+    if (count)
+    {
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(nRuns), count * sizeof(packedReference::NRun));
+    }
+    return crc;
+}
+
+/**
+ * \brief Four bases for each value of a packed byte. First base in the lowest bits
+ */
+struct UnpackTable
+{
+    char bases_[256][4];
+    UnpackTable()
+    {
+        for (unsigned byte = 0; 256 != byte; ++byte)
+        {
+            for (unsigned i = 0; 4 != i; ++i)
+            {
+                bases_[byte][i] = oligo::getBase((byte >> (i * 2)) & oligo::BCL_BASE_MASK, true);
+            }
+        }
+    }
+};
+
+PackedReference::PackedReference(const bfs::path &fastaPath) :
+    header_(0), contigsBegin_(0), contigsEnd_(0)
+{
+    const bfs::path storePath = getStorePath(fastaPath);
+    if (bfs::exists(storePath) && !map(storePath, fastaPath))
+    {
+        file_.close();
+        header_ = 0;
+    }
+}
+
+bfs::path PackedReference::getStorePath(const bfs::path &fastaPath)
+{
+    return fastaPath.string() + STORE_EXTENSION;
+}
+
+bool PackedReference::map(const bfs::path &storePath, const bfs::path &fastaPath)
+{
+    try
+    {
+        file_.open(storePath.string());
+    }
+    catch (const std::exception &e)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Ignoring unreadable packed reference " << storePath << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (!file_.is_open() || sizeof(packedReference::Header) > file_.size())
+    {
+        ISAAC_THREAD_CERR << "WARNING: Ignoring truncated packed reference " << storePath << std::endl;
+        return false;
+    }
+
+    header_ = reinterpret_cast<const packedReference::Header *>(file_.data());
+    if (!std::equal(header_->magic_, header_->magic_ + sizeof(header_->magic_), MAGIC) || VERSION != header_->version_)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Ignoring packed reference " << storePath << " of unsupported version " <<
+            header_->version_ << ". Expected " << VERSION << std::endl;
+        return false;
+    }
+
+    if (bfs::file_size(fastaPath) != header_->sourceSize_ || bfs::last_write_time(fastaPath) != header_->sourceMtime_)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Ignoring packed reference " << storePath << " which is older than " << fastaPath << std::endl;
+        return false;
+    }
+
+    contigsBegin_ = reinterpret_cast<const packedReference::ContigEntry *>(header_ + 1);
+    contigsEnd_ = contigsBegin_ + header_->contigCount_;
+    if (file_.size() < sizeof(packedReference::Header) + sizeof(packedReference::ContigEntry) * header_->contigCount_)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Ignoring truncated packed reference " << storePath << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool PackedReference::load(const SortedReferenceMetadata::Contig &xmlContig, ContigList::UpdateRange &contig) const
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    const packedReference::ContigEntry *entry = std::lower_bound(
+        contigsBegin_, contigsEnd_, xmlContig.offset_,
+        [](const packedReference::ContigEntry &entry, const uint64_t offset){return entry.fastaOffset_ < offset;});
+    if (contigsEnd_ == entry || xmlContig.offset_ != entry->fastaOffset_ ||
+        xmlContig.totalBases_ != entry->totalBases_ || xmlContig.acgtBases_ != entry->acgtBases_ ||
+        contig.getLength() != entry->totalBases_)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Packed reference does not match " << xmlContig << ". Loading it from fasta" << std::endl;
+        return false;
+    }
+
+    const uint64_t packedBytes = getPaddedPackedBytes(entry->totalBases_);
+    if (file_.size() < entry->dataOffset_ + packedBytes + entry->nRuns_ * sizeof(packedReference::NRun))
+    {
+        ISAAC_THREAD_CERR << "WARNING: Packed reference is truncated at " << xmlContig << ". Loading it from fasta" << std::endl;
+        return false;
+    }
+
+    const char *packed = file_.data() + entry->dataOffset_;
+    const packedReference::NRun *nRunsBegin = reinterpret_cast<const packedReference::NRun *>(packed + packedBytes);
+    const packedReference::NRun *nRunsEnd = nRunsBegin + entry->nRuns_;
+    if (entry->crc32_ != getChecksum(packed, packedBytes, nRunsBegin, entry->nRuns_))
+    {
+        ISAAC_THREAD_CERR << "WARNING: Packed reference checksum mismatch for " << xmlContig << ". Loading it from fasta" << std::endl;
+        return false;
+    }
+
+    static const UnpackTable unpackTable;
+    char *out = &*contig.begin();
+    const uint64_t fullBytes = entry->totalBases_ / 4;
+    for (const char *byte = packed; packed + fullBytes != byte; ++byte, out += 4)
+    {
+        memcpy(out, unpackTable.bases_[static_cast<unsigned char>(*byte)], 4);
+    }
+    if (entry->totalBases_ % 4)
+    {
+        memcpy(out, unpackTable.bases_[static_cast<unsigned char>(packed[fullBytes])], entry->totalBases_ % 4);
+    }
+
+    uint64_t nBases = 0;
+    for (const packedReference::NRun *nRun = nRunsBegin; nRunsEnd != nRun; ++nRun)
+    {
+        if (entry->totalBases_ < nRun->begin_ + nRun->length_)
+        {
+            ISAAC_THREAD_CERR << "WARNING: Packed reference N run out of range for " << xmlContig << ". Loading it from fasta" << std::endl;
+            return false;
+        }
+        std::fill(contig.begin() + nRun->begin_, contig.begin() + nRun->begin_ + nRun->length_, oligo::REFERENCE_OLIGO_N);
+        nBases += nRun->length_;
+    }
+
+    if (entry->totalBases_ - nBases != entry->acgtBases_)
+    {
+        ISAAC_THREAD_CERR << "WARNING: Packed reference N runs don't add up for " << xmlContig << ". Loading it from fasta" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PackedReference::store(const SortedReferenceMetadata::Contigs &contigs, const bfs::path &fastaPath)
+{
+    ISAAC_THREAD_CERR << "Packing " << fastaPath << " into " << getStorePath(fastaPath) << std::endl;
+
+    std::vector<const SortedReferenceMetadata::Contig *> fileContigs;
+    for (const SortedReferenceMetadata::Contig &contig : contigs)
+    {
+        if (fastaPath == contig.filePath_)
+        {
+            fileContigs.push_back(&contig);
+        }
+    }
+    std::sort(fileContigs.begin(), fileContigs.end(),
+              [](const SortedReferenceMetadata::Contig *left, const SortedReferenceMetadata::Contig *right)
+              {return left->offset_ < right->offset_;});
+
+    packedReference::Header header;
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), header.magic_);
+    header.version_ = VERSION;
+    header.contigCount_ = fileContigs.size();
+    header.sourceSize_ = bfs::file_size(fastaPath);
+    header.sourceMtime_ = bfs::last_write_time(fastaPath);
+
+    std::vector<packedReference::ContigEntry> entries(fileContigs.size());
+    // write into a temporary file first so that an interrupted conversion does not leave a broken store behind.
+    // The name is unique so that concurrent conversions of the same fasta don't write into each other's file
+    const bfs::path storePath = getStorePath(fastaPath);
+    const bfs::path tmpPath = storePath.string() + bfs::unique_path(".%%%%-%%%%-%%%%-%%%%.tmp").string();
+    try
+    {
+        std::ofstream os(tmpPath.c_str(), std::ios_base::binary);
+        if (!os)
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to open for writing " + tmpPath.string()));
+        }
+        uint64_t dataOffset = sizeof(header) + sizeof(packedReference::ContigEntry) * entries.size();
+        if (!os.seekp(dataOffset))
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to seek in " + tmpPath.string()));
+        }
+
+        static const oligo::Translator<true> translator = {};
+        std::vector<char> bases;
+        std::vector<char> packed;
+        std::vector<packedReference::NRun> nRuns;
+        for (std::size_t i = 0; fileContigs.size() != i; ++i)
+        {
+            const SortedReferenceMetadata::Contig &xmlContig = *fileContigs[i];
+            loadContig(xmlContig, bases);
+
+            packed.clear();
+            packed.resize(getPaddedPackedBytes(bases.size()), 0);
+            nRuns.clear();
+            for (uint64_t pos = 0; bases.size() != pos; ++pos)
+            {
+                const unsigned value = translator[bases[pos]];
+                if (oligo::INVALID_OLIGO == value)
+                {
+                    if (nRuns.empty() || nRuns.back().begin_ + nRuns.back().length_ != pos)
+                    {
+                        const packedReference::NRun nRun = {pos, 0};
+                        nRuns.push_back(nRun);
+                    }
+                    ++nRuns.back().length_;
+                }
+                else
+                {
+                    packed[pos / 4] |= value << ((pos % 4) * 2);
+                }
+            }
+
+            packedReference::ContigEntry &entry = entries[i];
+            entry.fastaOffset_ = xmlContig.offset_;
+            entry.totalBases_ = xmlContig.totalBases_;
+            entry.acgtBases_ = xmlContig.acgtBases_;
+            entry.dataOffset_ = dataOffset;
+            entry.nRuns_ = nRuns.size();
+            entry.crc32_ = getChecksum(packed.data(), packed.size(), nRuns.data(), nRuns.size());
+            entry.reserved_ = 0;
+
+            if (!os.write(packed.data(), packed.size()) ||
+                !os.write(reinterpret_cast<const char *>(nRuns.data()), sizeof(packedReference::NRun) * nRuns.size()))
+            {
+                BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + tmpPath.string()));
+            }
+            dataOffset += packed.size() + sizeof(packedReference::NRun) * nRuns.size();
+        }
+
+        if (!os.seekp(0) ||
+            !os.write(reinterpret_cast<const char *>(&header), sizeof(header)) ||
+            !os.write(reinterpret_cast<const char *>(entries.data()), sizeof(packedReference::ContigEntry) * entries.size()) ||
+            !os.flush())
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + tmpPath.string()));
+        }
+    }
+    catch (...)
+    {
+        boost::system::error_code ignored;
+        bfs::remove(tmpPath, ignored);
+        throw;
+    }
+
+    boost::system::error_code error;
+    bfs::rename(tmpPath, storePath, error);
+    if (error)
+    {
+        boost::system::error_code ignored;
+        bfs::remove(tmpPath, ignored);
+        BOOST_THROW_EXCEPTION(common::IoException(error.value(),
+            "Failed to rename " + tmpPath.string() + " to " + storePath.string() + ": " + error.message()));
+    }
+}
+
+PackedReferences::PackedReferences(const SortedReferenceMetadata::Contigs &contigs)
+{
+    for (const SortedReferenceMetadata::Contig &contig : contigs)
+    {
+        if (stores_.end() == stores_.find(contig.filePath_))
+        {
+            std::unique_ptr<PackedReference> store(new PackedReference(contig.filePath_));
+            if (store->isOpen())
+            {
+                ISAAC_THREAD_CERR << "Loading contigs of " << contig.filePath_ << " from " <<
+                    PackedReference::getStorePath(contig.filePath_) << std::endl;
+            }
+            stores_.insert(std::make_pair(contig.filePath_, std::move(store)));
+        }
+    }
+}
+
+bool PackedReferences::load(const SortedReferenceMetadata::Contig &xmlContig, ContigList::UpdateRange &contig) const
+{
+    const std::map<bfs::path, std::unique_ptr<PackedReference> >::const_iterator it = stores_.find(xmlContig.filePath_);
+    return stores_.end() != it && it->second->load(xmlContig, contig);
+}
+
+} // namespace reference
+} // namespace isaac
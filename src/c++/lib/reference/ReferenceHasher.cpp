@@ -126,6 +126,10 @@ void ReferenceHasher<ReferenceHashT>::dumpPositions(
     {
         const std::size_t offset = referenceHash.offsets_[referenceHash.keyFromKmer(kwp.first)]++;
         referenceHash.positions_.at(offset) = kwp.second;
+        if (referenceHash.fingerprints_)
+        {
+            referenceHash.positionFingerprints_.at(offset) = referenceHash.fingerprintFromKmer(kwp.first);
+        }
 //        ISAAC_THREAD_CERR << "kmer" << kwp.first << " offset:" << offset << " pos:" << kwp.second << std::endl;
     }
     buffer.clear();
@@ -191,12 +195,98 @@ void ReferenceHasher<ReferenceHashT>::sortPositions(
     if (blockBegin < referenceHash.offsets_.size())
     {
         const std::size_t blockEnd = std::min(referenceHash.offsets_.size(), blockBegin + blockLength + 1);
+        // bucket positions ordered by fingerprint and then by position
+        std::vector<std::pair<typename ReferenceHashT::Fingerprint, Offset> > fingerprinted;
         for (typename Offsets::iterator it = referenceHash.offsets_.begin() + blockBegin + 1;
             referenceHash.offsets_.begin() + blockEnd != it; ++it)
         {
-            std::sort(referenceHash.positions_.begin() + *(it - 1), referenceHash.positions_.begin() + *it);
+            if (!referenceHash.fingerprints_)
+            {
+                std::sort(referenceHash.positions_.begin() + *(it - 1), referenceHash.positions_.begin() + *it);
+                continue;
+            }
+
+            fingerprinted.clear();
+            for (Offset offset = *(it - 1); *it != offset; ++offset)
+            {
+                fingerprinted.push_back(
+                    std::make_pair(referenceHash.positionFingerprints_[offset], referenceHash.positions_[offset]));
+            }
+            std::sort(fingerprinted.begin(), fingerprinted.end());
+            Offset offset = *(it - 1);
+            for (const auto &fp : fingerprinted)
+            {
+                referenceHash.positionFingerprints_[offset] = fp.first;
+                referenceHash.positions_[offset] = fp.second;
+                ++offset;
+            }
+        }
+    }
+}
+
+/**
+ * \brief collects the position groups that findMatches would return for at least repeatFilterThreshold positions
+ *        into a small open addressing table.
+ */
+template <typename ReferenceHashT>
+void ReferenceHasher<ReferenceHashT>::buildRepeatFilter(
+    ReferenceHashT &referenceHash, const std::size_t repeatFilterThreshold)
+{
+    typedef typename ReferenceHashT::RepeatGroup RepeatGroup;
+    std::vector<RepeatGroup> repeats;
+    Offset begin = 0;
+    for (std::size_t key = 0; referenceHash.offsets_.size() != key; ++key)
+    {
+        const Offset end = referenceHash.offsets_[key];
+        if (end - begin >= repeatFilterThreshold)
+        {
+            if (!referenceHash.fingerprints_)
+            {
+                const RepeatGroup group = {typename ReferenceHashT::KeyT(key), 0, Offset(end - begin)};
+                repeats.push_back(group);
+            }
+            else
+            {
+                for (Offset groupBegin = begin; end != groupBegin;)
+                {
+                    const typename ReferenceHashT::Fingerprint fingerprint = referenceHash.positionFingerprints_[groupBegin];
+                    const Offset groupEnd = std::distance(
+                        referenceHash.positionFingerprints_.begin(),
+                        std::upper_bound(referenceHash.positionFingerprints_.begin() + groupBegin,
+                                         referenceHash.positionFingerprints_.begin() + end, fingerprint));
+                    if (groupEnd - groupBegin >= repeatFilterThreshold)
+                    {
+                        const RepeatGroup group = {typename ReferenceHashT::KeyT(key), fingerprint, Offset(groupEnd - groupBegin)};
+                        repeats.push_back(group);
+                    }
+                    groupBegin = groupEnd;
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // keep the load factor at or below 0.5
+    std::size_t slots = 1;
+    while (slots < repeats.size() * 2)
+    {
+        slots <<= 1;
+    }
+    const RepeatGroup emptyGroup = {0, 0, 0};
+    referenceHash.repeatGroups_.assign(slots, emptyGroup);
+    for (const RepeatGroup &group : repeats)
+    {
+        std::size_t slot = ReferenceHashT::repeatGroupSlot(group.key_, group.fingerprint_) & (slots - 1);
+        while (referenceHash.repeatGroups_[slot].count_)
+        {
+            slot = (slot + 1) & (slots - 1);
         }
+        referenceHash.repeatGroups_[slot] = group;
     }
+    referenceHash.repeatFilterThreshold_ = repeatFilterThreshold;
+
+    ISAAC_THREAD_CERR << " repeat filter: " << repeats.size() << " groups of " << repeatFilterThreshold <<
+        " or more positions in " << slots * sizeof(RepeatGroup) << " bytes" << std::endl;
 }
 
 /**
@@ -283,12 +373,18 @@ ReferenceHasher<ReferenceHashT>::countsToOffsets(Offsets& offsets)
 //}
 
 template <typename ReferenceHashT>
-ReferenceHashT ReferenceHasher<ReferenceHashT>::generate(const uint64_t bucketCount)
+ReferenceHashT ReferenceHasher<ReferenceHashT>::generate(
+    const uint64_t bucketCount, const bool canonical, const bool fingerprints, const std::size_t repeatFilterThreshold)
 {
-    ReferenceHashT ret(bucketCount);
+    ReferenceHashT ret(bucketCount, canonical, fingerprints);
 
     generate(ret);
 
+    if (repeatFilterThreshold)
+    {
+        buildRepeatFilter(ret, repeatFilterThreshold);
+    }
+
     return ret;
 }
 
@@ -346,9 +442,10 @@ void ReferenceHasher<ReferenceHashT>::generate(ReferenceHashT &ret)
     maxUniqueKeys = std::max(maxUniqueKeys, uniqueKeys);
     const Offset total = countsToOffsets(ret.offsets_);
     ISAAC_THREAD_CERR <<
-        " a:" << ret.getA() <<
-        " b:" << ret.getB() <<
+        " hash:" << ret.getHashPolicy() <<
         " buckets:" << ret.getBucketCount() <<
+        " canonical:" << ret.isCanonical() <<
+        " fingerprints:" << ret.hasFingerprints() <<
         " and " << total <<
         " genome " << oligo::KmerTraits<KmerT>::KMER_BASES <<
         "-mers "
@@ -357,6 +454,10 @@ void ReferenceHasher<ReferenceHashT>::generate(ReferenceHashT &ret)
 
 //    return ret;
     ret.positions_.resize(total);
+    if (ret.hasFingerprints())
+    {
+        ret.positionFingerprints_.resize(total);
+    }
     ISAAC_TRACE_STAT(" reserving memory done for " << ret.positions_.size() << " positions");
 
     threads_.execute(
@@ -397,5 +498,10 @@ template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<18>, common::N
 template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<19>, common::NumaAllocator<void, common::numa::defaultNodeInterleave> > >;
 template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<20>, common::NumaAllocator<void, common::numa::defaultNodeInterleave> > >;
 
+// hash policy comparison in isaac-bench
+template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<16>, common::NumaAllocator<void, common::numa::defaultNodeInterleave>, referenceHash::FastRange> >;
+template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<16>, common::NumaAllocator<void, common::numa::defaultNodeInterleave>, referenceHash::MultiplyShift> >;
+template class ReferenceHasher<ReferenceHash<oligo::BasicKmerType<16>, common::NumaAllocator<void, common::numa::defaultNodeInterleave>, referenceHash::PowerOfTwo> >;
+
 } // namespace reference
 } // namespace isaac
@@ -0,0 +1,137 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "common/MD5Sum.hh"
+#include "reference/ContigsPrinter.hh"
+#include "reference/SortedReferenceXml.hh"
+
+#include "RegistryName.hh"
+#include "testContigsPrinter.hh"
+
+using isaac::reference::ContigsPrinter;
+using isaac::reference::SortedReferenceMetadata;
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestContigsPrinter, registryName("ContigsPrinter"));
+
+/**
+ * \brief appends the contig to the fasta and the metadata ContigsPrinter is expected to produce for it to contigs
+ */
+static void addContig(
+    std::string &fasta,
+    const boost::filesystem::path &fastaPath,
+    const std::string &header,
+    const std::string &bases,
+    const std::size_t lineLength,
+    const std::string &newLine,
+    const bool lastNewLine,
+    SortedReferenceMetadata::Contigs &contigs)
+{
+    fasta += ">" + header + "\n";
+    const uint64_t offset = fasta.size();
+    for (std::size_t pos = 0; bases.size() > pos; pos += lineLength)
+    {
+        fasta += bases.substr(pos, lineLength);
+        if (lastNewLine || bases.size() > pos + lineLength)
+        {
+            fasta += newLine;
+        }
+    }
+
+    isaac::common::MD5Sum md5Sum;
+    std::string upper(bases);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    md5Sum.update(upper.c_str(), upper.size());
+
+    const uint64_t acgtBases = std::count_if(
+        bases.begin(), bases.end(), [](const char base){return std::string::npos != std::string("ACGTacgt").find(base);});
+    contigs.push_back(SortedReferenceMetadata::Contig(
+        contigs.size(), header.substr(0, header.find(' ')), false, fastaPath, offset, fasta.size() - offset,
+        contigs.empty() ? 0 : contigs.back().genomicPosition_ + contigs.back().totalBases_,
+        bases.size(), acgtBases, "", "", isaac::common::MD5Sum::toHexString(md5Sum.getDigest().data, 16)));
+}
+
+static std::string makeBases(const std::size_t length, const unsigned seed)
+{
+    std::string ret(length, 'N');
+    for (std::size_t i = 0; length != i; ++i)
+    {
+        ret[i] = (i + seed) % 101 < 7 ? 'N' : "ACGTacgt"[(i * 7 + i / 3 + seed) % 8];
+    }
+    return ret;
+}
+
+void TestContigsPrinter::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+    fastaPath_ = directory_ / "genome.fa";
+    expected_.clear();
+
+    std::string fasta;
+    addContig(fasta, fastaPath_, "one with description", makeBases(150, 1), 60, "\n", true, expected_);
+    addContig(fasta, fastaPath_, "empty", "", 60, "\n", true, expected_);
+    addContig(fasta, fastaPath_, "crlf", makeBases(1000, 2), 70, "\r\n", true, expected_);
+    // spans several read buffers
+    addContig(fasta, fastaPath_, "big", makeBases(3 * 1024 * 1024 + 17, 3), 60, "\n", true, expected_);
+    addContig(fasta, fastaPath_, "last", makeBases(130, 4), 60, "\n", false, expected_);
+
+    std::ofstream os(fastaPath_.c_str(), std::ios_base::binary);
+    CPPUNIT_ASSERT(os.write(fasta.c_str(), fasta.size()));
+}
+
+void TestContigsPrinter::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+static std::string printContigs(const boost::filesystem::path &fastaPath, const unsigned jobs)
+{
+    std::ostringstream os;
+    std::streambuf *const coutBuffer = std::cout.rdbuf(os.rdbuf());
+    try
+    {
+        ContigsPrinter(boost::filesystem::path(), fastaPath, jobs).run();
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(coutBuffer);
+        throw;
+    }
+    std::cout.rdbuf(coutBuffer);
+    return os.str();
+}
+
+void TestContigsPrinter::testContigs()
+{
+    std::istringstream is(printContigs(fastaPath_, 1));
+    const SortedReferenceMetadata::Contigs contigs = isaac::reference::loadSortedReferenceXml(is).getContigs();
+    CPPUNIT_ASSERT_EQUAL(expected_.size(), contigs.size());
+    for (std::size_t i = 0; expected_.size() != i; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(expected_[i], contigs[i]);
+        CPPUNIT_ASSERT_EQUAL(expected_[i].filePath_, contigs[i].filePath_);
+        CPPUNIT_ASSERT_EQUAL(expected_[i].bamM5_, contigs[i].bamM5_);
+    }
+}
+
+void TestContigsPrinter::testThreads()
+{
+    const std::string sequential = printContigs(fastaPath_, 1);
+    CPPUNIT_ASSERT_EQUAL(sequential, printContigs(fastaPath_, 8));
+    CPPUNIT_ASSERT_EQUAL(sequential, printContigs(fastaPath_, 16));
+}
@@ -0,0 +1,40 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_REFERENCE_TEST_CONTIGS_PRINTER_HH
+#define iSAAC_REFERENCE_TEST_CONTIGS_PRINTER_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+#include "reference/SortedReferenceMetadata.hh"
+
+class TestContigsPrinter : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestContigsPrinter );
+    CPPUNIT_TEST( testContigs );
+    CPPUNIT_TEST( testThreads );
+    CPPUNIT_TEST_SUITE_END();
+private:
+    boost::filesystem::path directory_;
+    boost::filesystem::path fastaPath_;
+    isaac::reference::SortedReferenceMetadata::Contigs expected_;
+public:
+    void setUp();
+    void tearDown();
+    void testContigs();
+    void testThreads();
+};
+
+#endif // #ifndef iSAAC_REFERENCE_TEST_CONTIGS_PRINTER_HH
@@ -0,0 +1,151 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <fstream>
+
+#include "reference/ContigLoader.hh"
+
+using isaac::reference::ContigList;
+using isaac::reference::PackedReference;
+using isaac::reference::SortedReferenceMetadata;
+
+#include "RegistryName.hh"
+#include "testPackedReference.hh"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestPackedReference, registryName("PackedReference"));
+
+static void addContig(
+    std::ofstream &os,
+    const boost::filesystem::path &fastaPath,
+    const std::string &name,
+    const std::string &bases,
+    SortedReferenceMetadata::Contigs &contigs)
+{
+    static const std::size_t LINE_LENGTH = 60;
+    os << ">" << name << "\n";
+    const uint64_t offset = os.tellp();
+    for (std::size_t pos = 0; bases.size() > pos; pos += LINE_LENGTH)
+    {
+        os << bases.substr(pos, LINE_LENGTH) << "\n";
+    }
+    const uint64_t size = uint64_t(os.tellp()) - offset;
+    const uint64_t acgtBases = std::count_if(
+        bases.begin(), bases.end(), [](const char base){return std::string::npos != std::string("ACGTacgt").find(base);});
+    contigs.push_back(SortedReferenceMetadata::Contig(
+        contigs.size(), name, false, fastaPath, offset, size, 0, bases.size(), acgtBases, "", "", ""));
+}
+
+void TestPackedReference::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+    fastaPath_ = directory_ / "genome.fa";
+    contigs_.clear();
+
+    std::ofstream os(fastaPath_.c_str());
+    addContig(os, fastaPath_, "one", "A", contigs_);
+    addContig(os, fastaPath_, "lower", "acgtNNnRgtcaNN", contigs_);
+    std::string longContig;
+    for (unsigned i = 0; 1001 != i; ++i)
+    {
+        longContig.push_back(i % 97 < 10 ? 'N' : "ACGT"[(i * 7 + i / 5) % 4]);
+    }
+    addContig(os, fastaPath_, "long", longContig, contigs_);
+}
+
+void TestPackedReference::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+static std::string loadFromFasta(const SortedReferenceMetadata::Contig &xmlContig)
+{
+    std::vector<char> bases;
+    isaac::reference::loadContig(xmlContig, bases);
+    return std::string(bases.begin(), bases.end());
+}
+
+static bool loadFromStore(
+    const PackedReference &store,
+    const SortedReferenceMetadata::Contigs &contigs,
+    const SortedReferenceMetadata::Contig &xmlContig,
+    std::string &result)
+{
+    ContigList contigList(contigs, 0);
+    ContigList::UpdateRange range = contigList.getUpdateRange(xmlContig.index_);
+    const bool ret = store.load(xmlContig, range);
+    result.assign(range.begin(), range.end());
+    return ret;
+}
+
+void TestPackedReference::testRoundTrip()
+{
+    CPPUNIT_ASSERT(!PackedReference(fastaPath_).isOpen());
+    PackedReference::store(contigs_, fastaPath_);
+    // nothing but the fasta and the store
+    CPPUNIT_ASSERT_EQUAL(2L, std::distance(
+        boost::filesystem::directory_iterator(directory_), boost::filesystem::directory_iterator()));
+
+    const PackedReference store(fastaPath_);
+    CPPUNIT_ASSERT(store.isOpen());
+    for (const SortedReferenceMetadata::Contig &xmlContig : contigs_)
+    {
+        std::string packed;
+        CPPUNIT_ASSERT(loadFromStore(store, contigs_, xmlContig, packed));
+        CPPUNIT_ASSERT_EQUAL(loadFromFasta(xmlContig), packed);
+    }
+    CPPUNIT_ASSERT_EQUAL(std::string("ACGTNNNNGTCANN"), loadFromFasta(contigs_.at(1)));
+
+    // contig that the store does not know about
+    SortedReferenceMetadata::Contig other = contigs_.at(1);
+    other.offset_ += 1;
+    std::string ignored;
+    CPPUNIT_ASSERT(!loadFromStore(store, contigs_, other, ignored));
+}
+
+void TestPackedReference::testStaleStore()
+{
+    PackedReference::store(contigs_, fastaPath_);
+    {
+        std::ofstream os(fastaPath_.c_str(), std::ios_base::app);
+        os << ">extra\nACGT\n";
+    }
+    CPPUNIT_ASSERT(!PackedReference(fastaPath_).isOpen());
+}
+
+void TestPackedReference::testCorruptContig()
+{
+    PackedReference::store(contigs_, fastaPath_);
+    const boost::filesystem::path storePath = PackedReference::getStorePath(fastaPath_);
+    {
+        // flip a base of the last contig. It is followed by 11 N runs
+        std::fstream fs(storePath.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        fs.seekg(-int(sizeof(isaac::reference::packedReference::NRun) * 11 + 16), std::ios_base::end);
+        const char c = fs.peek();
+        fs.seekp(fs.tellg());
+        fs.put(c ^ 1);
+    }
+
+    const PackedReference store(fastaPath_);
+    CPPUNIT_ASSERT(store.isOpen());
+    std::string packed;
+    CPPUNIT_ASSERT(loadFromStore(store, contigs_, contigs_.at(0), packed));
+    CPPUNIT_ASSERT(!loadFromStore(store, contigs_, contigs_.at(2), packed));
+}
+
+void TestPackedReference::testUnreadableStore()
+{
+    // exists but cannot be mapped
+    boost::filesystem::create_directory(PackedReference::getStorePath(fastaPath_));
+    CPPUNIT_ASSERT(!PackedReference(fastaPath_).isOpen());
+}
@@ -0,0 +1,44 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_REFERENCE_TEST_PACKED_REFERENCE_HH
+#define iSAAC_REFERENCE_TEST_PACKED_REFERENCE_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+#include "reference/PackedReference.hh"
+
+class TestPackedReference : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestPackedReference );
+    CPPUNIT_TEST( testRoundTrip );
+    CPPUNIT_TEST( testStaleStore );
+    CPPUNIT_TEST( testCorruptContig );
+    CPPUNIT_TEST( testUnreadableStore );
+    CPPUNIT_TEST_SUITE_END();
+private:
+    boost::filesystem::path directory_;
+    boost::filesystem::path fastaPath_;
+    isaac::reference::SortedReferenceMetadata::Contigs contigs_;
+public:
+    void setUp();
+    void tearDown();
+    void testRoundTrip();
+    void testStaleStore();
+    void testCorruptContig();
+    void testUnreadableStore();
+};
+
+#endif // #ifndef iSAAC_REFERENCE_TEST_PACKED_REFERENCE_HH
@@ -22,6 +22,7 @@
 #include <cassert>
 #include <cstring>
 #include <cerrno>
+#include <fstream>
 
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
@@ -34,6 +35,7 @@
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
 #include "common/FileSystem.hh"
+#include "common/Trace.hh"
 #include "flowcell/Layout.hh"
 #include "flowcell/ReadMetadata.hh"
 #include "reference/ContigLoader.hh"
@@ -71,6 +73,9 @@ AlignWorkflow::AlignWorkflow(
     const std::vector<std::string> &argv,
     const std::string &description,
     const std::size_t hashTableBucketCount,
+    const bool canonicalKmerHash,
+    const bool kmerFingerprints,
+    const unsigned seedMinimizerWindow,
     const std::vector<flowcell::Layout> &flowcellLayoutList,
     const unsigned seedLength,
     const flowcell::BarcodeMetadataList &barcodeMetadataList,
@@ -105,12 +110,15 @@ AlignWorkflow::AlignWorkflow(
     const bool preAllocateBins,
     const bool putUnalignedInTheBack,
     const bool realignGapsVigorously,
+    const build::GapRealignerEngine realignEngine,
+    const bool realignmentCache,
     const bool realignDodgyFragments,
     const unsigned realignedGapsPerFragment,
     const bool clipSemialigned,
     const bool clipOverlapping,
     const bool scatterRepeats,
     const bool rescueShadows,
+    const bool bitParallelShadowRescue,
     const bool trimPEAdapters,
     const unsigned gappedMismatchesMax,
     const unsigned smitWatermanGapsMax,
@@ -135,6 +143,7 @@ AlignWorkflow::AlignWorkflow(
     const int bamGzipLevel,
     const std::string &bamPuFormat,
     const bool bamProduceMd5,
+    const bool bamMergeRuns,
     const std::vector<std::string> &bamHeaderTags,
     const double expectedBgzfCompressionRatio,
     const bool singleLibrarySamples,
@@ -155,6 +164,9 @@ AlignWorkflow::AlignWorkflow(
     : argv_(argv)
     , description_(description)
     , hashTableBucketCount_(hashTableBucketCount)
+    , canonicalKmerHash_(canonicalKmerHash)
+    , kmerFingerprints_(kmerFingerprints)
+    , seedMinimizerWindow_(seedMinimizerWindow)
     , flowcellLayoutList_(flowcellLayoutList)
     , seedLength_(seedLength)
     , tempDirectory_(tempDirectory)
@@ -201,12 +213,15 @@ AlignWorkflow::AlignWorkflow(
     , preAllocateBins_(preAllocateBins)
     , putUnalignedInTheBack_(putUnalignedInTheBack)
     , realignGapsVigorously_(realignGapsVigorously)
+    , realignEngine_(realignEngine)
+    , realignmentCache_(realignmentCache)
     , realignDodgyFragments_(realignDodgyFragments)
     , realignedGapsPerFragment_(realignedGapsPerFragment)
     , clipSemialigned_(clipSemialigned)
     , clipOverlapping_(clipOverlapping)
     , scatterRepeats_(scatterRepeats)
     , rescueShadows_(rescueShadows)
+    , bitParallelShadowRescue_(bitParallelShadowRescue)
     , trimPEAdapters_(trimPEAdapters)
     , gappedMismatchesMax_(gappedMismatchesMax)
     , smitWatermanGapsMax_(smitWatermanGapsMax)
@@ -226,6 +241,7 @@ AlignWorkflow::AlignWorkflow(
     , bamGzipLevel_(bamGzipLevel)
     , bamPuFormat_(bamPuFormat)
     , bamProduceMd5_(bamProduceMd5)
+    , bamMergeRuns_(bamMergeRuns)
     , bamHeaderTags_(bamHeaderTags)
     , singleLibrarySamples_(singleLibrarySamples)
     , keepDuplicates_(keepDuplicates)
@@ -294,6 +310,9 @@ void AlignWorkflow::findMatches(
 {
     alignWorkflow::FindHashMatchesTransition findMatchesTransition(
         hashTableBucketCount_,
+        canonicalKmerHash_,
+        kmerFingerprints_,
+        seedMinimizerWindow_,
         flowcellLayoutList_,
         barcodeMetadataList_,
         cleanupIntermediary_,
@@ -327,7 +346,7 @@ void AlignWorkflow::findMatches(
         reports::AlignmentReportGenerator::none != statsImageFormat_,
         baseQualityCutoff_,
         keepUnaligned_, clipSemialigned_, clipOverlapping_,
-        scatterRepeats_, rescueShadows_, trimPEAdapters_, anchorMate_, gappedMismatchesMax_, smitWatermanGapsMax_, smartSmithWaterman_, smitWatermanGapSizeMax_, splitAlignments_,
+        scatterRepeats_, rescueShadows_, bitParallelShadowRescue_, trimPEAdapters_, anchorMate_, gappedMismatchesMax_, smitWatermanGapsMax_, smartSmithWaterman_, smitWatermanGapSizeMax_, splitAlignments_,
         alignmentCfg_,
         dodgyAlignmentScore_, anomalousPairHandicap_,
         qScoreBin_,
@@ -377,11 +396,11 @@ const demultiplexing::BarcodePathMap AlignWorkflow::generateBam(
                        barcodeTemplateLengthStatistics,
                        sortedReferenceMetadataList_,
                        contigLists_.node0Container(),
-                       projectsDirectory_,
+                       projectsDirectory_, tempDirectory_,
                        tempLoadersMax_, coresMax_, outputSaversMax_, realignGaps_, realignMapqMin_, knownIndelsPath_,
-                       bamGzipLevel_, bamPuFormat_, bamProduceMd5_, bamHeaderTags_, expectedCoverage_, targetBinSize_, expectedBgzfCompressionRatio_, singleLibrarySamples_,
+                       bamGzipLevel_, bamPuFormat_, bamProduceMd5_, bamMergeRuns_, bamHeaderTags_, expectedCoverage_, targetBinSize_, expectedBgzfCompressionRatio_, singleLibrarySamples_,
                        keepDuplicates_, markDuplicates_, anchorMate_,
-                       realignGapsVigorously_, realignDodgyFragments_, realignedGapsPerFragment_,
+                       realignGapsVigorously_, realignEngine_, realignmentCache_, realignDodgyFragments_, realignedGapsPerFragment_,
                        clipSemialigned_, alignmentCfg_,
                        // when splitting reads, the bin regex cannot be used to decide which 
                        // contigs to load.
@@ -447,27 +466,71 @@ AlignWorkflow::State AlignWorkflow::getNextState() const
     }
 }
 
+/**
+ * \brief Appends the wall time and io of the stage and the process-wide peak memory so far to
+ *        Stats/WorkflowPerformance.tsv. The file is appended to so that the stages of a resumed run end up in the
+ *        same table.
+ */
+void AlignWorkflow::storeStageUsage(
+    const std::string &stage,
+    const uint64_t beginNs,
+    const common::ResourceUsage &begin) const
+{
+    const double seconds = double(common::trace::nowNs() - beginNs) / 1000000000.0;
+    const common::ResourceUsage end = common::getResourceUsage();
+    uint64_t clusters = 0;
+    for (const flowcell::TileMetadata &tile : foundMatchesMetadata_.tileMetadataList_)
+    {
+        clusters += tile.getClusterCount();
+    }
+    const double clustersPerSecond = seconds ? double(clusters) / seconds : 0.0;
+
+    ISAAC_THREAD_CERR << "Stage " << stage << " done in " << seconds << " seconds, process peak RSS " << end.peakRss_ <<
+        " bytes, read " << (end.bytesRead_ - begin.bytesRead_) << " bytes, written " <<
+        (end.bytesWritten_ - begin.bytesWritten_) << " bytes, " << clustersPerSecond << " clusters/s" << std::endl;
+
+    const bfs::path performancePath = statsDirectory_ / "WorkflowPerformance.tsv";
+    const bool newFile = !bfs::exists(performancePath);
+    std::ofstream os(performancePath.c_str(), std::ios_base::app);
+    if (newFile)
+    {
+        // getrusage reports the peak of the whole process so far, not of the stage
+        os << "stage\tseconds\tprocess_peak_rss_bytes\tbytes_read\tbytes_written\tclusters\tclusters_per_second\n";
+    }
+    os << stage << "\t" << seconds << "\t" << end.peakRss_ << "\t" << (end.bytesRead_ - begin.bytesRead_) << "\t" <<
+        (end.bytesWritten_ - begin.bytesWritten_) << "\t" << clusters << "\t" << clustersPerSecond << "\n";
+    if (!os)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + performancePath.string()));
+    }
+}
+
 AlignWorkflow::State AlignWorkflow::step()
 {
     using std::swap;
+    const uint64_t beginNs = common::trace::nowNs();
+    const common::ResourceUsage begin = common::getResourceUsage();
     switch (state_)
     {
     case Start:
     {
         findMatches(foundMatchesMetadata_, selectedMatchesMetadata_, barcodeTemplateLengthStatistics_);
         state_ = getNextState();
+        storeStageUsage("Align", beginNs, begin);
         break;
     }
     case AlignDone:
     {
         generateAlignmentReports();
         state_ = getNextState();
+        storeStageUsage("AlignmentReports", beginNs, begin);
         break;
     }
     case AlignmentReportsDone:
     {
         barcodeBamMapping_ = generateBam(selectedMatchesMetadata_, barcodeTemplateLengthStatistics_);
         state_ = getNextState();
+        storeStageUsage("Bam", beginNs, begin);
         break;
     }
     case Finish:
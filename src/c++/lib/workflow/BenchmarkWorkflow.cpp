@@ -0,0 +1,917 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file BenchmarkWorkflow.cpp
+ **
+ ** \brief see BenchmarkWorkflow.hh
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include <boost/format.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "alignment/BandedSmithWaterman.hh"
+#include "alignment/BclClusters.hh"
+#include "alignment/Cluster.hh"
+#include "alignment/HashMatchFinder.hh"
+#include "alignment/Mismatch.hh"
+#include "bgzf/BgzfCompressor.hh"
+#include "build/GapRealigner.hh"
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+#include "common/Trace.hh"
+#include "demultiplexing/BarcodeResolver.hh"
+#include "demultiplexing/DemultiplexingStats.hh"
+#include "io/FastqReader.hh"
+#include "oligo/Nucleotides.hh"
+#include "reference/ReferenceHasher.hh"
+#include "workflow/BenchmarkWorkflow.hh"
+
+namespace isaac
+{
+namespace workflow
+{
+
+namespace bios = boost::io;
+
+using benchmarkWorkflow::SyntheticRead;
+using benchmarkWorkflow::KernelResult;
+
+namespace benchmarkWorkflow
+{
+
+static const char BASES[] = {'A', 'C', 'G', 'T'};
+// bcl and fastq quality of all synthetic bases
+static const unsigned BASE_QUALITY = 30;
+// one in this many bases is substituted
+static const unsigned SUBSTITUTION_RATE = 100;
+// one in this many reads carries an indel
+static const unsigned INDEL_READ_RATE = 8;
+static const unsigned INDEL_LENGTH_MAX = 4;
+// every this many bases a segment of the reference is a mutated copy of an earlier one
+static const unsigned REPEAT_SPACING = 20000;
+static const unsigned REPEAT_LENGTH = 500;
+// reads don't start or end closer than this to the reference ends
+static const unsigned REFERENCE_MARGIN = 64;
+
+typedef reference::ReferenceHash<oligo::BasicKmerType<16>, common::NumaAllocator<void, common::numa::defaultNodeInterleave> > ReferenceHash;
+typedef ReferenceHash::KmerT KmerT;
+
+// isaac-align defaults
+static const std::size_t CANDIDATE_MATCHES_MAX = 800;
+static const unsigned SEED_BASE_QUALITY_MIN = 3;
+static const unsigned REPEAT_THRESHOLD = 100;
+static const unsigned MATCH_FINDER_REPEATS_MAX = 100000;
+static const unsigned SEEDS_PER_MATCH_MAX = 4;
+static const unsigned REALIGNED_GAPS_PER_FRAGMENT = 4;
+static const unsigned BARCODE_COUNT = 96;
+static const unsigned BARCODE_LENGTH = 8;
+
+char complement(const char base)
+{
+    return 'A' == base ? 'T' : 'C' == base ? 'G' : 'G' == base ? 'C' : 'T' == base ? 'A' : base;
+}
+
+char substitute(const char base, std::mt19937 &generator)
+{
+    const unsigned shift = 1 + generator() % 3;
+    return BASES[(oligo::getValue(base) + shift) % 4];
+}
+
+void generateReference(
+    const uint64_t referenceLength,
+    std::mt19937 &generator,
+    reference::ContigLists &contigLists)
+{
+    reference::SortedReferenceMetadata sortedReferenceMetadata;
+    sortedReferenceMetadata.putContig(
+        0, "synthetic", "synthetic.fa", 0, referenceLength, referenceLength, referenceLength, 0, "", "", "");
+
+    reference::ContigList contigList(sortedReferenceMetadata.getContigs(), 1000);
+    reference::ContigList::UpdateRange contig = contigList.getUpdateRange(0);
+    std::generate(contig.begin(), contig.end(), [&generator](){return BASES[generator() % 4];});
+
+    for (uint64_t repeatBegin = REPEAT_SPACING; repeatBegin + REPEAT_LENGTH < referenceLength; repeatBegin += REPEAT_SPACING)
+    {
+        const uint64_t source = generator() % (repeatBegin - REPEAT_LENGTH);
+        for (unsigned i = 0; REPEAT_LENGTH != i; ++i)
+        {
+            const char base = *(contig.begin() + source + i);
+            *(contig.begin() + repeatBegin + i) = generator() % (SUBSTITUTION_RATE / 2) ? base : substitute(base, generator);
+        }
+    }
+    contigLists.push_back(std::move(contigList));
+}
+
+/**
+ * \brief smallest power of 2 that is not less than the reference length
+ */
+uint64_t getBucketCount(const reference::ContigList &contigList)
+{
+    uint64_t bucketCount = 1;
+    while (bucketCount < contigList.endOffset())
+    {
+        bucketCount <<= 1;
+    }
+    return bucketCount;
+}
+
+/**
+ * \brief non-overlapping seeds of every read, the way isaac-align probes them
+ */
+void generateSeeds(const std::vector<SyntheticRead> &reads, std::vector<KmerT> &seeds)
+{
+    for (const SyntheticRead &read : reads)
+    {
+        for (unsigned offset = 0; offset + KmerT::KMER_BASES <= read.bases_.size(); offset += KmerT::KMER_BASES)
+        {
+            uint64_t bits = 0;
+            for (unsigned i = 0; KmerT::KMER_BASES != i; ++i)
+            {
+                bits = (bits << oligo::BITS_PER_BASE) | oligo::getValue(read.bases_[offset + i]);
+            }
+            seeds.push_back(KmerT(KmerT::BitsType(bits)));
+        }
+    }
+}
+
+void generateReads(
+    const reference::Contig &contig,
+    const unsigned readLength,
+    const unsigned reads,
+    std::mt19937 &generator,
+    std::vector<SyntheticRead> &ret)
+{
+    ret.reserve(reads);
+    const uint64_t positionsCount = contig.size() - readLength - INDEL_LENGTH_MAX - REFERENCE_MARGIN * 2;
+    while (ret.size() != reads)
+    {
+        SyntheticRead read;
+        read.position_ = REFERENCE_MARGIN + generator() % positionsCount;
+        read.reverse_ = generator() % 2;
+        read.indelOffset_ = 0;
+        read.indelLength_ = 0;
+        const reference::Contig::const_iterator refBegin = contig.begin() + read.position_;
+        if (readLength >= 32 && !(ret.size() % INDEL_READ_RATE))
+        {
+            read.indelOffset_ = readLength / 4 + generator() % (readLength / 2);
+            const int indelLength = 1 + generator() % INDEL_LENGTH_MAX;
+            read.indelLength_ = generator() % 2 ? indelLength : -indelLength;
+        }
+
+        if (0 < read.indelLength_)
+        {
+            read.strandBases_.assign(refBegin, refBegin + read.indelOffset_);
+            read.strandBases_.insert(
+                read.strandBases_.end(),
+                refBegin + read.indelOffset_ + read.indelLength_, refBegin + readLength + read.indelLength_);
+        }
+        else
+        {
+            read.strandBases_.assign(refBegin, refBegin + read.indelOffset_);
+            for (int i = 0; -read.indelLength_ != i; ++i)
+            {
+                read.strandBases_.push_back(BASES[generator() % 4]);
+            }
+            read.strandBases_.insert(
+                read.strandBases_.end(),
+                refBegin + read.indelOffset_, refBegin + readLength + read.indelLength_);
+        }
+
+        for (char &base : read.strandBases_)
+        {
+            if (!(generator() % SUBSTITUTION_RATE))
+            {
+                base = substitute(base, generator);
+            }
+        }
+
+        if (read.reverse_)
+        {
+            read.bases_.resize(readLength);
+            std::transform(read.strandBases_.rbegin(), read.strandBases_.rend(), read.bases_.begin(), &complement);
+        }
+        else
+        {
+            read.bases_ = read.strandBases_;
+        }
+        ret.push_back(read);
+    }
+}
+
+std::string makeFastq(const std::vector<SyntheticRead> &reads)
+{
+    std::string ret;
+    const std::string quality(reads.front().bases_.size(), '!' + BASE_QUALITY);
+    for (const SyntheticRead &read : reads)
+    {
+        ret += (boost::format("@synthetic:%d\n") % (&read - &reads.front())).str();
+        ret.append(read.bases_.begin(), read.bases_.end());
+        ret += "\n+\n";
+        ret += quality;
+        ret += "\n";
+    }
+    return ret;
+}
+
+const char *getInstructionSet()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE4_2__)
+    return "sse4.2";
+#elif defined(__SSE4_1__)
+    return "sse4.1";
+#elif defined(__SSSE3__)
+    return "ssse3";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "generic";
+#endif
+}
+
+} // namespace benchmarkWorkflow
+
+using namespace benchmarkWorkflow;
+
+BenchmarkWorkflow::BenchmarkWorkflow(
+    const std::vector<std::string> &kernels,
+    const uint64_t referenceLength,
+    const unsigned readLength,
+    const unsigned reads,
+    const unsigned repeats,
+    const unsigned jobs,
+    const unsigned seed,
+    const bfs::path &tempDirectory,
+    const std::string &output)
+    : kernels_(kernels)
+    , readLength_(readLength)
+    , repeats_(repeats)
+    , jobs_(jobs)
+    , tempDirectory_(tempDirectory)
+    , output_(output)
+    , threads_(jobs_)
+{
+    std::mt19937 generator(seed);
+    ISAAC_THREAD_CERR << "Generating " << referenceLength << " bases of synthetic reference" << std::endl;
+    generateReference(referenceLength, generator, contigLists_);
+    ISAAC_THREAD_CERR << "Generating " << reads << " synthetic reads of length " << readLength_ << std::endl;
+    generateReads(contigLists_.at(0).at(0), readLength_, reads, generator, reads_);
+}
+
+bool BenchmarkWorkflow::isSelected(const std::string &kernel) const
+{
+    return kernels_.end() != std::find(kernels_.begin(), kernels_.end(), kernel);
+}
+
+/**
+ * \brief Times jobs_ threads running the kernel concurrently over their own copy of the state. prepare
+ *        restores the per-thread state before each repetition and is not timed.
+ *
+ * \param run returns the checksum of the thread results
+ */
+template <typename PrepareT, typename RunT>
+void BenchmarkWorkflow::measure(
+    const std::string &name, const std::string &unit, const uint64_t itemsPerThread,
+    PrepareT prepare, RunT run)
+{
+    ISAAC_THREAD_CERR << "Timing " << name << " on " << jobs_ << " threads" << std::endl;
+    std::vector<uint64_t> threadChecksums(jobs_, 0);
+    double bestSeconds = std::numeric_limits<double>::max();
+    for (unsigned repeat = 0; repeats_ != repeat; ++repeat)
+    {
+        threads_.execute([&prepare](const std::size_t threadNumber, const std::size_t){prepare(threadNumber);}, jobs_);
+        const uint64_t beginNs = common::trace::nowNs();
+        threads_.execute(
+            [&run, &threadChecksums](const std::size_t threadNumber, const std::size_t)
+            {
+                threadChecksums.at(threadNumber) = run(threadNumber);
+            }, jobs_);
+        bestSeconds = std::min(bestSeconds, double(common::trace::nowNs() - beginNs) / 1000000000.0);
+    }
+
+    uint64_t checksum = 0;
+    for (const uint64_t threadChecksum : threadChecksums)
+    {
+        checksum += threadChecksum;
+    }
+    const KernelResult result = {name, unit, itemsPerThread * jobs_, bestSeconds, checksum};
+    results_.push_back(result);
+    ISAAC_THREAD_CERR << "Timing " << name << " done: " <<
+        (double(result.items_) / result.seconds_ / jobs_) << " " << unit << "/s per core" << std::endl;
+}
+
+void BenchmarkWorkflow::benchmarkHash(const bool findMatches, const bool findReadMatches)
+{
+    const reference::ContigList &contigList = contigLists_.at(0);
+    reference::ReferenceHasher<ReferenceHash> hasher(contigList, threads_, jobs_);
+    const ReferenceHash referenceHash = hasher.generate(getBucketCount(contigList));
+
+    if (findMatches)
+    {
+        std::vector<KmerT> seeds;
+        generateSeeds(reads_, seeds);
+
+        measure(
+            "findMatches", "seeds", seeds.size(),
+            [](const std::size_t){},
+            [&referenceHash, &seeds](const std::size_t)
+            {
+                uint64_t checksum = 0;
+                ReferenceHash::MatchRange fwMatches;
+                ReferenceHash::MatchRange rvMatches;
+                for (const KmerT &seed : seeds)
+                {
+                    referenceHash.findMatches(seed, fwMatches, rvMatches);
+                    checksum += std::distance(fwMatches.first, fwMatches.second) + std::distance(rvMatches.first, rvMatches.second);
+                }
+                return checksum;
+            });
+    }
+
+    if (findReadMatches)
+    {
+        const flowcell::ReadMetadataList readMetadataList(1, flowcell::ReadMetadata(1, readLength_, 0, 0));
+        alignment::BclClusters clusters(readLength_);
+        clusters.reset(readLength_, reads_.size());
+        for (const SyntheticRead &read : reads_)
+        {
+            std::transform(read.bases_.begin(), read.bases_.end(), clusters.cluster(&read - &reads_.front()),
+                           [](const char base){return char(oligo::getValue(base) | (BASE_QUALITY << 2));});
+        }
+
+        struct MatchFinderThread
+        {
+            alignment::Cluster cluster_;
+            alignment::MatchLists matchLists_;
+            alignment::ReferenceOffsetLists fwMergeBuffers_;
+            alignment::ReferenceOffsetLists rvMergeBuffers_;
+
+            MatchFinderThread(const unsigned readLength) :
+                cluster_(readLength),
+                matchLists_(SEEDS_PER_MATCH_MAX + 1),
+                fwMergeBuffers_(matchLists_.size()),
+                rvMergeBuffers_(matchLists_.size())
+            {
+                const std::size_t seedsPerRead = readLength / ReferenceHash::SEED_LENGTH + 1;
+                for (alignment::Matches &matches : matchLists_)
+                {
+                    matches.reserve(REPEAT_THRESHOLD * seedsPerRead);
+                }
+                for (unsigned seedsPerMatch = 0; matchLists_.size() != seedsPerMatch; ++seedsPerMatch)
+                {
+                    fwMergeBuffers_[seedsPerMatch].reserve(REPEAT_THRESHOLD * seedsPerRead);
+                    rvMergeBuffers_[seedsPerMatch].reserve(REPEAT_THRESHOLD * seedsPerRead);
+                }
+            }
+        };
+        boost::ptr_vector<MatchFinderThread> matchFinderThreads;
+        while (matchFinderThreads.size() != jobs_)
+        {
+            matchFinderThreads.push_back(new MatchFinderThread(readLength_));
+        }
+
+        const alignment::ClusterHashMatchFinder<ReferenceHash> matchFinder(
+            referenceHash, CANDIDATE_MATCHES_MAX, SEED_BASE_QUALITY_MIN, MATCH_FINDER_REPEATS_MAX);
+
+        measure(
+            "findReadMatches", "reads", reads_.size(),
+            [](const std::size_t){},
+            [this, &contigList, &readMetadataList, &clusters, &matchFinder, &matchFinderThreads](const std::size_t threadNumber)
+            {
+                MatchFinderThread &state = matchFinderThreads.at(threadNumber);
+                uint64_t checksum = 0;
+                std::size_t repeatProbesAvoided = 0;
+                for (std::size_t clusterId = 0; reads_.size() != clusterId; ++clusterId)
+                {
+                    state.cluster_.init(
+                        readMetadataList, clusters.cluster(clusterId), 0, clusterId, alignment::ClusterXy(0, 0), true, 0, 0);
+                    matchFinder.findReadMatches(
+                        contigList, state.cluster_, readMetadataList.front(), REPEAT_THRESHOLD,
+                        state.matchLists_, state.fwMergeBuffers_, state.rvMergeBuffers_, repeatProbesAvoided);
+                    for (const alignment::Matches &matches : state.matchLists_)
+                    {
+                        checksum += matches.size();
+                    }
+                }
+                return checksum;
+            });
+    }
+}
+
+void BenchmarkWorkflow::benchmarkCountMismatches()
+{
+    const reference::Contig &contig = contigLists_.at(0).at(0);
+    measure(
+        "countMismatchesFast", "bases", reads_.size() * readLength_,
+        [](const std::size_t){},
+        [this, &contig](const std::size_t)
+        {
+            uint64_t checksum = 0;
+            for (const SyntheticRead &read : reads_)
+            {
+                checksum += alignment::countMismatchesFast(
+                    &read.strandBases_.front(), &read.strandBases_.back() + 1, &*(contig.begin() + read.position_));
+            }
+            return checksum;
+        });
+}
+
+void BenchmarkWorkflow::benchmarkBandedSmithWaterman()
+{
+    typedef alignment::BandedSmithWaterman<16> BandedSmithWaterman;
+    const reference::Contig &contig = contigLists_.at(0).at(0);
+
+    std::vector<const SyntheticRead *> gappedReads;
+    for (const SyntheticRead &read : reads_)
+    {
+        if (read.indelLength_)
+        {
+            gappedReads.push_back(&read);
+        }
+    }
+
+    boost::ptr_vector<BandedSmithWaterman> aligners;
+    std::vector<alignment::Cigar> cigars(jobs_);
+    while (aligners.size() != jobs_)
+    {
+        aligners.push_back(new BandedSmithWaterman(1, -4, 6, 1, readLength_));
+        cigars.at(aligners.size() - 1).reserve(1024);
+    }
+
+    // database is the read span plus the band on both sides, as in GappedAligner
+    const unsigned flank = (BandedSmithWaterman::WIDEST_GAP_SIZE - 1) / 2;
+    measure(
+        "bandedSmithWaterman", "reads", gappedReads.size(),
+        [](const std::size_t){},
+        [&contig, &gappedReads, &aligners, &cigars, flank](const std::size_t threadNumber)
+        {
+            const BandedSmithWaterman &aligner = aligners.at(threadNumber);
+            alignment::Cigar &cigar = cigars.at(threadNumber);
+            uint64_t checksum = 0;
+            for (const SyntheticRead *read : gappedReads)
+            {
+                cigar.clear();
+                const reference::Contig::const_iterator databaseBegin = contig.begin() + read->position_ - flank;
+                checksum += aligner.align(
+                    read->strandBases_, databaseBegin,
+                    databaseBegin + read->strandBases_.size() + BandedSmithWaterman::WIDEST_GAP_SIZE - 1, cigar);
+                checksum += cigar.size();
+            }
+            return checksum;
+        });
+}
+
+void BenchmarkWorkflow::benchmarkGapRealigner()
+{
+    const reference::Contig &contig = contigLists_.at(0).at(0);
+
+    flowcell::BarcodeMetadataList barcodeMetadataList(1);
+    barcodeMetadataList.at(0).setUnknown();
+    barcodeMetadataList.at(0).setIndex(0);
+    barcodeMetadataList.at(0).setReferenceIndex(0);
+
+    build::gapRealigner::RealignerGaps realignerGaps;
+    realignerGaps.reserve(reads_.size() / INDEL_READ_RATE + 1);
+    for (const SyntheticRead &read : reads_)
+    {
+        if (read.indelLength_)
+        {
+            realignerGaps.addGap(build::gapRealigner::Gap(
+                reference::ReferencePosition(0, read.position_ + read.indelOffset_), read.indelLength_));
+        }
+    }
+    realignerGaps.finalizeGaps();
+
+    // all reads are stored with an ungapped alignment. The ones that have indels get mismatches past the indel
+    const unsigned fragmentLength = io::FragmentHeader::getTotalLength(readLength_, sizeof(uint32_t), 0);
+    alignment::Cigar ungappedCigar;
+    ungappedCigar.addOperation(readLength_, alignment::Cigar::ALIGN);
+    build::PackedFragmentBuffer dataBuffer;
+    dataBuffer.resize(std::size_t(fragmentLength) * reads_.size());
+    std::vector<build::PackedFragmentBuffer::Index> originalIndex;
+    originalIndex.reserve(reads_.size());
+    for (const SyntheticRead &read : reads_)
+    {
+        const uint64_t clusterId = &read - &reads_.front();
+        const reference::Contig::const_iterator refBegin = contig.begin() + read.position_;
+        io::FragmentHeader header;
+        header.fStrandPosition_ = reference::ReferencePosition(0, read.position_);
+        header.fStrandOriginalPosition_ = header.fStrandPosition_;
+        header.rStrandPosition_ = header.fStrandPosition_ + readLength_ - 1;
+        header.mateFStrandPosition_ = header.fStrandPosition_;
+        header.readLength_ = readLength_;
+        header.cigarLength_ = 1;
+        header.editDistance_ = std::inner_product(
+            read.strandBases_.begin(), read.strandBases_.end(), refBegin, 0, std::plus<unsigned>(), std::not_equal_to<char>());
+        header.alignmentScore_ = 60;
+        header.mapQ_ = 60;
+        header.flags_.reverse_ = read.reverse_;
+        header.barcode_ = 0;
+        header.clusterId_ = clusterId;
+
+        io::FragmentAccessor &fragment = dataBuffer.getFragment(clusterId * fragmentLength);
+        static_cast<io::FragmentHeader &>(fragment) = header;
+        std::transform(read.strandBases_.begin(), read.strandBases_.end(), fragment.basesBegin(),
+                       [](const char base){return (oligo::getValue(base) & 0x03) | (BASE_QUALITY << 2);});
+        *fragment.cigarBegin() = ungappedCigar.front();
+
+        originalIndex.push_back(build::PackedFragmentBuffer::Index(
+            header.fStrandPosition_, clusterId * fragmentLength, clusterId * fragmentLength,
+            fragment.cigarBegin(), fragment.cigarEnd(), read.reverse_));
+    }
+
+    const reference::ReferencePosition binStartPos(0, 0);
+    const reference::ReferencePosition binEndPos(0, contig.size());
+    std::vector<alignment::Cigar> cigars(jobs_);
+    std::vector<std::vector<build::PackedFragmentBuffer::Index> > threadIndexes(jobs_);
+    for (const build::GapRealignerEngine engine : {build::REALIGN_ENGINE_COMBINATORIAL, build::REALIGN_ENGINE_GRAPH})
+    {
+        boost::ptr_vector<build::GapRealigner> realigners;
+        while (realigners.size() != jobs_)
+        {
+            realigners.push_back(new build::GapRealigner(
+                engine, false, false, false, REALIGNED_GAPS_PER_FRAGMENT, 3, 4, 0, barcodeMetadataList));
+            realigners.back().reserve();
+            cigars.at(realigners.size() - 1).reserve(1024);
+        }
+
+        measure(
+            build::REALIGN_ENGINE_GRAPH == engine ? "gapRealigner/graph" : "gapRealigner", "reads", reads_.size(),
+            [&threadIndexes, &originalIndex](const std::size_t threadNumber)
+            {
+                threadIndexes.at(threadNumber) = originalIndex;
+            },
+            [this, &realigners, &cigars, &threadIndexes, &realignerGaps, &dataBuffer, binStartPos, binEndPos](
+                const std::size_t threadNumber)
+            {
+                build::GapRealigner &realigner = realigners.at(threadNumber);
+                alignment::Cigar &cigar = cigars.at(threadNumber);
+                uint64_t checksum = 0;
+                for (build::PackedFragmentBuffer::Index &index : threadIndexes.at(threadNumber))
+                {
+                    reference::ReferencePosition newRStrandPosition;
+                    unsigned short newEditDistance = 0;
+                    cigar.clear();
+                    if (realigner.realign(
+                        realignerGaps, binStartPos, binEndPos, dataBuffer.getFragment(index), index,
+                        newRStrandPosition, newEditDistance, dataBuffer, cigar, contigLists_))
+                    {
+                        checksum += newEditDistance + std::distance(index.cigarBegin_, index.cigarEnd_);
+                    }
+                }
+                return checksum;
+            });
+    }
+}
+
+void BenchmarkWorkflow::benchmarkBgzfCompress()
+{
+    const std::string fastq = makeFastq(reads_);
+    std::vector<std::vector<char> > compressed(jobs_);
+
+    measure(
+        "bgzfCompress", "bytes", fastq.size(),
+        [&compressed, &fastq](const std::size_t threadNumber)
+        {
+            compressed.at(threadNumber).clear();
+            compressed.at(threadNumber).reserve(fastq.size());
+        },
+        [&compressed, &fastq](const std::size_t threadNumber)
+        {
+            namespace bios = boost::iostreams;
+            bios::filtering_ostream bgzfStream;
+            bgzfStream.push(bgzf::BgzfCompressor(bios::gzip::best_speed), 65535, 0);
+            bgzfStream.push(bios::back_inserter(compressed.at(threadNumber)));
+            bgzfStream.write(fastq.data(), fastq.size());
+            bgzfStream.strict_sync();
+            bgzfStream.reset();
+            return uint64_t(compressed.at(threadNumber).size());
+        });
+}
+
+void BenchmarkWorkflow::benchmarkFastqParse()
+{
+    const bfs::path fastqPath = tempDirectory_ / (boost::format("isaac-bench-%d.fastq") % getpid()).str();
+    {
+        const std::string fastq = makeFastq(reads_);
+        std::ofstream os(fastqPath.c_str());
+        if (!os.write(fastq.data(), fastq.size()) || !os.flush())
+        {
+            BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + fastqPath.string()));
+        }
+    }
+
+    const flowcell::ReadMetadataList readMetadataList(1, flowcell::ReadMetadata(1, readLength_, 0, 0));
+    boost::ptr_vector<io::FastqReader> readers;
+    std::vector<std::vector<char> > bcls(jobs_, std::vector<char>(readLength_));
+    while (readers.size() != jobs_)
+    {
+        readers.push_back(new io::FastqReader(false, 1, fastqPath.string().size()));
+    }
+
+    measure(
+        "fastqParse", "reads", reads_.size(),
+        [](const std::size_t){},
+        [&readers, &bcls, &fastqPath, &readMetadataList](const std::size_t threadNumber)
+        {
+            io::FastqReader &reader = readers.at(threadNumber);
+            std::vector<char> &bcl = bcls.at(threadNumber);
+            uint64_t checksum = 0;
+            reader.open(fastqPath, '!');
+            while (reader.hasData())
+            {
+                reader.extractBcl(readMetadataList.front(), bcl.begin());
+                checksum += bcl.front();
+                reader.next();
+            }
+            return checksum;
+        });
+
+    bfs::remove(fastqPath);
+}
+
+void BenchmarkWorkflow::benchmarkBarcodeResolve()
+{
+    std::mt19937 generator(reads_.size());
+
+    flowcell::BarcodeMetadataList barcodeMetadataList(1);
+    barcodeMetadataList.at(0).setFlowcellId("synthetic");
+    barcodeMetadataList.at(0).setLane(1);
+    barcodeMetadataList.at(0).setIndex(0);
+    barcodeMetadataList.at(0).setReferenceIndex(0);
+
+    // barcodes at least 3 mismatches apart so that their 1-mismatch variants don't collide
+    std::vector<std::string> sequences;
+    while (sequences.size() != BARCODE_COUNT)
+    {
+        std::string sequence(BARCODE_LENGTH, 'A');
+        std::generate(sequence.begin(), sequence.end(), [&generator](){return BASES[generator() % 4];});
+        if (sequences.end() == std::find_if(
+            sequences.begin(), sequences.end(),
+            [&sequence](const std::string &other)
+            {
+                return 3 > std::inner_product(
+                    sequence.begin(), sequence.end(), other.begin(), 0, std::plus<unsigned>(), std::not_equal_to<char>());
+            }))
+        {
+            sequences.push_back(sequence);
+            flowcell::BarcodeMetadata barcodeMetadata;
+            barcodeMetadata.setFlowcellId("synthetic");
+            barcodeMetadata.setLane(1);
+            barcodeMetadata.setSampleName((boost::format("sample%d") % sequences.size()).str());
+            barcodeMetadata.setSequence(sequence);
+            barcodeMetadata.setComponentMismatches(std::vector<unsigned>(1, 1));
+            barcodeMetadata.setIndex(barcodeMetadataList.size());
+            barcodeMetadata.setReferenceIndex(0);
+            barcodeMetadataList.push_back(barcodeMetadata);
+        }
+    }
+
+    // most clusters carry a barcode from the sample sheet, some with a mismatch, some are random
+    demultiplexing::Barcodes dataBarcodes;
+    dataBarcodes.reserve(reads_.size());
+    static const oligo::Translator<true> translator = {};
+    while (dataBarcodes.size() != reads_.size())
+    {
+        std::string sequence = sequences.at(generator() % sequences.size());
+        const unsigned kind = generator() % 20;
+        if (!kind)
+        {
+            std::generate(sequence.begin(), sequence.end(), [&generator](){return BASES[generator() % 4];});
+        }
+        else if (kind < 3)
+        {
+            char &base = sequence.at(generator() % sequence.size());
+            base = substitute(base, generator);
+        }
+        demultiplexing::Kmer kmer = 0;
+        for (const char base : sequence)
+        {
+            kmer = (kmer << demultiplexing::BITS_PER_BASE) | translator[base];
+        }
+        dataBarcodes.push_back(demultiplexing::Barcode(kmer, demultiplexing::BarcodeId(0, 0, dataBarcodes.size(), 0)));
+    }
+
+    const flowcell::FlowcellLayoutList flowcellLayoutList;
+    boost::ptr_vector<demultiplexing::BarcodeResolver> resolvers;
+    boost::ptr_vector<demultiplexing::DemultiplexingStats> demultiplexingStats;
+    std::vector<demultiplexing::Barcodes> threadBarcodes(jobs_);
+    while (resolvers.size() != jobs_)
+    {
+        resolvers.push_back(new demultiplexing::BarcodeResolver(barcodeMetadataList, barcodeMetadataList));
+        demultiplexingStats.push_back(new demultiplexing::DemultiplexingStats(flowcellLayoutList, barcodeMetadataList));
+    }
+
+    measure(
+        "barcodeResolve", "barcodes", dataBarcodes.size(),
+        [&threadBarcodes, &dataBarcodes](const std::size_t threadNumber)
+        {
+            threadBarcodes.at(threadNumber) = dataBarcodes;
+        },
+        [&resolvers, &demultiplexingStats, &threadBarcodes](const std::size_t threadNumber)
+        {
+            demultiplexing::Barcodes &barcodes = threadBarcodes.at(threadNumber);
+            resolvers.at(threadNumber).resolve(barcodes, demultiplexingStats.at(threadNumber));
+            uint64_t checksum = 0;
+            for (const demultiplexing::Barcode &barcode : barcodes)
+            {
+                checksum += barcode.getBarcode();
+            }
+            return checksum;
+        });
+}
+
+/**
+ * \brief Counts the reference kmers falling into each bucket of the policy and times the bucket computation and
+ *        the full seed lookup with the policy in place.
+ */
+template <typename HashPolicyT>
+void BenchmarkWorkflow::benchmarkHashPolicy(const uint64_t bucketCount)
+{
+    typedef reference::ReferenceHash<KmerT, common::NumaAllocator<void, common::numa::defaultNodeInterleave>, HashPolicyT> PolicyHash;
+    const reference::ContigList &contigList = contigLists_.at(0);
+    const reference::Contig &contig = contigList.at(0);
+    const HashPolicyT hashPolicy(bucketCount, KmerT::KMER_BASES);
+
+    std::vector<uint32_t> bucketKmers(bucketCount, 0);
+    uint64_t bits = 0;
+    uint64_t kmers = 0;
+    for (std::size_t i = 0; contig.size() != i; ++i)
+    {
+        bits = ((bits << oligo::BITS_PER_BASE) | oligo::getValue(contig[i])) & KmerT::BITS_MASK();
+        if (KmerT::KMER_BASES <= i + 1)
+        {
+            ++bucketKmers[hashPolicy(bits)];
+            ++kmers;
+        }
+    }
+
+    benchmarkWorkflow::HashOccupancy occupancy = {HashPolicyT::name(), bucketCount, 0, 0, 0.0};
+    double squares = 0.0;
+    for (const uint32_t count : bucketKmers)
+    {
+        occupancy.usedBuckets_ += bool(count);
+        occupancy.maxBucketKmers_ = std::max<uint64_t>(occupancy.maxBucketKmers_, count);
+        squares += double(count) * count;
+    }
+    occupancy.probedKmers_ = kmers ? squares / kmers : 0.0;
+    hashOccupancy_.push_back(occupancy);
+    ISAAC_THREAD_CERR << "Hash " << hashPolicy << ": " << occupancy.usedBuckets_ << " of " << bucketCount <<
+        " buckets used, largest has " << occupancy.maxBucketKmers_ << " kmers, " << occupancy.probedKmers_ <<
+        " kmers per probe" << std::endl;
+
+    std::vector<KmerT> seeds;
+    generateSeeds(reads_, seeds);
+
+    reference::ReferenceHasher<PolicyHash> hasher(contigList, threads_, jobs_);
+    const PolicyHash referenceHash = hasher.generate(bucketCount);
+    measure(
+        std::string("keyFromKmer/") + HashPolicyT::name(), "seeds", seeds.size(),
+        [](const std::size_t){},
+        [&referenceHash, &seeds](const std::size_t)
+        {
+            uint64_t checksum = 0;
+            for (const KmerT &seed : seeds)
+            {
+                checksum += referenceHash.keyFromKmer(seed);
+            }
+            return checksum;
+        });
+
+    measure(
+        std::string("findMatches/") + HashPolicyT::name(), "seeds", seeds.size(),
+        [](const std::size_t){},
+        [&referenceHash, &seeds](const std::size_t)
+        {
+            uint64_t checksum = 0;
+            typename PolicyHash::MatchRange fwMatches;
+            typename PolicyHash::MatchRange rvMatches;
+            for (const KmerT &seed : seeds)
+            {
+                referenceHash.findMatches(seed, fwMatches, rvMatches);
+                checksum += std::distance(fwMatches.first, fwMatches.second) + std::distance(rvMatches.first, rvMatches.second);
+            }
+            return checksum;
+        });
+}
+
+void BenchmarkWorkflow::benchmarkHashPolicies()
+{
+    const uint64_t bucketCount = getBucketCount(contigLists_.at(0));
+    benchmarkHashPolicy<reference::referenceHash::ModuloPrime>(bucketCount);
+    benchmarkHashPolicy<reference::referenceHash::MultiplyShift>(bucketCount);
+    benchmarkHashPolicy<reference::referenceHash::FastRange>(bucketCount);
+    benchmarkHashPolicy<reference::referenceHash::PowerOfTwo>(bucketCount);
+}
+
+void BenchmarkWorkflow::storeResults(std::ostream &os) const
+{
+    const reference::ContigList &contigList = contigLists_.at(0);
+    os << "{\n\"benchmark\":\"isaac-bench\",\"version\":\"" << iSAAC_VERSION_FULL << "\",\"isa\":\"" << getInstructionSet() <<
+        "\",\"threads\":" << jobs_ << ",\"referenceLength\":" << contigList.endOffset() <<
+        ",\"readLength\":" << readLength_ << ",\"reads\":" << reads_.size() << ",\"repeats\":" << repeats_ <<
+        ",\n\"kernels\":[";
+    for (const KernelResult &result : results_)
+    {
+        os << (&result == &results_.front() ? "\n" : ",\n") <<
+            boost::format("{\"name\":\"%s\",\"unit\":\"%s\",\"items\":%d,\"seconds\":%.6f,"
+                "\"itemsPerSecond\":%.1f,\"itemsPerSecondPerCore\":%.1f,\"checksum\":%d}") %
+            result.name_ % result.unit_ % result.items_ % result.seconds_ %
+            (double(result.items_) / result.seconds_) % (double(result.items_) / result.seconds_ / jobs_) % result.checksum_;
+    }
+    os << "\n]";
+    if (!hashOccupancy_.empty())
+    {
+        os << ",\n\"hashOccupancy\":[";
+        for (const benchmarkWorkflow::HashOccupancy &occupancy : hashOccupancy_)
+        {
+            os << (&occupancy == &hashOccupancy_.front() ? "\n" : ",\n") <<
+                boost::format("{\"policy\":\"%s\",\"buckets\":%d,\"usedBuckets\":%d,\"maxBucketKmers\":%d,"
+                    "\"probedKmers\":%.3f}") %
+                occupancy.policy_ % occupancy.buckets_ % occupancy.usedBuckets_ % occupancy.maxBucketKmers_ % occupancy.probedKmers_;
+        }
+        os << "\n]";
+    }
+    os << "}" << std::endl;
+}
+
+uint64_t BenchmarkWorkflow::getReferenceLengthMin(const unsigned readLength)
+{
+    return readLength + benchmarkWorkflow::INDEL_LENGTH_MAX + benchmarkWorkflow::REFERENCE_MARGIN * 2 + 1;
+}
+
+void BenchmarkWorkflow::run()
+{
+    if (isSelected("findMatches") || isSelected("findReadMatches"))
+    {
+        benchmarkHash(isSelected("findMatches"), isSelected("findReadMatches"));
+    }
+    if (isSelected("countMismatchesFast"))
+    {
+        benchmarkCountMismatches();
+    }
+    if (isSelected("bandedSmithWaterman"))
+    {
+        benchmarkBandedSmithWaterman();
+    }
+    if (isSelected("gapRealigner"))
+    {
+        benchmarkGapRealigner();
+    }
+    if (isSelected("bgzfCompress"))
+    {
+        benchmarkBgzfCompress();
+    }
+    if (isSelected("fastqParse"))
+    {
+        benchmarkFastqParse();
+    }
+    if (isSelected("barcodeResolve"))
+    {
+        benchmarkBarcodeResolve();
+    }
+    if (isSelected("hashPolicies"))
+    {
+        benchmarkHashPolicies();
+    }
+
+    if ("-" == output_)
+    {
+        storeResults(std::cout);
+        return;
+    }
+
+    std::ofstream os(output_.c_str());
+    storeResults(os);
+    if (!os)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write benchmark results to " + output_));
+    }
+}
+
+} // namespace workflow
+} // namespace isaac
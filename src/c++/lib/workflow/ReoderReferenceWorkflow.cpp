@@ -24,6 +24,7 @@
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
 #include "reference/ContigLoader.hh"
+#include "reference/PackedReference.hh"
 #include "workflow/ReorderReferenceWorkflow.hh"
 
 namespace isaac
@@ -31,15 +32,21 @@ namespace isaac
 namespace workflow
 {
 
+const std::size_t ReorderReferenceWorkflow::COPY_CHUNK_SIZE;
+
 ReorderReferenceWorkflow::ReorderReferenceWorkflow(
     const bfs::path &sortedReferenceMetadata,
     const bfs::path &newXmlPath,
     const bfs::path &newDataFileDirectory,
-    const std::vector<std::string> &newOrder
+    const std::vector<std::string> &newOrder,
+    const bool packedCache,
+    const unsigned jobs
     )
     : sortedReferenceMetadata_(sortedReferenceMetadata),
       newXmlPath_(newXmlPath),
       newDataFileDirectory_(newDataFileDirectory),
+      packedCache_(packedCache),
+      jobs_(jobs),
       xml_(reference::loadReferenceMetadataFromXml(sortedReferenceMetadata_))
 {
     const reference::SortedReferenceMetadata::Contigs &contigs = xml_.getContigs();
@@ -113,6 +120,28 @@ ReorderReferenceWorkflow::ReorderReferenceWorkflow(
     }
 }
 
+static bool endsWithNewLine(const reference::SortedReferenceMetadata::Contig &xmlContig)
+{
+    if (!xmlContig.size_)
+    {
+        // nothing but the header line
+        return true;
+    }
+    std::ifstream ifs(xmlContig.filePath_.c_str(), std::ios_base::binary);
+    if (!ifs || !ifs.seekg(xmlContig.offset_ + xmlContig.size_ - 1))
+    {
+        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to seek to position " +
+            std::to_string(xmlContig.offset_ + xmlContig.size_ - 1) + " in the input file: " + xmlContig.filePath_.string()));
+    }
+    const int last = ifs.get();
+    if (!ifs)
+    {
+        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to read the last byte of " + xmlContig.name_ +
+            " from input file: " + xmlContig.filePath_.string()));
+    }
+    return '\n' == last;
+}
+
 void ReorderReferenceWorkflow::run()
 {
     std::ofstream xmlOs(newXmlPath_.c_str());
@@ -122,45 +151,114 @@ void ReorderReferenceWorkflow::run()
     }
 
     const boost::filesystem::path targetPath = newDataFileDirectory_ / xml_.getContigs().front().filePath_.filename();
-    std::ofstream ofs(targetPath.c_str(), std::ios_base::binary);
+
+    // the layout of the new fasta is known upfront, so the pieces can be copied in any order
+    std::vector<CopyChunk> chunks;
+    uint64_t targetOffset = 0;
     std::size_t newIndex = 0;
     for(unsigned idx: originalIndexes_)
     {
         reference::SortedReferenceMetadata::Contig &xmlContig = xml_.getContigs().at(idx);
-        std::ifstream ifs(xmlContig.filePath_.c_str(), std::ios_base::binary);
-        if (!ifs)
+        const std::string header = ">" + xmlContig.name_ + "\n";
+        targetOffset += header.size();
+        // otherwise the next header would end up on the last line of the contig
+        const bool newLine = !endsWithNewLine(xmlContig);
+        uint64_t copied = 0;
+        do
         {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open input file: " + xmlContig.filePath_.string()));
+            const uint64_t size = std::min<uint64_t>(COPY_CHUNK_SIZE, xmlContig.size_ - copied);
+            const CopyChunk chunk =
+            {
+                xmlContig.filePath_, xmlContig.offset_ + copied, targetOffset + copied,
+                size, copied ? std::string() : header, newLine && xmlContig.size_ == copied + size
+            };
+            chunks.push_back(chunk);
+            copied += chunk.size_;
+        } while (xmlContig.size_ != copied);
+
+        xmlContig.offset_ = targetOffset;
+        xmlContig.size_ += newLine;
+        targetOffset += xmlContig.size_;
+        xmlContig.filePath_ = targetPath;
+        xmlContig.index_ = newIndex++;
+    }
+
+    {
+        std::ofstream ofs(targetPath.c_str(), std::ios_base::binary);
+        if (!ofs)
+        {
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open output file: " + targetPath.string()));
         }
-        ifs.seekg(xmlContig.offset_);
+    }
+    boost::filesystem::resize_file(targetPath, targetOffset);
+
+    std::size_t nextChunk = 0;
+    boost::mutex mutex;
+    common::ThreadVector threads(std::max<std::size_t>(1, std::min<std::size_t>(jobs_, chunks.size())));
+    threads.execute(boost::bind(&ReorderReferenceWorkflow::copyChunksThread, this,
+                                boost::cref(chunks), boost::cref(targetPath), boost::ref(nextChunk), boost::ref(mutex)));
+
+    for(unsigned idx: originalIndexes_)
+    {
+        ISAAC_THREAD_CERR << "Copied " << xml_.getContigs().at(idx) << std::endl;
+    }
+
+    std::sort(xml_.getContigs().begin(), xml_.getContigs().end(),
+            [](const reference::SortedReferenceMetadata::Contig &left,
+                    const reference::SortedReferenceMetadata::Contig &right){return left.index_ < right.index_;});
+
+    if (packedCache_)
+    {
+        reference::PackedReference::store(xml_.getContigs(), targetPath);
+    }
+
+    saveSortedReferenceXml(xmlOs, xml_);
+}
+
+void ReorderReferenceWorkflow::copyChunksThread(
+    const std::vector<CopyChunk> &chunks,
+    const bfs::path &targetPath,
+    std::size_t &nextChunk,
+    boost::mutex &mutex) const
+{
+    std::vector<char> buffer(COPY_CHUNK_SIZE);
+    std::fstream ofs(targetPath.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    if (!ofs)
+    {
+        BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open output file: " + targetPath.string()));
+    }
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (chunks.size() != nextChunk)
+    {
+        const CopyChunk &chunk = chunks.at(nextChunk++);
+        common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+
+        std::ifstream ifs(chunk.sourcePath_.c_str(), std::ios_base::binary);
         if (!ifs)
         {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to seek to position " + std::to_string(xmlContig.offset_) +
-                " in the input file: " + xmlContig.filePath_.string()));
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to open input file: " + chunk.sourcePath_.string()));
         }
-        ofs << ">" << xmlContig.name_ << std::endl;
-        if (!ifs)
+        if (!ifs.seekg(chunk.sourceOffset_))
         {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to write contig name " + xmlContig.name_ +
-                " into the output file: " + xmlContig.filePath_.string()));
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to seek to position " + std::to_string(chunk.sourceOffset_) +
+                " in the input file: " + chunk.sourcePath_.string()));
         }
-        xmlContig.offset_ = ofs.tellp();
-        std::copy_n(std::istreambuf_iterator<char>(ifs), xmlContig.size_, std::ostreambuf_iterator<char>(ofs));
-        if (!ifs)
+        if (!ifs.read(&buffer.front(), chunk.size_))
         {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to copy" + std::to_string(xmlContig.size_) +
-                " bytes from input file: " + xmlContig.filePath_.string() +
-                " into the output file: " + targetPath.string()));
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to read " + std::to_string(chunk.size_) +
+                " bytes from input file: " + chunk.sourcePath_.string()));
+        }
+        if (!ofs.seekp(chunk.targetOffset_ - chunk.header_.size()) ||
+            !ofs.write(chunk.header_.c_str(), chunk.header_.size()) ||
+            !ofs.write(&buffer.front(), chunk.size_) ||
+            (chunk.newLine_ && !ofs.put('\n')) ||
+            !ofs.flush())
+        {
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(errno, "Failed to write " + std::to_string(chunk.size_) +
+                " bytes into the output file: " + targetPath.string()));
         }
-        xmlContig.filePath_ = targetPath;
-        xmlContig.index_ = newIndex++;
-        ISAAC_THREAD_CERR << "Copied " << xmlContig << std::endl;
     }
-    std::sort(xml_.getContigs().begin(), xml_.getContigs().end(),
-            [](const reference::SortedReferenceMetadata::Contig &left,
-                    const reference::SortedReferenceMetadata::Contig &right){return left.index_ < right.index_;});
-
-    saveSortedReferenceXml(xmlOs, xml_);
 }
 
 } // namespace workflow
@@ -0,0 +1,274 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file SimulateRunWorkflow.cpp
+ **
+ ** \brief see SimulateRunWorkflow.hh
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include <algorithm>
+#include <fstream>
+
+#include <boost/format.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "common/Debug.hh"
+#include "common/Exceptions.hh"
+#include "common/FileSystem.hh"
+#include "workflow/SimulateRunWorkflow.hh"
+
+namespace isaac
+{
+namespace workflow
+{
+
+namespace bios = boost::iostreams;
+
+namespace simulateRunWorkflow
+{
+
+static const char BASES[] = {'A', 'C', 'G', 'T'};
+// length of the diverged copies that make the repeats
+static const unsigned REPEAT_LENGTH = 1000;
+// divergence of the repeat copies from the source
+static const double REPEAT_DIVERGENCE = 0.02;
+static const unsigned INDEL_LENGTH_MAX = 4;
+static const unsigned FASTA_LINE_LENGTH = 70;
+static const char QUALITY = '!' + 35;
+
+char complement(const char base)
+{
+    return 'A' == base ? 'T' : 'C' == base ? 'G' : 'G' == base ? 'C' : 'T' == base ? 'A' : base;
+}
+
+std::string reverseComplement(const std::string &sequence)
+{
+    std::string ret(sequence.size(), 'N');
+    std::transform(sequence.rbegin(), sequence.rend(), ret.begin(), &complement);
+    return ret;
+}
+
+void openFastq(const bfs::path &path, bios::filtering_ostream &stream)
+{
+    bios::file_sink sink(path.string(), std::ios_base::binary);
+    if (!sink.is_open())
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to open " + path.string()));
+    }
+    stream.push(bios::gzip_compressor(bios::gzip::best_speed));
+    stream.push(sink);
+}
+
+/**
+ * \brief Flushes the compressor and closes the file. The gzip footer is written only at this point.
+ */
+void closeFastq(const bfs::path &path, bios::filtering_ostream &stream)
+{
+    if (!stream)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + path.string()));
+    }
+    try
+    {
+        stream.reset();
+    }
+    catch (const std::ios_base::failure &e)
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to close " + path.string() + ": " + e.what()));
+    }
+}
+
+} // namespace simulateRunWorkflow
+
+using namespace simulateRunWorkflow;
+
+SimulateRunWorkflow::SimulateRunWorkflow(
+    const bfs::path &outputDirectory,
+    const uint64_t referenceLength,
+    const unsigned contigs,
+    const double repeatFraction,
+    const unsigned readLength,
+    const unsigned clusters,
+    const unsigned fragmentLengthMean,
+    const unsigned fragmentLengthSd,
+    const double errorRate,
+    const double indelRate,
+    const double duplicateRate,
+    const unsigned seed)
+    : outputDirectory_(outputDirectory)
+    , referenceLength_(referenceLength)
+    , contigCount_(contigs)
+    , repeatFraction_(repeatFraction)
+    , readLength_(readLength)
+    , clusters_(clusters)
+    , fragmentLengthMean_(fragmentLengthMean)
+    , fragmentLengthSd_(fragmentLengthSd)
+    , errorRate_(errorRate)
+    , indelRate_(indelRate)
+    , duplicateRate_(duplicateRate)
+    , generator_(seed)
+{
+}
+
+void SimulateRunWorkflow::run()
+{
+    const bfs::path fastqDirectory = outputDirectory_ / "Fastq";
+    std::vector<bfs::path> createList;
+    createList.push_back(outputDirectory_);
+    createList.push_back(fastqDirectory);
+    common::createDirectories(createList);
+
+    ISAAC_THREAD_CERR << "Generating " << referenceLength_ << " bases of reference in " << contigCount_ << " contigs" << std::endl;
+    generateReference();
+    storeReference(outputDirectory_ / "genome.fa");
+    ISAAC_THREAD_CERR << "Generating " << clusters_ << " read pairs of length " << readLength_ << std::endl;
+    generateFastq(fastqDirectory / "lane1_read1.fastq.gz", fastqDirectory / "lane1_read2.fastq.gz");
+    ISAAC_THREAD_CERR << "Generating synthetic run done" << std::endl;
+}
+
+void SimulateRunWorkflow::generateReference()
+{
+    std::uniform_int_distribution<unsigned> baseDistribution(0, 3);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const uint64_t contigLength = referenceLength_ / contigCount_;
+    // each repeat copy takes REPEAT_LENGTH bases, space them so that they cover repeatFraction_ of the contig
+    const uint64_t repeatSpacing = repeatFraction_ ? uint64_t(REPEAT_LENGTH / repeatFraction_) : contigLength;
+
+    for (unsigned i = 0; contigCount_ != i; ++i)
+    {
+        std::string contig(contigLength, 'N');
+        std::generate(contig.begin(), contig.end(), [this, &baseDistribution](){return BASES[baseDistribution(generator_)];});
+        for (uint64_t repeatBegin = repeatSpacing; repeatBegin + REPEAT_LENGTH < contigLength; repeatBegin += repeatSpacing)
+        {
+            const uint64_t source = std::uniform_int_distribution<uint64_t>(0, repeatBegin - REPEAT_LENGTH)(generator_);
+            for (unsigned offset = 0; REPEAT_LENGTH != offset; ++offset)
+            {
+                contig[repeatBegin + offset] = REPEAT_DIVERGENCE > uniform(generator_) ?
+                    BASES[baseDistribution(generator_)] : contig[source + offset];
+            }
+        }
+        contigs_.push_back(contig);
+    }
+}
+
+void SimulateRunWorkflow::storeReference(const bfs::path &fastaPath) const
+{
+    std::ofstream os(fastaPath.c_str());
+    for (const std::string &contig : contigs_)
+    {
+        os << ">chr" << (&contig - &contigs_.front() + 1) << "\n";
+        for (uint64_t offset = 0; contig.size() > offset; offset += FASTA_LINE_LENGTH)
+        {
+            os.write(contig.data() + offset, std::min<uint64_t>(FASTA_LINE_LENGTH, contig.size() - offset)) << "\n";
+        }
+    }
+    if (!os.flush())
+    {
+        BOOST_THROW_EXCEPTION(common::IoException(errno, "Failed to write " + fastaPath.string()));
+    }
+}
+
+/**
+ * \brief Copies length bases of the fragment starting at position and applies germline indels to it
+ */
+std::string SimulateRunWorkflow::makeFragment(const std::string &contig, const uint64_t position, const unsigned length)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<unsigned> indelLengthDistribution(1, INDEL_LENGTH_MAX);
+    std::string ret;
+    ret.reserve(length + INDEL_LENGTH_MAX);
+    for (uint64_t offset = position; ret.size() < length && contig.size() > offset; ++offset)
+    {
+        if (indelRate_ > uniform(generator_))
+        {
+            const unsigned indelLength = indelLengthDistribution(generator_);
+            if (uniform(generator_) < 0.5)
+            {
+                offset += indelLength;
+                continue;
+            }
+            for (unsigned i = 0; indelLength != i; ++i)
+            {
+                ret.push_back(BASES[generator_() % 4]);
+            }
+        }
+        ret.push_back(contig[offset]);
+    }
+    ret.resize(length, 'N');
+    return ret;
+}
+
+void SimulateRunWorkflow::addSequencingErrors(std::string &read)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (char &base : read)
+    {
+        if (errorRate_ > uniform(generator_))
+        {
+            base = BASES[(std::find(BASES, BASES + 4, base) - BASES + 1 + generator_() % 3) % 4];
+        }
+    }
+}
+
+void SimulateRunWorkflow::generateFastq(const bfs::path &read1Path, const bfs::path &read2Path)
+{
+    std::normal_distribution<double> fragmentLengthDistribution(fragmentLengthMean_, fragmentLengthSd_);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::discrete_distribution<unsigned> contigDistribution(contigCount_, 0.0, 1.0, [](double){return 1.0;});
+    const unsigned fragmentLengthMax = fragmentLengthMean_ + fragmentLengthSd_ * 4;
+
+    bios::filtering_ostream read1Stream;
+    openFastq(read1Path, read1Stream);
+    bios::filtering_ostream read2Stream;
+    openFastq(read2Path, read2Stream);
+
+    unsigned contigIndex = 0;
+    uint64_t position = 0;
+    unsigned fragmentLength = 0;
+    bool reverse = false;
+    std::string fragment;
+    for (unsigned cluster = 0; clusters_ != cluster; ++cluster)
+    {
+        if (!cluster || duplicateRate_ <= uniform(generator_))
+        {
+            contigIndex = contigDistribution(generator_);
+            fragmentLength = std::max<double>(
+                readLength_, std::min<double>(fragmentLengthMax, fragmentLengthDistribution(generator_)));
+            position = std::uniform_int_distribution<uint64_t>(
+                0, contigs_.at(contigIndex).size() - fragmentLength - INDEL_LENGTH_MAX)(generator_);
+            reverse = uniform(generator_) < 0.5;
+            fragment = makeFragment(contigs_.at(contigIndex), position, fragmentLength);
+        }
+        // duplicates reuse the previous fragment, only the sequencing errors differ
+        std::string forwardRead = fragment.substr(0, readLength_);
+        std::string reverseRead = reverseComplement(fragment.substr(fragmentLength - readLength_));
+        addSequencingErrors(forwardRead);
+        addSequencingErrors(reverseRead);
+
+        const std::string name = (boost::format("@sim:%d:chr%d:%d:%c") %
+            cluster % (contigIndex + 1) % (position + 1) % (reverse ? 'R' : 'F')).str();
+        const std::string quality(readLength_, QUALITY);
+
+        read1Stream << name << "/1\n" << (reverse ? reverseRead : forwardRead) << "\n+\n" << quality << "\n";
+        read2Stream << name << "/2\n" << (reverse ? forwardRead : reverseRead) << "\n+\n" << quality << "\n";
+    }
+
+    closeFastq(read1Path, read1Stream);
+    closeFastq(read2Path, read2Stream);
+}
+
+} // namespace workflow
+} // namespace isaac
@@ -19,6 +19,7 @@
 
 #include <boost/foreach.hpp>
 
+#include "common/Trace.hh"
 #include "workflow/alignWorkflow/BclBgzfDataSource.hh"
 
 namespace isaac
@@ -234,7 +235,12 @@ void BclBgzfBaseCallsSource::loadClusters(
         currentLaneNumber_ = tileMetadata.getLane();
     }
 
-    bclMapper_.mapTile(flowcell_, tileMetadata);
+    // bci mappers are loaded for the current lane only. Don't prefetch across the lane boundary.
+    const std::size_t nextTileIndex = tileMetadata.getOriginalIndex() + 1;
+    const flowcell::TileMetadata *nextTileMetadata =
+        flowcellTiles_.size() > nextTileIndex && flowcellTiles_.at(nextTileIndex).getLane() == currentLaneNumber_ ?
+            &flowcellTiles_.at(nextTileIndex) : 0;
+    bclMapper_.mapTile(flowcell_, tileMetadata, nextTileMetadata);
     ISAAC_THREAD_CERR << "Loading Bcl data done for " << tileMetadata << std::endl;
 
     ISAAC_THREAD_CERR << "Loading Filter data for " << tileMetadata << std::endl;
@@ -287,7 +293,10 @@ void BclBgzfBaseCallsSource::bclToClusters(
 
     ISAAC_THREAD_CERR << "Transposing Bcl data for " << tileMetadata.getClusterCount() << " bcl clusters" << std::endl;
     const clock_t startTranspose = clock();
-    bclMapper_.transpose(bclData.addMoreClusters(tileMetadata.getClusterCount()));
+    {
+        ISAAC_TRACE_SPAN("bclTranspose");
+        bclMapper_.transpose(bclData.addMoreClusters(tileMetadata.getClusterCount()));
+    }
     ISAAC_THREAD_CERR << "Transposing Bcl data done for " << bclData.getClusterCount() << " bcl clusters in " << (clock() - startTranspose) / 1000 << "ms" << std::endl;
 
     ISAAC_THREAD_CERR << "Extracting Pf values for " << tileMetadata.getClusterCount() << " bcl clusters" << std::endl;
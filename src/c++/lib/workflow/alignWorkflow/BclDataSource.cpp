@@ -19,6 +19,7 @@
 
 #include <boost/foreach.hpp>
 
+#include "common/Trace.hh"
 #include "workflow/alignWorkflow/BclDataSource.hh"
 
 namespace isaac
@@ -152,7 +153,10 @@ void BclBaseCallsSource::loadClusters(
 {
     ISAAC_THREAD_CERR << "Loading Bcl data for " << tileMetadata << std::endl;
 
-    bclMapper_.mapTile(flowcell_, tileMetadata);
+    const flowcell::TileMetadataList &flowcellTiles = tileSource_.flowcellTiles();
+    const std::size_t nextTileIndex = tileMetadata.getOriginalIndex() + 1;
+    bclMapper_.mapTile(flowcell_, tileMetadata,
+                       flowcellTiles.size() > nextTileIndex ? &flowcellTiles.at(nextTileIndex) : 0);
     ISAAC_THREAD_CERR << "Loading Bcl data done for " << tileMetadata << std::endl;
 
     ISAAC_THREAD_CERR << "Loading Filter data for " << tileMetadata << std::endl;
@@ -204,7 +208,10 @@ void BclBaseCallsSource::bclToClusters(
 
     ISAAC_THREAD_CERR << "Transposing Bcl data for " << tileMetadata.getClusterCount() << " bcl clusters" << std::endl;
     const clock_t startTranspose = clock();
-    bclMapper_.transpose(bclData.addMoreClusters(tileMetadata.getClusterCount()));
+    {
+        ISAAC_TRACE_SPAN("bclTranspose");
+        bclMapper_.transpose(bclData.addMoreClusters(tileMetadata.getClusterCount()));
+    }
     ISAAC_THREAD_CERR << "Transposing Bcl data done for " << bclData.getClusterCount() << " bcl clusters in " << (clock() - startTranspose) / 1000 << "ms" << std::endl;
 
     ISAAC_THREAD_CERR << "Extracting Pf values for " << tileMetadata.getClusterCount() << " bcl clusters" << std::endl;
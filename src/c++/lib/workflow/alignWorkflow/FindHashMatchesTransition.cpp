@@ -17,6 +17,8 @@
  ** \author Roman Petrovski
  **/
 
+#include <chrono>
+
 #include <boost/ref.hpp>
 
 #include "alignment/HashMatchFinder.hh"
@@ -26,6 +28,7 @@
 #include "common/Debug.hh"
 #include "common/Exceptions.hh"
 #include "common/Numa.hh"
+#include "common/Trace.hh"
 #include "demultiplexing/DemultiplexingStatsXml.hh"
 #include "flowcell/Layout.hh"
 #include "flowcell/ReadMetadata.hh"
@@ -125,10 +128,12 @@ void IoOverlapThreadWorker::run(
 //        ISAAC_BLOCK_WITH_CLENAUP([this](bool){release(loading_, stateChangedCondition_);})
         {
             wait(loading_, stateChangedCondition_, lock, forceTermination_);
+            const std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
             {
                 common::ScopedMallocBlockUnblock unblockMalloc(mallocBlock);
                 common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
 
+                ISAAC_TRACE_SPAN("tileLoad");
                 dataSource.resetBclData(tileMetadata, tileClusters_);
                 dataSource.loadClusters(tileMetadata, tileClusters_);
                 if(qScoreBin_)
@@ -136,6 +141,9 @@ void IoOverlapThreadWorker::run(
                     binQscores(tileClusters_);
                 }
             }
+            // lock is held again, the tile stats are safe to update
+            matchSelector_.recordTileLoad(
+                tileMetadata, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count());
         }
 
         ISAAC_BLOCK_WITH_CLENAUP([&](bool exceptionUnwinding)
@@ -181,6 +189,7 @@ void IoOverlapThreadWorker::run(
             }
             {
                 common::unlock_guard<boost::unique_lock<boost::mutex> > unlock(lock);
+                ISAAC_TRACE_SPAN("binFlush");
                 fragmentStorage_.flush();
             }
         }
@@ -191,6 +200,9 @@ void IoOverlapThreadWorker::run(
 
 FindHashMatchesTransition::FindHashMatchesTransition(
     const std::size_t hashTableBucketCount,
+    const bool canonicalKmerHash,
+    const bool kmerFingerprints,
+    const unsigned seedMinimizerWindow,
     const flowcell::FlowcellLayoutList &flowcellLayoutList,
     const flowcell::BarcodeMetadataList &barcodeMetadataList,
     const bool cleanupIntermediary,
@@ -231,6 +243,7 @@ FindHashMatchesTransition::FindHashMatchesTransition(
     const bool clipOverlapping,
     const bool scatterRepeats,
     const bool rescueShadows,
+    const bool bitParallelShadowRescue,
     const bool trimPEAdapters,
     const bool anchorMate,
     const unsigned gappedMismatchesMax,
@@ -251,12 +264,16 @@ FindHashMatchesTransition::FindHashMatchesTransition(
     const unsigned detectTemplateBlockSize
     )
     : hashTableBucketCount_(hashTableBucketCount)
+    , canonicalKmerHash_(canonicalKmerHash)
+    , kmerFingerprints_(kmerFingerprints)
+    , seedMinimizerWindow_(seedMinimizerWindow)
     , flowcellLayoutList_(flowcellLayoutList)
     , tempDirectory_(tempDirectory)
     , demultiplexingStatsXmlPath_(demultiplexingStatsXmlPath)
     , coresMax_(maxThreadCount)
     , candidateMatchesMax_(candidateMatchesMax)
     , matchFinderMaxRepeats_(std::max(matchFinderTooManyRepeats, std::max(matchFinderWayTooManyRepeats, matchFinderShadowSplitRepeats)))
+    , matchFinderMinRepeats_(std::min(matchFinderTooManyRepeats, std::min(matchFinderWayTooManyRepeats, matchFinderShadowSplitRepeats)))
     , seedBaseQualityMin_(seedBaseQualityMin)
     , seedLength_(seedLength)
     , repeatThreshold_(repeatThreshold)
@@ -317,6 +334,7 @@ FindHashMatchesTransition::FindHashMatchesTransition(
         clipOverlapping,
         scatterRepeats,
         rescueShadows,
+        bitParallelShadowRescue,
         trimPEAdapters,
         anchorMate,
         gappedMismatchesMax,
@@ -405,6 +423,7 @@ void FindHashMatchesTransition::resolveBarcodes(
     alignment::matchFinder::TileClusterInfo &tileClusterInfo,
     demultiplexing::DemultiplexingStats &demultiplexingStats)
 {
+    ISAAC_TRACE_SPAN("barcodeResolve");
     ISAAC_ASSERT_MSG(!barcodeGroup.empty(), "At least 'none' barcode must be defined");
     if (1 == barcodeGroup.size())
     {
@@ -495,12 +514,16 @@ template <typename ReferenceHashT>
 ReferenceHashT buildReferenceHash(
     const reference::ContigList &contigList,
     const std::size_t hashTableBucketCount,
+    const bool canonicalKmerHash,
+    const bool kmerFingerprints,
+    const std::size_t repeatFilterThreshold,
     common::ThreadVector &threads,
     const unsigned coresMax)
 {
+    ISAAC_TRACE_SPAN("hashBuild");
     reference::ReferenceHasher<ReferenceHashT> hasher(contigList, threads, coresMax);
 
-    ReferenceHashT ret = hasher.generate(hashTableBucketCount);
+    ReferenceHashT ret = hasher.generate(hashTableBucketCount, canonicalKmerHash, kmerFingerprints, repeatFilterThreshold);
 
     return ret;
 }
@@ -534,7 +557,7 @@ void FindHashMatchesTransition::findLaneMatches(
         ISAAC_THREAD_CERR << "Finding hash matches with repeat threshold: " << repeatThreshold_ << std::endl;
 
         alignment::ClusterHashMatchFinder<ReferenceHashT, SEEDS_PER_MATCH_MAX> matchFinder(
-            referenceHash, candidateMatchesMax_, seedBaseQualityMin_, matchFinderMaxRepeats_);
+            referenceHash, candidateMatchesMax_, seedBaseQualityMin_, matchFinderMaxRepeats_, seedMinimizerWindow_);
 
         matchSelector_.reserveMemory(unprocessedTiles);
 
@@ -787,7 +810,9 @@ void FindHashMatchesTransition::align(
 
     typedef reference::ReferenceHash<KmerT, common::NumaAllocator<void, common::numa::defaultNodeInterleave> > ReferenceHash;
     const ReferenceHash referenceHash(buildReferenceHash<ReferenceHash>(
-        contigLists_.node0Container().front(), hashTableBucketCount_, threads_, coresMax_));
+        contigLists_.node0Container().front(), hashTableBucketCount_, canonicalKmerHash_, kmerFingerprints_,
+        // seeds are never probed with a lower repeat threshold than this
+        matchFinderMinRepeats_, threads_, coresMax_));
 
     FoundMatchesMetadata ret(tempDirectory_, barcodeMetadataList_, 1, sortedReferenceMetadataList_);
     demultiplexing::DemultiplexingStats demultiplexingStats(flowcellLayoutList_, barcodeMetadataList_);
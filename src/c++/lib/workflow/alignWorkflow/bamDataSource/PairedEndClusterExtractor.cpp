@@ -61,12 +61,7 @@ void TempFileClusterExtractor::open(const boost::filesystem::path &tempFilePath,
 
             resize(expectedFileSize);
 
-            for (std::vector<char>::const_iterator it = begin(); end() != it; it = getNextRecord(it))
-            {
-                recordIndex_.push_back(it);
-            }
-
-            std::sort(recordIndex_.begin(), recordIndex_.end(), compareNameAndRead);
+            indexRecords();
             ISAAC_THREAD_CERR << "TempFileClusterExtractor::open: " << recordIndex_.size() << " " << tempFilePath << std::endl;
         }
         else
@@ -78,6 +73,82 @@ void TempFileClusterExtractor::open(const boost::filesystem::path &tempFilePath,
     tempFilePath_ = tempFilePath.c_str();
 }
 
+/**
+ * \brief takes the records that never made it to the temp file. records is left empty with its capacity intact
+ */
+void TempFileClusterExtractor::open(std::vector<char> &records)
+{
+    recordIndex_.clear();
+    assign(records.begin(), records.end());
+    records.clear();
+    indexRecords();
+    ISAAC_THREAD_CERR << "TempFileClusterExtractor::open: " << recordIndex_.size() << " from memory" << std::endl;
+
+    firstUnextracted_ = recordIndex_.begin();
+    // nothing is loaded from a file
+    tempFilePath_.clear();
+}
+
+void TempFileClusterExtractor::indexRecords()
+{
+    for (std::vector<char>::const_iterator it = begin(); end() != it; it = getNextRecord(it))
+    {
+        recordIndex_.push_back(it);
+    }
+
+    std::sort(recordIndex_.begin(), recordIndex_.end(), compareNameAndRead);
+}
+
+void UnpairedReadsCache::startExtractingUnpaired()
+{
+    ISAAC_THREAD_CERR << "startExtractingUnpaired " << std::endl;
+    for (unsigned partition = 0; partitionBuffers_.size() != partition; ++partition)
+    {
+        // partitions that did not fit in memory are extracted from their temp files entirely
+        if (tempFileSizes_[partition])
+        {
+            spillPartition(partition);
+        }
+    }
+    std::for_each(tempFiles_.begin(), tempFiles_.end(), boost::bind(&io::FileBufHolder<io::FileBufWithReopen>::flush, _1));
+
+    extractorFileIterator_ = tempFilePaths_.begin();
+    openExtractor();
+    extracting_ = true;
+}
+
+void UnpairedReadsCache::openExtractor()
+{
+    const std::size_t partition = extractorFileIterator_ - tempFilePaths_.begin();
+    if (tempFileSizes_[partition])
+    {
+        extractor_.open(*extractorFileIterator_, tempFileSizes_[partition]);
+    }
+    else
+    {
+        extractor_.open(partitionBuffers_[partition]);
+    }
+}
+
+void UnpairedReadsCache::spillPartition(const unsigned partition)
+{
+    std::vector<char> &partitionBuffer = partitionBuffers_[partition];
+    if (!partitionBuffer.empty())
+    {
+        ISAAC_THREAD_CERR << "Storing " << partitionBuffer.size() << " bytes of unpaired reads in " <<
+            common::pathStringToStdString(tempFilePaths_[partition]) << std::endl;
+        std::ostream os(tempFiles_[partition].get());
+        if (!os.write(&partitionBuffer.front(), partitionBuffer.size()))
+        {
+            BOOST_THROW_EXCEPTION(isaac::common::IoException(
+                errno, (boost::format("Failed to write: %d bytes into %s") % partitionBuffer.size() %
+                    common::pathStringToStdString(tempFilePaths_[partition])).str()));
+        }
+        tempFileSizes_[partition] += partitionBuffer.size();
+        partitionBuffer.clear();
+    }
+}
+
 template <typename IteratorT>
 void UnpairedReadsCache::storeUnpaired(
     IteratorT unpairedBegin,
@@ -100,42 +171,26 @@ void UnpairedReadsCache::storeUnpaired(
         ISAAC_ASSERT_MSG(byteBuff.size() == maxReadNameLength_, "Invalid number of name bytes extracted");
         byteBuff.push_back(0);// 0 terminator is needed for name comparison during extraction
         const unsigned nameCrc = getNameCrc<7>(crcWidth_, byteBuff.begin(), maxReadNameLength_);
-        std::ostream os(tempFiles_[nameCrc].get());
 
         const TempFileClusterExtractor::FlagsType flags =
             (block.isReadOne() ? TempFileClusterExtractor::READ_ONE_FLAG : 0) |
                 (block.isPf() ? TempFileClusterExtractor::PASS_FILTER_FLAG : 0) ;
         const unsigned recordLength = sizeof(recordLength) + sizeof(flags) + byteBuff.size() + readMetadata.getLength();
-        if (!os.write(reinterpret_cast<const char*>(&recordLength), sizeof(unsigned)))
-        {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(
-                errno, (boost::format("Failed to write: %d bytes into %s") % sizeof(unsigned) % common::pathStringToStdString(tempFilePaths_[nameCrc])).str()));
-        }
-        tempFileSizes_[nameCrc] += sizeof(unsigned);
-
-        if (!os.write(reinterpret_cast<const char*>(&flags), sizeof(flags)))
-        {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(
-                errno, (boost::format("Failed to write: %d bytes into %s") % sizeof(flags) % common::pathStringToStdString(tempFilePaths_[nameCrc])).str()));
-        }
-        tempFileSizes_[nameCrc] += sizeof(flags);
 
-        if (!os.write(byteBuff.begin(), byteBuff.size()))
+        std::vector<char> &partitionBuffer = partitionBuffers_[nameCrc];
+        if (partitionBuffer.size() + recordLength > partitionBuffer.capacity())
         {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(
-                errno, (boost::format("Failed to write: %d bytes into %s") % byteBuff.size() % common::pathStringToStdString(tempFilePaths_[nameCrc])).str()));
+            spillPartition(nameCrc);
         }
-        tempFileSizes_[nameCrc] += byteBuff.size();
+        partitionBuffer.insert(partitionBuffer.end(),
+                               reinterpret_cast<const char*>(&recordLength),
+                               reinterpret_cast<const char*>(&recordLength) + sizeof(recordLength));
+        partitionBuffer.push_back(flags);
+        partitionBuffer.insert(partitionBuffer.end(), byteBuff.begin(), byteBuff.end());
 
         byteBuff.resize(readMetadata.getLength());
         bam::extractBcl(idx.getBlock(), byteBuff.begin(), readMetadata);
-
-        if (!os.write(&byteBuff.front(), byteBuff.size()))
-        {
-            BOOST_THROW_EXCEPTION(isaac::common::IoException(
-                errno, (boost::format("Failed to write: %d bytes into %s") % byteBuff.size() % common::pathStringToStdString(tempFilePaths_[nameCrc])).str()));
-        }
-        tempFileSizes_[nameCrc] += byteBuff.size();
+        partitionBuffer.insert(partitionBuffer.end(), byteBuff.begin(), byteBuff.end());
     }
 }
 
@@ -151,7 +206,7 @@ inline bool inRange(const IndexRecord &idx, const char* rangeStart, const char*
 }
 
 /**
- * \brief stores bam records in [rangeStart,rangeEnd) into temporary files and frees memory associated with them
+ * \brief stores bam records in [rangeStart,rangeEnd) in the unpaired reads cache and frees memory associated with them
  * \precondition All records in the extractor are assumed to be unpaired
  */
 void PairedEndClusterExtractor::removeOld(
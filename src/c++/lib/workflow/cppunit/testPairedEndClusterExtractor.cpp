@@ -0,0 +1,212 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "workflow/alignWorkflow/bamDataSource/PairedEndClusterExtractor.hh"
+
+#include "RegistryName.hh"
+#include "testPairedEndClusterExtractor.hh"
+
+using isaac::workflow::alignWorkflow::bamDataSource::PairedEndClusterExtractor;
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestPairedEndClusterExtractor, registryName("PairedEndClusterExtractor"));
+
+static const unsigned READ_LENGTH = 8;
+static const unsigned NAME_LENGTH_MAX = 16;
+static const unsigned PAIRS = 1000;
+
+void TestPairedEndClusterExtractor::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+}
+
+void TestPairedEndClusterExtractor::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+template <typename T>
+static void appendValue(std::vector<char> &buffer, const T value)
+{
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&value), reinterpret_cast<const char*>(&value) + sizeof(value));
+}
+
+/**
+ * \brief appends an unmapped bam record without cigar
+ */
+static void appendRecord(std::vector<char> &buffer, const std::string &name, const bool readOne, const std::string &bases)
+{
+    static const std::string BAM_BASES = "=ACMGRSVTWYHKDBN";
+    const std::size_t blockBegin = buffer.size();
+    appendValue<int32_t>(buffer, 0);
+    appendValue<int32_t>(buffer, -1);
+    appendValue<int32_t>(buffer, -1);
+    appendValue<uint32_t>(buffer, name.size() + 1);
+    appendValue<uint32_t>(buffer, (0x01 | 0x04 | 0x08 | (readOne ? 0x40 : 0x80)) << 16);
+    appendValue<int32_t>(buffer, bases.size());
+    appendValue<int32_t>(buffer, -1);
+    appendValue<int32_t>(buffer, -1);
+    appendValue<int32_t>(buffer, 0);
+    buffer.insert(buffer.end(), name.c_str(), name.c_str() + name.size() + 1);
+    for (std::size_t i = 0; bases.size() > i; i += 2)
+    {
+        const char high = BAM_BASES.find(bases[i]);
+        const char low = bases.size() > i + 1 ? BAM_BASES.find(bases[i + 1]) : 0;
+        buffer.push_back(high << 4 | low);
+    }
+    for (std::size_t i = 0; bases.size() != i; ++i)
+    {
+        buffer.push_back(10 + i % 30);
+    }
+    const int32_t blockSize = buffer.size() - blockBegin - sizeof(int32_t);
+    std::copy(reinterpret_cast<const char*>(&blockSize), reinterpret_cast<const char*>(&blockSize) + sizeof(blockSize),
+              buffer.begin() + blockBegin);
+}
+
+static std::vector<const isaac::bam::BamBlockHeader *> getBlocks(const std::vector<char> &buffer)
+{
+    std::vector<const isaac::bam::BamBlockHeader *> ret;
+    for (std::size_t offset = 0; buffer.size() != offset;
+        offset += sizeof(int32_t) + *reinterpret_cast<const int32_t*>(&buffer[offset]))
+    {
+        ret.push_back(reinterpret_cast<const isaac::bam::BamBlockHeader *>(&buffer[offset]));
+    }
+    return ret;
+}
+
+static std::string makeBases(const unsigned seed)
+{
+    std::string ret;
+    for (unsigned i = 0; READ_LENGTH != i; ++i)
+    {
+        ret.push_back("ACGT"[(seed * 7 + i * 3 + seed / 4) % 4]);
+    }
+    return ret;
+}
+
+static std::string makeName(const unsigned pair)
+{
+    return "pair:" + std::to_string(pair);
+}
+
+static std::size_t getTempFilesSize(const boost::filesystem::path &directory)
+{
+    std::size_t ret = 0;
+    for (boost::filesystem::directory_iterator it(directory); boost::filesystem::directory_iterator() != it; ++it)
+    {
+        ret += boost::filesystem::file_size(it->path());
+    }
+    return ret;
+}
+
+/**
+ * \brief Feeds the extractor two bam buffers the same way BamClusterLoader does. The first buffer has read 1 of all
+ *        the pairs and one complete pair, the second buffer has read 2 of all the pairs. So all but one pair
+ *        go through the unpaired reads cache.
+ *
+ * \param tempFilesSize  receives the amount of data stored in the temp files by the time extraction starts
+ * \return clusters by read name
+ */
+static std::map<std::string, std::string> extractClusters(
+    const boost::filesystem::path &directory,
+    const std::size_t unpairedMemoryMax,
+    std::size_t &tempFilesSize)
+{
+    isaac::flowcell::ReadMetadataList readMetadataList;
+    readMetadataList.push_back(isaac::flowcell::ReadMetadata(1, READ_LENGTH, 0, 0));
+    readMetadataList.push_back(isaac::flowcell::ReadMetadata(READ_LENGTH + 1, READ_LENGTH * 2, 1, READ_LENGTH));
+
+    std::vector<char> r1Buffer;
+    std::vector<char> r2Buffer;
+    for (unsigned pair = 0; PAIRS != pair; ++pair)
+    {
+        appendRecord(r1Buffer, makeName(pair), true, makeBases(pair * 2));
+        appendRecord(r2Buffer, makeName(pair), false, makeBases(pair * 2 + 1));
+    }
+    appendRecord(r1Buffer, makeName(PAIRS), true, makeBases(PAIRS * 2));
+    appendRecord(r1Buffer, makeName(PAIRS), false, makeBases(PAIRS * 2 + 1));
+
+    PairedEndClusterExtractor extractor(
+        directory, 1024 * 1024, 16, NAME_LENGTH_MAX, READ_LENGTH * 2, true, PAIRS * 2, unpairedMemoryMax);
+    extractor.open("flowcell");
+
+    const unsigned clusterLength = READ_LENGTH * 2 + NAME_LENGTH_MAX;
+    std::vector<char> clusters((PAIRS + 1) * clusterLength);
+    std::vector<bool> pf(PAIRS + 1);
+    std::vector<char>::iterator clusterIt = clusters.begin();
+    std::vector<bool>::iterator pfIt = pf.begin();
+    unsigned clusterCount = PAIRS + 1;
+    const std::vector<char> *buffers[] = {&r1Buffer, &r2Buffer};
+    for (const std::vector<char> *buffer : buffers)
+    {
+        const std::vector<const isaac::bam::BamBlockHeader *> blocks = getBlocks(*buffer);
+        for (std::size_t i = 0; blocks.size() != i; ++i)
+        {
+            extractor.append(*blocks[i], blocks.size() == i + 1, NAME_LENGTH_MAX, clusterCount, readMetadataList, clusterIt, pfIt);
+        }
+        extractor.removeOld(&buffer->front(), &buffer->front() + buffer->size(), readMetadataList);
+    }
+    CPPUNIT_ASSERT_EQUAL(PAIRS, clusterCount);
+
+    extractor.startExtractingUnpaired();
+    tempFilesSize = getTempFilesSize(directory);
+    CPPUNIT_ASSERT_EQUAL(0U, extractor.extractUnpaired(READ_LENGTH, READ_LENGTH, NAME_LENGTH_MAX, clusterCount, clusterIt, pfIt));
+    CPPUNIT_ASSERT(clusters.end() == clusterIt);
+
+    std::map<std::string, std::string> ret;
+    for (std::vector<char>::const_iterator it = clusters.begin(); clusters.end() != it; it += clusterLength)
+    {
+        const std::string name(&*it + READ_LENGTH * 2);
+        CPPUNIT_ASSERT(ret.insert(std::make_pair(name, std::string(it, it + READ_LENGTH * 2))).second);
+    }
+    return ret;
+}
+
+static void checkClusters(const std::map<std::string, std::string> &clusters)
+{
+    CPPUNIT_ASSERT_EQUAL(std::size_t(PAIRS + 1), clusters.size());
+    for (unsigned pair = 0; PAIRS >= pair; ++pair)
+    {
+        std::vector<char> expected(READ_LENGTH * 2);
+        std::vector<char> record;
+        appendRecord(record, makeName(pair), true, makeBases(pair * 2));
+        appendRecord(record, makeName(pair), false, makeBases(pair * 2 + 1));
+        const std::vector<const isaac::bam::BamBlockHeader *> blocks = getBlocks(record);
+        isaac::bam::extractBcl(*blocks[0], expected.begin(), isaac::flowcell::ReadMetadata(1, READ_LENGTH, 0, 0));
+        isaac::bam::extractBcl(*blocks[1], expected.begin() + READ_LENGTH,
+                               isaac::flowcell::ReadMetadata(READ_LENGTH + 1, READ_LENGTH * 2, 1, READ_LENGTH));
+
+        const std::map<std::string, std::string>::const_iterator cluster = clusters.find(makeName(pair));
+        CPPUNIT_ASSERT(clusters.end() != cluster);
+        CPPUNIT_ASSERT(std::string(expected.begin(), expected.end()) == cluster->second);
+    }
+}
+
+void TestPairedEndClusterExtractor::testUnpairedInMemory()
+{
+    std::size_t tempFilesSize = 0;
+    checkClusters(extractClusters(directory_, 1024 * 1024 * 1024, tempFilesSize));
+    // all unpaired reads fit in memory, nothing goes through the temp files
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), tempFilesSize);
+}
+
+void TestPairedEndClusterExtractor::testUnpairedSpilled()
+{
+    std::size_t tempFilesSize = 0;
+    checkClusters(extractClusters(directory_, 0, tempFilesSize));
+    CPPUNIT_ASSERT(0 != tempFilesSize);
+}
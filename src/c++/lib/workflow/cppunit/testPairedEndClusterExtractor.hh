@@ -0,0 +1,36 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_WORKFLOW_TEST_PAIRED_END_CLUSTER_EXTRACTOR_HH
+#define iSAAC_WORKFLOW_TEST_PAIRED_END_CLUSTER_EXTRACTOR_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+class TestPairedEndClusterExtractor : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestPairedEndClusterExtractor );
+    CPPUNIT_TEST( testUnpairedInMemory );
+    CPPUNIT_TEST( testUnpairedSpilled );
+    CPPUNIT_TEST_SUITE_END();
+private:
+    boost::filesystem::path directory_;
+public:
+    void setUp();
+    void tearDown();
+    void testUnpairedInMemory();
+    void testUnpairedSpilled();
+};
+
+#endif // #ifndef iSAAC_WORKFLOW_TEST_PAIRED_END_CLUSTER_EXTRACTOR_HH
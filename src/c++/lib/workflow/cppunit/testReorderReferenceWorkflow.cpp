@@ -0,0 +1,153 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "reference/ContigLoader.hh"
+#include "reference/ContigsPrinter.hh"
+#include "reference/SortedReferenceXml.hh"
+#include "workflow/ReorderReferenceWorkflow.hh"
+
+#include "RegistryName.hh"
+#include "testReorderReferenceWorkflow.hh"
+
+using isaac::reference::SortedReferenceMetadata;
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( TestReorderReferenceWorkflow, registryName("ReorderReferenceWorkflow"));
+
+static std::string makeContig(const std::size_t length, const unsigned seed, const bool lastNewLine)
+{
+    static const std::size_t LINE_LENGTH = 60;
+    std::string ret;
+    for (std::size_t i = 0; length != i; ++i)
+    {
+        ret.push_back((i + seed) % 101 < 7 ? 'N' : "ACGTacgt"[(i * 7 + i / 3 + seed) % 8]);
+        if ((lastNewLine || length != i + 1) && LINE_LENGTH - 1 == i % LINE_LENGTH)
+        {
+            ret.push_back('\n');
+        }
+    }
+    if (lastNewLine && length % LINE_LENGTH)
+    {
+        ret.push_back('\n');
+    }
+    return ret;
+}
+
+static std::string readFile(const boost::filesystem::path &path)
+{
+    std::ifstream is(path.c_str(), std::ios_base::binary);
+    CPPUNIT_ASSERT(is);
+    return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+static std::string printContigs(const boost::filesystem::path &fastaPath)
+{
+    std::ostringstream os;
+    std::streambuf *const coutBuffer = std::cout.rdbuf(os.rdbuf());
+    try
+    {
+        isaac::reference::ContigsPrinter(boost::filesystem::path(), fastaPath, 1).run();
+    }
+    catch (...)
+    {
+        std::cout.rdbuf(coutBuffer);
+        throw;
+    }
+    std::cout.rdbuf(coutBuffer);
+    return os.str();
+}
+
+void TestReorderReferenceWorkflow::setUp()
+{
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory_);
+    const boost::filesystem::path fastaPath = directory_ / "genome.fa";
+    xmlPath_ = directory_ / "sorted-reference.xml";
+
+    a_ = makeContig(150, 1, true);
+    // gets copied in several pieces
+    b_ = makeContig(9 * 1024 * 1024 + 17, 2, true);
+    // no new line at the end of the fasta
+    c_ = makeContig(130, 3, false);
+    {
+        std::ofstream os(fastaPath.c_str(), std::ios_base::binary);
+        CPPUNIT_ASSERT(os << ">a\n" << a_ << ">b\n" << b_ << ">c\n" << c_);
+    }
+
+    std::ofstream os(xmlPath_.c_str());
+    CPPUNIT_ASSERT(os << printContigs(fastaPath));
+}
+
+void TestReorderReferenceWorkflow::tearDown()
+{
+    boost::filesystem::remove_all(directory_);
+}
+
+/**
+ * \brief Reorders the reference on 1, 8 and 16 threads and checks that the fasta is as expected, and that the
+ *        new metadata points at the same bases and agrees with what ContigsPrinter finds in the new fasta
+ */
+static void checkReorder(
+    const boost::filesystem::path &directory,
+    const boost::filesystem::path &xmlPath,
+    const std::vector<std::string> &newOrder,
+    const std::string &expectedFasta)
+{
+    const SortedReferenceMetadata::Contigs original = isaac::reference::loadReferenceMetadataFromXml(xmlPath).getContigs();
+    for (const unsigned jobs : {1, 8, 16})
+    {
+        const boost::filesystem::path outDirectory = directory / ("out-" + std::to_string(jobs));
+        boost::filesystem::create_directories(outDirectory);
+        const boost::filesystem::path outXmlPath = outDirectory / "sorted-reference.xml";
+        isaac::workflow::ReorderReferenceWorkflow(xmlPath, outXmlPath, outDirectory, newOrder, false, jobs).run();
+
+        const boost::filesystem::path outFastaPath = outDirectory / "genome.fa";
+        CPPUNIT_ASSERT(expectedFasta == readFile(outFastaPath));
+
+        const SortedReferenceMetadata::Contigs reordered = isaac::reference::loadReferenceMetadataFromXml(outXmlPath).getContigs();
+        std::istringstream is(printContigs(outFastaPath));
+        const SortedReferenceMetadata::Contigs printed = isaac::reference::loadSortedReferenceXml(is).getContigs();
+        CPPUNIT_ASSERT_EQUAL(original.size(), reordered.size());
+        CPPUNIT_ASSERT_EQUAL(original.size(), printed.size());
+        for (std::size_t i = 0; reordered.size() != i; ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL(printed[i].name_, reordered[i].name_);
+            CPPUNIT_ASSERT_EQUAL(printed[i].offset_, reordered[i].offset_);
+            CPPUNIT_ASSERT_EQUAL(printed[i].size_, reordered[i].size_);
+            CPPUNIT_ASSERT_EQUAL(printed[i].bamM5_, reordered[i].bamM5_);
+
+            const SortedReferenceMetadata::Contig &originalContig = *std::find_if(
+                original.begin(), original.end(),
+                [&reordered, i](const SortedReferenceMetadata::Contig &contig){return reordered[i].name_ == contig.name_;});
+            std::vector<char> originalBases;
+            isaac::reference::loadContig(originalContig, originalBases);
+            std::vector<char> reorderedBases;
+            isaac::reference::loadContig(reordered[i], reorderedBases);
+            CPPUNIT_ASSERT(originalBases == reorderedBases);
+        }
+    }
+}
+
+void TestReorderReferenceWorkflow::testReorder()
+{
+    checkReorder(directory_, xmlPath_, {"c", "a", "b"}, ">c\n" + c_ + "\n>a\n" + a_ + ">b\n" + b_);
+}
+
+void TestReorderReferenceWorkflow::testPreserveOrder()
+{
+    checkReorder(directory_, xmlPath_, std::vector<std::string>(), ">a\n" + a_ + ">b\n" + b_ + ">c\n" + c_ + "\n");
+}
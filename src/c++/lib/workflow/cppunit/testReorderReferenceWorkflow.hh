@@ -0,0 +1,41 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **/
+
+#ifndef iSAAC_WORKFLOW_TEST_REORDER_REFERENCE_WORKFLOW_HH
+#define iSAAC_WORKFLOW_TEST_REORDER_REFERENCE_WORKFLOW_HH
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <boost/filesystem.hpp>
+
+class TestReorderReferenceWorkflow : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TestReorderReferenceWorkflow );
+    CPPUNIT_TEST( testReorder );
+    CPPUNIT_TEST( testPreserveOrder );
+    CPPUNIT_TEST_SUITE_END();
+private:
+    boost::filesystem::path directory_;
+    boost::filesystem::path xmlPath_;
+    // bytes following the header line of each contig in the original fasta
+    std::string a_;
+    std::string b_;
+    std::string c_;
+public:
+    void setUp();
+    void tearDown();
+    void testReorder();
+    void testPreserveOrder();
+};
+
+#endif // #ifndef iSAAC_WORKFLOW_TEST_REORDER_REFERENCE_WORKFLOW_HH
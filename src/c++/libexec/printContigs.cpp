@@ -31,6 +31,7 @@ void printContigs(const isaac::options::PrintContigsOptions &options)
 {
     isaac::reference::ContigsPrinter contigsPrinter(
         options.originalMetadataPath,
-        options.genomeFile);
+        options.genomeFile,
+        options.jobs);
     contigsPrinter.run();
 }
@@ -0,0 +1,46 @@
+/**
+ ** Isaac Genome Alignment Software
+ ** Copyright (c) 2010-2017 Illumina, Inc.
+ ** All rights reserved.
+ **
+ ** This software is provided under the terms and conditions of the
+ ** GNU GENERAL PUBLIC LICENSE Version 3
+ **
+ ** You should have received a copy of the GNU GENERAL PUBLIC LICENSE Version 3
+ ** along with this program. If not, see
+ ** <https://github.com/illumina/licenses/>.
+ **
+ ** \file simulateRun.cpp
+ **
+ ** \brief Generates a synthetic reference and paired-end fastq flowcell
+ **
+ ** \author Roman Petrovski
+ **/
+
+#include "options/SimulateRunOptions.hh"
+#include "workflow/SimulateRunWorkflow.hh"
+
+void simulateRun(const isaac::options::SimulateRunOptions &options);
+
+int main(int argc, char *argv[])
+{
+    isaac::common::run(simulateRun, argc, argv);
+}
+
+void simulateRun(const isaac::options::SimulateRunOptions &options)
+{
+    isaac::workflow::SimulateRunWorkflow workflow(
+        options.outputDirectory_,
+        options.referenceLength_,
+        options.contigs_,
+        options.repeatFraction_,
+        options.readLength_,
+        options.clusters_,
+        options.fragmentLengthMean_,
+        options.fragmentLengthSd_,
+        options.errorRate_,
+        options.indelRate_,
+        options.duplicateRate_,
+        options.seed_);
+    workflow.run();
+}